@@ -40,6 +40,34 @@ const uint8_t NIBP_ADDR = 0x43;
 // Protocol commands
 const uint8_t CMD_PING = 0x00;
 const uint8_t CMD_SCAN = 0x01;
+const uint8_t CMD_READ_ALL = 0x04;
+const uint8_t CMD_READ_FIFO = 0x05;
+const uint8_t CMD_FIFO_LEVEL = 0x06;
+
+// READ_ALL frame: [seq][presence mask][float per set bit...][CRC-8]
+// (see include/hardware/i2c_protocol.h)
+const uint8_t SENSOR_COUNT = 6;
+const uint8_t FRAME_MAX = 3 + 4 * SENSOR_COUNT;
+const unsigned long SAMPLE_INTERVAL_MS = 4;  // 250 Hz
+
+// Waveform FIFO entry: [channel][time us, u32][float], all little-endian
+const uint16_t FIFO_CAPACITY = 512;
+const uint8_t FIFO_ENTRY_SIZE = 9;
+const uint8_t FIFO_READ_MAX = 28;  // 4 + 28 * 9 = 256, the Wire buffer
+const uint8_t FIFO_FRAME_MAX = 4 + FIFO_ENTRY_SIZE * FIFO_READ_MAX;
+
+// Waveform channels: sensor ID, status bit, sample period
+struct WaveformChannel {
+    uint8_t id;
+    uint8_t bit;
+    unsigned long periodUs;
+};
+const WaveformChannel WAVEFORMS[] = {
+    {0x00, 0, 2000},   // ECG, 500 Hz
+    {0x01, 1, 10000},  // Pleth (SpO2 sensor), 100 Hz
+    {0x04, 5, 40000},  // Respiration, 25 Hz
+};
+const uint8_t WAVEFORM_COUNT = sizeof(WAVEFORMS) / sizeof(WAVEFORMS[0]);
 
 // LED
 #define LED_PIN 14
@@ -50,6 +78,33 @@ volatile uint8_t sensorStatus = 0;
 volatile bool needsScan = false;
 volatile bool isScanning = false;  // Prevent scan interruptions
 
+// Latest reading per status bit (ECG, SpO2, Core Temp, NIBP, Skin Temp, Resp)
+float sensorValues[SENSOR_COUNT] = {0};
+
+// READ_ALL double buffer: loop() fills the back frame and flips frontFrame,
+// onRequest() sends the front one, so the Pi never sees a half-built frame
+struct Frame {
+    uint8_t bytes[FRAME_MAX];
+    uint8_t length;
+};
+Frame frames[2];
+volatile uint8_t frontFrame = 0;
+uint8_t frameSequence = 0;
+
+// Waveform ring FIFO: loop() pushes at fifoHead, onReceive() pops at
+// fifoTail. Each index has one writer, so no locking is needed. Both count
+// freely and wrap at 65536, a multiple of FIFO_CAPACITY.
+struct FifoEntry {
+    uint8_t channel;
+    uint32_t timestamp;
+    float value;
+};
+FifoEntry fifo[FIFO_CAPACITY];
+volatile uint16_t fifoHead = 0;
+volatile uint16_t fifoTail = 0;
+volatile uint16_t fifoDropped = 0;    // Since the last FIFO_LEVEL
+unsigned long nextWaveformUs[WAVEFORM_COUNT] = {0};
+
 void setup() {
     delay(1500);
     Serial.begin(115200);
@@ -84,11 +139,32 @@ void setup() {
 
     // Do initial scan
     scanSensors();
+    publishFrame();
+
+    unsigned long now = micros();
+    for (uint8_t c = 0; c < WAVEFORM_COUNT; c++) {
+        nextWaveformUs[c] = now;
+    }
     
     digitalWrite(LED_PIN, LOW);
 }
 
 void loop() {
+    // ========================================================================
+    // Sample waveforms into the FIFO, each at its own rate
+    // ========================================================================
+    sampleWaveforms();
+
+    // ========================================================================
+    // Sample attached sensors into the READ_ALL frame at 250 Hz
+    // ========================================================================
+    static unsigned long lastSampleTime = 0;
+    if (millis() - lastSampleTime >= SAMPLE_INTERVAL_MS) {
+        lastSampleTime = millis();
+        sampleSensors();
+        publishFrame();
+    }
+
     // ========================================================================
     // Auto-scan sensors every 5 seconds
     // ========================================================================
@@ -211,6 +287,79 @@ void scanSensors() {
     isScanning = false;  // Scan complete
 }
 
+void sampleSensors() {
+    // Per-sensor reads go here once the W1/W2 buses are enabled (see
+    // scanSensors()); until then attached sensors keep their last value.
+}
+
+uint16_t fifoLevel() {
+    return (uint16_t)(fifoHead - fifoTail);
+}
+
+void sampleWaveforms() {
+    unsigned long now = micros();
+    for (uint8_t c = 0; c < WAVEFORM_COUNT; c++) {
+        // Due times advance by the period, so the rate holds even when loop()
+        // runs late; the timestamp is when the sample was due
+        while ((long)(now - nextWaveformUs[c]) >= 0) {
+            unsigned long due = nextWaveformUs[c];
+            nextWaveformUs[c] += WAVEFORMS[c].periodUs;
+            if (!(sensorStatus & (1 << WAVEFORMS[c].bit))) {
+                continue;  // Sensor not attached: nothing is sampled
+            }
+            if (fifoLevel() >= FIFO_CAPACITY) {
+                noInterrupts();  // FIFO_LEVEL resets the count from the ISR
+                fifoDropped++;
+                interrupts();
+                continue;
+            }
+            FifoEntry &entry = fifo[fifoHead % FIFO_CAPACITY];
+            entry.channel = WAVEFORMS[c].id;
+            entry.timestamp = due;
+            entry.value = readWaveform(c);
+            fifoHead = fifoHead + 1;  // Publish after the entry is written
+        }
+    }
+}
+
+float readWaveform(uint8_t channel) {
+    // Waveform reads go here once the W1/W2 buses are enabled; until then
+    // the channel repeats the sensor's last value.
+    return sensorValues[WAVEFORMS[channel].bit];
+}
+
+// CRC-8/SMBUS: polynomial 0x07, initial value 0
+uint8_t crc8(const uint8_t *data, uint8_t length) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void publishFrame() {
+    // Build into the back buffer; onRequest() may be sending the front one
+    Frame &frame = frames[1 - frontFrame];
+    uint8_t mask = sensorStatus;
+    uint8_t length = 0;
+
+    frame.bytes[length++] = frameSequence++;
+    frame.bytes[length++] = mask;
+    for (uint8_t bit = 0; bit < SENSOR_COUNT; bit++) {
+        if (mask & (1 << bit)) {
+            memcpy(&frame.bytes[length], &sensorValues[bit], sizeof(float));  // Little-endian, as on the Pi
+            length += sizeof(float);
+        }
+    }
+    frame.bytes[length] = crc8(frame.bytes, length);
+    frame.length = length + 1;
+
+    frontFrame = 1 - frontFrame;  // Single byte write: atomic against onRequest()
+}
+
 bool probeSensor(TwoWire &wire, uint8_t addr) {
     wire.beginTransmission(addr);
     uint8_t error = wire.endTransmission();
@@ -220,6 +369,44 @@ bool probeSensor(TwoWire &wire, uint8_t addr) {
 // State for I2C response
 volatile uint8_t activeCommand = 0;
 volatile uint8_t responseBuffer = 0;
+uint8_t fifoResponse[FIFO_FRAME_MAX];
+uint16_t fifoResponseLength = 0;
+
+// Pop up to count samples into a READ_FIFO frame
+void buildFifoResponse(uint8_t count) {
+    if (count > FIFO_READ_MAX) {
+        count = FIFO_READ_MAX;
+    }
+    uint16_t length = 3;
+    uint8_t taken = 0;
+    while (taken < count && fifoTail != fifoHead) {
+        const FifoEntry &entry = fifo[fifoTail % FIFO_CAPACITY];
+        fifoResponse[length++] = entry.channel;
+        memcpy(&fifoResponse[length], &entry.timestamp, 4);  // Little-endian, as on the Pi
+        memcpy(&fifoResponse[length + 4], &entry.value, 4);
+        length += 8;
+        fifoTail = fifoTail + 1;
+        taken++;
+    }
+    uint16_t level = fifoLevel();
+    fifoResponse[0] = taken;
+    fifoResponse[1] = level & 0xFF;
+    fifoResponse[2] = level >> 8;
+    fifoResponse[length] = crc8(fifoResponse, length);
+    fifoResponseLength = length + 1;
+}
+
+void buildFifoLevelResponse() {
+    uint16_t level = fifoLevel();
+    uint16_t dropped = fifoDropped;
+    fifoDropped = 0;
+    fifoResponse[0] = level & 0xFF;
+    fifoResponse[1] = level >> 8;
+    fifoResponse[2] = dropped & 0xFF;
+    fifoResponse[3] = dropped >> 8;
+    fifoResponse[4] = crc8(fifoResponse, 4);
+    fifoResponseLength = 5;
+}
 
 // Called when Pi sends data (CMD write)
 void onReceive(int numBytes) {
@@ -237,6 +424,12 @@ void onReceive(int numBytes) {
             // Pre-load 0x42
             responseBuffer = 0x42;
         }
+        else if (activeCommand == CMD_READ_FIFO) {
+            buildFifoResponse(WireBackbone.available() ? WireBackbone.read() : 0);
+        }
+        else if (activeCommand == CMD_FIFO_LEVEL) {
+            buildFifoLevelResponse();
+        }
         else {
             responseBuffer = 0x00;
         }
@@ -250,7 +443,16 @@ void onReceive(int numBytes) {
 
 // Called when Pi reads data
 void onRequest() {
-    // FORCE 0x42 for debugging. Ignore buffer.
-    WireBackbone.write(0x42);
+    if (activeCommand == CMD_READ_ALL) {
+        // Reads past the frame get 0xFF padding from the SERCOM
+        const Frame &frame = frames[frontFrame];
+        WireBackbone.write(frame.bytes, frame.length);
+        return;
+    }
+    if (activeCommand == CMD_READ_FIFO || activeCommand == CMD_FIFO_LEVEL) {
+        WireBackbone.write(fifoResponse, fifoResponseLength);
+        return;
+    }
+    WireBackbone.write(responseBuffer);
 }
 
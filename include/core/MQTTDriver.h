@@ -1,17 +1,34 @@
 #ifndef MQTTDRIVER_H
 #define MQTTDRIVER_H
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <string>
+#include <string_view>
 #include <functional>
 #include <mutex>
+#include <thread>
 #include <mosquitto.h>
 #include "core/SensorDataStore.h"
+#include "core/bed_store.h"
+#include "core/mqtt_payload.h"
+#include "core/mqtt_stats.h"
+
+class MqttRecorder;
 
 /**
  * @brief MQTT client driver for patient simulation telemetry
  * 
  * Subscribes to medical simulation topics (heart, lung, conditions) from an MQTT broker
- * and updates the SensorDataStore with received values.
+ * and updates the SensorDataStore with received values. With a BedStore attached,
+ * the same topics under bed/<id>/ (e.g. bed/12/heart/heartRate) go to that bed's shard.
+ *
+ * Messages are applied in batches: each keeps the latest value per topic and
+ * patient, and a batch reaches each store, bed physiology and the patient
+ * snapshot in one publish. startLoop() runs the network loop on its own
+ * thread and drains every message that is ready into one batch.
  */
 class MQTTDriver {
 public:
@@ -64,10 +81,51 @@ public:
 
     /**
      * @brief Callback invoked when a topic update is received
-     * @param topic MQTT topic name
+     * @param topic MQTT topic name (valid only during the call)
      * @param value Parsed numeric value
      */
-    using UpdateCallback = std::function<void(const std::string& topic, float value)>;
+    using UpdateCallback = std::function<void(std::string_view topic, float value)>;
+
+    /**
+     * @brief One published batch
+     */
+    struct BatchInfo {
+        size_t messages = 0;    ///< Messages parsed into the batch
+        bool patient = false;   ///< The monitor's own patient changed (not only beds)
+        std::chrono::steady_clock::time_point received; ///< When its first message was read
+    };
+
+    /**
+     * @brief Callback invoked after a batch has been published
+     */
+    using BatchCallback = std::function<void(const BatchInfo& batch)>;
+
+    /**
+     * @brief One message for ingestBatch()
+     */
+    struct Message {
+        std::string_view topic;
+        const void* payload;
+        int payloadlen;
+    };
+
+    /// Messages drained from the socket before a batch is published
+    static constexpr size_t MAX_BATCH = 256;
+
+    /**
+     * @brief Aggregate topic carrying many values in one message
+     *
+     * Text format (default): a JSON object keyed by topic name, flat or
+     * grouped, e.g. {"heart/heartRate": 72, "lung": {"oxygenSaturation": 97}}.
+     * Float32 format: a packed record, a little-endian uint32 mask followed
+     * by one little-endian float per set bit, where bit i is vitalsField(i).
+     * A message is applied whole, or not at all if any known value is
+     * invalid; unknown keys are ignored. Beds use bed/<id>/patient/vitals.
+     */
+    static constexpr std::string_view VITALS_TOPIC = "patient/vitals";
+
+    /// Topic carried by bit i of a packed vitals record (empty past the last one)
+    static std::string_view vitalsField(size_t bit);
 
     /**
      * @brief Construct MQTT driver
@@ -121,22 +179,128 @@ public:
 
     /**
      * @brief Process MQTT events (must be called regularly in main loop)
+     *
+     * Runs one pass of the network thread: waits up to timeout_ms for the
+     * socket, drains what is ready into one batch, and reconnects at once if
+     * the connection dropped. startLoop() is preferred.
      * @param timeout_ms Timeout in milliseconds
      */
     void loop(int timeout_ms = 10);
 
+    /**
+     * @brief Run the network loop on a dedicated thread (call after connect())
+     *
+     * The thread waits on the socket, drains up to MAX_BATCH ready messages,
+     * publishes them as one batch, and reconnects if the connection drops.
+     * Do not call loop() while it runs.
+     * @return false if the client could not be created or the loop already runs
+     */
+    bool startLoop();
+
+    /**
+     * @brief Stop the network thread (also done by the destructor)
+     */
+    void stopLoop();
+
+    /**
+     * @brief Handle one message as if it had arrived from the broker
+     *
+     * The mosquitto message callback takes the same path; also used to feed
+     * messages from elsewhere (tests, benchmarks).
+     * @param topic Full topic, e.g. "heart/heartRate" or "bed/12/heart/heartRate"
+     * @param payload Payload bytes
+     * @param payloadlen Payload length
+     */
+    void ingest(std::string_view topic, const void* payload, int payloadlen);
+
+    /**
+     * @brief Handle several messages as one batch, in order
+     * @param messages Messages to apply
+     * @param count Number of messages
+     */
+    void ingestBatch(const Message* messages, size_t count);
+
     /**
      * @brief Get snapshot of patient data
      * @return Current patient data
      */
     PatientData getPatientDataSnapshot() const;
 
+    /**
+     * @brief Patient state for the waveform simulator
+     *
+     * Heart rate, respiratory rate, SpO2 and blood pressure from the latest
+     * messages; values not yet received keep the simulator defaults.
+     * @return Physiology to pass to SignalGenerator::setPhysiology()
+     */
+    SignalGenerator::Physiology physiology() const;
+
+    /**
+     * @brief Route bed/<id>/... topics to per-bed shards (call before connect())
+     *
+     * Subscribes to bed/+/heart/#, bed/+/lung/# and bed/+/conditions/#; a bed
+     * is added to the store by its first message. The single-patient topics
+     * keep updating the store passed to the constructor.
+     * @param beds Ward store, or nullptr to ignore bed topics (default)
+     */
+    void setBedStore(BedStore* beds);
+
+    /**
+     * @brief Choose how a topic's payload is encoded (call before connect())
+     *
+     * Topics default to Text. A binary format suits publishers that send
+     * raw floats or MessagePack/CBOR scalars; it applies to the topic for the
+     * monitor's own patient and for every bed.
+     * @param topic Per-patient topic, e.g. "heart/heartRate", or VITALS_TOPIC
+     * @param format Payload encoding (Text or Float32 for VITALS_TOPIC)
+     * @return false if the topic is not subscribed or cannot take the format
+     */
+    bool setPayloadFormat(std::string_view topic, MqttPayload::Format format);
+
     /**
      * @brief Set callback for topic updates
+     *
+     * Called once per topic and patient changed by a batch, after the batch
+     * is published, with the latest value. Must not call ingest().
      * @param cb Callback function
      */
     void setUpdateCallback(UpdateCallback cb);
 
+    /**
+     * @brief Set callback for published batches (same rules as the update callback)
+     * @param cb Callback function
+     */
+    void setBatchCallback(BatchCallback cb);
+
+    /**
+     * @brief Ingestion counters and receive-to-publish latency (any thread)
+     *
+     * Topic slots follow statsTopic(); counting costs a few plain stores per
+     * message on a per-thread block.
+     */
+    const MqttStats& stats() const { return stats_; }
+
+    /// Topic counted in slot i of stats() (empty past the last one)
+    static std::string_view statsTopic(size_t slot);
+
+    /**
+     * @brief Record every message handled from now on (see mqtt_log.h)
+     *
+     * Messages are recorded as received, before parsing, whether they come
+     * from the broker or through ingest().
+     * @param recorder Open recorder (must outlive its use), or nullptr to stop
+     */
+    void setRecorder(MqttRecorder* recorder);
+
+    /**
+     * @brief Publish a message to the broker (e.g. to replay a log through it)
+     *
+     * Safe to call from any thread while the network loop runs: the message
+     * is queued and the loop is woken to send it.
+     * @return false if not connected or the client rejected it
+     */
+    bool publish(std::string_view topic, const void* payload, int payloadlen);
+
 private:
     // Mosquitto callbacks (static wrappers)
     static void onConnect_(struct mosquitto* mosq, void* userdata, int rc);
@@ -145,7 +309,17 @@ private:
 
     // Instance callback handlers
     void handleConnect_(int rc);
-    void handleMessage_(const std::string& topic, const void* payload, int payloadlen);
+    void markDisconnected_();
+    void handleMessage_(std::string_view topic, const void* payload, int payloadlen);
+
+    // Batching; the caller holds batchMutex_
+    bool parseVitals_(std::string_view payload, uint32_t& topics, float* values) const;
+    void stage_(BedStore::Shard* bed, size_t topic, float value);
+    void publishBatch_();
+
+    // Network thread body, and one pass of it (poll, read and publish, write, keepalive)
+    void networkLoop_();
+    int service_(int timeoutMs);
 
     // Subscribe to all topics
     bool subscribeAll_();
@@ -153,11 +327,21 @@ private:
     // Field update helper
     void setField_(float& field, bool& hasFlag, float value);
 
-    // Parsing helpers
-    static std::string trim_(std::string s);
-    static std::string lower_(std::string s);
-    static bool parseFloat_(const char* bytes, int len, float& out);
-    static bool parseBoolish_(const char* bytes, int len, float& out);
+    // Payload format per subscribed topic, indexed like the topic table
+    static constexpr size_t MAX_TOPICS = 32;
+    std::array<MqttPayload::Format, MAX_TOPICS> payloadFormats_{};
+    MqttPayload::Format vitalsFormat_ = MqttPayload::Format::Text;
+
+    // Latest value per topic for one patient, held until the batch is published
+    struct Pending {
+        BedStore::Shard* bed = nullptr;  // nullptr for the monitor's own patient
+        uint32_t topics = 0;             // bit k set => values[k] is the latest for topic k
+        std::array<float, MAX_TOPICS> values{};
+    };
+    std::mutex batchMutex_;
+    std::array<Pending, 1 + BedStore::MAX_BEDS> pending_;
+    size_t pendingCount_ = 0;
+    BatchInfo batch_;
 
     // MQTT connection state
     struct mosquitto* mosq_ = nullptr;
@@ -168,15 +352,28 @@ private:
     std::string password_;
     bool useAuth_ = false;
     int keepAliveSec_ = 60;
-    bool connected_ = false;
+    std::atomic<bool> connected_{false};
+    bool everConnected_ = false;  // Only touched by the connect callback
+
+    MqttStats stats_;
+    MqttRecorder* recorder_ = nullptr;  // Guarded by batchMutex_
+
+    // Network thread
+    std::thread loopThread_;
+    std::atomic<bool> loopRunning_{false};
+    std::mutex loopMutex_;
+    std::condition_variable loopCv_;
+    int wakeFd_ = -1;  // eventfd; publish() wakes the loop's poll
 
     // Data store reference
     SensorDataStore& sensorStore_;
+    BedStore* beds_ = nullptr;
 
     // Internal patient data snapshot
     mutable std::mutex mtx_;
     PatientData patient_;
-    UpdateCallback updateCb_;
+    UpdateCallback updateCb_;  // Guarded by batchMutex_
+    BatchCallback batchCb_;    // Guarded by batchMutex_
 };
 
 #endif // MQTTDRIVER_H
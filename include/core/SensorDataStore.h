@@ -1,23 +1,63 @@
 // SensorDataStore.h
 #pragma once
 
-#include <mutex>
-#include <optional>
+#include <cstdint>
 #include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
 // Adjust include path if your project uses a different include root:
 #include "core/signal_generator.h"
+#include "core/seqlock.h"
+#include "core/time_series_ring.h"
 
 class SensorDataStore {
 public:
   using Clock = std::chrono::steady_clock;
   using TimePoint = Clock::time_point;
 
-
+  // Field identifiers (bit index in Snapshot::present)
+  enum class Field : uint8_t {
+    Ecg = 0,
+    Spo2,
+    Resp,
+    Pleth,
+    BpSystolic,
+    BpDiastolic,
+    TempCavity,
+    TempSkin,
+    Timestamp,
+    Count
+  };
+  static constexpr size_t FIELD_COUNT = static_cast<size_t>(Field::Count);
+
+  // Everything the store knows, captured in one consistent read:
+  // values, availability flags and per-field update times.
+  struct Snapshot {
+    SignalGenerator::SensorData data{};
+    uint32_t present = 0;                 // bit i set => Field(i) has been written
+    TimePoint updated[FIELD_COUNT] = {};  // last write time per field
+
+    bool has(Field f) const { return (present >> static_cast<unsigned>(f)) & 1u; }
+    double value(Field f) const;          // 0 if the field was never written
+    TimePoint lastUpdate(Field f) const { return updated[static_cast<size_t>(f)]; }
+  };
+
+
+  // The single-patient store used by the monitor's own stream
   static SensorDataStore& instance();
 
+  // Independent store (e.g. one bed of a BedStore) keeping historySeconds of history
+  explicit SensorDataStore(double historySeconds = HISTORY_SECONDS);
+
+  SensorDataStore(const SensorDataStore&) = delete;
+  SensorDataStore& operator=(const SensorDataStore&) = delete;
+
 
   // ----- Setters -----
+  // Writers never block on readers; concurrent writers are serialized briefly.
   void setEcg(double v);
   void setSpo2(double v);
   void setResp(double v);
@@ -28,16 +68,31 @@ public:
   void setTempSkin(double v);
   void setTimestamp(double v);
 
-  // Optional convenience: set many at once (only overwrites provided fields)
-  void setBulk(const double& ecg,
-               const double& spo2,
-               const double& resp,
-               const double& pleth,
-               const double& bp_systolic,
-               const double& bp_diastolic,
-               const double& temp_cavity,
-               const double& temp_skin,
-               const double& timestamp);
+  // A partial write: only the fields set() here are applied
+  struct Update {
+    uint32_t present = 0;               // bit i set => values[i] is applied
+    double values[FIELD_COUNT] = {};
+
+    void set(Field f, double v) {
+      values[static_cast<size_t>(f)] = v;
+      present |= 1u << static_cast<unsigned>(f);
+    }
+    bool empty() const { return present == 0; }
+  };
+
+  // Apply every field of the update in one publish, so readers see them together
+  void apply(const Update& update);
+
+  // Set many at once in one publish; fields given as std::nullopt are left as they are
+  void setBulk(std::optional<double> ecg,
+               std::optional<double> spo2,
+               std::optional<double> resp,
+               std::optional<double> pleth,
+               std::optional<double> bp_systolic,
+               std::optional<double> bp_diastolic,
+               std::optional<double> temp_cavity,
+               std::optional<double> temp_skin,
+               std::optional<double> timestamp);
 
   // ----- Getters (every value) -----
   double getEcg() const;
@@ -61,9 +116,32 @@ public:
   bool hasTempSkin() const;
   bool hasTimestamp() const;
 
-  // ----- Snapshot of the underlying struct -----
-  // Note: snapshot returns the struct as-is (fields may be stale if never set).
-  SignalGenerator::SensorData snapshot() const;
+  // Forget every value and flag (re-initialization, tests)
+  void clear();
+
+  // ----- Consistent snapshot -----
+  // Lock-free read of values, has-flags and timestamps together. Prefer this
+  // over several individual getters, which may observe different writes.
+  Snapshot snapshot() const;
+
+  // ----- History (per-channel ring buffers, stream time in seconds) -----
+  // Waveforms (ecg, resp, pleth) are kept at up to WAVEFORM_HISTORY_RATE_HZ,
+  // vitals at VITALS_HISTORY_RATE_HZ, both for HISTORY_SECONDS unless
+  // the constructor was given another length.
+  static constexpr double HISTORY_SECONDS = 600.0;
+  static constexpr double WAVEFORM_HISTORY_RATE_HZ = 500.0;
+  static constexpr double VITALS_HISTORY_RATE_HZ = 10.0;
+
+  // Record one streamed frame (single producer thread only; allocation-free)
+  void recordHistory(const SignalGenerator::SensorData& frame);
+
+  // Append samples with from <= t <= to; returns count (0 for Field::Timestamp)
+  size_t readHistory(Field f, double from, double to, std::vector<TimeSample>& out,
+                     size_t maxSamples = 0) const;
+
+  // Channel names match the stream's JSON keys ("ecg", "bp_systolic", ...)
+  static const char* fieldName(Field f);
+  static bool fieldFromName(const std::string& name, Field& out);
 
   // ----- Per-field last update timestamps -----
   TimePoint lastUpdateEcg() const;
@@ -77,32 +155,12 @@ public:
   TimePoint lastUpdateTimestamp() const;
 
 private:
-    SensorDataStore();
-
-  void setField_(double& field, bool& hasFlag, TimePoint& ts, double v);
-
-  mutable std::mutex mtx_;
-  SignalGenerator::SensorData data_{}; // from core/signal_generator.h
-
-  // availability flags
-  bool has_ecg_ = false;
-  bool has_spo2_ = false;
-  bool has_resp_ = false;
-  bool has_pleth_ = false;
-  bool has_bp_systolic_ = false;
-  bool has_bp_diastolic_ = false;
-  bool has_temp_cavity_ = false;
-  bool has_temp_skin_ = false;
-  bool has_timestamp_ = false;
-
-  // last update timestamps
-  TimePoint ts_ecg_;
-  TimePoint ts_spo2_;
-  TimePoint ts_resp_;
-  TimePoint ts_pleth_;
-  TimePoint ts_bp_systolic_;
-  TimePoint ts_bp_diastolic_;
-  TimePoint ts_temp_cavity_;
-  TimePoint ts_temp_skin_;
-  TimePoint ts_timestamp_;
+  static void setField_(Snapshot& s, Field f, double v, TimePoint now);
+  void set_(Field f, double v);
+
+  Seqlock<Snapshot> state_;
+
+  std::unique_ptr<TimeSeriesRing> history_[FIELD_COUNT]; // none for Field::Timestamp
+  double lastVitalsHistoryT_ = 0.0;
+  bool haveVitalsHistory_ = false;
 };
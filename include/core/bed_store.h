@@ -0,0 +1,101 @@
+#ifndef BED_STORE_H
+#define BED_STORE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "core/SensorDataStore.h"
+#include "core/seqlock.h"
+#include "core/signal_generator.h"
+
+/**
+ * @brief Patient data for a whole ward, one independent shard per bed
+ *
+ * Each bed owns a SensorDataStore (latest values and history) and the
+ * physiology its simulated waveforms follow. Shards are allocated on first
+ * use and aligned to a cache line, so writers for different beds never share
+ * a lock or a cache line. Looking a bed up is lock-free; only adding a bed
+ * takes a mutex. Beds are never removed, so shard pointers stay valid for
+ * the lifetime of the store.
+ *
+ * Bed ids come from MQTT topics of the form bed/<id>/<topic> and are 1 to
+ * MAX_ID_LENGTH characters from [A-Za-z0-9_-].
+ */
+class BedStore
+{
+public:
+    static constexpr size_t MAX_BEDS = 64;
+    static constexpr size_t MAX_ID_LENGTH = 32;
+    static constexpr size_t CACHE_LINE = 64;
+
+    /// History kept per bed; shorter than the single-patient store so a full ward fits in memory
+    static constexpr double DEFAULT_HISTORY_SECONDS = 120.0;
+
+    struct alignas(CACHE_LINE) Shard
+    {
+        Shard(std::string bedId, double historySeconds);
+
+        const std::string id;
+        SensorDataStore store;
+
+        SignalGenerator::Physiology physiology() const { return physiology_.load(); }
+
+        /// Incremented by every physiology update, so readers can skip unchanged beds
+        uint64_t physiologyVersion() const { return physiologyVersion_.load(std::memory_order_acquire); }
+
+        /// Modify the physiology in place: fn(SignalGenerator::Physiology&)
+        template <typename Fn>
+        void updatePhysiology(Fn&& fn)
+        {
+            physiology_.update(std::forward<Fn>(fn));
+            physiologyVersion_.fetch_add(1, std::memory_order_release);
+        }
+
+    private:
+        Seqlock<SignalGenerator::Physiology> physiology_;
+        std::atomic<uint64_t> physiologyVersion_{0};
+    };
+
+    /**
+     * @param historySeconds History kept by each bed's SensorDataStore
+     */
+    explicit BedStore(double historySeconds = DEFAULT_HISTORY_SECONDS);
+
+    BedStore(const BedStore&) = delete;
+    BedStore& operator=(const BedStore&) = delete;
+
+    /// Existing shard or nullptr (lock-free)
+    Shard* find(std::string_view id) const;
+
+    /// Existing or newly added shard; nullptr for an invalid id or a full ward
+    Shard* acquire(std::string_view id);
+
+    /// Number of beds; at(i) is valid for i < size(), in the order beds were added
+    size_t size() const { return count_.load(std::memory_order_acquire); }
+    Shard* at(size_t i) const { return shards_[i].get(); }
+
+    static bool validId(std::string_view id);
+
+    /**
+     * @brief Split "bed/<id>/<rest>" into its bed id and per-patient topic
+     *
+     * id and rest are views into topic; nothing is copied.
+     * @return false for any other topic or an invalid id
+     */
+    static bool splitTopic(std::string_view topic, std::string_view& id, std::string_view& rest);
+
+private:
+    const double historySeconds_;
+    std::array<std::unique_ptr<Shard>, MAX_BEDS> shards_;
+    std::atomic<size_t> count_{0};
+    std::mutex addMutex_;
+    bool warnedFull_ = false;
+};
+
+#endif // BED_STORE_H
@@ -0,0 +1,61 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Lock-free latency histogram with percentile summaries
+ *
+ * Latencies are counted in log-linear microsecond buckets: exact below 8 us,
+ * then 8 buckets per power of two, so a reported percentile is within 12.5%
+ * of the true value. record() is a few relaxed atomic adds and may be called
+ * from any number of threads; summary() may run concurrently and sees a
+ * recent (not necessarily instantaneous) state.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr size_t SUB_BUCKETS = 8;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS + SUB_BUCKETS * 32; // Up to 2^35 us (~9.5 hours)
+
+    struct Summary
+    {
+        uint64_t count = 0;
+        double meanUs = 0.0;
+        double p50Us = 0.0;
+        double p90Us = 0.0;
+        double p99Us = 0.0;
+        double p999Us = 0.0;
+        double maxUs = 0.0;
+    };
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(std::chrono::nanoseconds latency);
+
+    /// Latency below which a fraction q (0..1] of the samples fall; 0 if empty
+    double percentileUs(double q) const;
+
+    Summary summary() const;
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    void reset();
+
+private:
+    static size_t bucketFor(uint64_t us);
+    static uint64_t bucketUpperUs(size_t bucket);
+
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sumUs_{0};
+    std::atomic<uint64_t> maxUs_{0};
+};
+
+#endif // LATENCY_HISTOGRAM_H
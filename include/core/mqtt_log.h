@@ -0,0 +1,136 @@
+#ifndef MQTT_LOG_H
+#define MQTT_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/MQTTDriver.h"
+
+/**
+ * @brief Compact binary log of MQTT traffic, for reproducing a ward's load
+ *
+ * File layout: the 8-byte magic "CCMQLOG\x01", then one record per message:
+ *
+ *     varint  nanoseconds since the previous message (the first: 0)
+ *     varint  topic reference: 0 = new topic, n = the n-th topic seen
+ *     [varint topic length, topic bytes]   only for a new topic
+ *     varint  payload length
+ *     payload bytes
+ *
+ * Varints are LEB128 (7 bits per byte, low first). Topics repeat, so a
+ * typical ward message costs a few bytes of framing plus its payload.
+ */
+namespace MqttLog
+{
+    constexpr char MAGIC[8] = {'C', 'C', 'M', 'Q', 'L', 'O', 'G', '\x01'};
+    constexpr size_t MAX_TOPIC_LENGTH = 65535;
+    constexpr size_t MAX_PAYLOAD = 268435455; // The MQTT limit
+}
+
+/**
+ * @brief Writes received messages to an MQTT log (any thread)
+ *
+ * Records are staged in memory and written in large blocks, so recording
+ * costs a copy and a clock read per message. Attach to a driver with
+ * MQTTDriver::setRecorder().
+ */
+class MqttRecorder
+{
+public:
+    MqttRecorder() = default;
+    ~MqttRecorder();
+    MqttRecorder(const MqttRecorder&) = delete;
+    MqttRecorder& operator=(const MqttRecorder&) = delete;
+
+    /// Create (or truncate) the log and write its header
+    bool open(const std::string& path);
+
+    /// Flush and close; further records are dropped
+    void close();
+
+    bool isOpen() const;
+
+    /// Append one message that arrived at the given time
+    void record(std::string_view topic, const void* payload, int payloadlen,
+                std::chrono::steady_clock::time_point arrival = std::chrono::steady_clock::now());
+
+    /// Messages recorded since open()
+    size_t count() const;
+
+private:
+    void flush_();
+
+    mutable std::mutex mutex_;
+    std::ofstream file_;
+    std::vector<uint8_t> buffer_;
+    std::map<std::string, uint64_t, std::less<>> topics_; // Topic -> reference (1-based)
+    std::chrono::steady_clock::time_point last_{};
+    size_t count_ = 0;
+};
+
+/**
+ * @brief An MQTT log loaded into memory, replayed at 1x, Nx or maximum speed
+ *
+ * Replay hands messages to a sink in batches of up to MQTTDriver::MAX_BATCH:
+ * everything already due when paced, full batches at maximum speed. The
+ * sink is typically MQTTDriver::ingestBatch() (in-process) or a loop over
+ * MQTTDriver::publish() (through a broker).
+ */
+class MqttReplay
+{
+public:
+    using Sink = std::function<void(const MQTTDriver::Message* messages, size_t count)>;
+
+    struct Result
+    {
+        size_t messages = 0;
+        size_t batches = 0;
+        double seconds = 0.0;           // Wall time of the replay
+        double messagesPerSecond = 0.0;
+        double maxLagMs = 0.0;          // Furthest behind schedule (paced replays)
+    };
+
+    /// Read and validate a whole log; false if it is missing or malformed
+    bool load(const std::string& path);
+
+    /// Messages in the log
+    size_t size() const { return entries_.size(); }
+
+    /// Time from the first message to the last, as recorded
+    std::chrono::nanoseconds duration() const;
+
+    std::string_view topic(size_t i) const { return topics_[entries_[i].topic]; }
+    std::string_view payload(size_t i) const;
+    std::chrono::nanoseconds offset(size_t i) const { return std::chrono::nanoseconds(entries_[i].offsetNs); }
+
+    /**
+     * @brief Feed every message to the sink, in order
+     * @param sink Receives each batch
+     * @param speed Recorded seconds per wall second; 0 (or less) replays as fast as the sink allows
+     * @param stop Optional flag that ends the replay early when set
+     */
+    Result replay(const Sink& sink, double speed = 1.0, const std::atomic<bool>* stop = nullptr) const;
+
+private:
+    struct Entry
+    {
+        uint64_t offsetNs;      // Since the first message
+        uint32_t topic;         // Index into topics_
+        uint32_t payloadLength;
+        size_t payloadOffset;   // Into data_
+    };
+
+    std::string data_;
+    std::vector<std::string> topics_;
+    std::vector<Entry> entries_;
+};
+
+#endif // MQTT_LOG_H
@@ -0,0 +1,95 @@
+#ifndef MQTT_PAYLOAD_H
+#define MQTT_PAYLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @file mqtt_payload.h
+ * @brief Allocation-free parsing of MQTT telemetry payloads into one value
+ *
+ * Every parser reads the payload in place and accepts it only if the whole
+ * payload is one finite value:
+ * - Text: a decimal number with optional surrounding whitespace and leading
+ *   '+', parsed with std::from_chars (locale-independent). Condition topics
+ *   also take true/false, on/off, yes/no in any case.
+ * - Float32: a raw IEEE-754 float (4 bytes) or double (8 bytes), little-endian
+ *   as the hub firmware writes them.
+ * - MessagePack: one scalar (int, uint, float 32/64, bool).
+ * - CBOR: one scalar (unsigned/negative int, half/single/double float, bool).
+ *
+ * Booleans read as 1 and 0. For boolish topics numbers map to 1 (non-zero) or 0.
+ *
+ * Aggregate payloads holding many values are read with parseJsonObject(),
+ * which also works in place.
+ */
+namespace MqttPayload
+{
+    enum class Format : uint8_t
+    {
+        Text,
+        Float32,
+        MessagePack,
+        Cbor
+    };
+
+    /// Decimal number, e.g. " 72.5\n"
+    bool parseNumber(std::string_view text, float& out);
+
+    /// Keyword (true/on/yes, false/off/no, any case) or number mapped to 1/0
+    bool parseBoolish(std::string_view text, float& out);
+
+    /// Little-endian float (4 bytes) or double (8 bytes)
+    bool parseRawFloat(std::string_view bytes, float& out);
+
+    /// One MessagePack scalar
+    bool parseMessagePack(std::string_view bytes, float& out);
+
+    /// One CBOR scalar
+    bool parseCbor(std::string_view bytes, float& out);
+
+    /**
+     * @brief Parse a payload in the given format
+     * @param boolish Map the value to 1/0 (and accept keywords for Text)
+     */
+    bool parse(Format format, std::string_view payload, bool boolish, float& out);
+
+    /// Longest flattened JSON key kept by parseJsonObject()
+    constexpr size_t MAX_JSON_KEY = 64;
+
+    /**
+     * @brief One scalar member of a JSON object
+     */
+    struct JsonMember
+    {
+        char key[MAX_JSON_KEY];
+        size_t keyLength;
+        std::string_view value; ///< Raw token: a number, true/false, or a string's contents (escapes kept)
+        bool isString;
+
+        std::string_view name() const { return std::string_view(key, keyLength); }
+    };
+
+    /**
+     * @brief Read the scalar members of a JSON object in one pass
+     *
+     * Members of nested objects are flattened with '/', so
+     * {"heart": {"heartRate": 72}} gives "heart/heartRate". Only two levels are
+     * flattened. Deeper objects, arrays and nulls are checked and skipped, as
+     * are keys longer than MAX_JSON_KEY or with non-ASCII escapes. Values
+     * point into json.
+     * @param json Payload; must be exactly one well-formed JSON object
+     * @param members Output array
+     * @param maxMembers Capacity of members; more scalar members is an error
+     * @param count Scalar members found
+     * @return false if the payload is malformed or has too many members
+     */
+    bool parseJsonObject(std::string_view json, JsonMember* members, size_t maxMembers, size_t& count);
+
+    /// "text", "float32", "msgpack" or "cbor"
+    bool formatFromName(std::string_view name, Format& out);
+    const char* formatName(Format format);
+}
+
+#endif // MQTT_PAYLOAD_H
@@ -0,0 +1,125 @@
+#ifndef MQTT_STATS_H
+#define MQTT_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "core/latency_histogram.h"
+
+/**
+ * @brief Lock-free MQTT ingestion counters with per-topic rates
+ *
+ * Each writing thread gets its own cache-line aligned block of counters, so
+ * counting is a plain load and store on a line no other thread writes: no
+ * locked instruction and no cache-line bouncing on the hot path. snapshot()
+ * sums the blocks. The first MAX_THREADS writers get a block of their own;
+ * further threads share one block and count with atomic adds.
+ *
+ * Topics are numbered by the owner (MQTTDriver uses its topic table order)
+ * and each gets a received and a parse-failure count.
+ */
+class MqttStats
+{
+public:
+    static constexpr size_t MAX_TOPICS = 32;
+    static constexpr size_t MAX_THREADS = 8;
+    static constexpr size_t CACHE_LINE = 64;
+
+    /// Shortest interval that per-topic rates are measured over
+    static constexpr std::chrono::milliseconds RATE_WINDOW{1000};
+
+    enum class Counter : uint8_t
+    {
+        Received = 0,   // Every message, known or not
+        UnknownTopic,   // Not a subscribed topic
+        ParseFailure,   // Known topic, invalid payload
+        BedFull,        // Bed topic dropped because the ward is full
+        Batch,          // Batches published
+        Connect,        // Successful connections
+        Reconnect,      // ... after the first
+        Disconnect,     // Connection lost or closed
+        Count
+    };
+    static constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::Count);
+
+    struct Snapshot
+    {
+        std::array<uint64_t, COUNTER_COUNT> counters{};
+        std::array<uint64_t, MAX_TOPICS> topicReceived{};
+        std::array<uint64_t, MAX_TOPICS> topicFailures{};
+
+        /// Messages per second over the latest rate window
+        double receivedRate = 0.0;
+        std::array<double, MAX_TOPICS> topicRates{};
+
+        /// Seconds since the stats were created
+        double uptimeSeconds = 0.0;
+
+        uint64_t count(Counter c) const { return counters[static_cast<size_t>(c)]; }
+    };
+
+    MqttStats();
+    MqttStats(const MqttStats&) = delete;
+    MqttStats& operator=(const MqttStats&) = delete;
+
+    void add(Counter c, uint64_t n = 1);
+
+    /// One message on a known topic; counts Received, and ParseFailure unless parsed
+    void topic(size_t topic, bool parsed);
+
+    /// Receive-to-publish latency, one sample per published batch
+    void recordPublish(std::chrono::nanoseconds latency) { publishLatency_.record(latency); }
+    const LatencyHistogram& publishLatency() const { return publishLatency_; }
+
+    /**
+     * @brief Sum of every thread's counters (any thread)
+     *
+     * Rates are computed over the interval between reads, once it is at
+     * least RATE_WINDOW long; reads in between return the latest rates.
+     */
+    Snapshot snapshot() const;
+
+private:
+    struct alignas(CACHE_LINE) Block
+    {
+        std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+        std::array<std::atomic<uint64_t>, MAX_TOPICS> topicReceived{};
+        std::array<std::atomic<uint64_t>, MAX_TOPICS> topicFailures{};
+    };
+
+    // Calling thread's block; shared is set for the overflow block
+    Block& local(bool& shared);
+
+    static void bump(std::atomic<uint64_t>& counter, uint64_t n, bool shared)
+    {
+        if (shared)
+        {
+            counter.fetch_add(n, std::memory_order_relaxed);
+        }
+        else
+        {
+            // Single writer: no read-modify-write needed
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    }
+
+    const uint64_t id_;  // Tells thread-local caches apart from other instances
+    const std::chrono::steady_clock::time_point created_;
+    std::array<std::atomic<std::thread::id>, MAX_THREADS> owners_{};
+    std::array<Block, MAX_THREADS + 1> blocks_;  // The last one is shared
+    LatencyHistogram publishLatency_;
+
+    // Rate window, only touched by readers
+    mutable std::mutex rateMutex_;
+    mutable std::chrono::steady_clock::time_point windowStart_;
+    mutable Snapshot windowTotals_;
+    mutable double receivedRate_ = 0.0;
+    mutable std::array<double, MAX_TOPICS> topicRates_{};
+    mutable bool windowDone_ = false;
+};
+
+#endif // MQTT_STATS_H
@@ -0,0 +1,141 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+/**
+ * @brief Sequence lock for small, trivially copyable values
+ *
+ * Readers never take a lock: they copy the value and retry only if a write
+ * overlapped the copy, so a read is a handful of loads in the common case
+ * and always returns a consistent (never torn) value. Writers are serialized
+ * by a tiny spin flag held only for the duration of the copy-in; they never
+ * wait on readers.
+ *
+ * The payload is kept as relaxed atomic words so concurrent reads and writes
+ * are well-defined under the C++ memory model.
+ */
+template <typename T>
+class Seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock requires a trivially copyable type");
+
+public:
+    Seqlock() { store(T{}); }
+    explicit Seqlock(const T& initial) { store(initial); }
+
+    Seqlock(const Seqlock&) = delete;
+    Seqlock& operator=(const Seqlock&) = delete;
+
+    /**
+     * @brief Read a consistent copy of the value (lock-free, never blocks writers)
+     */
+    T load() const
+    {
+        T out;
+        for (;;)
+        {
+            const uint64_t before = seq_.load(std::memory_order_acquire);
+            if (before & 1u)
+            {
+                cpuRelax();
+                continue;
+            }
+            copyOut(out);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == before)
+            {
+                return out;
+            }
+        }
+    }
+
+    /**
+     * @brief Replace the whole value
+     */
+    void store(const T& value)
+    {
+        lockWriters();
+        publish(value);
+        unlockWriters();
+    }
+
+    /**
+     * @brief Read-modify-write under the writer flag
+     * @param fn Callable taking T& that edits the current value in place
+     */
+    template <typename Fn>
+    void update(Fn&& fn)
+    {
+        lockWriters();
+        T value;
+        copyOut(value); // Writers are exclusive, so no retry is needed
+        fn(value);
+        publish(value);
+        unlockWriters();
+    }
+
+    /**
+     * @brief Number of completed writes (useful for change detection)
+     */
+    uint64_t version() const { return seq_.load(std::memory_order_acquire) >> 1; }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    static void cpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    void lockWriters()
+    {
+        while (writer_.test_and_set(std::memory_order_acquire))
+        {
+            cpuRelax();
+        }
+    }
+
+    void unlockWriters() { writer_.clear(std::memory_order_release); }
+
+    void copyOut(T& out) const
+    {
+        uint64_t buf[WORDS];
+        for (size_t i = 0; i < WORDS; ++i)
+        {
+            buf[i] = words_[i].load(std::memory_order_relaxed);
+        }
+        std::memcpy(&out, buf, sizeof(T));
+    }
+
+    void publish(const T& value)
+    {
+        uint64_t buf[WORDS] = {};
+        std::memcpy(buf, &value, sizeof(T));
+
+        const uint64_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i)
+        {
+            words_[i].store(buf[i], std::memory_order_relaxed);
+        }
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    alignas(64) std::atomic<uint64_t> seq_{0};
+    std::atomic_flag writer_ = ATOMIC_FLAG_INIT;
+    std::atomic<uint64_t> words_[WORDS];
+};
+
+#endif // SEQLOCK_H
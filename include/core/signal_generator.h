@@ -1,8 +1,16 @@
 #ifndef SIGNAL_GENERATOR_H
 #define SIGNAL_GENERATOR_H
 
+#include <atomic>
 #include <cmath>
-#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "core/seqlock.h"
+#include "core/sim_clock.h"
+#include "core/waveform_kernels.h"
+
+class SensorDataStore;
 
 /**
  * @brief Signal generator for medical waveforms (ECG, SpO2, Respiratory)
@@ -12,7 +20,12 @@
  * web server implementations.
  * 
  * Uses wall-clock time to ensure all client connections see synchronized
- * waveforms, preventing speed-up when multiple tabs are open.
+ * waveforms, preventing speed-up when multiple tabs are open. The time
+ * source is a SimClock, so it can also run scaled or in fixed steps.
+ * 
+ * Heart rate, respiratory rate, SpO2 and blood pressure follow the current
+ * Physiology, which may be changed from any thread while samples are being
+ * generated. Samples themselves must be generated from a single thread.
  * 
  * NOTE: This is a placeholder for real hardware integration. Replace the
  * generate() methods with actual sensor readings when connecting to hardware.
@@ -33,14 +46,69 @@ public:
         double timestamp;     // Current time in seconds
     };
 
+    /**
+     * @brief Patient state the waveforms follow
+     */
+    struct Physiology
+    {
+        double heartRateBpm = 75.0;  // ECG and pleth beat rate
+        double respRateBpm = 18.0;   // Breaths per minute
+        double spo2 = 97.5;          // SpO2 baseline (%)
+        double bpSystolic = 120.0;   // Systolic baseline (mmHg)
+        double bpDiastolic = 80.0;   // Diastolic baseline (mmHg)
+    };
+
     SignalGenerator();
 
+    /**
+     * @brief Change the patient state (any thread, lock-free)
+     *
+     * Values are clamped to plausible ranges; non-finite values keep the
+     * default. Generation picks the change up at its next sample with a
+     * single atomic load, and rate changes keep the waveform phase
+     * continuous: a beat in progress carries on at the new rate.
+     */
+    void setPhysiology(const Physiology& physiology);
+
+    /**
+     * @brief Current patient state (after clamping)
+     */
+    Physiology physiology() const;
+
     /**
      * @brief Generate sensor data at the current time point
      * @return SensorData struct containing all waveform values
      */
     SensorData generate();
 
+    /**
+     * @brief Generate one sample at an explicit time
+     *
+     * Evaluates each waveform directly (std::exp, std::sin); the reference
+     * that generateBlock() is checked against.
+     * @param time Seconds since start
+     */
+    SensorData generateAt(double time);
+
+    /**
+     * @brief Generate a block of samples at explicit times
+     *
+     * Sample i is taken at t0 + i * dt (seconds since start, the same
+     * timeline as generate()). Externally supplied values are read once for
+     * the whole block.
+     *
+     * ECG and pleth are played back from the beat templates
+     * (waveform_template.h) and the rest from the vectorized kernels
+     * (waveform_kernels.h); results agree with generateAt() to within 1e-3
+     * at a fraction of its cost per sample.
+     *
+     * @param t0 Time of the first sample
+     * @param dt Sample interval (e.g. 0.004 for 250 Hz)
+     * @param n Number of samples
+     * @param out Destination, at least n entries
+     */
+    void generateBlock(double t0, double dt, size_t n, SensorData* out);
+
     /**
      * @brief Advance time by delta seconds (deprecated - now uses wall-clock time)
      * @param dt Time delta in seconds (e.g., 0.05 for 20Hz updates)
@@ -48,7 +116,7 @@ public:
     void tick(double dt);
 
     /**
-     * @brief Reset time to zero
+     * @brief Reset time to zero (resets the clock, which may be shared)
      */
     void reset();
 
@@ -58,7 +126,40 @@ public:
      */
     double getTime() const;
 
+    /**
+     * @brief Use another time source (default: a SimClock::real() of its own)
+     *
+     * Call before generating; the clock is not swapped atomically.
+     */
+    void setClock(std::shared_ptr<SimClock> clock);
+
+    const std::shared_ptr<SimClock>& clock() const { return clock_; }
+
+    /**
+     * @brief Take live ECG and SpO2 from this store (default: SensorDataStore::instance())
+     *
+     * A per-bed generator should read its bed's store, so one patient's
+     * hardware or MQTT values never show on another's waveforms. The store
+     * must outlive the generator; call before generating.
+     */
+    void setStore(const SensorDataStore& store);
+
 private:
+    // Externally supplied values (SensorDataStore) that replace synthesized ones
+    struct LiveValues
+    {
+        bool hasEcg = false;
+        double ecg = 0.0;
+        bool hasSpo2 = false;
+        double spo2 = 0.0;
+    };
+
+    LiveValues readLiveValues() const;
+    SensorData sampleAt(double time, const LiveValues& live) const;
+
+    // Retune the oscillators at `time` if the physiology changed
+    void applyPhysiology(double time);
+
     // Waveform generation parameters (optimized for realistic medical signals)
     struct WaveformParams
     {
@@ -68,12 +169,24 @@ private:
         double spO2Freq = 1.2;           // SpO2 frequency (Hz) - ~72 BPM
         double spO2Base = 0.55;          // SpO2 baseline offset
         double spO2Amplitude = 0.4;      // SpO2 oscillation amplitude
-        double respFreq = 0.3;           // Respiratory frequency (Hz) - ~18 breaths/min
         double respAmplitude = 0.6;      // Respiratory amplitude
     } params_;
 
-    // Wall-clock start time for synchronized signal generation
-    std::chrono::steady_clock::time_point startTime_;
+    // Time source for synchronized signal generation
+    std::shared_ptr<SimClock> clock_;
+
+    // Where live values come from
+    const SensorDataStore* store_;
+
+    // Published by setPhysiology(); the version tells the generating thread to reload
+    Seqlock<Physiology> physiology_;
+    std::atomic<uint64_t> physiologyVersion_{0};
+
+    // Generating thread only
+    uint64_t appliedVersion_ = 0;
+    Physiology active_;
+    WaveformKernels::Oscillator beat_;
+    WaveformKernels::Oscillator breath_;
 };
 
 #endif // SIGNAL_GENERATOR_H
@@ -0,0 +1,70 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief Time source for the simulated signals, in seconds since start
+ *
+ * Shared by SignalGenerator, the I2C mock and the web streamer so they all
+ * agree on "now":
+ * - Real: wall-clock (steady) time, the default;
+ * - Scaled: wall-clock time multiplied by a speed factor, for running
+ *   faster (or slower) than real time;
+ * - FixedStep: time only moves when the owner calls tick(), by a fixed step
+ *   each time, so a run is exactly reproducible and as fast as the CPU.
+ *
+ * All members are safe to call from any thread.
+ */
+class SimClock
+{
+public:
+    enum class Mode
+    {
+        Real,
+        Scaled,
+        FixedStep
+    };
+
+    /// Wall-clock time since construction
+    static std::shared_ptr<SimClock> real();
+
+    /// Wall-clock time since construction times speed (> 0)
+    static std::shared_ptr<SimClock> scaled(double speed);
+
+    /// Starts at 0 and advances by stepSeconds (> 0) per tick()
+    static std::shared_ptr<SimClock> fixedStep(double stepSeconds);
+
+    /// Current simulated time in seconds
+    double now() const;
+
+    /// Advance a FixedStep clock by steps (no effect in other modes)
+    void tick(uint64_t steps = 1);
+
+    /// Restart from zero
+    void reset();
+
+    Mode mode() const { return mode_; }
+
+    /// Simulated seconds per wall-clock second (1 for Real and FixedStep)
+    double speed() const { return speed_; }
+
+    /// Seconds per tick() (0 unless FixedStep)
+    double step() const { return step_; }
+
+private:
+    SimClock(Mode mode, double speed, double step);
+
+    static int64_t wallNanos();
+
+    const Mode mode_;
+    const double speed_;
+    const double step_;
+    std::atomic<int64_t> startNanos_; // Real and Scaled
+    std::atomic<uint64_t> steps_{0};  // FixedStep
+};
+
+#endif // SIM_CLOCK_H
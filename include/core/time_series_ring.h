@@ -0,0 +1,99 @@
+#ifndef TIME_SERIES_RING_H
+#define TIME_SERIES_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief One timestamped sample in a channel's history
+ */
+struct TimeSample
+{
+    double t; ///< Stream time in seconds
+    double v; ///< Sample value
+};
+
+/**
+ * @brief Fixed-capacity, single-writer time-series ring buffer
+ *
+ * Storage is allocated once at construction (cache-line aligned); push()
+ * never allocates and never blocks. Any number of readers may query a time
+ * range concurrently with the writer: they copy the slots and then discard
+ * any that the writer may have overwritten during the copy, so results are
+ * always consistent and ordered by time.
+ *
+ * Timestamps pushed by the writer must be non-decreasing.
+ */
+class TimeSeriesRing
+{
+public:
+    /**
+     * @param capacity Number of samples retained (oldest are overwritten)
+     */
+    explicit TimeSeriesRing(size_t capacity);
+
+    TimeSeriesRing(const TimeSeriesRing&) = delete;
+    TimeSeriesRing& operator=(const TimeSeriesRing&) = delete;
+
+    /**
+     * @brief Append a sample (single writer only; allocation-free)
+     */
+    void push(double t, double v)
+    {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[head % capacity_];
+        // Announce the overwrite before touching the slot so racing readers can detect it
+        claim_.store(head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.t.store(t, std::memory_order_relaxed);
+        slot.v.store(v, std::memory_order_relaxed);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy samples with from <= t <= to into out (appended, time ordered)
+     * @param maxSamples Upper bound on samples appended (0 = unlimited)
+     * @return Number of samples appended
+     */
+    size_t readRange(double from, double to, std::vector<TimeSample>& out,
+                     size_t maxSamples = 0) const;
+
+    /**
+     * @brief Most recent sample, if any
+     * @return false if the ring is empty
+     */
+    bool latest(TimeSample& out) const;
+
+    /// Number of samples currently retained
+    size_t size() const;
+
+    /// Maximum number of samples retained
+    size_t capacity() const { return capacity_; }
+
+    /// Total samples ever pushed
+    uint64_t totalPushed() const { return head_.load(std::memory_order_acquire); }
+
+private:
+    struct Slot
+    {
+        std::atomic<double> t{0.0};
+        std::atomic<double> v{0.0};
+    };
+
+    struct AlignedDelete
+    {
+        void operator()(Slot* p) const;
+    };
+
+    uint64_t lowerBound(uint64_t lo, uint64_t hi, double from) const;
+
+    const size_t capacity_;
+    std::unique_ptr<Slot[], AlignedDelete> slots_; // 64-byte aligned block
+    alignas(64) std::atomic<uint64_t> head_{0};    // Samples fully written
+    std::atomic<uint64_t> claim_{0};               // Samples started (head_ or head_ + 1)
+};
+
+#endif // TIME_SERIES_RING_H
@@ -0,0 +1,91 @@
+#ifndef WAVEFORM_KERNELS_H
+#define WAVEFORM_KERNELS_H
+
+#include <cmath>
+#include <cstddef>
+
+/**
+ * @file waveform_kernels.h
+ * @brief Branchless, vectorizable kernels for block waveform synthesis
+ *
+ * Each kernel fills an array of n samples from an array of sample times.
+ * sin is replaced by a polynomial approximation, so the loops have no
+ * data-dependent branches or library calls and the compiler can vectorize
+ * them (SSE/AVX2/AVX-512 on x86, NEON on ARM; see simdTarget()). On targets
+ * without vector units the same loops run as plain scalar code. Beat shapes
+ * (ECG, pleth) come from WaveformTemplate tables instead.
+ *
+ * Results match SignalGenerator's scalar path to within about 1e-9.
+ */
+namespace WaveformKernels
+{
+    /// Samples per kernel call in SignalGenerator::generateBlock() (stack arrays)
+    constexpr size_t CHUNK = 64;
+
+    /**
+     * @brief sin(2 pi cycles), absolute error below 1e-9
+     *
+     * Taking cycles rather than radians keeps the range reduction exact for
+     * the f * t arguments the generator uses.
+     */
+    inline double fastSinCycles(double cycles)
+    {
+        double c = cycles - std::floor(cycles + 0.5);  // [-0.5, 0.5)
+        c = c > 0.25 ? 0.5 - c : c;                    // sin(pi - x) = sin(x)
+        c = c < -0.25 ? -0.5 - c : c;
+        const double x = 6.283185307179586 * c;        // [-pi/2, pi/2]
+        const double x2 = x * x;
+        double p = 1.0 / 6227020800.0;
+        p = p * x2 - 1.0 / 39916800.0;
+        p = p * x2 + 1.0 / 362880.0;
+        p = p * x2 - 1.0 / 5040.0;
+        p = p * x2 + 1.0 / 120.0;
+        p = p * x2 - 1.0 / 6.0;
+        p = p * x2 + 1.0;
+        return p * x;
+    }
+
+    /**
+     * @brief Free-running oscillator whose rate can change without a phase jump
+     *
+     * Cycles completed by time t are anchorCycles + (t - anchorTime) * hz;
+     * retune() moves the anchor to the moment of the change.
+     */
+    struct Oscillator
+    {
+        double hz = 1.0;
+        double anchorTime = 0.0;
+        double anchorCycles = 0.0;
+
+        double cyclesAt(double t) const { return anchorCycles + (t - anchorTime) * hz; }
+
+        /// Switch to newHz at time t, continuing from the phase reached there
+        void retune(double t, double newHz)
+        {
+            const double cycles = cyclesAt(t);
+            anchorCycles = cycles - std::floor(cycles);
+            anchorTime = t;
+            hz = newHz;
+        }
+    };
+
+    /**
+     * @brief Position within the cycle at each time, in [0, 1)
+     */
+    void phase(const Oscillator& osc, const double* t, size_t n, double* out);
+
+    /**
+     * @brief sin(2 pi phase)
+     */
+    void phaseSine(const double* phase, size_t n, double* out);
+
+    /**
+     * @brief sin(2 pi freqHz t)
+     */
+    void sine(const double* t, size_t n, double freqHz, double* out);
+
+    /// Instruction set the kernels were compiled for ("AVX2", "NEON", ..., "scalar")
+    const char* simdTarget();
+}
+
+#endif // WAVEFORM_KERNELS_H
@@ -0,0 +1,90 @@
+#ifndef WAVEFORM_TEMPLATE_H
+#define WAVEFORM_TEMPLATE_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @file waveform_template.h
+ * @brief One beat of a waveform, rendered once and played back from a table
+ *
+ * A template samples a beat shape (a function of phase in [0, 1)) into
+ * equal cells when it is built; playback is a multiply, a table load and a
+ * linear interpolation, so it is independent of how expensive the shape is
+ * and of the heart rate (the caller maps time to phase).
+ *
+ * Each cell stores its own start value and slope, both sampled from just
+ * inside the cell. A step in the shape that falls on a cell
+ * edge is therefore reproduced exactly rather than smeared across a cell;
+ * DEFAULT_CELLS puts an edge on every multiple of 0.01 in phase, where the
+ * built-in shapes have their segment boundaries.
+ */
+class WaveformTemplate
+{
+public:
+    using Shape = double (*)(double phase);
+
+    static constexpr size_t DEFAULT_CELLS = 4000;
+
+    /**
+     * @brief Render a shape
+     * @param shape Beat shape, evaluated on both sides of every cell edge
+     * @param cells Table resolution (interpolation error falls with its square)
+     */
+    explicit WaveformTemplate(Shape shape, size_t cells = DEFAULT_CELLS);
+
+    /**
+     * @brief Value at a beat phase
+     * @param phase Position within the beat, [0, 1) (clamped)
+     */
+    double at(double phase) const
+    {
+        double x = phase * scale_;
+        x = x > 0.0 ? x : 0.0;
+        x = x < scale_ ? x : scale_;
+        size_t i = static_cast<size_t>(x);
+        i = i < last_ ? i : last_;
+        const Cell& c = cells_[i];
+        return c.value + c.slope * (x - static_cast<double>(i));
+    }
+
+    /// at() for n phases
+    void render(const double* phase, size_t n, double* out) const;
+
+    size_t cells() const { return cells_.size(); }
+
+private:
+    struct Cell
+    {
+        float value; ///< Value at the start of the cell
+        float slope; ///< Change across the cell
+    };
+
+    std::vector<Cell> cells_;
+    double scale_;
+    size_t last_;
+};
+
+/**
+ * @brief Beat shapes used by the simulators, and their shared templates
+ *
+ * Templates are built on first use (thread-safe) and shared by every
+ * SignalGenerator and the I2C mock.
+ */
+namespace BeatTemplates
+{
+    /// SignalGenerator ECG: P 0-0.15, QRS 0.20-0.30, T 0.40-0.70 (unscaled)
+    double ecgShape(double phase);
+
+    /// I2C mock ECG: narrower P wave (0-0.1) and a rounded S wave (unscaled)
+    double mockEcgShape(double phase);
+
+    /// Pleth pulse: upstroke 0-0.3, dicrotic notch 0.3-0.5, diastolic decay
+    double plethShape(double phase);
+
+    const WaveformTemplate& ecg();
+    const WaveformTemplate& mockEcg();
+    const WaveformTemplate& pleth();
+}
+
+#endif // WAVEFORM_TEMPLATE_H
@@ -0,0 +1,145 @@
+#ifndef HUB_EMULATOR_H
+#define HUB_EMULATOR_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include "hardware/i2c_bus.h"
+#include "hardware/i2c_protocol.h"
+
+/**
+ * @brief SAMD21 SensorHub emulated on the host, as an I2CBus
+ *
+ * Answers the hub protocol the way firmware/sensor_hub/sensor_hub.ino does,
+ * so I2CDriver can be run without hardware:
+ * - Answers are ready a configurable latency after a command's last byte.
+ *   A plain read before then gets the previous answer. In a combined
+ *   transaction the hub stretches the clock until the answer is ready,
+ *   unless stretching is turned off.
+ * - Bytes take real time at the configured bus speed (busy-waited, so the
+ *   timing holds at microsecond scale).
+ * - READ_ALL frames are built by sample() into the back half of a double
+ *   buffer and then flipped to the front, which the hub serves.
+ * - Waveform samples queued with pushFifo() are served by READ_FIFO and
+ *   counted by FIFO_LEVEL; a full FIFO drops new samples, as the hub does.
+ *
+ * All members are safe to call from any thread.
+ */
+class HubEmulator : public I2CBus
+{
+public:
+    struct Timing
+    {
+        std::chrono::nanoseconds byteTime{0};   ///< One byte plus ACK on the bus
+        std::chrono::nanoseconds latency{0};    ///< Command received to answer ready
+    };
+
+    /// Timing of a bus at clockHz (9 clocks per byte)
+    static Timing atClock(uint32_t clockHz, std::chrono::nanoseconds latency);
+
+    /// Instant bus; every sensor attached, reading 0
+    HubEmulator();
+
+    explicit HubEmulator(const Timing& timing);
+
+    void setTiming(const Timing& timing);
+
+    /// Whether the adapter supports combined (I2C_RDWR) transactions
+    void setCombined(bool combined);
+
+    /// Whether the hub holds SCL in a combined transaction until it has answered
+    void setStretches(bool stretches);
+
+    /// Whether the hub ACKs its address at all
+    void setPresent(bool present);
+
+    /// Attach a sensor with this reading (takes effect in the next sample())
+    void setSensor(SensorId id, float value);
+
+    /// Detach a sensor (takes effect in the next sample())
+    void removeSensor(SensorId id);
+
+    /**
+     * @brief Take a sample: build the next READ_ALL frame and publish it
+     * @return Sequence number of the published frame
+     */
+    uint8_t sample();
+
+    /// Flip one bit of the next READ_ALL or READ_FIFO answer (to exercise the CRC)
+    void corruptNextFrame();
+
+    /**
+     * @brief Queue a waveform sample, as the hub's sampling loop does
+     * @return false if the FIFO is full (the sample is dropped)
+     */
+    bool pushFifo(SensorId channel, uint32_t timestampUs, float value);
+
+    /// Samples queued in the FIFO
+    size_t fifoLevel() const;
+
+    /// SensorStatusBits of the attached sensors
+    uint8_t presence() const;
+
+    size_t transfers() const;   ///< Combined transactions served
+    size_t staleReads() const;  ///< Reads that came before the answer was ready
+
+    // I2CBus
+    bool setAddress(uint8_t address) override;
+    bool write(const uint8_t* data, size_t length) override;
+    bool read(uint8_t* data, size_t length) override;
+    bool transfer(Segment* segments, size_t count) override;
+
+private:
+    static constexpr size_t MAX_ANSWER = readFifoFrameLength(READ_FIFO_MAX_SAMPLES);
+
+    struct Frame
+    {
+        uint8_t bytes[READ_ALL_MAX_LENGTH];
+        size_t length;
+    };
+
+    struct FifoEntry
+    {
+        SensorId channel;
+        uint32_t timestampUs;
+        float value;
+    };
+
+    /// Bus time for an address byte plus bytes
+    void busTime_(size_t bytes) const;
+
+    // Caller holds mutex_
+    bool acked_() const;
+    void command_(const uint8_t* data, size_t length);
+    void readFifo_(size_t requested);
+    void respond_(uint8_t* data, size_t length);
+
+    mutable std::mutex mutex_;
+    Timing timing_;
+    bool combined_ = true;
+    bool stretches_ = true;
+    bool present_ = true;
+    uint8_t address_ = 0;
+
+    uint8_t presence_ = 0;                       // SensorStatusBits
+    float values_[READ_ALL_SENSOR_COUNT] = {};   // By SensorId
+    Frame frames_[2] = {};                       // READ_ALL double buffer
+    size_t front_ = 0;
+    uint8_t sequence_ = 0;
+    bool corruptNext_ = false;
+    std::deque<FifoEntry> fifo_;
+    size_t fifoDropped_ = 0;                     // Since the last FIFO_LEVEL
+
+    uint8_t answer_[MAX_ANSWER] = {};            // Response buffer served to reads
+    size_t answerLength_ = 0;
+    uint8_t pending_[MAX_ANSWER] = {};           // Next answer, once ready
+    size_t pendingLength_ = 0;
+    std::chrono::steady_clock::time_point readyAt_{};
+
+    size_t transfers_ = 0;
+    size_t staleReads_ = 0;
+};
+
+#endif // HUB_EMULATOR_H
@@ -0,0 +1,79 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Raw I²C transport used by I2CDriver
+ *
+ * The Linux implementation talks to /dev/i2c-*; tests and benchmarks supply
+ * their own (e.g. a simulated hub with bus timing).
+ */
+class I2CBus
+{
+public:
+    /// One segment of a combined transaction
+    struct Segment
+    {
+        uint8_t address;   ///< 7-bit address
+        bool read;         ///< true: read into data, false: write from data
+        uint8_t* data;
+        size_t length;
+    };
+
+    virtual ~I2CBus() = default;
+
+    /// Select the slave for write() and read()
+    virtual bool setAddress(uint8_t address) = 0;
+
+    /// Plain write to the selected slave (START, bytes, STOP)
+    virtual bool write(const uint8_t* data, size_t length) = 0;
+
+    /// Plain read from the selected slave (START, bytes, STOP)
+    virtual bool read(uint8_t* data, size_t length) = 0;
+
+    /**
+     * @brief Run segments as one transaction, joined by repeated starts
+     *
+     * The bus is held from the first START to the final STOP, so no other
+     * master can slip in between a command and its response.
+     */
+    virtual bool transfer(Segment* segments, size_t count) = 0;
+};
+
+/**
+ * @brief I2CBus on a Linux i2c-dev device
+ *
+ * transfer() is one ioctl(I2C_RDWR). The slave address set through
+ * setAddress() is cached, so repeated selects of the same device cost no
+ * system call.
+ */
+class LinuxI2CBus : public I2CBus
+{
+public:
+    explicit LinuxI2CBus(int bus);
+    ~LinuxI2CBus() override;
+
+    LinuxI2CBus(const LinuxI2CBus&) = delete;
+    LinuxI2CBus& operator=(const LinuxI2CBus&) = delete;
+
+    /// Open /dev/i2c-<bus>
+    bool open();
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+
+    bool setAddress(uint8_t address) override;
+    bool write(const uint8_t* data, size_t length) override;
+    bool read(uint8_t* data, size_t length) override;
+    bool transfer(Segment* segments, size_t count) override;
+
+private:
+    static constexpr int NO_ADDRESS = -1;
+
+    int bus_;
+    int fd_ = -1;
+    int address_ = NO_ADDRESS; // Slave selected with I2C_SLAVE, or NO_ADDRESS
+};
+
+#endif // I2C_BUS_H
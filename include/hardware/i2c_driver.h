@@ -2,7 +2,12 @@
 #define I2C_DRIVER_H
 
 #include <string>
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include "core/latency_histogram.h"
+#include "core/sim_clock.h"
+#include "hardware/i2c_bus.h"
 #include "hardware/i2c_protocol.h"
 
 /**
@@ -14,16 +19,63 @@
  * 
  * Supports both real hardware (Linux I²C via /dev/i2c-*) and mock mode
  * for development/testing without physical hardware.
+ *
+ * Each hub command is one transaction: the command is written and the
+ * response read back without a STOP in between (I2C_RDWR with a repeated
+ * start), the hub stretching the clock until its answer is ready. For
+ * adapters or firmware that cannot do that, a non-zero turnaround splits
+ * the two halves and waits that long between them; measureTurnaround()
+ * finds the shortest setting the hub answers reliably at.
  */
 class I2CDriver
 {
 public:
+    /// One READ_ALL answer, unpacked
+    struct HubFrame
+    {
+        uint8_t sequence = 0;  ///< Hub sample number (wraps at 256)
+        uint8_t present = 0;   ///< SensorStatusBits of the sensors carried
+        float values[READ_ALL_SENSOR_COUNT] = {}; ///< Indexed by SensorId; 0 when absent
+
+        bool has(SensorId id) const;
+        float value(SensorId id) const { return values[static_cast<size_t>(id)]; }
+    };
+
+    /// One waveform sample from the hub FIFO
+    struct FifoSample
+    {
+        SensorId channel;
+        uint32_t timestampUs;  ///< Hub clock when sampled (wraps every ~71 minutes)
+        float value;
+    };
+
+    /// One READ_FIFO answer
+    struct FifoBatch
+    {
+        size_t count = 0;
+        uint16_t level = 0;    ///< Samples still queued on the hub
+        FifoSample samples[READ_FIFO_MAX_SAMPLES];
+    };
+
+    /// FIFO_LEVEL answer
+    struct FifoStatus
+    {
+        uint16_t level = 0;    ///< Samples queued
+        uint16_t dropped = 0;  ///< Samples lost to a full FIFO since the last query
+    };
+
     /**
      * @brief Construct I²C driver
      * @param bus I²C bus number (default: 1 for Pi 400 GPIO 2/3)
      * @param mockMode Enable mock mode for testing without hardware
      */
     explicit I2CDriver(int bus = 1, bool mockMode = false);
+
+    /**
+     * @brief Construct on an existing transport (e.g. a simulated hub)
+     * @param bus Transport to use; the driver is open from the start
+     */
+    explicit I2CDriver(std::unique_ptr<I2CBus> bus);
     
     ~I2CDriver();
 
@@ -42,7 +94,42 @@ public:
      * @brief Check if I²C bus is open
      * @return true if open
      */
-    bool isOpen() const { return fd_ >= 0 || mockMode_; }
+    bool isOpen() const { return bus_ != nullptr || mockMode_; }
+
+    /**
+     * @brief Time source for mock waveforms (default: a SimClock::real() of its own)
+     *
+     * Mock values are a function of this clock's time, so two drivers on the
+     * same fixed-step clock produce identical readings.
+     */
+    void setClock(std::shared_ptr<SimClock> clock);
+
+    /**
+     * @brief Wait between writing a command and reading its response
+     *
+     * Zero (the default) sends both in one combined transaction. Anything
+     * else uses a separate write and read with this gap in between.
+     */
+    void setTurnaround(std::chrono::microseconds turnaround) { turnaround_ = turnaround; }
+
+    std::chrono::microseconds turnaround() const { return turnaround_; }
+
+    /**
+     * @brief Find the shortest turnaround the hub answers PING at
+     *
+     * Tries a combined transaction first, then split ones with doubling gaps
+     * up to limit. Each candidate must succeed MAX_RETRIES times in a row.
+     * On success the turnaround is set to the gap found (doubled for a
+     * split gap, as headroom) and transactionLatency() restarts, so it only
+     * covers real traffic.
+     *
+     * @param limit Longest gap to try
+     * @return true if the hub answered (always true in mock mode)
+     */
+    bool measureTurnaround(std::chrono::microseconds limit = std::chrono::milliseconds(20));
+
+    /// Duration of each command transaction, write through response
+    const LatencyHistogram& transactionLatency() const { return transactionLatency_; }
 
     // ========================================================================
     // Hub Protocol Commands
@@ -58,7 +145,8 @@ public:
      * @brief Read sensor value from hub
      * @param sensorId Sensor identifier
      * @param value Output float value
-     * @return true if successful
+     * @return true if the hub answered with a finite value (its 0xFF error
+     *         bytes read as NaN and are rejected)
      */
     bool readSensor(SensorId sensorId, float& value);
 
@@ -75,6 +163,56 @@ public:
      */
     bool getSensorStatus(uint8_t* statusBuffer);
 
+    /**
+     * @brief Read every attached sensor in one transaction (READ_ALL)
+     *
+     * The read is sized for the presence mask of the previous frame; if the
+     * mask has grown, or the frame fails its CRC, it is repeated once at
+     * full length.
+     *
+     * @param frame Output frame
+     * @return true if a valid frame was read
+     */
+    bool readAll(HubFrame& frame);
+
+    /**
+     * @brief Unpack a READ_ALL frame
+     * @param data Bytes read from the hub (may include trailing padding)
+     * @param length Number of bytes read
+     * @param frame Output frame
+     * @return false if the frame is truncated, has unknown mask bits or fails its CRC
+     */
+    static bool parseHubFrame(const uint8_t* data, size_t length, HubFrame& frame);
+
+    /**
+     * @brief Take up to maxSamples waveform samples from the hub FIFO (READ_FIFO)
+     *
+     * The read is sized for maxSamples, so ask for what fifoLevel() reported
+     * rather than always the maximum. Samples are removed from the hub as
+     * they are sent, so a frame that fails its CRC is lost (and counted in
+     * frameErrors()).
+     *
+     * @param batch Output samples, oldest first, and the level left behind
+     * @param maxSamples At most READ_FIFO_MAX_SAMPLES
+     * @return true if a valid frame was read
+     */
+    bool readFifo(FifoBatch& batch, size_t maxSamples = READ_FIFO_MAX_SAMPLES);
+
+    /**
+     * @brief How many samples the hub FIFO holds (FIFO_LEVEL)
+     * @return true if a valid answer was read
+     */
+    bool fifoLevel(FifoStatus& status);
+
+    /**
+     * @brief Unpack a READ_FIFO frame
+     * @return false if the frame is truncated, has an unknown channel or fails its CRC
+     */
+    static bool parseFifoFrame(const uint8_t* data, size_t length, FifoBatch& batch);
+
+    /// READ_ALL, READ_FIFO and FIFO_LEVEL answers that failed their length or CRC check
+    uint64_t frameErrors() const { return frameErrors_; }
+
     // ========================================================================
     // Low-Level I²C Operations (for internal use)
     // ========================================================================
@@ -121,13 +259,38 @@ public:
     bool readBytes(uint8_t address, uint8_t* buffer, size_t length);
 
 private:
-    int bus_;           // I²C bus number
-    int fd_;            // File descriptor for I²C device
+    /**
+     * @brief Write a command and read its response
+     * @return true if both halves completed
+     */
+    bool transact(uint8_t address, const uint8_t* command, size_t commandLength,
+                  uint8_t* response, size_t responseLength);
+
+    /// One turnaround probe: a fresh PING answer at this gap
+    bool probeTurnaround(std::chrono::microseconds gap, std::chrono::microseconds limit);
+
+    int busNumber_;     // I²C bus number
+    std::unique_ptr<I2CBus> bus_;  // Null until opened (or in mock mode)
+    LinuxI2CBus* device_ = nullptr; // bus_, when open() created it
     bool mockMode_;     // Mock mode flag
+    std::shared_ptr<SimClock> clock_; // Mock waveform time
+    std::chrono::microseconds turnaround_{0}; // 0 = combined transaction
+    LatencyHistogram transactionLatency_;
+    size_t readAllLength_ = READ_ALL_MAX_LENGTH; // Frame length for the last mask seen
+    uint64_t frameErrors_ = 0;
+
+    uint8_t mockSequence_ = 0;
+    double mockFifoStart_ = 0.0;     // Clock time of each mock FIFO channel's first sample
+    uint64_t mockFifoTaken_[3] = {}; // Samples read per mock FIFO channel
+    bool mockFifoStarted_ = false;
 
     // Mock data generation
     float generateMockValue(SensorId sensorId);
+    float generateMockWaveform(SensorId channel, double time);
     uint8_t generateMockStatusByte();
+    void startMockFifo(double now);
+    uint64_t mockFifoDue(size_t channel, double now) const;
+    size_t mockFifoLevel(double now) const;
 };
 
 #endif // I2C_DRIVER_H
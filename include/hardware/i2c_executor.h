@@ -0,0 +1,176 @@
+#ifndef I2C_EXECUTOR_H
+#define I2C_EXECUTOR_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include "hardware/i2c_driver.h"
+
+/**
+ * @brief Single owner of an I2CDriver, running hub commands on its own thread
+ *
+ * Any thread may submit commands. Each command returns a future, or takes a
+ * callback that runs on the executor thread. The driver is only ever touched
+ * by that thread, so callers never race on the bus, and none of them blocks
+ * for a transaction unless it waits on the result.
+ *
+ * Commands run in Priority order, first come first served within a priority,
+ * so waveform reads are not held up behind a hot-plug scan queued before them.
+ * When a command is taken, others that one transaction can also answer are
+ * taken with it:
+ * - Pending pings share one PING, and pending scans share one SCAN.
+ * - Pending sensor reads and bulk reads of any priority share one READ_ALL.
+ *   If the hub cannot answer it, they fall back to one READ_SENSOR per sensor.
+ * FIFO commands consume samples, so each gets a transaction of its own.
+ *
+ * Callbacks should be short. They must not wait on another command of the
+ * same executor.
+ */
+class I2CExecutor
+{
+public:
+    /// Lower values run first
+    enum class Priority
+    {
+        Waveform = 0,  ///< FIFO drains
+        Reading = 1,   ///< Sensor values
+        Scan = 2,      ///< Hot-plug scans and housekeeping
+    };
+
+    struct Reading
+    {
+        bool ok = false;
+        float value = 0.0f;
+    };
+
+    struct Frame
+    {
+        bool ok = false;
+        I2CDriver::HubFrame frame;
+    };
+
+    struct Fifo
+    {
+        bool ok = false;
+        I2CDriver::FifoBatch batch;
+    };
+
+    struct FifoLevel
+    {
+        bool ok = false;
+        I2CDriver::FifoStatus status;
+    };
+
+    using PingCallback = std::function<void(bool)>;
+    using ScanCallback = std::function<void(uint8_t)>;
+    using ReadCallback = std::function<void(const Reading&)>;
+    using FrameCallback = std::function<void(const Frame&)>;
+
+    /// Takes the driver and starts the executor thread
+    explicit I2CExecutor(std::unique_ptr<I2CDriver> driver);
+
+    /// Runs every command already submitted, then stops the thread
+    ~I2CExecutor();
+
+    I2CExecutor(const I2CExecutor&) = delete;
+    I2CExecutor& operator=(const I2CExecutor&) = delete;
+
+    /// PING; true if the hub answered
+    void ping(PingCallback done, Priority priority = Priority::Scan);
+    std::future<bool> ping(Priority priority = Priority::Scan);
+
+    /// SCAN_SENSORS; SensorStatusBits, or 0xFF on failure (as I2CDriver::scanSensors())
+    void scan(ScanCallback done, Priority priority = Priority::Scan);
+    std::future<uint8_t> scan(Priority priority = Priority::Scan);
+
+    /// One sensor's value
+    void read(SensorId sensor, ReadCallback done, Priority priority = Priority::Reading);
+    std::future<Reading> read(SensorId sensor, Priority priority = Priority::Reading);
+
+    /// Every attached sensor (READ_ALL)
+    void readAll(FrameCallback done, Priority priority = Priority::Reading);
+    std::future<Frame> readAll(Priority priority = Priority::Reading);
+
+    /// Up to maxSamples waveform samples (READ_FIFO)
+    std::future<Fifo> readFifo(size_t maxSamples, Priority priority = Priority::Waveform);
+
+    /// Hub FIFO fill (FIFO_LEVEL)
+    std::future<FifoLevel> fifoLevel(Priority priority = Priority::Waveform);
+
+    /**
+     * @brief Run anything else against the driver on the executor thread
+     *
+     * For setup and housekeeping (open(), measureTurnaround(), setClock()).
+     * @return Future of fn's result
+     */
+    template <typename Fn>
+    auto call(Fn fn, Priority priority = Priority::Scan) -> std::future<std::invoke_result_t<Fn&, I2CDriver&>>
+    {
+        using Result = std::invoke_result_t<Fn&, I2CDriver&>;
+        auto task = std::make_shared<std::packaged_task<Result(I2CDriver&)>>(std::move(fn));
+        std::future<Result> result = task->get_future();
+        Job job;
+        job.kind = Kind::Call;
+        job.call = [task](I2CDriver& driver) { (*task)(driver); };
+        submit(std::move(job), priority);
+        return result;
+    }
+
+    size_t pending() const;           ///< Commands submitted and not yet run
+    uint64_t transactions() const;    ///< Transactions run for commands
+    uint64_t batched() const;         ///< Commands answered by another command's transaction
+
+private:
+    static constexpr size_t PRIORITIES = 3;
+
+    enum class Kind
+    {
+        Ping,
+        Scan,
+        Read,     // Sensor read, or READ_ALL if bulk
+        Call,
+    };
+
+    struct Job
+    {
+        Kind kind = Kind::Call;
+        bool bulk = false;            // Read: the whole frame was asked for
+        SensorId sensor = SensorId::ECG;
+        PingCallback onPing;
+        ScanCallback onScan;
+        ReadCallback onRead;
+        FrameCallback onFrame;
+        std::function<void(I2CDriver&)> call;
+    };
+
+    void submit(Job job, Priority priority);
+    void run();
+
+    // Executor thread
+    void take_(Kind kind, std::deque<Job>& batch);
+    void runPings_(std::deque<Job>& batch);
+    void runScans_(std::deque<Job>& batch);
+    void runReads_(std::deque<Job>& batch);
+
+    std::unique_ptr<I2CDriver> driver_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::array<std::deque<Job>, PRIORITIES> queues_;
+    bool stopping_ = false;
+    std::atomic<uint64_t> transactions_{0};
+    std::atomic<uint64_t> batched_{0};
+
+    std::thread thread_;
+};
+
+#endif // I2C_EXECUTOR_H
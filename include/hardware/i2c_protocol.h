@@ -1,6 +1,7 @@
 #ifndef I2C_PROTOCOL_H
 #define I2C_PROTOCOL_H
 
+#include <cstddef>
 #include <cstdint>
 
 /**
@@ -33,7 +34,10 @@ enum class HubCommand : uint8_t
     PING = 0x00,         ///< Health check - Hub responds with 0x42
     SCAN_SENSORS = 0x01, ///< Get cached sensor status - Response: [status_byte] (Hub auto-scans every 5s)
     READ_SENSOR = 0x02,  ///< Read sensor value - Request: [cmd, sensor_id], Response: [4-byte float]
-    GET_STATUS = 0x03    ///< Get detailed status - Response: [5-byte status array]
+    GET_STATUS = 0x03,   ///< Get detailed status - Response: [5-byte status array]
+    READ_ALL = 0x04,     ///< Every attached sensor at once - Response: [READ_ALL frame] (see below)
+    READ_FIFO = 0x05,    ///< Drain waveform samples - Request: [cmd, max count], Response: [FIFO frame] (see below)
+    FIFO_LEVEL = 0x06    ///< Waveform FIFO fill - Response: [level (u16), dropped (u16), CRC-8]
 };
 
 // ============================================================================
@@ -76,6 +80,97 @@ namespace SensorStatusBits
     constexpr uint8_t RESPIRATORY = (1 << 5); // Bit 5: Respiratory (Virtual)
 }
 
+// ============================================================================
+// READ_ALL Frame
+// ============================================================================
+//
+//   [0]      sequence number, +1 per hub sample (wraps at 256)
+//   [1]      presence mask (SensorStatusBits)
+//   [2..]    one little-endian float32 per set bit, lowest bit first
+//   [last]   CRC-8 of every byte before it
+//
+// The frame is 3 + 4 * (set bits) bytes. The hub answers a longer read with
+// 0xFF padding, so a master that does not know the mask yet can read
+// READ_ALL_MAX_LENGTH bytes. The same CRC-8 protects the FIFO frames below.
+
+/// Sensors a READ_ALL frame can carry
+constexpr size_t READ_ALL_SENSOR_COUNT = 6;
+
+/// Frame with every sensor present
+constexpr size_t READ_ALL_MAX_LENGTH = 3 + 4 * READ_ALL_SENSOR_COUNT;
+
+/// Sensor carried by each mask bit, in frame order
+constexpr SensorId READ_ALL_ORDER[READ_ALL_SENSOR_COUNT] = {
+    SensorId::ECG, SensorId::SPO2, SensorId::TEMP_CORE,
+    SensorId::NIBP, SensorId::TEMP_SKIN, SensorId::RESPIRATORY};
+
+/// Length of a frame with this presence mask
+constexpr size_t readAllFrameLength(uint8_t mask)
+{
+    size_t sensors = 0;
+    for (size_t bit = 0; bit < READ_ALL_SENSOR_COUNT; ++bit)
+    {
+        sensors += (mask >> bit) & 1;
+    }
+    return 3 + 4 * sensors;
+}
+
+/// CRC-8/SMBUS (polynomial 0x07, initial value 0), as used for SMBus PEC
+constexpr uint8_t crc8(const uint8_t* data, size_t length)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// ============================================================================
+// Waveform FIFO
+// ============================================================================
+//
+// The hub samples the waveform channels (ECG, pleth on the SpO2 sensor,
+// respiration) on its own clock into a ring FIFO, and the Pi drains it in
+// bursts. READ_FIFO answer:
+//
+//   [0]      N, samples in this frame (at most the count requested)
+//   [1..2]   samples still queued after this frame, little-endian uint16
+//   [3..]    N entries of FIFO_ENTRY_SIZE bytes:
+//              channel (SensorId), hub time in microseconds (uint32,
+//              wraps every ~71 minutes), value (float32), all little-endian
+//   [last]   CRC-8 of every byte before it
+//
+// FIFO_LEVEL answer: queued samples (uint16), samples dropped because the
+// FIFO was full since the last FIFO_LEVEL (uint16), CRC-8.
+
+/// Bytes per FIFO entry: channel, timestamp, value
+constexpr size_t FIFO_ENTRY_SIZE = 1 + 4 + 4;
+
+/// Most samples one READ_FIFO may return (the frame fits the hub's 256-byte I²C buffer)
+constexpr size_t READ_FIFO_MAX_SAMPLES = 28;
+
+/// Length of a READ_FIFO frame carrying count samples
+constexpr size_t readFifoFrameLength(size_t count)
+{
+    return 4 + FIFO_ENTRY_SIZE * count;
+}
+
+/// Length of the FIFO_LEVEL answer
+constexpr size_t FIFO_LEVEL_LENGTH = 5;
+
+/// Samples the hub FIFO holds before it drops new ones
+constexpr size_t HUB_FIFO_CAPACITY = 512;
+
+/// Hub sample rates of the FIFO channels (Hz)
+constexpr uint32_t FIFO_ECG_HZ = 500;
+constexpr uint32_t FIFO_PLETH_HZ = 100;
+constexpr uint32_t FIFO_RESP_HZ = 25;
+
 // ============================================================================
 // Protocol Constants
 // ============================================================================
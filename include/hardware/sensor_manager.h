@@ -1,10 +1,21 @@
 #ifndef SENSOR_MANAGER_H
 #define SENSOR_MANAGER_H
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+#include "core/SensorDataStore.h"
+#include "core/latency_histogram.h"
 #include "hardware/i2c_driver.h"
+#include "hardware/i2c_executor.h"
 #include "hardware/i2c_protocol.h"
 
 /**
@@ -31,16 +42,40 @@ struct SensorInfo
     std::string name;
 };
 
+/**
+ * @brief One waveform sample, stamped when the hub took it
+ */
+struct WaveformSample
+{
+    uint64_t timestampUs; ///< Hub clock in microseconds, unwrapped (never wraps)
+    float value;
+};
+
 /**
  * @brief Manages sensor detection and data reading via SAMD21 hub
  * 
  * Handles communication with SAMD21 SensorHub via I²C bus, detection of
  * connected sensors, reading sensor data, and tracking attachment status.
+ * Every hub command goes through an I2CExecutor, the bus's only user, which
+ * other components may also submit to (hub()).
+ *
+ * Waveform channels (ECG, pleth, respiration) are sampled by the hub into
+ * its FIFO; pollFifo() drains it into one buffer per channel, keeping the
+ * hub's sample times, so the host can poll far below the sample rate.
+ *
+ * startAcquisition() hands the hub to a scheduler thread that polls each
+ * attached sensor at its own rate, drains the FIFO and rescans for hot-plugged
+ * sensors, publishing into a SensorDataStore. While it runs, it owns the
+ * sensor state: call scanSensors(), readSensor() and pollFifo() only while
+ * it is stopped.
  */
 class SensorManager
 {
 public:
     explicit SensorManager(bool mockMode = false);
+
+    /// Use an existing driver (e.g. on a HubEmulator)
+    explicit SensorManager(std::unique_ptr<I2CDriver> driver);
     ~SensorManager();
 
     bool initialize();
@@ -49,14 +84,188 @@ public:
     bool readSensor(SensorType type, float& value);
     const SensorInfo& getSensorInfo(SensorType type) const;
     std::string getSensorStatusJson() const;
+    uint8_t getSensorStatusBits() const;
+
+    /// SensorStatusBits of the sensors attached at the last scan (any thread)
+    uint8_t attachedSensorBits() const { return attachedBits_.load(std::memory_order_relaxed); }
+
+    /// Time source for mock sensor values (see I2CDriver::setClock())
+    void setClock(std::shared_ptr<SimClock> clock);
+
+    /// Command queue of the hub bus, for asynchronous commands from any thread
+    I2CExecutor& hub() { return *hub_; }
+
+    // ========================================================================
+    // Waveform FIFO
+    // ========================================================================
+
+    /// Waveform samples kept per channel until taken (10 s of 500 Hz ECG)
+    static constexpr size_t WAVEFORM_BUFFER_SAMPLES = 5000;
+
+    struct FifoStats
+    {
+        uint64_t polls = 0;
+        uint64_t reads = 0;          ///< READ_FIFO transactions
+        uint64_t samples = 0;        ///< Samples received
+        uint64_t hubDropped = 0;     ///< Lost to a full hub FIFO
+        uint64_t bufferDropped = 0;  ///< Overwritten here before being taken
+        uint64_t unattached = 0;     ///< Dropped: the channel's sensor is not attached
+    };
+
+    /**
+     * @brief Drain the hub's waveform FIFO into the channel buffers
+     *
+     * Asks for the FIFO level, then reads exactly that many samples, at most
+     * READ_FIFO_MAX_SAMPLES per transaction, and updates fifoPollInterval().
+     * Samples of channels whose sensor is not attached are dropped.
+     *
+     * @return Samples received, or -1 if the hub could not be read
+     */
+    int pollFifo();
+
+    /**
+     * @brief Move a channel's buffered samples into out, oldest first
+     * @return Number of samples appended
+     */
+    size_t takeSamples(SensorType type, std::vector<WaveformSample>& out);
+
+    /**
+     * @brief How long to wait before the next pollFifo()
+     *
+     * Sized from the measured sample rate so that a poll finds about one
+     * READ_FIFO transaction's worth, within the bounds below.
+     */
+    std::chrono::microseconds fifoPollInterval() const { return fifoPollInterval_; }
+
+    /// Limits for fifoPollInterval() (default 5-20 ms: at least 50 polls/s)
+    void setFifoPollBounds(std::chrono::microseconds fastest, std::chrono::microseconds slowest);
+
+    const FifoStats& fifoStats() const { return fifoStats_; }
+
+    // ========================================================================
+    // Acquisition
+    // ========================================================================
+
+    /// Work the acquisition thread schedules, each on its own deadlines
+    enum class AcquisitionTask
+    {
+        ECG,          ///< Vitals, at setAcquisitionRate(); those due share one READ_ALL
+        SpO2,
+        TempCore,
+        TempSkin,
+        NIBP,
+        Respiratory,
+        Waveforms,    ///< pollFifo(), at fifoPollInterval()
+        HotPlugScan,  ///< scanSensors(), every AcquisitionConfig::scanInterval
+        Count
+    };
+
+    struct AcquisitionConfig
+    {
+        int realtimePriority = 0;   ///< SCHED_FIFO priority (1-99); 0 keeps normal scheduling
+        int cpu = -1;               ///< CPU to pin the thread to; -1 = any
+        std::chrono::milliseconds scanInterval{3000};
+    };
+
+    struct AcquisitionStats
+    {
+        uint64_t runs = 0;
+        uint64_t overruns = 0;   ///< Deadlines skipped because a run ended a period or more late
+        uint64_t failures = 0;   ///< Runs whose hub transaction failed
+        LatencyHistogram::Summary jitter; ///< How late each run started
+    };
+
+    /**
+     * @brief Rate at which the acquisition thread reads a sensor's value
+     *
+     * Defaults: 1 Hz for SpO2, temperatures and NIBP; 0 (not read) for ECG
+     * and respiration, whose waveforms come through the FIFO. May be changed
+     * while acquisition runs.
+     *
+     * @param hz Reads per second; 0 stops reading the sensor
+     */
+    void setAcquisitionRate(SensorType type, double hz);
+    double acquisitionRate(SensorType type) const;
+
+    /**
+     * @brief Start the acquisition thread
+     *
+     * Readings go into store as they arrive (store may be null: sensors are
+     * still scanned and the FIFO drained into the waveform buffers). The
+     * thread sleeps on absolute deadlines, so a late run does not delay the
+     * ones after it. If realtime scheduling or pinning is refused, the thread
+     * runs without it.
+     *
+     * @return false if acquisition is already running
+     */
+    bool startAcquisition(SensorDataStore* store, const AcquisitionConfig& config);
+
+    /// startAcquisition() with normal scheduling and the default scan interval
+    bool startAcquisition(SensorDataStore* store) { return startAcquisition(store, AcquisitionConfig()); }
+
+    /// Stop and join the acquisition thread (returns within about 100 ms)
+    void stopAcquisition();
+
+    bool isAcquiring() const { return acquiring_.load(std::memory_order_acquire); }
+
+    /// Whether the acquisition thread got SCHED_FIFO
+    bool acquisitionRealtime() const { return realtime_.load(std::memory_order_acquire); }
+
+    /// Counters of one task (safe to call while acquisition runs)
+    AcquisitionStats acquisitionStats(AcquisitionTask task) const;
+
+    /// Name of a task, e.g. "temp_core" or "waveforms"
+    static const char* acquisitionTaskName(AcquisitionTask task);
 
 private:
-    std::unique_ptr<I2CDriver> i2c_;
+    std::unique_ptr<I2CExecutor> hub_;
     std::map<SensorType, SensorInfo> sensors_;
     bool mockMode_;
 
+    std::map<SensorType, std::deque<WaveformSample>> waveforms_;
+    FifoStats fifoStats_;
+    bool hubClockStarted_ = false;
+    uint64_t hubClockUs_ = 0;      // Unwrapped time of the latest FIFO sample
+    uint64_t lastPollUs_ = 0;      // hubClockUs_ at the previous poll with samples
+    double fifoRate_ = 0.0;        // Samples per hub microsecond
+    std::chrono::microseconds fifoPollMin_{5000};
+    std::chrono::microseconds fifoPollMax_{20000};
+    std::chrono::microseconds fifoPollInterval_{20000};
+
+    std::mutex waveformsMutex_;           // waveforms_, between pollFifo() and takeSamples()
+
+    using AcquisitionClock = std::chrono::steady_clock;
+    static constexpr size_t ACQUISITION_TASKS = static_cast<size_t>(AcquisitionTask::Count);
+
+    struct ScheduledTask
+    {
+        std::atomic<double> rateHz{0.0};        // Sensor tasks; 0 = off
+        AcquisitionClock::time_point deadline;  // Acquisition thread only
+        std::atomic<uint64_t> runs{0};
+        std::atomic<uint64_t> overruns{0};
+        std::atomic<uint64_t> failures{0};
+        LatencyHistogram jitter;
+    };
+
+    std::array<ScheduledTask, ACQUISITION_TASKS> tasks_;
+    std::atomic<bool> acquiring_{false};
+    std::atomic<bool> realtime_{false};
+    std::atomic<bool> hubDetected_{false};
+    std::atomic<uint8_t> attachedBits_{0}; // sensors_ attachment, for other threads
+    std::thread acquisitionThread_;
+
     void initializeSensorMap();
     SensorId sensorTypeToId(SensorType type) const;
+    bool sensorIdToType(SensorId id, SensorType& type) const;
+    uint64_t unwrapHubTime(uint32_t timestampUs);
+
+    void acquisitionLoop(SensorDataStore* store, AcquisitionConfig config);
+    void applyRealtime(const AcquisitionConfig& config);
+    std::chrono::nanoseconds taskPeriod(size_t task, const AcquisitionConfig& config) const;
+    bool runTask(size_t task);
+    void readVitals(size_t due, AcquisitionClock::time_point woke, SensorDataStore* store,
+                    const AcquisitionConfig& config);
+    void completeTask(size_t task, bool ok, AcquisitionClock::time_point woke, const AcquisitionConfig& config);
 };
 
 #endif // SENSOR_MANAGER_H
@@ -0,0 +1,96 @@
+#ifndef FRAME_BROADCASTER_H
+#define FRAME_BROADCASTER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Single-producer, multi-consumer hub for encoded stream frames
+ *
+ * The producer encodes each frame exactly once per tick and publishes it as
+ * an immutable, reference-counted buffer. Every streaming sink waits on the
+ * hub and writes the shared buffer as-is, so the per-tick encode cost does
+ * not grow with the number of connected clients.
+ */
+class FrameBroadcaster
+{
+public:
+    /// Immutable encoded frame shared by all sinks
+    using Frame = std::shared_ptr<const std::string>;
+
+    /**
+     * @brief RAII registration of a streaming sink (counts as one client)
+     */
+    class Subscription
+    {
+    public:
+        explicit Subscription(FrameBroadcaster& hub);
+        ~Subscription();
+
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+    private:
+        FrameBroadcaster& hub_;
+    };
+
+    FrameBroadcaster() = default;
+
+    /**
+     * @brief Publish a new frame and wake every waiting sink
+     * @param payload Fully encoded frame (e.g. "data: {...}\n\n")
+     * @return Sequence number assigned to the frame
+     */
+    uint64_t publish(std::string payload);
+
+    /**
+     * @brief Block until a frame newer than lastSeq is available
+     * @param lastSeq In/out: last sequence seen by the caller
+     * @param timeout Maximum time to wait
+     * @return The latest frame, or nullptr on timeout or after close()
+     */
+    Frame waitForNext(uint64_t& lastSeq, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Get the most recently published frame without waiting
+     * @param seq Optional output for the frame's sequence number
+     * @return Latest frame, or nullptr if nothing was published yet
+     */
+    Frame latest(uint64_t* seq = nullptr) const;
+
+    /**
+     * @brief Sequence number of the most recent frame (0 = none yet)
+     */
+    uint64_t sequence() const;
+
+    /**
+     * @brief Wake all waiters and make further waits return immediately
+     */
+    void close();
+
+    /**
+     * @brief Re-open the hub after close()
+     */
+    void reopen();
+
+    /**
+     * @brief Number of sinks currently subscribed
+     */
+    int subscriberCount() const { return subscribers_.load(std::memory_order_relaxed); }
+
+private:
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    Frame frame_;
+    uint64_t seq_ = 0;
+    bool closed_ = false;
+
+    std::atomic<int> subscribers_{0};
+};
+
+#endif // FRAME_BROADCASTER_H
@@ -0,0 +1,189 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "core/signal_generator.h"
+
+/**
+ * @file frame_codec.h
+ * @brief Compact binary encoding of stream frames
+ *
+ * Opt-in alternative to the JSON frame (`/ws?format=binary`). All fields are
+ * little-endian, no padding:
+ *
+ * | Offset | Type | Field                                         |
+ * |--------|------|-----------------------------------------------|
+ * | 0      | u8   | version (BINARY_FRAME_VERSION)                |
+ * | 1      | u8   | sensor presence bitmask (SensorStatusBits)    |
+ * | 2      | u32  | frame sequence number                         |
+ * | 6      | u32  | timestamp in milliseconds                     |
+ * | 10     | f32  | ecg                                           |
+ * | 14     | f32  | spo2                                          |
+ * | 18     | f32  | resp                                          |
+ * | 22     | f32  | pleth                                         |
+ * | 26     | f32  | bp_systolic                                   |
+ * | 30     | f32  | bp_diastolic                                  |
+ * | 34     | f32  | temp_cavity                                   |
+ * | 38     | f32  | temp_skin                                     |
+ *
+ * Clients that subscribe to a subset of channels (see StreamSubscription)
+ * get a version 2 frame instead, carrying only the channels due on the tick:
+ *
+ * | Offset | Type  | Field                                            |
+ * |--------|-------|--------------------------------------------------|
+ * | 0      | u8    | version (BINARY_CHANNELS_FRAME_VERSION)          |
+ * | 1      | u8    | sensor presence bitmask (SensorStatusBits)       |
+ * | 2      | u32   | frame sequence number                            |
+ * | 6      | u32   | timestamp in milliseconds                        |
+ * | 10     | u16   | channel mask (bit i = SensorDataStore::Field(i)) |
+ * | 12     | f32[] | one value per set bit, in bit order              |
+ *
+ * When waveforms are sampled at a native rate, frames carry the block of
+ * samples since the previous frame (version 3). Header as version 2 plus a
+ * block mask, then per channel in bit order either one f32 or, for block
+ * channels, a run of samples:
+ *
+ * | Offset | Type  | Field                                               |
+ * |--------|-------|-----------------------------------------------------|
+ * | 0..11  |       | as version 2 (version = BINARY_BLOCK_FRAME_VERSION) |
+ * | 12     | u16   | block mask (subset of the channel mask)             |
+ * | 14     |       | per channel: f32, or the run below                  |
+ * |        | i32   | first sample time, microseconds from the timestamp  |
+ * |        | u32   | sample interval in microseconds                     |
+ * |        | u16   | sample count                                        |
+ * |        | f32[] | samples                                             |
+ *
+ * Over SSE the frame is base64 encoded into a single `data:` line; over a
+ * WebSocket it is sent as-is in a binary message. Versions 1 and 2 encode
+ * without allocating.
+ */
+namespace FrameCodec
+{
+    constexpr uint8_t BINARY_FRAME_VERSION = 1;
+    constexpr size_t BINARY_FRAME_SIZE = 42;
+
+    constexpr uint8_t BINARY_CHANNELS_FRAME_VERSION = 2;
+    constexpr size_t BINARY_CHANNELS_HEADER_SIZE = 12;
+    constexpr size_t BINARY_CHANNELS_FRAME_MAX_SIZE = BINARY_CHANNELS_HEADER_SIZE + 8 * 4;
+
+    constexpr uint8_t BINARY_BLOCK_FRAME_VERSION = 3;
+    constexpr size_t BINARY_BLOCK_HEADER_SIZE = 14;
+    constexpr size_t BINARY_BLOCK_RUN_HEADER_SIZE = 10;
+
+    /// Channel mask of a version 1 frame (all eight values)
+    constexpr uint16_t ALL_CHANNELS = 0xFF;
+
+    /// Channels that can be sent as sample runs (ecg, resp, pleth)
+    constexpr uint16_t WAVEFORM_CHANNELS = 0x0D;
+
+    /**
+     * @brief Native-rate samples produced since the previous frame
+     */
+    struct SampleBlock
+    {
+        const SignalGenerator::SensorData* samples = nullptr;
+        size_t count = 0;
+        uint64_t firstIndex = 0; ///< Sample number of samples[0]; its time is firstIndex / rateHz
+        int rateHz = 0;
+    };
+
+    /**
+     * @brief The samples of a block kept by a decimation step
+     *
+     * Keeps samples whose sample number is a multiple of step, so decimated
+     * runs stay evenly spaced across consecutive blocks.
+     * @param first Set to the index (into block.samples) of the first kept sample
+     * @return Number of kept samples
+     */
+    size_t blockSlice(const SampleBlock& block, uint32_t step, size_t& first);
+
+    /// Value of channel i (SensorDataStore::Field order) of a sample
+    double channelValue(const SignalGenerator::SensorData& data, size_t channel);
+
+    /// Base64 length of a binary frame (42 bytes -> 56 chars, no padding)
+    constexpr size_t BINARY_FRAME_BASE64_SIZE = ((BINARY_FRAME_SIZE + 2) / 3) * 4;
+
+    /// "data: " + base64 + "\n\n"
+    constexpr size_t BINARY_SSE_FRAME_SIZE = 6 + BINARY_FRAME_BASE64_SIZE + 2;
+
+    /**
+     * @brief Decoded view of a binary frame
+     */
+    struct BinaryFrame
+    {
+        uint8_t version = 0;
+        uint8_t sensors = 0;
+        uint32_t seq = 0;
+        uint16_t channels = 0; ///< Values present in data (ALL_CHANNELS for version 1)
+        SignalGenerator::SensorData data{};
+
+        /// Sample runs (version 3); data holds the last sample of each run
+        struct Run
+        {
+            double t0 = 0.0;
+            double dt = 0.0;
+            std::vector<double> values;
+        };
+        uint16_t blockChannels = 0;
+        Run runs[8];
+    };
+
+    /**
+     * @brief Encode a frame into exactly BINARY_FRAME_SIZE bytes
+     * @param data Sample values (timestamp in seconds)
+     * @param sensors Presence bitmask (SensorStatusBits layout)
+     * @param seq Frame sequence number
+     * @param out Destination, at least BINARY_FRAME_SIZE bytes
+     */
+    void encodeBinary(const SignalGenerator::SensorData& data, uint8_t sensors, uint32_t seq,
+                      uint8_t* out);
+
+    /**
+     * @brief Encode a version 2 frame holding only the selected channels
+     * @param channels Channel mask (bit i = SensorDataStore::Field(i), bits 0-7)
+     * @param out Destination, at least BINARY_CHANNELS_FRAME_MAX_SIZE bytes
+     * @return Number of bytes written
+     */
+    size_t encodeBinaryChannels(const SignalGenerator::SensorData& data, uint8_t sensors, uint32_t seq,
+                                uint16_t channels, uint8_t* out);
+
+    /**
+     * @brief Encode a version 3 frame with sample runs for the block channels
+     * @param latest Values for the non-block channels; its timestamp is the frame timestamp
+     * @param channels Channel mask
+     * @param block Samples since the previous frame
+     * @param blockChannels Channels sent as runs (subset of channels and WAVEFORM_CHANNELS)
+     * @param steps Decimation step per channel (8 entries, see blockSlice())
+     * @param out Replaced with the frame; reuse it to avoid reallocating
+     */
+    void encodeBinaryBlock(const SignalGenerator::SensorData& latest, uint8_t sensors, uint32_t seq,
+                           uint16_t channels, const SampleBlock& block, uint16_t blockChannels,
+                           const uint32_t* steps, std::vector<uint8_t>& out);
+
+    /**
+     * @brief Decode a version 1, 2 or 3 frame (float32 precision)
+     *
+     * Channels missing from a version 2 or 3 frame are left at zero.
+     * @return false if the buffer is too short or the version is unknown
+     */
+    bool decodeBinary(const uint8_t* in, size_t len, BinaryFrame& out);
+
+    /**
+     * @brief Encode a frame as an SSE event with a base64 payload
+     * @param out Destination, at least BINARY_SSE_FRAME_SIZE bytes
+     * @return Number of bytes written (always BINARY_SSE_FRAME_SIZE)
+     */
+    size_t encodeBinarySse(const SignalGenerator::SensorData& data, uint8_t sensors, uint32_t seq,
+                           char* out);
+
+    /**
+     * @brief Standard base64 (RFC 4648) with padding
+     * @param out Destination, at least ((len + 2) / 3) * 4 bytes
+     * @return Number of characters written
+     */
+    size_t base64Encode(const uint8_t* in, size_t len, char* out);
+}
+
+#endif // FRAME_CODEC_H
@@ -0,0 +1,85 @@
+#ifndef HUB_WAVEFORMS_H
+#define HUB_WAVEFORMS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "core/signal_generator.h"
+#include "hardware/sensor_manager.h"
+
+/**
+ * @file hub_waveforms.h
+ * @brief Hub FIFO waveform samples played out onto the stream's sample grid
+ *
+ * SensorManager buffers the ECG, pleth and respiration samples it drains
+ * from the hub FIFO, each stamped with the hub's clock. The stream samples
+ * waveforms on its own grid (SignalGenerator times, at the native waveform
+ * rate or once per frame). HubWaveforms takes the buffered samples each frame
+ * and writes them over the synthesized values of those channels, before the
+ * frame is encoded and recorded in the history.
+ *
+ * Each channel is a small jitter buffer: hub time is mapped to stream time
+ * with a fixed PLAYOUT_DELAY, long enough to cover a FIFO poll interval and
+ * a frame, and every grid sample takes the newest hub sample at or before
+ * its mapped time. The mapping is re-anchored when the hub stops sending for
+ * MAX_HOLD_US, when the buffer runs more than MAX_BACKLOG_US ahead (clock
+ * drift, a stalled stream), or when stream time goes backwards. Until a
+ * channel has a sample to play, its synthesized values are left as they are,
+ * and a channel whose sensor is not attached is never played.
+ *
+ * Producer thread only.
+ */
+class HubWaveforms
+{
+public:
+    static constexpr int64_t PLAYOUT_DELAY_US = 100000;
+    static constexpr int64_t MAX_HOLD_US = 2 * PLAYOUT_DELAY_US;
+    static constexpr int64_t MAX_BACKLOG_US = 1000000;
+
+    HubWaveforms();
+
+    /**
+     * @brief Take the buffered hub samples and write them over a run of stream samples
+     * @param sensors Source of the samples (SensorManager::takeSamples())
+     * @param samples Stream samples in time order (timestamps in seconds)
+     * @param n Number of samples
+     * @return Bitmask of the channels written (bit i = SensorDataStore::Field(i))
+     */
+    uint16_t apply(SensorManager& sensors, SignalGenerator::SensorData* samples, size_t n);
+
+    /// Take and drop the buffered hub samples (mock mode: the simulated patient owns the stream)
+    void discard(SensorManager& sensors);
+
+private:
+    struct Channel
+    {
+        SensorType type;
+        double SignalGenerator::SensorData::* value;
+        uint16_t bit;
+        uint8_t sensorBit;                   // SensorStatusBits of the channel's sensor
+
+        Channel(SensorType t, double SignalGenerator::SensorData::* v, uint16_t b, uint8_t s)
+            : type(t), value(v), bit(b), sensorBit(s)
+        {
+        }
+
+        std::deque<WaveformSample> pending;  // Not yet played, oldest first
+        bool anchored = false;
+        double anchorTime = 0.0;             // Stream time mapped to anchorHubUs
+        int64_t anchorHubUs = 0;
+        double lastTime = 0.0;
+        bool playing = false;                // current holds a sample
+        WaveformSample current{};
+    };
+
+    void take_(SensorManager& sensors);
+    void reset_(Channel& channel);
+    bool play_(Channel& channel, double time, double& value);
+
+    std::array<Channel, 3> channels_;
+    std::vector<WaveformSample> taken_;      // Reused by take_()
+};
+
+#endif // HUB_WAVEFORMS_H
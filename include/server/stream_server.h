@@ -0,0 +1,348 @@
+#ifndef STREAM_SERVER_H
+#define STREAM_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "server/stream_subscription.h"
+#include "server/websocket.h"
+
+/**
+ * @file stream_server.h
+ * @brief Event-loop server for the real-time data stream
+ *
+ * Runs on its own port next to the HTTP server. A single reactor thread
+ * multiplexes every connection with non-blocking sockets and epoll, so a
+ * client costs a table entry and a queue rather than a parked thread. The
+ * same thread owns a timerfd that drives the stream tick.
+ *
+ * `GET /ws` is served two ways:
+ * - with an `Upgrade: websocket` header, as an RFC 6455 WebSocket;
+ * - otherwise as Server-Sent Events (one `data:` line per frame).
+ *
+ * Each broadcast payload is wrapped once per transport and the buffer is
+ * shared by every queued client. Text messages from WebSocket clients are
+ * delivered to a MessageHandler, which can answer through send().
+ *
+ * Clients with the same format and StreamSubscription form a group; the
+ * producer encodes one payload per group and sends it with broadcast(groupId).
+ *
+ * Sockets are never written with blocking calls, so a stalled client only
+ * grows its own bounded queue; what happens when that queue is full is set
+ * by the SlowClientPolicy. Ticks fire on absolute deadlines (a fixed grid
+ * from when the rate was set), so late ticks are counted, not accumulated.
+ */
+class StreamServer
+{
+public:
+    /// Payload format chosen by the client with `/ws?format=binary|json`
+    enum class Format : uint8_t
+    {
+        Json,  ///< JSON frame (WebSocket text message / SSE data line)
+        Binary ///< FrameCodec frame (WebSocket binary message / base64 SSE data line)
+    };
+
+    /// How a client is attached
+    enum class Transport : uint8_t
+    {
+        WebSocket,
+        Sse
+    };
+
+    /// What to do with a client whose outbound queue cannot keep up
+    enum class SlowClientPolicy : uint8_t
+    {
+        DropOldest, ///< Discard the oldest queued frame to make room
+        Coalesce,   ///< Keep only the latest pending frame (latest snapshot wins)
+        Disconnect  ///< Like DropOldest, but disconnect once lag exceeds maxLag
+    };
+
+    /**
+     * @brief Per-client outbound queue limits
+     */
+    struct BackpressureConfig
+    {
+        size_t maxQueuedFrames = 64; ///< Data frames queued per client
+        SlowClientPolicy policy = SlowClientPolicy::DropOldest;
+        std::chrono::milliseconds maxLag{2000}; ///< Disconnect threshold for SlowClientPolicy::Disconnect
+    };
+
+    /**
+     * @brief Tick scheduling statistics
+     */
+    struct TickStats
+    {
+        uint64_t ticks = 0;        ///< Ticks delivered to the handler
+        uint64_t missed = 0;       ///< Deadlines skipped because the reactor was late
+        double lastLateMs = 0.0;   ///< Delay of the last tick past its deadline
+        double maxLateMs = 0.0;    ///< Worst delay past a deadline
+        double maxHandlerMs = 0.0; ///< Slowest tick handler run
+    };
+
+    /**
+     * @brief Snapshot of one registered client
+     */
+    struct ClientInfo
+    {
+        uint64_t id = 0;
+        std::string remote; ///< "address:port"
+        Transport transport = Transport::WebSocket;
+        Format format = Format::Json;
+        double connectedSeconds = 0.0;
+        uint64_t framesSent = 0;
+        uint64_t bytesSent = 0;
+        size_t queuedFrames = 0;
+        SlowClientPolicy policy = SlowClientPolicy::DropOldest;
+        uint64_t framesDropped = 0; ///< Data frames discarded by the policy
+        double lagMs = 0.0;         ///< Age of the oldest unsent data frame
+        double maxLagMs = 0.0;      ///< Worst queue-to-socket delay of a data frame
+        std::string subscription;   ///< StreamSubscription::key()
+    };
+
+    /**
+     * @brief Clients sharing a format and subscription
+     */
+    struct SubscriptionGroup
+    {
+        uint32_t id = 0;
+        Format format = Format::Json;
+        StreamSubscription subscription;
+        int clients = 0;
+    };
+
+    /// Called on the reactor thread for every complete WebSocket text message
+    using MessageHandler = std::function<void(uint64_t clientId, const std::string& message)>;
+
+    /// Called on the reactor thread once per timer tick
+    using TickHandler = std::function<void()>;
+
+    StreamServer();
+    ~StreamServer();
+
+    StreamServer(const StreamServer&) = delete;
+    StreamServer& operator=(const StreamServer&) = delete;
+
+    /**
+     * @brief Bind, listen and start the reactor thread
+     * @param port TCP port (0 picks an ephemeral port, see port())
+     * @param bindAddress IPv4 address to bind
+     * @return false if the socket could not be set up
+     */
+    bool start(int port, const std::string& bindAddress = "0.0.0.0");
+
+    /**
+     * @brief Send close frames, disconnect all clients and join the reactor thread
+     */
+    void stop();
+
+    bool isRunning() const { return running_; }
+
+    /// Port actually bound (valid after start())
+    int port() const { return port_; }
+
+    /**
+     * @brief Set the handler for incoming text messages (call before start())
+     */
+    void setMessageHandler(MessageHandler handler);
+
+    /**
+     * @brief Set the tick handler (call before start())
+     */
+    void setTickHandler(TickHandler handler);
+
+    /**
+     * @brief Set the tick rate; takes effect immediately when running
+     * @param hz Ticks per second (0 disables the timer)
+     */
+    void setTickRate(int hz);
+
+    /**
+     * @brief Set the default outbound queue limits (call before start())
+     *
+     * Clients may choose their own policy with `?policy=drop|coalesce|disconnect`.
+     */
+    void setBackpressure(const BackpressureConfig& config);
+
+    /// Tick scheduling statistics
+    TickStats tickStats() const;
+
+    /// Policy name as used in query strings and /api/status
+    static const char* policyName(SlowClientPolicy policy);
+
+    /// Parse "drop", "coalesce" or "disconnect"
+    static bool policyFromName(const std::string& name, SlowClientPolicy& out);
+
+    /**
+     * @brief Queue one payload to every open client of the given format
+     *
+     * The payload is wrapped once per transport that has clients (WebSocket
+     * frame, SSE data line) and written straight to sockets that are ready.
+     * Safe to call from any thread, including the tick handler.
+     */
+    void broadcast(Format format, const void* payload, size_t len);
+
+    /**
+     * @brief Queue one payload to the open clients of one subscription group
+     *
+     * Same delivery as broadcast(Format, ...), restricted to the group.
+     */
+    void broadcast(uint32_t groupId, const void* payload, size_t len);
+
+    /// Groups with at least one open client
+    std::vector<SubscriptionGroup> subscriptionGroups() const;
+
+    /**
+     * @brief Change the subscription of an open client
+     * @return false if the client is not connected
+     */
+    bool setSubscription(uint64_t clientId, const StreamSubscription& subscription);
+
+    /**
+     * @brief Queue a text message to one WebSocket client
+     * @return false if the client is not connected
+     */
+    bool send(uint64_t clientId, const std::string& text);
+
+    /// Number of open clients (WebSocket and SSE)
+    int clientCount() const;
+
+    /// Number of open clients using the given format
+    int clientCount(Format format) const;
+
+    /// Snapshot of the client table
+    std::vector<ClientInfo> clients() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using WireFrame = std::shared_ptr<const std::string>;
+
+    enum class State : uint8_t
+    {
+        Handshake, ///< Reading the HTTP request
+        Open,      ///< Streaming
+        Closing    ///< Final bytes queued; drop once the queue drains
+    };
+
+    struct QueuedFrame
+    {
+        WireFrame bytes;
+        Clock::time_point queuedAt;
+        bool data; // Broadcast payload (subject to the policy) vs protocol frame
+    };
+
+    struct Connection
+    {
+        int fd = -1;
+        uint64_t id = 0;
+        std::string remote;
+        State state = State::Handshake;
+        Transport transport = Transport::WebSocket;
+        Format format = Format::Json;
+        uint32_t events = 0; // Current epoll interest
+        bool dead = false;   // Scheduled for removal
+        Clock::time_point connectedAt;
+        Clock::time_point lastReceived;
+        Clock::time_point lastPing;
+
+        std::string inbound;           // Unparsed received bytes
+        std::string message;           // Fragmented message being reassembled
+        WebSocket::Opcode messageOpcode = WebSocket::Opcode::Text;
+        bool inMessage = false;
+
+        std::deque<QueuedFrame> outbound; // Shared frames awaiting write
+        size_t outboundOffset = 0;        // Bytes of outbound.front() already written
+        size_t queuedData = 0;            // Data frames in outbound
+        SlowClientPolicy policy = SlowClientPolicy::DropOldest;
+        uint64_t framesSent = 0;
+        uint64_t bytesSent = 0;
+        uint64_t framesDropped = 0;
+        Clock::duration maxLag{0};
+        StreamSubscription subscription;
+        uint32_t group = 0; // SubscriptionGroup id while open
+    };
+
+    struct Group
+    {
+        uint32_t id;
+        Format format;
+        std::string key;
+        StreamSubscription subscription;
+        int clients[2]; // [Transport]
+    };
+
+    struct PendingMessage
+    {
+        uint64_t clientId;
+        std::string text;
+    };
+
+    void reactorThread();
+    void wake();
+    void armTimer(int hz);
+    void onTimer(uint64_t expirations);
+    void acceptClients();
+    bool readFrom(Connection& conn, std::vector<PendingMessage>& messages);
+    bool parseInbound(Connection& conn, std::vector<PendingMessage>& messages);
+    bool handleRequest(Connection& conn);
+    bool handleFrames(Connection& conn, std::vector<PendingMessage>& messages);
+    bool flush(Connection& conn);
+    void updateInterest(Connection& conn);
+    void enqueue(Connection& conn, WireFrame frame);
+    void enqueueData(Connection& conn, const WireFrame& frame, Clock::time_point now);
+    bool dropPendingData(Connection& conn);
+    void deliver(Format format, uint32_t groupId, const void* payload, size_t len, bool toWs, bool toSse);
+    void joinGroup(Connection& conn);
+    void leaveGroup(Connection& conn);
+    Clock::duration lag(const Connection& conn, Clock::time_point now) const;
+    void markOpen(Connection& conn);
+    void markClosed(Connection& conn);
+    void beginClose(Connection& conn, uint16_t code, const std::string& reason);
+    void housekeeping(Clock::time_point now);
+    void closeConnection(int fd);
+    std::atomic<int>& openCounter(const Connection& conn);
+
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;  // eventfd
+    int timerFd_ = -1; // timerfd driving the tick
+    int port_ = 0;
+    std::atomic<bool> running_{false};
+    std::atomic<int> tickHz_{0};
+    BackpressureConfig backpressure_;
+
+    // Tick grid (reactor thread only once running)
+    int armedHz_ = 0;
+    Clock::time_point tickAnchor_;
+    Clock::duration tickPeriod_{0};
+    uint64_t tickIndex_ = 0;
+
+    // Tick statistics (written by the reactor, read by tickStats())
+    std::atomic<uint64_t> ticks_{0};
+    std::atomic<uint64_t> missedTicks_{0};
+    std::atomic<int64_t> lastLateUs_{0};
+    std::atomic<int64_t> maxLateUs_{0};
+    std::atomic<int64_t> maxHandlerUs_{0};
+    std::unique_ptr<std::thread> thread_;
+    MessageHandler messageHandler_;
+    TickHandler tickHandler_;
+
+    // Client table; socket I/O happens with the lock held
+    mutable std::mutex mutex_;
+    std::unordered_map<int, Connection> connections_; // Keyed by fd
+    std::vector<int> deadFds_;                         // Failed outside the reactor, reaped by it
+    uint64_t nextClientId_ = 1;
+    std::atomic<int> openClients_[2][2] = {{{0}, {0}}, {{0}, {0}}}; // [Transport][Format]
+    std::vector<Group> groups_;                                      // Only groups with open clients
+    uint32_t nextGroupId_ = 1;
+};
+
+#endif // STREAM_SERVER_H
@@ -0,0 +1,100 @@
+#ifndef STREAM_SUBSCRIPTION_H
+#define STREAM_SUBSCRIPTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include "core/SensorDataStore.h"
+
+/**
+ * @file stream_subscription.h
+ * @brief Which channels a stream client wants, and how often
+ *
+ * Parsed from the `/ws` query string:
+ * - `channels=ecg,pleth,spo2` selects channels by SensorDataStore::fieldName();
+ *   `sensors` adds the sensor status object. Default: every channel and sensors.
+ * - `<channel>_hz=N` sets the rate of one channel;
+ * - `waveform_hz=N` / `vitals_hz=N` set the rate of the waveform channels
+ *   (ecg, resp, pleth) or of all the others. Per-channel rates win.
+ * - `bed=ID` streams one bed of the ward (see BedStore) instead of the
+ *   monitor's own patient.
+ *
+ * Rates are realised by decimating the stream tick: a channel goes out on
+ * every round(tickHz / hz)-th tick, so a rate at or above the tick rate means
+ * every tick. When waveforms are sampled at a native rate, waveform channels
+ * are instead decimated from the native samples and every frame carries the
+ * kept samples since the previous one. Timestamp and sensor status ride
+ * along with any frame that carries at least one channel.
+ *
+ * Clients with equal subscriptions share one encoded frame per tick; key()
+ * is the canonical form used to group them.
+ */
+class StreamSubscription
+{
+public:
+    /// Selectable channels (SensorDataStore::Field, without Timestamp)
+    static constexpr size_t CHANNEL_COUNT = 8;
+    static constexpr uint16_t ALL_CHANNELS = (1u << CHANNEL_COUNT) - 1;
+
+    /// Every channel on every tick, with sensor status
+    StreamSubscription() = default;
+
+    /**
+     * @brief Build a subscription from query parameters
+     * @param params Decoded query parameters (unrelated keys are ignored)
+     * @param out Parsed subscription
+     * @param error Set to a short reason on failure (may be null)
+     * @return false on an unknown channel or an invalid rate
+     */
+    static bool parse(const std::map<std::string, std::string>& params, StreamSubscription& out,
+                      std::string* error = nullptr);
+
+    /// Channel bitmask (bit i = SensorDataStore::Field(i))
+    uint16_t channels() const { return channels_; }
+
+    /// Whether sensor status is included
+    bool sensors() const { return sensors_; }
+
+    /// Bed id, or empty for the monitor's own patient
+    const std::string& bed() const { return bed_; }
+
+    /// Requested rate of a channel in Hz (0 = every tick)
+    double rateHz(SensorDataStore::Field field) const;
+
+    /// Decimation factor of a channel at a base rate, the tick or native sample rate (1 = keep all)
+    uint32_t decimation(SensorDataStore::Field field, int baseHz) const;
+
+    /**
+     * @brief Channels due on a tick
+     * @param tick Tick sequence number
+     * @param tickHz Current tick rate
+     * @return Bitmask of channels to send (0 = send nothing this tick)
+     */
+    uint16_t dueChannels(uint64_t tick, int tickHz) const;
+
+    /// True for the default (own patient, everything, every tick)
+    bool isDefault() const;
+
+    /// Canonical text form; equal subscriptions have equal keys
+    std::string key() const;
+
+    /// Change the channel selection
+    void setChannels(uint16_t mask, bool sensors);
+
+    /// Change the rate of one channel (0 = every tick)
+    void setRate(SensorDataStore::Field field, double hz);
+
+    /// Change the bed (empty = own patient); ignored unless BedStore::validId()
+    void setBed(const std::string& bed);
+
+    static bool isWaveform(SensorDataStore::Field field);
+
+private:
+    uint16_t channels_ = ALL_CHANNELS;
+    bool sensors_ = true;
+    double rateHz_[CHANNEL_COUNT] = {};
+    std::string bed_;
+};
+
+#endif // STREAM_SUBSCRIPTION_H
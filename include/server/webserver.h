@@ -3,23 +3,32 @@
 
 #include <string>
 #include <atomic>
+#include <chrono>
 #include <thread>
 #include <mutex>
 #include <vector>
 #include <memory>
+#include "core/bed_store.h"
+#include "core/latency_histogram.h"
 #include "core/signal_generator.h"
 #include "hardware/sensor_manager.h"
+#include "server/frame_broadcaster.h"
+#include "server/frame_codec.h"
+#include "server/hub_waveforms.h"
+#include "server/stream_server.h"
 #include "httplib.h"
 
 // Forward declarations
 class SensorManager;
+class MQTTDriver;
 
 /**
  * @brief Lightweight HTTP/WebSocket server for patient monitor data
  * 
  * Serves:
  * - Static HTML/CSS/JS files from web/ directory
- * - Real-time sensor data via WebSocket at /ws
+ * - Real-time sensor data via Server-Sent Events at /ws
+ * - Real-time sensor data via native WebSocket at ws://host:<streamPort>/ws
  * - RESTful API endpoints for configuration
  */
 class WebServer
@@ -59,8 +68,88 @@ public:
      */
     void setUpdateRate(int hz);
 
+    /// Current frame rate in Hertz
+    int getUpdateRate() const { return updateRateHz_.load(); }
+
+    /**
+     * @brief Set the native waveform sample rate (call before start())
+     *
+     * Waveforms (ecg, resp, pleth) are sampled at this rate and each frame
+     * carries the samples since the previous one.
+     * @param hz Samples per second (0 = one sample per frame)
+     */
+    void setWaveformRate(int hz);
+
+    /**
+     * @brief Scheduling of the sensor acquisition thread (call before start())
+     * @param realtimePriority SCHED_FIFO priority 1-99; 0 = normal scheduling
+     * @param cpu CPU to pin the thread to; -1 = any
+     */
+    void setAcquisitionScheduling(int realtimePriority, int cpu);
+
+    /**
+     * @brief Drive the simulated waveforms from a patient state (any thread)
+     * @param physiology Heart rate, respiratory rate, SpO2 and BP baselines
+     */
+    void setPhysiology(const SignalGenerator::Physiology& physiology);
+
+    /**
+     * @brief Note that ingested data (e.g. an MQTT batch) has been published (any thread)
+     *
+     * The next streamed frame records the time since receivedAt in the
+     * ingest latency histogram reported by /api/status.
+     * @param receivedAt When the data was received
+     */
+    void markIngested(std::chrono::steady_clock::time_point receivedAt);
+
+    /// Receive-to-stream latency of ingested data
+    const LatencyHistogram& ingestLatency() const { return ingestLatency_; }
+
     /**
-     * @brief Get current number of connected WebSocket clients
+     * @brief Set the time source for the simulated signals (call before start())
+     *
+     * Shared by the signal generator, the mock sensors and the streamer. A
+     * SimClock::fixedStep() clock is advanced by one step per frame, so
+     * with a step larger than the frame period the stream runs faster than
+     * real time and is exactly reproducible.
+     */
+    void setClock(std::shared_ptr<SimClock> clock);
+
+    /**
+     * @brief Serve the beds of a ward as well as the own patient (call before start())
+     *
+     * Every bed in the store gets its own simulated waveforms, following the
+     * bed's physiology and recorded into the bed's history. Stream clients
+     * select a bed with `bed=ID`; /api/beds lists them and /api/history
+     * takes the same parameter.
+     * @param beds Ward store (must outlive the server), or nullptr for none (default)
+     */
+    void setBedStore(BedStore* beds);
+
+    /**
+     * @brief Report an MQTT driver's ingestion stats at /api/metrics/mqtt (any thread)
+     * @param mqtt Driver (must outlive the server or be reset to nullptr first)
+     */
+    void setMqttDriver(const MQTTDriver* mqtt) { mqtt_ = mqtt; }
+
+    /**
+     * @brief Set the WebSocket stream port (call before start())
+     * @param port TCP port (default: HTTP port + 1)
+     */
+    void setStreamPort(int port) { streamPort_ = port; }
+
+    /**
+     * @brief Get the WebSocket stream port
+     */
+    int getStreamPort() const { return streamPort_; }
+
+    /**
+     * @brief Set per-client outbound queue limits and slow-client policy (call before start())
+     */
+    void setBackpressure(const StreamServer::BackpressureConfig& config) { streamServer_.setBackpressure(config); }
+
+    /**
+     * @brief Get current number of streaming clients (SSE and WebSocket)
      * @return Number of active connections
      */
     int getClientCount() const;
@@ -68,30 +157,69 @@ public:
 private:
     void serverThread();
     void dataStreamThread();
-    void sensorScanThread();
-    std::string generateJsonData(const SignalGenerator::SensorData& data);
+    std::string generateJsonData(const SignalGenerator::SensorData& data, uint16_t channels,
+                                 const std::string& sensorsJson, const FrameCodec::SampleBlock* block = nullptr,
+                                 uint16_t blockChannels = 0, const uint32_t* steps = nullptr);
+    /// Samples of one patient for the current frame (producer only)
+    struct WaveformSource
+    {
+        int64_t nextSample = -1;                         // Next native sample number
+        std::vector<SignalGenerator::SensorData> samples; // Samples of the current frame
+        FrameCodec::SampleBlock block;                   // Run over samples (empty at 0 Hz)
+        SignalGenerator::SensorData data{};              // Newest sample
+    };
+
+    /// One bed of the ward (producer only)
+    struct BedStream
+    {
+        BedStore::Shard* bed = nullptr;
+        SignalGenerator signalGen;
+        uint64_t physiologyVersion = 0;
+        WaveformSource source;
+    };
+
+    /// Sample one patient; hub (own patient only) overlays the hardware waveforms before history and stream
+    void sampleFrame(SignalGenerator& gen, SensorDataStore& history, int tickHz, WaveformSource& src,
+                     HubWaveforms* hub = nullptr);
+    void sampleWaveforms(SignalGenerator& gen, SensorDataStore& history, int tickHz, WaveformSource& src,
+                         HubWaveforms* hub);
+    void sampleBeds(int tickHz);
+    const WaveformSource* bedSource(const std::string& bed) const;
+    void publishFrame();
+    void handleStreamMessage(uint64_t clientId, const std::string& message);
 
     int port_;
+    int streamPort_;
     std::string webRoot_;
     std::atomic<bool> running_;
     std::atomic<int> updateRateHz_;
     bool mockMode_;
     
+    std::shared_ptr<SimClock> clock_;
     SignalGenerator signalGen_;
+    FrameBroadcaster broadcaster_;       // JSON frames, encoded once per tick, shared by all SSE sinks
+    FrameBroadcaster binaryBroadcaster_; // Base64 binary frames (/ws?format=binary)
+    uint32_t frameSeq_ = 0;              // Producer-thread only
+    std::atomic<int64_t> ingestPendingNs_{0}; // Oldest ingest not yet streamed (steady clock ns, 0 = none)
+    LatencyHistogram ingestLatency_;
+    int waveformRateHz_;                 // Native waveform sample rate (0 = per frame)
+    WaveformSource local_;               // The monitor's own patient (producer only)
+    HubWaveforms hubWaveforms_;          // Hub FIFO samples for local_ (producer only)
+    BedStore* beds_ = nullptr;
+    std::atomic<const MQTTDriver*> mqtt_{nullptr};
+    std::vector<std::unique_ptr<BedStream>> bedStreams_; // In BedStore order (producer only)
+    std::vector<uint8_t> binaryBlock_;   // Reused version 3 frame buffer (producer only)
+    StreamServer streamServer_;          // Native WebSocket clients (registered client table)
     std::unique_ptr<SensorManager> sensorMgr_;
+    SensorManager::AcquisitionConfig acquisition_;
     std::unique_ptr<httplib::Server> server_;
     
     std::unique_ptr<std::thread> serverThreadHandle_;
     std::unique_ptr<std::thread> dataThreadHandle_;
-    std::unique_ptr<std::thread> sensorScanThreadHandle_;
     
     // Shutdown synchronization
     std::mutex shutdownMutex_;
     std::condition_variable shutdownCv_;
-    
-    // Thread-safe client management
-    mutable std::mutex clientsMutex_;
-    std::vector<void*> clients_; // WebSocket connection handles
 };
 
 #endif // WEBSERVER_H
@@ -0,0 +1,130 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * @file websocket.h
+ * @brief Minimal RFC 6455 (WebSocket) protocol helpers
+ *
+ * Covers what the streaming server needs: the opening handshake, frame
+ * encoding/decoding with masking, and a small HTTP request parser. No I/O is
+ * performed here; see StreamServer for the socket side.
+ */
+namespace WebSocket
+{
+    /// Frame opcodes (RFC 6455 section 5.2)
+    enum class Opcode : uint8_t
+    {
+        Continuation = 0x0,
+        Text = 0x1,
+        Binary = 0x2,
+        Close = 0x8,
+        Ping = 0x9,
+        Pong = 0xA
+    };
+
+    /// Status codes carried in close frames
+    namespace CloseCode
+    {
+        constexpr uint16_t NORMAL = 1000;
+        constexpr uint16_t GOING_AWAY = 1001;
+        constexpr uint16_t PROTOCOL_ERROR = 1002;
+        constexpr uint16_t TOO_BIG = 1009;
+    }
+
+    /// Largest header: 2 bytes + 8-byte length + 4-byte mask
+    constexpr size_t MAX_HEADER_SIZE = 14;
+
+    /**
+     * @brief One decoded frame
+     */
+    struct Frame
+    {
+        Opcode opcode = Opcode::Text;
+        bool fin = true;
+        bool masked = false;
+        std::string payload; ///< Already unmasked
+    };
+
+    /// Result of parseFrame()
+    enum class ParseResult
+    {
+        NeedMore, ///< Buffer holds an incomplete frame
+        Ok,       ///< One frame decoded
+        Error     ///< Protocol violation or frame exceeds the size limit
+    };
+
+    /**
+     * @brief Decode one frame from the front of a buffer
+     * @param data Received bytes
+     * @param len Number of bytes available
+     * @param out Decoded frame (valid when Ok)
+     * @param consumed Bytes used by the frame (valid when Ok)
+     * @param maxPayload Reject frames larger than this
+     */
+    ParseResult parseFrame(const uint8_t* data, size_t len, Frame& out, size_t& consumed,
+                           size_t maxPayload);
+
+    /**
+     * @brief Write a frame header
+     * @param out Destination, at least MAX_HEADER_SIZE bytes
+     * @param mask Masking key (client-to-server frames); nullptr for unmasked
+     * @return Header length in bytes
+     */
+    size_t writeHeader(uint8_t* out, Opcode opcode, uint64_t payloadLen, bool fin = true,
+                       const uint8_t* mask = nullptr);
+
+    /**
+     * @brief Encode a complete frame
+     * @param mask 4-byte masking key, or nullptr for a server (unmasked) frame
+     */
+    std::string encodeFrame(Opcode opcode, const void* payload, size_t len,
+                            const uint8_t* mask = nullptr);
+
+    /// Close frame payload: 2-byte status code + optional reason
+    std::string encodeClose(uint16_t code, const std::string& reason = std::string());
+
+    /**
+     * @brief Compute Sec-WebSocket-Accept for a client's Sec-WebSocket-Key
+     */
+    std::string acceptKey(const std::string& clientKey);
+
+    /// SHA-1 digest (needed by the handshake only)
+    void sha1(const uint8_t* data, size_t len, uint8_t digest[20]);
+
+    /**
+     * @brief Parsed HTTP/1.1 request head
+     */
+    struct HttpRequest
+    {
+        std::string method;
+        std::string target; ///< Path plus query string
+        std::string path;
+        std::map<std::string, std::string> query;   ///< Decoded query parameters
+        std::map<std::string, std::string> headers; ///< Lower-cased names
+
+        std::string header(const std::string& lowerName) const;
+        std::string param(const std::string& name) const;
+    };
+
+    /**
+     * @brief Parse a request head (everything up to and including "\r\n\r\n")
+     */
+    bool parseHttpRequest(const std::string& head, HttpRequest& out);
+
+    /**
+     * @brief Whether the request is a valid WebSocket upgrade (version 13)
+     */
+    bool isUpgradeRequest(const HttpRequest& req);
+
+    /**
+     * @brief Build the "101 Switching Protocols" response for an upgrade request
+     */
+    std::string handshakeResponse(const HttpRequest& req);
+}
+
+#endif // WEBSOCKET_H
@@ -1,11 +1,146 @@
 // src/core/MQTTDriver.cpp
 #include "core/MQTTDriver.h"
+#include "core/mqtt_log.h"
 
+#include <bitset>
 #include <cstring>
-#include <cstdlib>
-#include <cctype>
 #include <cmath>
 #include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+using PatientData = MQTTDriver::PatientData;
+using Physiology = SignalGenerator::Physiology;
+
+// How a topic's payload is read
+enum class Payload : uint8_t { Number, Boolish };
+
+// SensorDataStore channel fed by a topic
+enum class StoreField : uint8_t { None, Spo2, BpSystolic, BpDiastolic, PlethFromCardiacOutput };
+
+struct TopicEntry {
+  std::string_view name;
+  Payload payload;
+  float PatientData::* value;
+  bool PatientData::* present;
+  StoreField store;
+  double Physiology::* physiology;  // nullptr if the waveforms do not follow it
+};
+
+// Every per-patient topic, spelled as the simulator publishes them ("rhytm",
+// "diabetsKeto"). Beds use the same names under bed/<id>/. Rates
+// (heart/heartRate, lung/respiratoryRate) are not samples; they reach the
+// waveforms through the physiology only.
+constexpr TopicEntry TOPICS[] = {
+  {"heart/heartRate",          Payload::Number,  &PatientData::heartRate,            &PatientData::has_heartRate,            StoreField::None,                   &Physiology::heartRateBpm},
+  {"heart/systolicBP",         Payload::Number,  &PatientData::systolicBP,           &PatientData::has_systolicBP,           StoreField::BpSystolic,             &Physiology::bpSystolic},
+  {"heart/diastolicBP",        Payload::Number,  &PatientData::diastolicBP,          &PatientData::has_diastolicBP,          StoreField::BpDiastolic,            &Physiology::bpDiastolic},
+  {"heart/strokeVolume",       Payload::Number,  &PatientData::strokeVolume,         &PatientData::has_strokeVolume,         StoreField::None,                   nullptr},
+  {"heart/contractility",      Payload::Number,  &PatientData::contractility,        &PatientData::has_contractility,        StoreField::None,                   nullptr},
+  {"heart/cardiacOutput",      Payload::Number,  &PatientData::cardiacOutput,        &PatientData::has_cardiacOutput,        StoreField::PlethFromCardiacOutput, nullptr},
+  {"heart/map",                Payload::Number,  &PatientData::meanArterialPressure, &PatientData::has_meanArterialPressure, StoreField::None,                   nullptr},
+  {"heart/prefactor",          Payload::Number,  &PatientData::preFactor,            &PatientData::has_preFactor,            StoreField::None,                   nullptr},
+  {"heart/rhytm",              Payload::Number,  &PatientData::rhythm,               &PatientData::has_rhythm,               StoreField::None,                   nullptr},
+  {"lung/oxygenSaturation",    Payload::Number,  &PatientData::oxygenSaturation,     &PatientData::has_oxygenSaturation,     StoreField::Spo2,                   &Physiology::spo2},
+  {"lung/respiratoryRate",     Payload::Number,  &PatientData::respiratoryRate,      &PatientData::has_respiratoryRate,      StoreField::None,                   &Physiology::respRateBpm},
+  {"lung/airwayObstruction",   Payload::Number,  &PatientData::airwayObstruction,    &PatientData::has_airwayObstruction,    StoreField::None,                   nullptr},
+  {"conditions/septic",        Payload::Boolish, &PatientData::septic,               &PatientData::has_septic,               StoreField::None,                   nullptr},
+  {"conditions/anaphylaxis",   Payload::Boolish, &PatientData::anaphylaxis,          &PatientData::has_anaphylaxis,          StoreField::None,                   nullptr},
+  {"conditions/diabetesHypo",  Payload::Boolish, &PatientData::diabetesHypo,         &PatientData::has_diabetesHypo,         StoreField::None,                   nullptr},
+  {"conditions/diabetsKeto",   Payload::Boolish, &PatientData::diabetesKeto,         &PatientData::has_diabetesKeto,         StoreField::None,                   nullptr},
+  {"conditions/cardiacArrest", Payload::Boolish, &PatientData::cardiacArrest,        &PatientData::has_cardiacArrest,        StoreField::None,                   nullptr},
+};
+constexpr size_t TOPIC_COUNT = sizeof(TOPICS) / sizeof(TOPICS[0]);
+
+constexpr size_t longestTopicName() {
+  size_t n = 0;
+  for (const TopicEntry& t : TOPICS) n = t.name.size() > n ? t.name.size() : n;
+  return n;
+}
+// Room for "bed/<id>/<topic>" when a bed's topics are reported to the update callback
+constexpr size_t BED_TOPIC_MAX = 4 + BedStore::MAX_ID_LENGTH + 1 + longestTopicName();
+
+// ---- perfect hash over TOPICS ----
+// Seeded FNV-1a; the seed is searched at compile time until every topic lands
+// in a slot of its own, so a lookup is one hash and one string compare.
+constexpr size_t SLOT_COUNT = 64;  // power of two, comfortably above TOPIC_COUNT
+constexpr uint8_t EMPTY_SLOT = 0xFF;
+static_assert(TOPIC_COUNT < SLOT_COUNT, "Topic table too large for the slot table");
+
+constexpr uint32_t topicHash(std::string_view s, uint32_t seed) {
+  uint32_t h = 2166136261u ^ seed;
+  for (char c : s) h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+  return h ^ (h >> 15);
+}
+
+struct SlotTable {
+  uint32_t seed = 0;
+  uint8_t index[SLOT_COUNT] = {};
+};
+
+constexpr SlotTable buildSlots() {
+  for (uint32_t seed = 0; seed < 100000; ++seed) {
+    SlotTable t;
+    t.seed = seed;
+    for (auto& i : t.index) i = EMPTY_SLOT;
+    bool ok = true;
+    for (size_t k = 0; k < TOPIC_COUNT && ok; ++k) {
+      uint8_t& slot = t.index[topicHash(TOPICS[k].name, seed) & (SLOT_COUNT - 1)];
+      ok = (slot == EMPTY_SLOT);
+      slot = static_cast<uint8_t>(k);
+    }
+    if (ok) return t;
+  }
+  return SlotTable{};
+}
+
+constexpr SlotTable SLOTS = buildSlots();
+
+constexpr bool everyTopicHasItsSlot() {
+  for (size_t k = 0; k < TOPIC_COUNT; ++k) {
+    if (SLOTS.index[topicHash(TOPICS[k].name, SLOTS.seed) & (SLOT_COUNT - 1)] != k) return false;
+  }
+  return true;
+}
+static_assert(everyTopicHasItsSlot(), "No collision-free seed found for the topic table");
+
+const TopicEntry* findTopic(std::string_view topic) {
+  const uint8_t i = SLOTS.index[topicHash(topic, SLOTS.seed) & (SLOT_COUNT - 1)];
+  return (i != EMPTY_SLOT && TOPICS[i].name == topic) ? &TOPICS[i] : nullptr;
+}
+
+void stageStore(SensorDataStore::Update& update, StoreField field, float value) {
+  using Field = SensorDataStore::Field;
+  switch (field) {
+    case StoreField::Spo2:        update.set(Field::Spo2, static_cast<double>(value)); break;
+    case StoreField::BpSystolic:  update.set(Field::BpSystolic, static_cast<double>(value)); break;
+    case StoreField::BpDiastolic: update.set(Field::BpDiastolic, static_cast<double>(value)); break;
+    case StoreField::PlethFromCardiacOutput:
+      // Cardiac output can influence plethysmograph waveform
+      // Map CO (2-15 L/min) to pleth amplitude (0.3-0.9)
+      if (value > 0) {
+        double normalizedPleth = 0.3 + (value / 20.0);
+        if (normalizedPleth > 0.9) normalizedPleth = 0.9;
+        update.set(Field::Pleth, normalizedPleth);
+      }
+      break;
+    case StoreField::None:
+      break;
+  }
+}
+
+// Stats slot of the vitals topic, after the topic table
+constexpr size_t VITALS_SLOT = TOPIC_COUNT;
+
+// JSON members read from one vitals message; more is rejected
+constexpr size_t MAX_VITALS_MEMBERS = 64;
+
+// Network thread timing
+constexpr int POLL_TIMEOUT_MS = 100;  // Upper bound on keepalive and stop latency
+constexpr auto RECONNECT_DELAY = std::chrono::seconds(1);
+}  // namespace
 
 MQTTDriver::MQTTDriver(SensorDataStore& sensorStore)
 : sensorStore_(sensorStore) {
@@ -23,15 +158,21 @@ std::cerr << "MQTT connect failed 2\n";  }
 
   // Auto-reconnect settings (simple + effective)
   mosquitto_reconnect_delay_set(mosq_, 1 /*min*/, 10 /*max*/, true /*exponential*/);
+
+  // Lets publish() wake the network loop from another thread
+  wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeFd_ < 0) std::cerr << "[MQTT] Cannot create wake eventfd; publishes wait for the next poll\n";
 }
 
 MQTTDriver::~MQTTDriver() {
+  stopLoop();
   try { disconnect(); } catch (...) {}
   if (mosq_) {
     mosquitto_destroy(mosq_);
     mosq_ = nullptr;
   }
   mosquitto_lib_cleanup();
+  if (wakeFd_ >= 0) ::close(wakeFd_);
 }
 
 void MQTTDriver::setBroker(std::string host, int port) {
@@ -76,6 +217,10 @@ bool MQTTDriver::connect() {
     mosquitto_username_pw_set(mosq_, username_.c_str(), password_.c_str());
   }
 
+  // publish() may run on another thread than the network loop; this makes
+  // libmosquitto lock its state and leave the writing to the loop
+  mosquitto_threaded_set(mosq_, true);
+
   const int rc = mosquitto_connect(mosq_, host_.c_str(), port_, keepAliveSec_);
   if (rc != MOSQ_ERR_SUCCESS) {
     return false;
@@ -86,7 +231,7 @@ bool MQTTDriver::connect() {
 void MQTTDriver::disconnect() {
   if (!mosq_) return;
   mosquitto_disconnect(mosq_);
-  connected_ = false;
+  markDisconnected_();
 }
 
 bool MQTTDriver::isConnected() const {
@@ -96,26 +241,145 @@ bool MQTTDriver::isConnected() const {
 void MQTTDriver::loop(int timeout_ms) {
   if (!mosq_) return;
 
-  // This processes incoming/outgoing packets.
-  // It will also handle automatic reconnect attempts if the connection drops.
-  const int rc = mosquitto_loop(mosq_, timeout_ms, 1 /*max packets*/);
-  if (rc == MOSQ_ERR_NO_CONN) {
-    connected_ = false;
-    // If you want to explicitly trigger reconnect, you can:
+  // One pass of the network thread, then an immediate reconnect if the connection dropped
+  if (service_(timeout_ms) != MOSQ_ERR_SUCCESS) {
+    markDisconnected_();
     mosquitto_reconnect(mosq_);
   }
 }
 
+bool MQTTDriver::startLoop() {
+  if (!mosq_ || loopRunning_) return false;
+  loopRunning_ = true;
+  loopThread_ = std::thread(&MQTTDriver::networkLoop_, this);
+  return true;
+}
+
+void MQTTDriver::stopLoop() {
+  {
+    std::lock_guard<std::mutex> lk(loopMutex_);
+    loopRunning_ = false;
+  }
+  loopCv_.notify_all();
+  if (loopThread_.joinable()) loopThread_.join();
+}
+
+int MQTTDriver::service_(int timeoutMs) {
+  const int fd = mosquitto_socket(mosq_);
+  if (fd < 0) return MOSQ_ERR_NO_CONN;
+
+  // The wait happens outside the batch lock, so setters and stats never stall on it.
+  // publish() wakes it through wakeFd_, so queued messages go out at once.
+  pollfd fds[2] = {{fd, static_cast<short>(POLLIN | (mosquitto_want_write(mosq_) ? POLLOUT : 0)), 0},
+                   {wakeFd_, POLLIN, 0}};
+  const int ready = ::poll(fds, wakeFd_ >= 0 ? 2 : 1, timeoutMs);
+  const pollfd& pfd = fds[0];
+  int rc = MOSQ_ERR_SUCCESS;
+
+  if (ready > 0 && (fds[1].revents & POLLIN)) {
+    uint64_t wakes = 0;
+    [[maybe_unused]] const ssize_t cleared = ::read(wakeFd_, &wakes, sizeof(wakes));
+  }
+  if (ready > 0 && (pfd.revents & (POLLIN | POLLERR | POLLHUP))) {
+    // Drain everything already received, then publish it as one batch
+    std::lock_guard<std::mutex> batch(batchMutex_);
+    for (size_t n = 0; n < MAX_BATCH && rc == MOSQ_ERR_SUCCESS; ++n) {
+      rc = mosquitto_loop_read(mosq_, 1);
+      pollfd more{fd, POLLIN, 0};
+      if (::poll(&more, 1, 0) <= 0) break;
+    }
+    publishBatch_();
+  }
+  if (rc == MOSQ_ERR_SUCCESS && mosquitto_want_write(mosq_)) rc = mosquitto_loop_write(mosq_, 1);
+  if (rc == MOSQ_ERR_SUCCESS) rc = mosquitto_loop_misc(mosq_);  // Keepalive pings
+  return rc;
+}
+
+void MQTTDriver::networkLoop_() {
+  while (loopRunning_) {
+    const int rc = service_(POLL_TIMEOUT_MS);
+
+    if (rc != MOSQ_ERR_SUCCESS) {
+      markDisconnected_();
+      std::unique_lock<std::mutex> lk(loopMutex_);
+      if (loopCv_.wait_for(lk, RECONNECT_DELAY, [this] { return !loopRunning_; })) break;
+      lk.unlock();
+      mosquitto_reconnect(mosq_);  // Subscriptions are renewed by the connect callback
+    }
+  }
+}
+
 MQTTDriver::PatientData MQTTDriver::getPatientDataSnapshot() const {
   std::lock_guard<std::mutex> lk(mtx_);
   return patient_;
 }
 
-void MQTTDriver::setUpdateCallback(UpdateCallback cb) {
+SignalGenerator::Physiology MQTTDriver::physiology() const {
   std::lock_guard<std::mutex> lk(mtx_);
+  SignalGenerator::Physiology p;
+  if (patient_.has_heartRate) p.heartRateBpm = patient_.heartRate;
+  if (patient_.has_respiratoryRate) p.respRateBpm = patient_.respiratoryRate;
+  if (patient_.has_oxygenSaturation) p.spo2 = patient_.oxygenSaturation;
+  if (patient_.has_systolicBP) p.bpSystolic = patient_.systolicBP;
+  if (patient_.has_diastolicBP) p.bpDiastolic = patient_.diastolicBP;
+  return p;
+}
+
+void MQTTDriver::setBedStore(BedStore* beds) {
+  beds_ = beds;
+}
+
+std::string_view MQTTDriver::vitalsField(size_t bit) {
+  return bit < TOPIC_COUNT ? TOPICS[bit].name : std::string_view();
+}
+
+std::string_view MQTTDriver::statsTopic(size_t slot) {
+  static_assert(VITALS_SLOT < MqttStats::MAX_TOPICS, "Raise MqttStats::MAX_TOPICS");
+  return slot == VITALS_SLOT ? VITALS_TOPIC : vitalsField(slot);
+}
+
+bool MQTTDriver::setPayloadFormat(std::string_view topic, MqttPayload::Format format) {
+  static_assert(TOPIC_COUNT <= MAX_TOPICS, "Raise MQTTDriver::MAX_TOPICS");
+  if (topic == VITALS_TOPIC) {
+    if (format != MqttPayload::Format::Text && format != MqttPayload::Format::Float32) return false;
+    vitalsFormat_ = format;
+    return true;
+  }
+  const TopicEntry* entry = findTopic(topic);
+  if (!entry) return false;
+  payloadFormats_[static_cast<size_t>(entry - TOPICS)] = format;
+  return true;
+}
+
+void MQTTDriver::setRecorder(MqttRecorder* recorder) {
+  std::lock_guard<std::mutex> batch(batchMutex_);
+  recorder_ = recorder;
+}
+
+bool MQTTDriver::publish(std::string_view topic, const void* payload, int payloadlen) {
+  if (!mosq_ || !connected_) return false;
+  const std::string name(topic);  // mosquitto wants a C string
+  if (mosquitto_publish(mosq_, nullptr, name.c_str(), payloadlen, payload, 0 /*qos*/, false) != MOSQ_ERR_SUCCESS) {
+    return false;
+  }
+  // The message is only queued (threaded mode); wake the loop to write it
+  if (wakeFd_ >= 0) {
+    const uint64_t one = 1;
+    [[maybe_unused]] const ssize_t woke = ::write(wakeFd_, &one, sizeof(one));  // Fails only if a wake is pending
+  }
+  return true;
+}
+
+void MQTTDriver::setUpdateCallback(UpdateCallback cb) {
+  std::lock_guard<std::mutex> batch(batchMutex_);  // Callbacks run under the batch lock
   updateCb_ = std::move(cb);
 }
 
+void MQTTDriver::setBatchCallback(BatchCallback cb) {
+  std::lock_guard<std::mutex> batch(batchMutex_);
+  batchCb_ = std::move(cb);
+}
+
 // ---- callbacks ----
 
 void MQTTDriver::onConnect_(struct mosquitto*, void* userdata, int rc) {
@@ -125,7 +389,7 @@ void MQTTDriver::onConnect_(struct mosquitto*, void* userdata, int rc) {
 
 void MQTTDriver::onDisconnect_(struct mosquitto*, void* userdata, int /*rc*/) {
   auto* self = static_cast<MQTTDriver*>(userdata);
-  if (self) self->connected_ = false;
+  if (self) self->markDisconnected_();
 }
 
 void MQTTDriver::onMessage_(struct mosquitto*, void* userdata, const struct mosquitto_message* msg) {
@@ -138,10 +402,17 @@ void MQTTDriver::onMessage_(struct mosquitto*, void* userdata, const struct mosq
 void MQTTDriver::handleConnect_(int rc) {
   connected_ = (rc == 0);
   if (connected_) {
+    stats_.add(MqttStats::Counter::Connect);
+    if (everConnected_) stats_.add(MqttStats::Counter::Reconnect);
+    everConnected_ = true;
     subscribeAll_();
   }
 }
 
+void MQTTDriver::markDisconnected_() {
+  if (connected_.exchange(false)) stats_.add(MqttStats::Counter::Disconnect);
+}
+
 bool MQTTDriver::subscribeAll_() {
   if (!mosq_) return false;
 
@@ -149,29 +420,19 @@ bool MQTTDriver::subscribeAll_() {
   constexpr int QOS = 0;
 
   bool ok = true;
-
-  // Heart (exact names from your screenshot)
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "heart/heartRate", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "heart/systolicBP", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "heart/diastolicBP", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "heart/strokeVolume", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "heart/contractility", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "heart/cardiacOutput", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "heart/map", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "heart/prefactor", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "heart/rhytm", QOS) == MOSQ_ERR_SUCCESS);
-
-  // Lung
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "lung/oxygenSaturation", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "lung/respiratoryRate", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "lung/airwayObstruction", QOS) == MOSQ_ERR_SUCCESS);
-
-  // Conditions (exact names from your screenshot)
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "conditions/septic", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "conditions/anaphylaxis", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "conditions/diabetesHypo", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "conditions/diabetsKeto", QOS) == MOSQ_ERR_SUCCESS);
-  ok &= (mosquitto_subscribe(mosq_, nullptr, "conditions/cardiacArrest", QOS) == MOSQ_ERR_SUCCESS);
+  for (const TopicEntry& t : TOPICS) {
+    const std::string name(t.name);
+    ok &= (mosquitto_subscribe(mosq_, nullptr, name.c_str(), QOS) == MOSQ_ERR_SUCCESS);
+  }
+  ok &= (mosquitto_subscribe(mosq_, nullptr, std::string(VITALS_TOPIC).c_str(), QOS) == MOSQ_ERR_SUCCESS);
+
+  // Ward: the same topics per bed, routed to the bed's shard
+  if (beds_) {
+    ok &= (mosquitto_subscribe(mosq_, nullptr, "bed/+/heart/#", QOS) == MOSQ_ERR_SUCCESS);
+    ok &= (mosquitto_subscribe(mosq_, nullptr, "bed/+/lung/#", QOS) == MOSQ_ERR_SUCCESS);
+    ok &= (mosquitto_subscribe(mosq_, nullptr, "bed/+/conditions/#", QOS) == MOSQ_ERR_SUCCESS);
+    ok &= (mosquitto_subscribe(mosq_, nullptr, "bed/+/patient/vitals", QOS) == MOSQ_ERR_SUCCESS);
+  }
 
   return ok;
 }
@@ -181,181 +442,181 @@ void MQTTDriver::setField_(float& field, bool& hasFlag, float value) {
   hasFlag = true;
 }
 
-void MQTTDriver::handleMessage_(const std::string& topic, const void* payload, int payloadlen) {
-  const char* bytes = static_cast<const char*>(payload);
-  if (!bytes || payloadlen <= 0) return;
+void MQTTDriver::ingest(std::string_view topic, const void* payload, int payloadlen) {
+  std::lock_guard<std::mutex> batch(batchMutex_);
+  handleMessage_(topic, payload, payloadlen);
+  publishBatch_();
+}
 
-  float value = NAN;
-  bool parsed = false;
+void MQTTDriver::ingestBatch(const Message* messages, size_t count) {
+  std::lock_guard<std::mutex> batch(batchMutex_);
+  for (size_t i = 0; i < count; ++i) {
+    handleMessage_(messages[i].topic, messages[i].payload, messages[i].payloadlen);
+  }
+  publishBatch_();
+}
 
-  const bool isCondition = (topic.rfind("conditions/", 0) == 0);
-  if (isCondition) {
-    parsed = parseBoolish_(bytes, payloadlen, value);
-    if (!parsed) parsed = parseFloat_(bytes, payloadlen, value);
+void MQTTDriver::handleMessage_(std::string_view fullTopic, const void* payload, int payloadlen) {
+  if (!payload || payloadlen < 0) payloadlen = 0;  // Counted; an empty payload fails to parse
+  if (recorder_) recorder_->record(fullTopic, payload, payloadlen);
+
+  // bed/<id>/<topic> carries the same per-patient topics for one bed
+  std::string_view bedId;
+  std::string_view topic = fullTopic;
+  const bool forBed = beds_ && BedStore::splitTopic(fullTopic, bedId, topic);
+
+  // Parse everything before staging anything, so a message applies whole or not at all
+  uint32_t topics = 0;
+  float values[TOPIC_COUNT];
+  const std::string_view bytes(static_cast<const char*>(payload), static_cast<size_t>(payloadlen));
+  if (topic == VITALS_TOPIC) {
+    const bool parsed = parseVitals_(bytes, topics, values);
+    stats_.topic(VITALS_SLOT, parsed);
+    if (!parsed || topics == 0) return;
   } else {
-    parsed = parseFloat_(bytes, payloadlen, value);
-  }
-  if (!parsed) return;
-
-  // Update SensorDataStore (SensorData struct) where it fits.
-  // SensorData fields: ecg, spo2, resp, pleth, bp_systolic, bp_diastolic, temp_cavity, temp_skin, timestamp
-  if (topic == "lung/oxygenSaturation") {
-    sensorStore_.setSpo2(static_cast<double>(value));
-  } else if (topic == "lung/respiratoryRate") {
-    sensorStore_.setResp(static_cast<double>(value));
-  } else if (topic == "heart/systolicBP") {
-    sensorStore_.setBpSystolic(static_cast<double>(value));
-  } else if (topic == "heart/diastolicBP") {
-    sensorStore_.setBpDiastolic(static_cast<double>(value));
-  } else if (topic == "heart/heartRate") {
-    // Convert heart rate to approximate ECG amplitude
-    // Normal ECG has P wave (~0.1mV), QRS complex (~1mV), T wave (~0.3mV)
-    // Map heart rate (30-200 bpm) to a normalized ECG signal
-    double normalizedEcg = 0.0;
-    if (value > 0) {
-      // Normalize around 75 BPM as baseline (0.5 amplitude)
-      normalizedEcg = 0.5 + (value - 75.0) / 300.0;
-      // Clamp to valid range
-      if (normalizedEcg < 0.1) normalizedEcg = 0.1;
-      if (normalizedEcg > 0.9) normalizedEcg = 0.9;
-    }
-    sensorStore_.setEcg(normalizedEcg);
-  } else if (topic == "heart/cardiacOutput") {
-    // Cardiac output can influence plethysmograph waveform
-    // Map CO (2-15 L/min) to pleth amplitude (0.3-0.9)
-    if (value > 0) {
-      double normalizedPleth = 0.3 + (value / 20.0);
-      if (normalizedPleth > 0.9) normalizedPleth = 0.9;
-      sensorStore_.setPleth(normalizedPleth);
+    // One hash and one compare; unknown topics are ignored
+    const TopicEntry* entry = findTopic(topic);
+    if (!entry) {
+      stats_.add(MqttStats::Counter::Received);
+      stats_.add(MqttStats::Counter::UnknownTopic);
+      return;
     }
+    const size_t index = static_cast<size_t>(entry - TOPICS);
+
+    // Parsed in place, no allocation
+    const bool parsed =
+        MqttPayload::parse(payloadFormats_[index], bytes, entry->payload == Payload::Boolish, values[index]);
+    stats_.topic(index, parsed);
+    if (!parsed) return;
+    topics = 1u << index;
   }
 
-  UpdateCallback cbCopy;
-
-  // Update internal snapshot for everything
-  {
-    std::lock_guard<std::mutex> lk(mtx_);
-
-    // ---- switch-like routing (fast + readable) ----
-    // We can’t switch on std::string directly; instead we do if-chain here.
-    // If you want, I can convert this to enum+switch.
-    if (topic == "heart/heartRate") {
-      setField_(patient_.heartRate, patient_.has_heartRate, value);
-    } else if (topic == "heart/systolicBP") {
-      setField_(patient_.systolicBP, patient_.has_systolicBP, value);
-    } else if (topic == "heart/diastolicBP") {
-      setField_(patient_.diastolicBP, patient_.has_diastolicBP, value);
-    } else if (topic == "heart/strokeVolume") {
-      setField_(patient_.strokeVolume, patient_.has_strokeVolume, value);
-    } else if (topic == "heart/contractility") {
-      setField_(patient_.contractility, patient_.has_contractility, value);
-    } else if (topic == "heart/cardiacOutput") {
-      setField_(patient_.cardiacOutput, patient_.has_cardiacOutput, value);
-    } else if (topic == "heart/map") {
-      setField_(patient_.meanArterialPressure, patient_.has_meanArterialPressure, value);
-    } else if (topic == "heart/prefactor") {
-      setField_(patient_.preFactor, patient_.has_preFactor, value);
-    } else if (topic == "heart/rhytm") {
-      setField_(patient_.rhythm, patient_.has_rhythm, value);
-    }
-
-    else if (topic == "lung/oxygenSaturation") {
-      setField_(patient_.oxygenSaturation, patient_.has_oxygenSaturation, value);
-    } else if (topic == "lung/respiratoryRate") {
-      setField_(patient_.respiratoryRate, patient_.has_respiratoryRate, value);
-    } else if (topic == "lung/airwayObstruction") {
-      setField_(patient_.airwayObstruction, patient_.has_airwayObstruction, value);
-    }
-
-    else if (topic == "conditions/septic") {
-      setField_(patient_.septic, patient_.has_septic, value);
-    } else if (topic == "conditions/anaphylaxis") {
-      setField_(patient_.anaphylaxis, patient_.has_anaphylaxis, value);
-    } else if (topic == "conditions/diabetesHypo") {
-      setField_(patient_.diabetesHypo, patient_.has_diabetesHypo, value);
-    } else if (topic == "conditions/diabetsKeto") {
-      setField_(patient_.diabetesKeto, patient_.has_diabetesKeto, value);
-    } else if (topic == "conditions/cardiacArrest") {
-      setField_(patient_.cardiacArrest, patient_.has_cardiacArrest, value);
-    } else {
-      // unknown topic, ignore
+  BedStore::Shard* bed = nullptr;
+  if (forBed) {
+    bed = beds_->acquire(bedId);
+    if (!bed) {
+      stats_.add(MqttStats::Counter::BedFull);
       return;
     }
-
-    cbCopy = updateCb_;
   }
 
-  if (cbCopy) cbCopy(topic, value);
+  if (batch_.messages++ == 0) batch_.received = std::chrono::steady_clock::now();
+  for (size_t k = 0; k < TOPIC_COUNT; ++k) {
+    if (topics & (1u << k)) stage_(bed, k, values[k]);
+  }
 }
 
-// ---- parsing helpers ----
-
-std::string MQTTDriver::trim_(std::string s) {
-  size_t i = 0;
-  while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i]))) i++;
-  s.erase(0, i);
-  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.pop_back();
-  return s;
-}
+bool MQTTDriver::parseVitals_(std::string_view payload, uint32_t& topics, float* values) const {
+  topics = 0;
+  if (vitalsFormat_ == MqttPayload::Format::Float32) {
+    // uint32 mask, then one float per set bit in table order
+    if (payload.size() < 4) return false;
+    const auto* p = reinterpret_cast<const uint8_t*>(payload.data());
+    const uint32_t mask = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                          (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    if ((mask >> TOPIC_COUNT) != 0 || payload.size() != 4 + 4 * std::bitset<32>(mask).count()) return false;
+
+    size_t offset = 4;
+    for (size_t k = 0; k < TOPIC_COUNT; ++k) {
+      if (!(mask & (1u << k))) continue;
+      float v;
+      if (!MqttPayload::parseRawFloat(payload.substr(offset, 4), v)) return false;
+      values[k] = (TOPICS[k].payload == Payload::Boolish) ? (v != 0.0f ? 1.0f : 0.0f) : v;
+      offset += 4;
+    }
+    topics = mask;
+    return true;
+  }
 
-std::string MQTTDriver::lower_(std::string s) {
-  for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
-  return s;
+  MqttPayload::JsonMember members[MAX_VITALS_MEMBERS];
+  size_t count = 0;
+  if (!MqttPayload::parseJsonObject(payload, members, MAX_VITALS_MEMBERS, count)) return false;
+  for (size_t i = 0; i < count; ++i) {
+    const TopicEntry* entry = findTopic(members[i].name());
+    if (!entry) continue;
+    const size_t k = static_cast<size_t>(entry - TOPICS);
+    if (!MqttPayload::parse(MqttPayload::Format::Text, members[i].value, entry->payload == Payload::Boolish,
+                            values[k])) {
+      return false;
+    }
+    topics |= 1u << k;
+  }
+  return true;
 }
 
-bool MQTTDriver::parseFloat_(const char* bytes, int len, float& out) {
-  if (!bytes || len <= 0) return false;
-
-  // Copy into a small null-terminated buffer
-  char buf[64];
-  const int n = (len < static_cast<int>(sizeof(buf) - 1)) ? len : static_cast<int>(sizeof(buf) - 1);
-  std::memcpy(buf, bytes, n);
-  buf[n] = '\0';
-
-  std::string s = trim_(buf);
-  if (s.empty()) return false;
-
-  const char* c = s.c_str();
-  char* end = nullptr;
-  out = std::strtof(c, &end);
-  if (end == c) return false;
-
-  while (*end) {
-    if (!std::isspace(static_cast<unsigned char>(*end))) return false;
-    ++end;
+void MQTTDriver::stage_(BedStore::Shard* bed, size_t topic, float value) {
+  Pending* p = nullptr;
+  for (size_t i = 0; i < pendingCount_ && !p; ++i) {
+    if (pending_[i].bed == bed) p = &pending_[i];
   }
-  return true;
+  if (!p) {
+    p = &pending_[pendingCount_++];  // One slot per bed plus the own patient always suffices
+    p->bed = bed;
+    p->topics = 0;
+  }
+  p->values[topic] = value;  // Later messages for the same topic win
+  p->topics |= 1u << topic;
 }
 
-bool MQTTDriver::parseBoolish_(const char* bytes, int len, float& out) {
-  if (!bytes || len <= 0) return false;
+void MQTTDriver::publishBatch_() {
+  if (batch_.messages == 0) return;
 
-  char buf[64];
-  const int n = (len < static_cast<int>(sizeof(buf) - 1)) ? len : static_cast<int>(sizeof(buf) - 1);
-  std::memcpy(buf, bytes, n);
-  buf[n] = '\0';
+  for (size_t i = 0; i < pendingCount_; ++i) {
+    const Pending& p = pending_[i];
 
-  std::string s = lower_(trim_(buf));
-  if (s.empty()) return false;
+    SensorDataStore::Update update;
+    bool physiology = false;
+    for (size_t k = 0; k < TOPIC_COUNT; ++k) {
+      if (p.topics & (1u << k)) {
+        stageStore(update, TOPICS[k].store, p.values[k]);
+        physiology |= TOPICS[k].physiology != nullptr;
+      }
+    }
 
-  if (s == "true" || s == "on" || s == "yes") { out = 1.0f; return true; }
-  if (s == "false" || s == "off" || s == "no") { out = 0.0f; return true; }
+    if (p.bed) {
+      // Each bed has its own shard, so beds never contend with each other here
+      p.bed->store.apply(update);
+      if (physiology) {
+        p.bed->updatePhysiology([&](Physiology& phys) {
+          for (size_t k = 0; k < TOPIC_COUNT; ++k) {
+            if ((p.topics & (1u << k)) && TOPICS[k].physiology) phys.*TOPICS[k].physiology = p.values[k];
+          }
+        });
+      }
+    } else {
+      sensorStore_.apply(update);
+      std::lock_guard<std::mutex> lk(mtx_);
+      for (size_t k = 0; k < TOPIC_COUNT; ++k) {
+        if (p.topics & (1u << k)) setField_(patient_.*TOPICS[k].value, patient_.*TOPICS[k].present, p.values[k]);
+      }
+      batch_.patient = true;
+    }
+  }
 
-  float v = NAN;
-  // allow numeric and map to 0/1
-  const char* c = s.c_str();
-  char* end = nullptr;
-  v = std::strtof(c, &end);
-  if (end != c) {
-    while (*end) {
-      if (!std::isspace(static_cast<unsigned char>(*end))) return false;
-      ++end;
+  stats_.add(MqttStats::Counter::Batch);
+  stats_.recordPublish(std::chrono::steady_clock::now() - batch_.received);
+
+  if (updateCb_) {
+    char topic[BED_TOPIC_MAX];
+    for (size_t i = 0; i < pendingCount_; ++i) {
+      const Pending& p = pending_[i];
+      size_t prefix = 0;
+      if (p.bed) {
+        std::memcpy(topic, "bed/", 4);
+        std::memcpy(topic + 4, p.bed->id.data(), p.bed->id.size());
+        prefix = 4 + p.bed->id.size();
+        topic[prefix++] = '/';
+      }
+      for (size_t k = 0; k < TOPIC_COUNT; ++k) {
+        if (!(p.topics & (1u << k))) continue;
+        const std::string_view name = TOPICS[k].name;
+        std::memcpy(topic + prefix, name.data(), name.size());
+        updateCb_(std::string_view(topic, prefix + name.size()), p.values[k]);
+      }
     }
-    out = (v != 0.0f) ? 1.0f : 0.0f;
-    return true;
   }
+  if (batchCb_) batchCb_(batch_);
 
-  return false;
+  pendingCount_ = 0;
+  batch_ = BatchInfo{};
 }
-
-
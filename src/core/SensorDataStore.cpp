@@ -1,183 +1,207 @@
 // SensorDataStore.cpp
 #include "core/SensorDataStore.h"
 
-SensorDataStore::SensorDataStore() = default;
+#include <algorithm>
 
-void SensorDataStore::setField_(double& field,
-                                bool& hasFlag,
-                                TimePoint& ts,
-                                double v) {
-  field = v;
-  hasFlag = true;
-  ts = Clock::now();
-}
-
-// ----- Setters -----
-void SensorDataStore::setEcg(double v) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  setField_(data_.ecg, has_ecg_, ts_ecg_, v);
-}
-
-void SensorDataStore::setSpo2(double v) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  setField_(data_.spo2, has_spo2_, ts_spo2_, v);
-}
-
-void SensorDataStore::setResp(double v) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  setField_(data_.resp, has_resp_, ts_resp_, v);
-}
+namespace {
+using SensorData = SignalGenerator::SensorData;
 
-void SensorDataStore::setPleth(double v) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  setField_(data_.pleth, has_pleth_, ts_pleth_, v);
+// Indexed by SensorDataStore::Field
+constexpr double SensorData::* FIELD_MEMBERS[SensorDataStore::FIELD_COUNT] = {
+  &SensorData::ecg,
+  &SensorData::spo2,
+  &SensorData::resp,
+  &SensorData::pleth,
+  &SensorData::bp_systolic,
+  &SensorData::bp_diastolic,
+  &SensorData::temp_cavity,
+  &SensorData::temp_skin,
+  &SensorData::timestamp,
+};
 }
 
-void SensorDataStore::setBpSystolic(double v) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  setField_(data_.bp_systolic, has_bp_systolic_, ts_bp_systolic_, v);
-}
+SensorDataStore::SensorDataStore(double historySeconds) {
+  historySeconds = std::max(historySeconds, 1.0 / VITALS_HISTORY_RATE_HZ);
+  const auto waveformCapacity = static_cast<size_t>(historySeconds * WAVEFORM_HISTORY_RATE_HZ);
+  const auto vitalsCapacity = static_cast<size_t>(historySeconds * VITALS_HISTORY_RATE_HZ);
 
-void SensorDataStore::setBpDiastolic(double v) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  setField_(data_.bp_diastolic, has_bp_diastolic_, ts_bp_diastolic_, v);
+  for (size_t i = 0; i < FIELD_COUNT; ++i) {
+    const Field f = static_cast<Field>(i);
+    if (f == Field::Timestamp) continue;
+    const bool waveform = (f == Field::Ecg || f == Field::Resp || f == Field::Pleth);
+    history_[i] = std::make_unique<TimeSeriesRing>(waveform ? waveformCapacity : vitalsCapacity);
+  }
 }
 
-void SensorDataStore::setTempCavity(double v) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  setField_(data_.temp_cavity, has_temp_cavity_, ts_temp_cavity_, v);
+double SensorDataStore::Snapshot::value(Field f) const {
+  if (!has(f)) return 0;
+  return data.*FIELD_MEMBERS[static_cast<size_t>(f)];
 }
 
-void SensorDataStore::setTempSkin(double v) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  setField_(data_.temp_skin, has_temp_skin_, ts_temp_skin_, v);
+void SensorDataStore::setField_(Snapshot& s, Field f, double v, TimePoint now) {
+  s.data.*FIELD_MEMBERS[static_cast<size_t>(f)] = v;
+  s.present |= 1u << static_cast<unsigned>(f);
+  s.updated[static_cast<size_t>(f)] = now;
 }
 
-void SensorDataStore::setTimestamp(double v) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  setField_(data_.timestamp, has_timestamp_, ts_timestamp_, v);
+void SensorDataStore::set_(Field f, double v) {
+  const TimePoint now = Clock::now();
+  state_.update([&](Snapshot& s) { setField_(s, f, v, now); });
 }
 
-void SensorDataStore::setBulk(const double& ecg,
-                              const double& spo2,
-                              const double& resp,
-                              const double& pleth,
-                              const double& bp_systolic,
-                              const double& bp_diastolic,
-                              const double& temp_cavity,
-                              const double& temp_skin,
-                              const double& timestamp) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  if (ecg)         setField_(data_.ecg,         has_ecg_,         ts_ecg_,         ecg);
-  if (spo2)        setField_(data_.spo2,        has_spo2_,        ts_spo2_,        spo2);
-  if (resp)        setField_(data_.resp,        has_resp_,        ts_resp_,        resp);
-  if (pleth)       setField_(data_.pleth,       has_pleth_,       ts_pleth_,       pleth);
-  if (bp_systolic) setField_(data_.bp_systolic, has_bp_systolic_, ts_bp_systolic_, bp_systolic);
-  if (bp_diastolic)setField_(data_.bp_diastolic,has_bp_diastolic_,ts_bp_diastolic_, bp_diastolic);
-  if (temp_cavity) setField_(data_.temp_cavity, has_temp_cavity_, ts_temp_cavity_, temp_cavity);
-  if (temp_skin)   setField_(data_.temp_skin,   has_temp_skin_,   ts_temp_skin_,   temp_skin);
-  if (timestamp)   setField_(data_.timestamp,   has_timestamp_,   ts_timestamp_,   timestamp);
+// ----- Setters -----
+void SensorDataStore::setEcg(double v)         { set_(Field::Ecg, v); }
+void SensorDataStore::setSpo2(double v)        { set_(Field::Spo2, v); }
+void SensorDataStore::setResp(double v)        { set_(Field::Resp, v); }
+void SensorDataStore::setPleth(double v)       { set_(Field::Pleth, v); }
+void SensorDataStore::setBpSystolic(double v)  { set_(Field::BpSystolic, v); }
+void SensorDataStore::setBpDiastolic(double v) { set_(Field::BpDiastolic, v); }
+void SensorDataStore::setTempCavity(double v)  { set_(Field::TempCavity, v); }
+void SensorDataStore::setTempSkin(double v)    { set_(Field::TempSkin, v); }
+void SensorDataStore::setTimestamp(double v)   { set_(Field::Timestamp, v); }
+
+void SensorDataStore::setBulk(std::optional<double> ecg,
+                              std::optional<double> spo2,
+                              std::optional<double> resp,
+                              std::optional<double> pleth,
+                              std::optional<double> bp_systolic,
+                              std::optional<double> bp_diastolic,
+                              std::optional<double> temp_cavity,
+                              std::optional<double> temp_skin,
+                              std::optional<double> timestamp) {
+  const std::optional<double>* values[FIELD_COUNT] = {
+    &ecg, &spo2, &resp, &pleth, &bp_systolic, &bp_diastolic, &temp_cavity, &temp_skin, &timestamp,
+  };
+  Update update;
+  for (size_t i = 0; i < FIELD_COUNT; ++i) {
+    if (*values[i]) update.set(static_cast<Field>(i), **values[i]);
+  }
+  apply(update);
+}
+
+void SensorDataStore::apply(const Update& update) {
+  if (update.empty()) return;
+  const TimePoint now = Clock::now();
+  // One publish for all provided fields, so readers see them together
+  state_.update([&](Snapshot& s) {
+    for (size_t i = 0; i < FIELD_COUNT; ++i) {
+      if (update.present & (1u << i)) setField_(s, static_cast<Field>(i), update.values[i], now);
+    }
+  });
 }
 
 // ----- Getters -----
-double SensorDataStore::getEcg() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return has_ecg_ ? data_.ecg : 0;
-}
+double SensorDataStore::getEcg() const         { return snapshot().value(Field::Ecg); }
+double SensorDataStore::getSpo2() const        { return snapshot().value(Field::Spo2); }
+double SensorDataStore::getResp() const        { return snapshot().value(Field::Resp); }
+double SensorDataStore::getPleth() const       { return snapshot().value(Field::Pleth); }
+double SensorDataStore::getBpSystolic() const  { return snapshot().value(Field::BpSystolic); }
+double SensorDataStore::getBpDiastolic() const { return snapshot().value(Field::BpDiastolic); }
+double SensorDataStore::getTempCavity() const  { return snapshot().value(Field::TempCavity); }
+double SensorDataStore::getTempSkin() const    { return snapshot().value(Field::TempSkin); }
+double SensorDataStore::getTimestamp() const   { return snapshot().value(Field::Timestamp); }
 
-double SensorDataStore::getSpo2() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return has_spo2_ ? double(data_.spo2) : 0;
-}
-
-double SensorDataStore::getResp() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return has_resp_ ? double(data_.resp) : 0;
-}
-
-double SensorDataStore::getPleth() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return has_pleth_ ? double(data_.pleth) : 0;
-}
-
-double SensorDataStore::getBpSystolic() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return has_bp_systolic_ ? double(data_.bp_systolic) : 0;
-}
-
-double SensorDataStore::getBpDiastolic() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return has_bp_diastolic_ ? double(data_.bp_diastolic) : 0;
-}
-
-double SensorDataStore::getTempCavity() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return has_temp_cavity_ ? double(data_.temp_cavity) : 0;
-}
-
-double SensorDataStore::getTempSkin() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return has_temp_skin_ ? double(data_.temp_skin) : 0;
-}
+// ----- Has flags -----
+bool SensorDataStore::hasEcg() const { return snapshot().has(Field::Ecg); }
+bool SensorDataStore::hasSpo2() const { return snapshot().has(Field::Spo2); }
+bool SensorDataStore::hasResp() const { return snapshot().has(Field::Resp); }
+bool SensorDataStore::hasPleth() const { return snapshot().has(Field::Pleth); }
+bool SensorDataStore::hasBpSystolic() const { return snapshot().has(Field::BpSystolic); }
+bool SensorDataStore::hasBpDiastolic() const { return snapshot().has(Field::BpDiastolic); }
+bool SensorDataStore::hasTempCavity() const { return snapshot().has(Field::TempCavity); }
+bool SensorDataStore::hasTempSkin() const { return snapshot().has(Field::TempSkin); }
+bool SensorDataStore::hasTimestamp() const { return snapshot().has(Field::Timestamp); }
 
-double SensorDataStore::getTimestamp() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return has_timestamp_ ? double(data_.timestamp) : 0;
+void SensorDataStore::clear() {
+  state_.store(Snapshot{});
 }
 
-// ----- Has flags -----
-bool SensorDataStore::hasEcg() const { std::lock_guard<std::mutex> lk(mtx_); return has_ecg_; }
-bool SensorDataStore::hasSpo2() const { std::lock_guard<std::mutex> lk(mtx_); return has_spo2_; }
-bool SensorDataStore::hasResp() const { std::lock_guard<std::mutex> lk(mtx_); return has_resp_; }
-bool SensorDataStore::hasPleth() const { std::lock_guard<std::mutex> lk(mtx_); return has_pleth_; }
-bool SensorDataStore::hasBpSystolic() const { std::lock_guard<std::mutex> lk(mtx_); return has_bp_systolic_; }
-bool SensorDataStore::hasBpDiastolic() const { std::lock_guard<std::mutex> lk(mtx_); return has_bp_diastolic_; }
-bool SensorDataStore::hasTempCavity() const { std::lock_guard<std::mutex> lk(mtx_); return has_temp_cavity_; }
-bool SensorDataStore::hasTempSkin() const { std::lock_guard<std::mutex> lk(mtx_); return has_temp_skin_; }
-bool SensorDataStore::hasTimestamp() const { std::lock_guard<std::mutex> lk(mtx_); return has_timestamp_; }
-
 // ----- Snapshot -----
-SignalGenerator::SensorData SensorDataStore::snapshot() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return data_;
+SensorDataStore::Snapshot SensorDataStore::snapshot() const {
+  return state_.load();
+}
+
+// ----- History -----
+void SensorDataStore::recordHistory(const SignalGenerator::SensorData& frame) {
+  const double t = frame.timestamp;
+
+  history_[static_cast<size_t>(Field::Ecg)]->push(t, frame.ecg);
+  history_[static_cast<size_t>(Field::Resp)]->push(t, frame.resp);
+  history_[static_cast<size_t>(Field::Pleth)]->push(t, frame.pleth);
+
+  // Vitals change slowly; keep them at a reduced rate so 10 minutes stay cheap.
+  // The small tolerance absorbs rounding in frame timestamps.
+  constexpr double vitalsPeriod = 0.999 / VITALS_HISTORY_RATE_HZ;
+  if (haveVitalsHistory_ && t - lastVitalsHistoryT_ < vitalsPeriod) return;
+  haveVitalsHistory_ = true;
+  lastVitalsHistoryT_ = t;
+
+  history_[static_cast<size_t>(Field::Spo2)]->push(t, frame.spo2);
+  history_[static_cast<size_t>(Field::BpSystolic)]->push(t, frame.bp_systolic);
+  history_[static_cast<size_t>(Field::BpDiastolic)]->push(t, frame.bp_diastolic);
+  history_[static_cast<size_t>(Field::TempCavity)]->push(t, frame.temp_cavity);
+  history_[static_cast<size_t>(Field::TempSkin)]->push(t, frame.temp_skin);
+}
+
+size_t SensorDataStore::readHistory(Field f, double from, double to,
+                                    std::vector<TimeSample>& out, size_t maxSamples) const {
+  const size_t i = static_cast<size_t>(f);
+  if (i >= FIELD_COUNT || !history_[i]) return 0;
+  return history_[i]->readRange(from, to, out, maxSamples);
+}
+
+const char* SensorDataStore::fieldName(Field f) {
+  switch (f) {
+    case Field::Ecg:         return "ecg";
+    case Field::Spo2:        return "spo2";
+    case Field::Resp:        return "resp";
+    case Field::Pleth:       return "pleth";
+    case Field::BpSystolic:  return "bp_systolic";
+    case Field::BpDiastolic: return "bp_diastolic";
+    case Field::TempCavity:  return "temp_cavity";
+    case Field::TempSkin:    return "temp_skin";
+    case Field::Timestamp:   return "timestamp";
+    default:                 return "";
+  }
+}
+
+bool SensorDataStore::fieldFromName(const std::string& name, Field& out) {
+  for (size_t i = 0; i < FIELD_COUNT; ++i) {
+    if (name == fieldName(static_cast<Field>(i))) {
+      out = static_cast<Field>(i);
+      return true;
+    }
+  }
+  return false;
 }
 
 // ----- Last update times -----
 SensorDataStore::TimePoint SensorDataStore::lastUpdateEcg() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return ts_ecg_;
+  return snapshot().lastUpdate(Field::Ecg);
 }
 SensorDataStore::TimePoint SensorDataStore::lastUpdateSpo2() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return ts_spo2_;
+  return snapshot().lastUpdate(Field::Spo2);
 }
 SensorDataStore::TimePoint SensorDataStore::lastUpdateResp() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return ts_resp_;
+  return snapshot().lastUpdate(Field::Resp);
 }
 SensorDataStore::TimePoint SensorDataStore::lastUpdatePleth() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return ts_pleth_;
+  return snapshot().lastUpdate(Field::Pleth);
 }
 SensorDataStore::TimePoint SensorDataStore::lastUpdateBpSystolic() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return ts_bp_systolic_;
+  return snapshot().lastUpdate(Field::BpSystolic);
 }
 SensorDataStore::TimePoint SensorDataStore::lastUpdateBpDiastolic() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return ts_bp_diastolic_;
+  return snapshot().lastUpdate(Field::BpDiastolic);
 }
 SensorDataStore::TimePoint SensorDataStore::lastUpdateTempCavity() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return ts_temp_cavity_;
+  return snapshot().lastUpdate(Field::TempCavity);
 }
 SensorDataStore::TimePoint SensorDataStore::lastUpdateTempSkin() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return ts_temp_skin_;
+  return snapshot().lastUpdate(Field::TempSkin);
 }
 SensorDataStore::TimePoint SensorDataStore::lastUpdateTimestamp() const {
-  std::lock_guard<std::mutex> lk(mtx_);
-  return ts_timestamp_;
+  return snapshot().lastUpdate(Field::Timestamp);
 }
 SensorDataStore& SensorDataStore::instance() {
   static SensorDataStore inst;
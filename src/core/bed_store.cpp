@@ -0,0 +1,99 @@
+#include "core/bed_store.h"
+
+#include <cctype>
+#include <iostream>
+
+namespace {
+    constexpr std::string_view BED_PREFIX = "bed/";
+}
+
+BedStore::Shard::Shard(std::string bedId, double historySeconds)
+    : id(std::move(bedId)), store(historySeconds)
+{
+}
+
+BedStore::BedStore(double historySeconds)
+    : historySeconds_(historySeconds)
+{
+}
+
+BedStore::Shard* BedStore::find(std::string_view id) const
+{
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (shards_[i]->id == id)
+        {
+            return shards_[i].get();
+        }
+    }
+    return nullptr;
+}
+
+BedStore::Shard* BedStore::acquire(std::string_view id)
+{
+    if (Shard* shard = find(id))
+    {
+        return shard;
+    }
+    if (!validId(id))
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(addMutex_);
+    if (Shard* shard = find(id))
+    {
+        return shard; // Added by another writer meanwhile
+    }
+    const size_t n = count_.load(std::memory_order_relaxed);
+    if (n == MAX_BEDS)
+    {
+        if (!warnedFull_)
+        {
+            std::cerr << "[BedStore] Ward full (" << MAX_BEDS << " beds), ignoring bed " << id << std::endl;
+            warnedFull_ = true;
+        }
+        return nullptr;
+    }
+    shards_[n] = std::make_unique<Shard>(std::string(id), historySeconds_);
+    count_.store(n + 1, std::memory_order_release); // Publishes the shard to find()
+    return shards_[n].get();
+}
+
+bool BedStore::validId(std::string_view id)
+{
+    if (id.empty() || id.size() > MAX_ID_LENGTH)
+    {
+        return false;
+    }
+    for (char c : id)
+    {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BedStore::splitTopic(std::string_view topic, std::string_view& id, std::string_view& rest)
+{
+    if (topic.substr(0, BED_PREFIX.size()) != BED_PREFIX)
+    {
+        return false;
+    }
+    const size_t slash = topic.find('/', BED_PREFIX.size());
+    if (slash == std::string_view::npos || slash + 1 == topic.size())
+    {
+        return false;
+    }
+    const std::string_view bed = topic.substr(BED_PREFIX.size(), slash - BED_PREFIX.size());
+    if (!validId(bed))
+    {
+        return false;
+    }
+    id = bed;
+    rest = topic.substr(slash + 1);
+    return true;
+}
@@ -0,0 +1,112 @@
+#include "core/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr unsigned SUB_BITS = 3; // log2(SUB_BUCKETS)
+
+    unsigned highestBit(uint64_t v)
+    {
+        unsigned bit = 0;
+        while (v >>= 1)
+        {
+            ++bit;
+        }
+        return bit;
+    }
+}
+
+size_t LatencyHistogram::bucketFor(uint64_t us)
+{
+    if (us < SUB_BUCKETS)
+    {
+        return static_cast<size_t>(us);
+    }
+    const unsigned octave = highestBit(us); // >= SUB_BITS
+    const size_t sub = static_cast<size_t>(us >> (octave - SUB_BITS)) & (SUB_BUCKETS - 1);
+    const size_t bucket = SUB_BUCKETS + (octave - SUB_BITS) * SUB_BUCKETS + sub;
+    return std::min(bucket, BUCKET_COUNT - 1);
+}
+
+uint64_t LatencyHistogram::bucketUpperUs(size_t bucket)
+{
+    if (bucket < SUB_BUCKETS)
+    {
+        return bucket;
+    }
+    const size_t octave = (bucket - SUB_BUCKETS) / SUB_BUCKETS; // Above SUB_BITS
+    const uint64_t sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    const uint64_t width = uint64_t{1} << octave;
+    return ((SUB_BUCKETS + sub) << octave) + width - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency)
+{
+    const uint64_t us = latency.count() > 0 ? static_cast<uint64_t>(latency.count()) / 1000 : 0;
+    buckets_[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sumUs_.fetch_add(us, std::memory_order_relaxed);
+
+    uint64_t max = maxUs_.load(std::memory_order_relaxed);
+    while (us > max && !maxUs_.compare_exchange_weak(max, us, std::memory_order_relaxed))
+    {
+    }
+}
+
+double LatencyHistogram::percentileUs(double q) const
+{
+    uint64_t total = 0;
+    std::array<uint64_t, BUCKET_COUNT> counts;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0)
+    {
+        return 0.0;
+    }
+
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * total)));
+    const uint64_t max = maxUs_.load(std::memory_order_relaxed);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            // Upper edge of the bucket, but never beyond the largest sample
+            return static_cast<double>(std::min(bucketUpperUs(i), max));
+        }
+    }
+    return static_cast<double>(max);
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const
+{
+    Summary s;
+    s.count = count_.load(std::memory_order_relaxed);
+    if (s.count == 0)
+    {
+        return s;
+    }
+    s.meanUs = static_cast<double>(sumUs_.load(std::memory_order_relaxed)) / static_cast<double>(s.count);
+    s.p50Us = percentileUs(0.50);
+    s.p90Us = percentileUs(0.90);
+    s.p99Us = percentileUs(0.99);
+    s.p999Us = percentileUs(0.999);
+    s.maxUs = static_cast<double>(maxUs_.load(std::memory_order_relaxed));
+    return s;
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& bucket : buckets_)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sumUs_.store(0, std::memory_order_relaxed);
+    maxUs_.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,269 @@
+#include "core/mqtt_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <thread>
+
+namespace {
+    constexpr size_t FLUSH_BYTES = 1 << 16;
+    constexpr std::chrono::milliseconds REPLAY_MAX_SLEEP(100); // How long a stop can go unseen
+
+    void putVarint(std::vector<uint8_t>& out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    bool getVarint(const std::string& in, size_t& pos, uint64_t& v)
+    {
+        v = 0;
+        for (unsigned shift = 0; shift < 64 && pos < in.size(); shift += 7)
+        {
+            const auto byte = static_cast<uint8_t>(in[pos++]);
+            v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+// ---- MqttRecorder ----
+
+MqttRecorder::~MqttRecorder()
+{
+    close();
+}
+
+bool MqttRecorder::open(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_.is_open())
+    {
+        flush_();
+        file_.close();
+    }
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_)
+    {
+        std::cerr << "MQTT log: cannot create " << path << std::endl;
+        return false;
+    }
+    file_.write(MqttLog::MAGIC, sizeof(MqttLog::MAGIC));
+    buffer_.clear();
+    buffer_.reserve(FLUSH_BYTES * 2);
+    topics_.clear();
+    last_ = {};
+    count_ = 0;
+    return static_cast<bool>(file_);
+}
+
+void MqttRecorder::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_.is_open())
+    {
+        flush_();
+        file_.close();
+    }
+}
+
+bool MqttRecorder::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_.is_open();
+}
+
+size_t MqttRecorder::count() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+void MqttRecorder::record(std::string_view topic, const void* payload, int payloadlen,
+                          std::chrono::steady_clock::time_point arrival)
+{
+    const size_t length = payload && payloadlen > 0 ? static_cast<size_t>(payloadlen) : 0;
+    if (topic.size() > MqttLog::MAX_TOPIC_LENGTH || length > MqttLog::MAX_PAYLOAD)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open())
+    {
+        return;
+    }
+
+    const int64_t delta = count_ == 0 ? 0 : std::chrono::duration_cast<std::chrono::nanoseconds>(arrival - last_).count();
+    putVarint(buffer_, static_cast<uint64_t>(std::max<int64_t>(0, delta)));
+    if (count_ == 0 || arrival > last_)
+    {
+        last_ = arrival;
+    }
+
+    auto known = topics_.find(topic); // No allocation for known topics
+    if (known != topics_.end())
+    {
+        putVarint(buffer_, known->second);
+    }
+    else
+    {
+        topics_.emplace(std::string(topic), topics_.size() + 1);
+        putVarint(buffer_, 0);
+        putVarint(buffer_, topic.size());
+        buffer_.insert(buffer_.end(), topic.begin(), topic.end());
+    }
+
+    putVarint(buffer_, length);
+    const auto* bytes = static_cast<const uint8_t*>(payload);
+    buffer_.insert(buffer_.end(), bytes, bytes + length);
+    ++count_;
+
+    if (buffer_.size() >= FLUSH_BYTES)
+    {
+        flush_();
+    }
+}
+
+void MqttRecorder::flush_()
+{
+    file_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    file_.flush();
+    buffer_.clear();
+}
+
+// ---- MqttReplay ----
+
+bool MqttReplay::load(const std::string& path)
+{
+    entries_.clear();
+    topics_.clear();
+    data_.clear();
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "MQTT log: cannot open " << path << std::endl;
+        return false;
+    }
+    data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (data_.size() < sizeof(MqttLog::MAGIC) ||
+        std::memcmp(data_.data(), MqttLog::MAGIC, sizeof(MqttLog::MAGIC)) != 0)
+    {
+        std::cerr << "MQTT log: " << path << " is not an MQTT log" << std::endl;
+        data_.clear();
+        return false;
+    }
+
+    size_t pos = sizeof(MqttLog::MAGIC);
+    uint64_t offset = 0;
+    while (pos < data_.size())
+    {
+        uint64_t delta = 0;
+        uint64_t ref = 0;
+        uint64_t length = 0;
+        bool ok = getVarint(data_, pos, delta) && getVarint(data_, pos, ref);
+        if (ok && ref == 0)
+        {
+            ok = getVarint(data_, pos, length) && length <= MqttLog::MAX_TOPIC_LENGTH && length <= data_.size() - pos;
+            if (ok)
+            {
+                topics_.emplace_back(data_, pos, static_cast<size_t>(length));
+                pos += static_cast<size_t>(length);
+                ref = topics_.size();
+            }
+        }
+        ok = ok && ref <= topics_.size() && getVarint(data_, pos, length) && length <= MqttLog::MAX_PAYLOAD &&
+             length <= data_.size() - pos;
+        if (!ok)
+        {
+            std::cerr << "MQTT log: " << path << " is truncated or corrupt after " << entries_.size()
+                      << " messages" << std::endl;
+            entries_.clear();
+            topics_.clear();
+            data_.clear();
+            return false;
+        }
+
+        offset += delta;
+        entries_.push_back({offset, static_cast<uint32_t>(ref - 1), static_cast<uint32_t>(length), pos});
+        pos += static_cast<size_t>(length);
+    }
+    return true;
+}
+
+std::chrono::nanoseconds MqttReplay::duration() const
+{
+    return entries_.empty() ? std::chrono::nanoseconds(0) : offset(entries_.size() - 1);
+}
+
+std::string_view MqttReplay::payload(size_t i) const
+{
+    return std::string_view(data_).substr(entries_[i].payloadOffset, entries_[i].payloadLength);
+}
+
+MqttReplay::Result MqttReplay::replay(const Sink& sink, double speed, const std::atomic<bool>* stop) const
+{
+    using Clock = std::chrono::steady_clock;
+    Result result;
+    MQTTDriver::Message batch[MQTTDriver::MAX_BATCH];
+
+    const auto start = Clock::now();
+    auto dueAt = [&](size_t i) {
+        return start + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double, std::nano>(static_cast<double>(entries_[i].offsetNs) / speed));
+    };
+
+    auto stopped = [stop] { return stop && stop->load(std::memory_order_relaxed); };
+
+    size_t next = 0;
+    while (next < entries_.size() && !stopped())
+    {
+        if (speed > 0.0)
+        {
+            const auto due = dueAt(next);
+            const auto now = Clock::now();
+            if (due > now)
+            {
+                // In slices: a log can be idle for minutes
+                for (auto t = now; t < due && !stopped(); t = Clock::now())
+                {
+                    std::this_thread::sleep_until(std::min(due, t + REPLAY_MAX_SLEEP));
+                }
+                if (stopped())
+                {
+                    break;
+                }
+            }
+            else
+            {
+                result.maxLagMs = std::max(result.maxLagMs, std::chrono::duration<double, std::milli>(now - due).count());
+            }
+        }
+
+        // Everything due by now (or a full batch at maximum speed)
+        const auto now = Clock::now();
+        size_t count = 0;
+        while (next < entries_.size() && count < MQTTDriver::MAX_BATCH && (speed <= 0.0 || dueAt(next) <= now))
+        {
+            const Entry& e = entries_[next++];
+            batch[count++] = {topics_[e.topic], data_.data() + e.payloadOffset, static_cast<int>(e.payloadLength)};
+        }
+        sink(batch, count);
+        result.messages += count;
+        ++result.batches;
+    }
+
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.messagesPerSecond = result.seconds > 0.0 ? static_cast<double>(result.messages) / result.seconds : 0.0;
+    return result;
+}
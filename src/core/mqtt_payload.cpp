@@ -0,0 +1,676 @@
+#include "core/mqtt_payload.h"
+
+#include <charconv>
+#include <cstring>
+#include <system_error>
+
+namespace {
+    constexpr std::string_view WHITESPACE = " \t\r\n\f\v";
+
+    struct Keyword
+    {
+        std::string_view word;
+        float value;
+    };
+
+    constexpr Keyword KEYWORDS[] = {
+        {"true", 1.0f}, {"on", 1.0f}, {"yes", 1.0f},
+        {"false", 0.0f}, {"off", 0.0f}, {"no", 0.0f},
+    };
+
+    std::string_view trim(std::string_view s)
+    {
+        const size_t first = s.find_first_not_of(WHITESPACE);
+        if (first == std::string_view::npos)
+        {
+            return {};
+        }
+        return s.substr(first, s.find_last_not_of(WHITESPACE) - first + 1);
+    }
+
+    char lowerAscii(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    bool equalsIgnoreCase(std::string_view s, std::string_view lowerWord)
+    {
+        if (s.size() != lowerWord.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < s.size(); ++i)
+        {
+            if (lowerAscii(s[i]) != lowerWord[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Bit test rather than std::isfinite, which -ffast-math may fold to true
+    bool finite(double v)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        return (bits & 0x7FF0000000000000ull) != 0x7FF0000000000000ull;
+    }
+
+    // Narrow to float, rejecting NaN, infinities and doubles beyond float range
+    bool accept(double v, float& out)
+    {
+        if (!finite(v) || v > 3.4028234663852886e38 || v < -3.4028234663852886e38)
+        {
+            return false;
+        }
+        out = static_cast<float>(v);
+        return true;
+    }
+
+    const uint8_t* bytesOf(std::string_view s)
+    {
+        return reinterpret_cast<const uint8_t*>(s.data());
+    }
+
+    uint64_t loadBigEndian(const uint8_t* p, size_t n)
+    {
+        uint64_t v = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            v = (v << 8) | p[i];
+        }
+        return v;
+    }
+
+    uint64_t loadLittleEndian(const uint8_t* p, size_t n)
+    {
+        uint64_t v = 0;
+        for (size_t i = n; i > 0; --i)
+        {
+            v = (v << 8) | p[i - 1];
+        }
+        return v;
+    }
+
+    double floatFromBits(uint64_t bits)
+    {
+        const uint32_t b = static_cast<uint32_t>(bits);
+        float f;
+        std::memcpy(&f, &b, sizeof(f));
+        return f;
+    }
+
+    double doubleFromBits(uint64_t bits)
+    {
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+
+    double halfFromBits(uint64_t bits)
+    {
+        const int exponent = static_cast<int>((bits >> 10) & 0x1F);
+        const double mantissa = static_cast<double>(bits & 0x3FF);
+        double magnitude;
+        if (exponent == 0)
+        {
+            magnitude = mantissa * 0x1p-24; // Subnormal
+        }
+        else if (exponent == 31)
+        {
+            magnitude = doubleFromBits(0x7FF0000000000000ull); // Infinity or NaN, rejected either way
+        }
+        else
+        {
+            magnitude = (1024.0 + mantissa) * static_cast<double>(1ull << exponent) * 0x1p-25;
+        }
+        return (bits & 0x8000) ? -magnitude : magnitude;
+    }
+
+    // Single-pass JSON reader over a view; validates as it goes, never allocates
+    class JsonReader
+    {
+    public:
+        JsonReader(std::string_view json, MqttPayload::JsonMember* members, size_t maxMembers)
+            : p_(json.data()), end_(json.data() + json.size()), members_(members), maxMembers_(maxMembers)
+        {
+        }
+
+        bool read(size_t& count)
+        {
+            skipSpace();
+            if (!object(nullptr, 0, 1))
+            {
+                return false;
+            }
+            skipSpace();
+            count = count_;
+            return p_ == end_;
+        }
+
+    private:
+        static constexpr int MAX_DEPTH = 16;
+        static constexpr int FLATTENED_DEPTH = 2;
+
+        void skipSpace()
+        {
+            while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r'))
+            {
+                ++p_;
+            }
+        }
+
+        bool consume(char c)
+        {
+            skipSpace();
+            if (p_ < end_ && *p_ == c)
+            {
+                ++p_;
+                return true;
+            }
+            return false;
+        }
+
+        static bool isHex(char c)
+        {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+        }
+
+        static int hexValue(char c)
+        {
+            return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+        }
+
+        // String contents between the quotes; if key is given, also the
+        // unescaped text (keyOk false when it cannot be kept)
+        bool string(std::string_view& raw, char* key, size_t& keyLength, bool& keyOk)
+        {
+            if (p_ == end_ || *p_ != '"')
+            {
+                return false;
+            }
+            const char* start = ++p_;
+            while (p_ < end_ && *p_ != '"')
+            {
+                char c = *p_++;
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    return false; // Control characters must be escaped
+                }
+                if (c == '\\')
+                {
+                    if (p_ == end_)
+                    {
+                        return false;
+                    }
+                    const char e = *p_++;
+                    switch (e)
+                    {
+                    case '"': case '\\': case '/': c = e; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'n': c = '\n'; break;
+                    case 'r': c = '\r'; break;
+                    case 't': c = '\t'; break;
+                    case 'u':
+                    {
+                        if (end_ - p_ < 4 || !isHex(p_[0]) || !isHex(p_[1]) || !isHex(p_[2]) || !isHex(p_[3]))
+                        {
+                            return false;
+                        }
+                        const int code = (hexValue(p_[0]) << 12) | (hexValue(p_[1]) << 8) |
+                                         (hexValue(p_[2]) << 4) | hexValue(p_[3]);
+                        p_ += 4;
+                        if (code >= 0x80)
+                        {
+                            keyOk = false; // Topic names are ASCII
+                        }
+                        c = static_cast<char>(code);
+                        break;
+                    }
+                    default:
+                        return false;
+                    }
+                }
+                if (key && keyOk)
+                {
+                    if (keyLength == MqttPayload::MAX_JSON_KEY)
+                    {
+                        keyOk = false;
+                    }
+                    else
+                    {
+                        key[keyLength++] = c;
+                    }
+                }
+            }
+            if (p_ == end_)
+            {
+                return false;
+            }
+            raw = std::string_view(start, static_cast<size_t>(p_ - start));
+            ++p_; // Closing quote
+            return true;
+        }
+
+        // JSON number grammar: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+        bool number(std::string_view& raw)
+        {
+            const char* start = p_;
+            auto digits = [&] {
+                const char* first = p_;
+                while (p_ < end_ && *p_ >= '0' && *p_ <= '9')
+                {
+                    ++p_;
+                }
+                return p_ > first;
+            };
+            if (p_ < end_ && *p_ == '-')
+            {
+                ++p_;
+            }
+            if (p_ < end_ && *p_ == '0')
+            {
+                ++p_;
+            }
+            else if (!digits())
+            {
+                return false;
+            }
+            if (p_ < end_ && *p_ == '.')
+            {
+                ++p_;
+                if (!digits())
+                {
+                    return false;
+                }
+            }
+            if (p_ < end_ && (*p_ == 'e' || *p_ == 'E'))
+            {
+                ++p_;
+                if (p_ < end_ && (*p_ == '+' || *p_ == '-'))
+                {
+                    ++p_;
+                }
+                if (!digits())
+                {
+                    return false;
+                }
+            }
+            raw = std::string_view(start, static_cast<size_t>(p_ - start));
+            return true;
+        }
+
+        bool literal(std::string_view word)
+        {
+            if (static_cast<size_t>(end_ - p_) < word.size() || std::string_view(p_, word.size()) != word)
+            {
+                return false;
+            }
+            p_ += word.size();
+            return true;
+        }
+
+        // Any value; scalars are recorded under key when it is set
+        bool value(const char* key, size_t keyLength, int depth)
+        {
+            skipSpace();
+            if (p_ == end_)
+            {
+                return false;
+            }
+            std::string_view raw;
+            bool isString = false;
+            switch (*p_)
+            {
+            case '{':
+                return object(key, keyLength, depth + 1);
+            case '[':
+                return array(depth + 1);
+            case '"':
+            {
+                size_t unused = 0;
+                bool unusedOk = false;
+                if (!string(raw, nullptr, unused, unusedOk))
+                {
+                    return false;
+                }
+                isString = true;
+                break;
+            }
+            case 't':
+                if (!literal("true"))
+                {
+                    return false;
+                }
+                raw = std::string_view(p_ - 4, 4);
+                break;
+            case 'f':
+                if (!literal("false"))
+                {
+                    return false;
+                }
+                raw = std::string_view(p_ - 5, 5);
+                break;
+            case 'n':
+                return literal("null"); // Treated as absent
+            default:
+                if (!number(raw))
+                {
+                    return false;
+                }
+                break;
+            }
+            if (key)
+            {
+                if (count_ == maxMembers_)
+                {
+                    return false;
+                }
+                MqttPayload::JsonMember& m = members_[count_++];
+                std::memcpy(m.key, key, keyLength);
+                m.keyLength = keyLength;
+                m.value = raw;
+                m.isString = isString;
+            }
+            return true;
+        }
+
+        bool array(int depth)
+        {
+            if (depth > MAX_DEPTH)
+            {
+                return false;
+            }
+            ++p_; // '['
+            if (consume(']'))
+            {
+                return true;
+            }
+            do
+            {
+                if (!value(nullptr, 0, depth))
+                {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        }
+
+        // prefix is the flattened key of this object (nullptr: members are not recorded)
+        bool object(const char* prefix, size_t prefixLength, int depth)
+        {
+            if (depth > MAX_DEPTH || p_ == end_ || *p_ != '{')
+            {
+                return false;
+            }
+            ++p_;
+            if (consume('}'))
+            {
+                return true;
+            }
+            const bool record = depth <= FLATTENED_DEPTH && (depth == 1 || prefix);
+            do
+            {
+                skipSpace();
+                char key[MqttPayload::MAX_JSON_KEY];
+                size_t keyLength = 0;
+                bool keyOk = record;
+                if (keyOk && prefixLength > 0)
+                {
+                    if (prefixLength + 1 > MqttPayload::MAX_JSON_KEY)
+                    {
+                        keyOk = false;
+                    }
+                    else
+                    {
+                        std::memcpy(key, prefix, prefixLength);
+                        key[prefixLength] = '/';
+                        keyLength = prefixLength + 1;
+                    }
+                }
+                std::string_view raw;
+                if (!string(raw, key, keyLength, keyOk) || !consume(':'))
+                {
+                    return false;
+                }
+                if (!value(keyOk ? key : nullptr, keyLength, depth))
+                {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}');
+        }
+
+        const char* p_;
+        const char* end_;
+        MqttPayload::JsonMember* members_;
+        size_t maxMembers_;
+        size_t count_ = 0;
+    };
+
+    // Length of the big-endian argument following a CBOR initial byte; -1 if unsupported
+    int cborArgumentLength(uint8_t info)
+    {
+        if (info < 24)
+        {
+            return 0;
+        }
+        if (info <= 27)
+        {
+            return 1 << (info - 24);
+        }
+        return -1;
+    }
+}
+
+namespace MqttPayload
+{
+    bool parseNumber(std::string_view text, float& out)
+    {
+        std::string_view s = trim(text);
+        if (!s.empty() && s.front() == '+')
+        {
+            s.remove_prefix(1);
+            if (!s.empty() && (s.front() == '+' || s.front() == '-'))
+            {
+                return false;
+            }
+        }
+        if (s.empty())
+        {
+            return false;
+        }
+
+        float value;
+        const char* end = s.data() + s.size();
+        const std::from_chars_result r = std::from_chars(s.data(), end, value);
+        if (r.ec != std::errc() || r.ptr != end)
+        {
+            return false;
+        }
+        return accept(value, out);
+    }
+
+    bool parseBoolish(std::string_view text, float& out)
+    {
+        const std::string_view s = trim(text);
+        for (const Keyword& k : KEYWORDS)
+        {
+            if (equalsIgnoreCase(s, k.word))
+            {
+                out = k.value;
+                return true;
+            }
+        }
+        float value;
+        if (!parseNumber(s, value))
+        {
+            return false;
+        }
+        out = value != 0.0f ? 1.0f : 0.0f;
+        return true;
+    }
+
+    bool parseRawFloat(std::string_view bytes, float& out)
+    {
+        const uint8_t* p = bytesOf(bytes);
+        switch (bytes.size())
+        {
+        case 4:
+            return accept(floatFromBits(loadLittleEndian(p, 4)), out);
+        case 8:
+            return accept(doubleFromBits(loadLittleEndian(p, 8)), out);
+        default:
+            return false;
+        }
+    }
+
+    bool parseMessagePack(std::string_view bytes, float& out)
+    {
+        if (bytes.empty())
+        {
+            return false;
+        }
+        const uint8_t* p = bytesOf(bytes);
+        const uint8_t type = p[0];
+        const size_t size = bytes.size();
+
+        if (type <= 0x7F || type >= 0xE0) // Positive and negative fixint
+        {
+            return size == 1 && accept(static_cast<int8_t>(type), out);
+        }
+        if (type == 0xC2 || type == 0xC3) // false, true
+        {
+            return size == 1 && accept(type == 0xC3 ? 1.0 : 0.0, out);
+        }
+        if (type == 0xCA)
+        {
+            return size == 5 && accept(floatFromBits(loadBigEndian(p + 1, 4)), out);
+        }
+        if (type == 0xCB)
+        {
+            return size == 9 && accept(doubleFromBits(loadBigEndian(p + 1, 8)), out);
+        }
+        if (type >= 0xCC && type <= 0xD3) // uint8..uint64, int8..int64
+        {
+            const size_t length = size_t{1} << ((type - 0xCC) & 3);
+            if (size != 1 + length)
+            {
+                return false;
+            }
+            const uint64_t raw = loadBigEndian(p + 1, length);
+            if (type <= 0xCF)
+            {
+                return accept(static_cast<double>(raw), out);
+            }
+            const unsigned shift = static_cast<unsigned>(64 - 8 * length); // Sign-extend
+            return accept(static_cast<double>(static_cast<int64_t>(raw << shift) >> shift), out);
+        }
+        return false;
+    }
+
+    bool parseCbor(std::string_view bytes, float& out)
+    {
+        if (bytes.empty())
+        {
+            return false;
+        }
+        const uint8_t* p = bytesOf(bytes);
+        const uint8_t major = p[0] >> 5;
+        const uint8_t info = p[0] & 0x1F;
+        const int length = cborArgumentLength(info);
+        if (length < 0 || bytes.size() != 1 + static_cast<size_t>(length))
+        {
+            return false;
+        }
+        const uint64_t argument = length == 0 ? info : loadBigEndian(p + 1, static_cast<size_t>(length));
+
+        switch (major)
+        {
+        case 0: // Unsigned integer
+            return accept(static_cast<double>(argument), out);
+        case 1: // Negative integer, -1 - argument
+            return accept(-1.0 - static_cast<double>(argument), out);
+        case 7:
+            switch (info)
+            {
+            case 20: // false
+            case 21: // true
+                return accept(info == 21 ? 1.0 : 0.0, out);
+            case 25:
+                return accept(halfFromBits(argument), out);
+            case 26:
+                return accept(floatFromBits(argument), out);
+            case 27:
+                return accept(doubleFromBits(argument), out);
+            default:
+                return false;
+            }
+        default:
+            return false;
+        }
+    }
+
+    bool parse(Format format, std::string_view payload, bool boolish, float& out)
+    {
+        float value;
+        bool ok = false;
+        switch (format)
+        {
+        case Format::Text:
+            return boolish ? parseBoolish(payload, out) : parseNumber(payload, out);
+        case Format::Float32:
+            ok = parseRawFloat(payload, value);
+            break;
+        case Format::MessagePack:
+            ok = parseMessagePack(payload, value);
+            break;
+        case Format::Cbor:
+            ok = parseCbor(payload, value);
+            break;
+        }
+        if (!ok)
+        {
+            return false;
+        }
+        out = boolish ? (value != 0.0f ? 1.0f : 0.0f) : value;
+        return true;
+    }
+
+    bool parseJsonObject(std::string_view json, JsonMember* members, size_t maxMembers, size_t& count)
+    {
+        JsonReader reader(json, members, maxMembers);
+        return reader.read(count);
+    }
+
+    bool formatFromName(std::string_view name, Format& out)
+    {
+        for (Format f : {Format::Text, Format::Float32, Format::MessagePack, Format::Cbor})
+        {
+            if (equalsIgnoreCase(name, formatName(f)))
+            {
+                out = f;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const char* formatName(Format format)
+    {
+        switch (format)
+        {
+        case Format::Text:
+            return "text";
+        case Format::Float32:
+            return "float32";
+        case Format::MessagePack:
+            return "msgpack";
+        case Format::Cbor:
+            return "cbor";
+        }
+        return "text";
+    }
+}
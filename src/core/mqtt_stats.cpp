@@ -0,0 +1,118 @@
+#include "core/mqtt_stats.h"
+
+namespace {
+    std::atomic<uint64_t> nextId{1};
+
+    // The calling thread's block in the stats it used last
+    struct LocalCache
+    {
+        uint64_t owner = 0;
+        void* block = nullptr;
+        bool shared = false;
+    };
+    thread_local LocalCache cache;
+}
+
+MqttStats::MqttStats()
+    : id_(nextId.fetch_add(1, std::memory_order_relaxed)),
+      created_(std::chrono::steady_clock::now()),
+      windowStart_(created_)
+{
+}
+
+MqttStats::Block& MqttStats::local(bool& shared)
+{
+    if (cache.owner == id_)
+    {
+        shared = cache.shared;
+        return *static_cast<Block*>(cache.block);
+    }
+
+    // First count from this thread since it last used other stats: find or claim its block
+    const std::thread::id self = std::this_thread::get_id();
+    size_t slot = MAX_THREADS;
+    for (size_t i = 0; i < MAX_THREADS && slot == MAX_THREADS; ++i)
+    {
+        std::thread::id owner = owners_[i].load(std::memory_order_acquire);
+        if (owner == self || (owner == std::thread::id() && owners_[i].compare_exchange_strong(owner, self)))
+        {
+            slot = i; // A recycled id belongs to a thread that has exited, so the block is still single-writer
+        }
+    }
+
+    cache.owner = id_;
+    cache.block = &blocks_[slot];
+    cache.shared = slot == MAX_THREADS;
+    shared = cache.shared;
+    return blocks_[slot];
+}
+
+void MqttStats::add(Counter c, uint64_t n)
+{
+    bool shared = false;
+    Block& block = local(shared);
+    bump(block.counters[static_cast<size_t>(c)], n, shared);
+}
+
+void MqttStats::topic(size_t topic, bool parsed)
+{
+    if (topic >= MAX_TOPICS)
+    {
+        return;
+    }
+    bool shared = false;
+    Block& block = local(shared);
+    bump(block.counters[static_cast<size_t>(Counter::Received)], 1, shared);
+    bump(block.topicReceived[topic], 1, shared);
+    if (!parsed)
+    {
+        bump(block.counters[static_cast<size_t>(Counter::ParseFailure)], 1, shared);
+        bump(block.topicFailures[topic], 1, shared);
+    }
+}
+
+MqttStats::Snapshot MqttStats::snapshot() const
+{
+    Snapshot s;
+    for (const Block& block : blocks_)
+    {
+        for (size_t i = 0; i < COUNTER_COUNT; ++i)
+        {
+            s.counters[i] += block.counters[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < MAX_TOPICS; ++i)
+        {
+            s.topicReceived[i] += block.topicReceived[i].load(std::memory_order_relaxed);
+            s.topicFailures[i] += block.topicFailures[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    s.uptimeSeconds = std::chrono::duration<double>(now - created_).count();
+
+    std::lock_guard<std::mutex> lock(rateMutex_);
+    const auto window = now - windowStart_;
+    if (window >= RATE_WINDOW || !windowDone_)
+    {
+        // Until the first window completes, rates cover everything so far
+        const double seconds = std::chrono::duration<double>(window).count();
+        if (seconds > 0.0)
+        {
+            const size_t received = static_cast<size_t>(Counter::Received);
+            receivedRate_ = static_cast<double>(s.counters[received] - windowTotals_.counters[received]) / seconds;
+            for (size_t i = 0; i < MAX_TOPICS; ++i)
+            {
+                topicRates_[i] = static_cast<double>(s.topicReceived[i] - windowTotals_.topicReceived[i]) / seconds;
+            }
+        }
+        if (window >= RATE_WINDOW)
+        {
+            windowStart_ = now;
+            windowTotals_ = s;
+            windowDone_ = true;
+        }
+    }
+    s.receivedRate = receivedRate_;
+    s.topicRates = topicRates_;
+    return s;
+}
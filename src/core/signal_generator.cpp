@@ -1,23 +1,154 @@
 #include "core/signal_generator.h"
 
 #include "core/SensorDataStore.h"
-#include <chrono>
+#include "core/waveform_kernels.h"
+#include "core/waveform_template.h"
+#include <algorithm>
+
+namespace {
+    constexpr double SLOW_DRIFT_HZ = 0.02;  // SpO2 and BP variation
+    constexpr double TEMP_DRIFT_HZ = 0.01;
+    constexpr double PLETH_RIPPLE_HZ = 15.0;
+
+    // Plausible ranges for externally supplied physiology
+    constexpr double MIN_HEART_RATE_BPM = 20.0;
+    constexpr double MAX_HEART_RATE_BPM = 300.0;
+    constexpr double MIN_RESP_RATE_BPM = 2.0;
+    constexpr double MAX_RESP_RATE_BPM = 80.0;
+    constexpr double MIN_SPO2 = 50.0;
+    constexpr double MAX_SPO2 = 100.0;
+    constexpr double MIN_BP = 20.0;
+    constexpr double MAX_BP = 300.0;
+
+    double clampOr(double value, double lo, double hi, double fallback)
+    {
+        if (!std::isfinite(value)) {
+            return fallback;
+        }
+        return std::min(std::max(value, lo), hi);
+    }
+}
 
 SignalGenerator::SignalGenerator()
 {
     // Initialize with default parameters
     // Record start time for wall-clock based generation
-    startTime_ = std::chrono::steady_clock::now();
+    clock_ = SimClock::real();
+    store_ = &SensorDataStore::instance();
+    beat_.hz = active_.heartRateBpm / 60.0;
+    breath_.hz = active_.respRateBpm / 60.0;
+    physiology_.store(active_);
+
+    // Render the beat templates now rather than on the first streamed block
+    BeatTemplates::ecg();
+    BeatTemplates::pleth();
 }
 
 SignalGenerator::SensorData SignalGenerator::generate()
 {
-    // Use wall-clock time instead of accumulated ticks
+    // Use clock time instead of accumulated ticks
     // This ensures all client connections see the same waveforms
-    auto now = std::chrono::steady_clock::now();
-    std::chrono::duration<double> elapsed = now - startTime_;
-    double time_ = elapsed.count();
+    return generateAt(getTime());
+}
+
+SignalGenerator::SensorData SignalGenerator::generateAt(double time)
+{
+    applyPhysiology(time);
+    return sampleAt(time, readLiveValues());
+}
+
+void SignalGenerator::setPhysiology(const Physiology& physiology)
+{
+    const Physiology defaults;
+    Physiology p;
+    p.heartRateBpm = clampOr(physiology.heartRateBpm, MIN_HEART_RATE_BPM, MAX_HEART_RATE_BPM,
+                             defaults.heartRateBpm);
+    p.respRateBpm = clampOr(physiology.respRateBpm, MIN_RESP_RATE_BPM, MAX_RESP_RATE_BPM,
+                            defaults.respRateBpm);
+    p.spo2 = clampOr(physiology.spo2, MIN_SPO2, MAX_SPO2, defaults.spo2);
+    p.bpSystolic = clampOr(physiology.bpSystolic, MIN_BP, MAX_BP, defaults.bpSystolic);
+    p.bpDiastolic = clampOr(physiology.bpDiastolic, MIN_BP, p.bpSystolic, defaults.bpDiastolic);
+
+    physiology_.store(p);
+    physiologyVersion_.fetch_add(1, std::memory_order_release);
+}
+
+SignalGenerator::Physiology SignalGenerator::physiology() const
+{
+    return physiology_.load();
+}
+
+void SignalGenerator::applyPhysiology(double time)
+{
+    // The common case is one atomic load and a compare
+    const uint64_t version = physiologyVersion_.load(std::memory_order_acquire);
+    if (version == appliedVersion_) {
+        return;
+    }
+    appliedVersion_ = version;
+    active_ = physiology_.load();
+    beat_.retune(time, active_.heartRateBpm / 60.0);
+    breath_.retune(time, active_.respRateBpm / 60.0);
+}
+
+void SignalGenerator::generateBlock(double t0, double dt, size_t n, SensorData* out)
+{
+    using namespace WaveformKernels;
+    applyPhysiology(t0);
+    const LiveValues live = readLiveValues();
+
+    // Channels are synthesized a chunk at a time into per-channel arrays
+    // (beat shapes from the templates, sines from the vectorized kernels),
+    // then interleaved into SensorData
+    double t[CHUNK], beatPhase[CHUNK], breathPhase[CHUNK], ecgWave[CHUNK], plethWave[CHUNK];
+    double ripple[CHUNK], respWave[CHUNK], slowDrift[CHUNK], tempDrift[CHUNK];
+
+    for (size_t base = 0; base < n; base += CHUNK) {
+        const size_t count = std::min(CHUNK, n - base);
+        for (size_t i = 0; i < count; ++i) {
+            // Multiply rather than accumulate so long blocks do not drift
+            t[i] = t0 + static_cast<double>(base + i) * dt;
+        }
+
+        phase(beat_, t, count, beatPhase);
+        phase(breath_, t, count, breathPhase);
+        BeatTemplates::ecg().render(beatPhase, count, ecgWave);
+        BeatTemplates::pleth().render(beatPhase, count, plethWave);
+        phaseSine(breathPhase, count, respWave);
+        sine(t, count, PLETH_RIPPLE_HZ, ripple);
+        sine(t, count, SLOW_DRIFT_HZ, slowDrift);
+        sine(t, count, TEMP_DRIFT_HZ, tempDrift);
+
+        for (size_t i = 0; i < count; ++i) {
+            SensorData& data = out[base + i];
+            data.timestamp = t[i];
+            data.ecg = live.hasEcg ? live.ecg : 0.5 + ecgWave[i] * 0.4;
+            data.spo2 = live.hasSpo2 ? live.spo2 : std::min(MAX_SPO2, active_.spo2 + 1.0 * slowDrift[i]);
+            data.resp = params_.respAmplitude * respWave[i];
+            data.pleth = plethWave[i] + 0.02 * ripple[i];
+            data.bp_systolic = active_.bpSystolic + 5.0 * slowDrift[i];
+            data.bp_diastolic = active_.bpDiastolic + 5.0 * slowDrift[i] * 0.5;
+            data.temp_cavity = 37.2 + 0.2 * tempDrift[i];
+            data.temp_skin = 36.8 + 0.2 * tempDrift[i] * 0.8;
+        }
+    }
+}
+
+SignalGenerator::LiveValues SignalGenerator::readLiveValues() const
+{
+    // One consistent, lock-free read of any externally supplied values
+    const SensorDataStore::Snapshot snapshot = store_->snapshot();
     
+    LiveValues live;
+    live.hasEcg = snapshot.has(SensorDataStore::Field::Ecg);
+    live.ecg = snapshot.data.ecg;
+    live.hasSpo2 = snapshot.has(SensorDataStore::Field::Spo2);
+    live.spo2 = snapshot.data.spo2;
+    return live;
+}
+
+SignalGenerator::SensorData SignalGenerator::sampleAt(double time_, const LiveValues& live) const
+{
     SensorData data;
     data.timestamp = time_;
 
@@ -25,112 +156,50 @@ SignalGenerator::SensorData SignalGenerator::generate()
     // ECG Waveform Generation  
     // Realistic ECG with P wave, QRS complex, and T wave
     // ========================================================================
-    const double ecgHR = 75.0; // Heart rate in BPM
-    const double ecgBeatInterval = 60.0 / ecgHR; // ~0.8 seconds per beat
-    double ecgBeatPhase = std::fmod(time_, ecgBeatInterval) / ecgBeatInterval;
-    
-    double ecgValue = 0.0;
-    
-    // P wave (atrial depolarization) at 0.0-0.15
-    if (ecgBeatPhase < 0.15) {
-        double pPhase = ecgBeatPhase / 0.15;
-        ecgValue = 0.15 * std::exp(-8.0 * std::pow(pPhase - 0.5, 2));
-    }
-    // PR segment (AV node delay) at 0.15-0.20
-    else if (ecgBeatPhase < 0.20) {
-        ecgValue = 0.0;
-    }
-    // QRS complex (ventricular depolarization) at 0.20-0.30
-    else if (ecgBeatPhase < 0.30) {
-        double qrsPhase = (ecgBeatPhase - 0.20) / 0.10;
-        if (qrsPhase < 0.2) {
-            // Q wave (small downward deflection)
-            ecgValue = -0.1 * (qrsPhase / 0.2);
-        }
-        else if (qrsPhase < 0.6) {
-            // R wave (tall upward spike)
-            double rPhase = (qrsPhase - 0.2) / 0.4;
-            ecgValue = -0.1 + 1.2 * std::exp(-std::pow((rPhase - 0.5) * 6.0, 2));
-        }
-        else {
-            // S wave (small downward deflection)
-            double sPhase = (qrsPhase - 0.6) / 0.4;
-            ecgValue = -0.08 * (1.0 - sPhase);
-        }
-    }
-    // ST segment at 0.30-0.40
-    else if (ecgBeatPhase < 0.40) {
-        ecgValue = 0.0;
-    }
-    // T wave (ventricular repolarization) at 0.40-0.70
-    else if (ecgBeatPhase < 0.70) {
-        double tPhase = (ecgBeatPhase - 0.40) / 0.30;
-        ecgValue = 0.3 * std::exp(-8.0 * std::pow(tPhase - 0.5, 2));
-    }
-    // Return to baseline
-    else {
-        ecgValue = 0.0;
-    }
+    const double beatCycles = beat_.cyclesAt(time_);
+    const double beatPhase = beatCycles - std::floor(beatCycles);
+    const double ecgValue = BeatTemplates::ecgShape(beatPhase);
     
     // Scale to fit chart range and add baseline offset
-    data.ecg = SensorDataStore::instance().hasEcg() ? SensorDataStore::instance().getEcg() : 0.5 + ecgValue * 0.4;
+    data.ecg = live.hasEcg ? live.ecg : 0.5 + ecgValue * 0.4;
 
     // ========================================================================
     // SpO2 Percentage Generation  
     // SpO2 should be a stable percentage (96-99%), not a waveform
     // ========================================================================
-    data.spo2 = SensorDataStore::instance().hasSpo2() ? SensorDataStore::instance().getSpo2() : 
-                97.5 + 1.0 * std::sin(2.0 * M_PI * 0.02 * time_);  // Slow variation around 97.5%
+    data.spo2 = live.hasSpo2 ? live.spo2 : 
+                std::min(MAX_SPO2, active_.spo2 + 1.0 * std::sin(2.0 * M_PI * SLOW_DRIFT_HZ * time_));  // Slow variation around the baseline
 
     // ========================================================================
     // Respiratory Waveform Generation
     // Simulates respiratory rate (breathing)
     // ========================================================================
     data.resp = params_.respAmplitude * 
-                std::sin(2.0 * M_PI * params_.respFreq * time_);
+                std::sin(2.0 * M_PI * breath_.cyclesAt(time_));
 
     // ========================================================================
     // Plethysmograph Waveform Generation (Pulse oximetry waveform)
     // Realistic pulsatile waveform with dicrotic notch
     // ========================================================================
-    const double HR = 75.0;  // Heart rate in BPM
-    const double beatInterval = 60.0 / HR;
-    const double beatPhase = std::fmod(time_, beatInterval) / beatInterval;
-    
-    double plethValue = 0.0;
-    if (beatPhase < 0.3) {
-        // Rapid systolic upstroke
-        double upstrokePhase = beatPhase / 0.3;
-        plethValue = std::pow(upstrokePhase, 2.0);
-    }
-    else if (beatPhase < 0.5) {
-        // Dicrotic notch
-        double notchPhase = (beatPhase - 0.3) / 0.2;
-        plethValue = 1.0 - 0.15 * std::sin(notchPhase * M_PI);
-    }
-    else {
-        // Diastolic decay
-        double decayPhase = (beatPhase - 0.5) / 0.5;
-        plethValue = (1.0 - 0.15) * std::exp(-3.0 * decayPhase);
-    }
+    double plethValue = BeatTemplates::plethShape(beatPhase);
     
     // Add small baseline noise for realism
-    plethValue += 0.02 * std::sin(2.0 * M_PI * 15.0 * time_);
+    plethValue += 0.02 * std::sin(2.0 * M_PI * PLETH_RIPPLE_HZ * time_);
     data.pleth = plethValue;
 
     // ========================================================================
     // Blood Pressure Generation
     // Simulates realistic BP values with slow variation
     // ========================================================================
-    const double bpVariation = 5.0 * std::sin(2.0 * M_PI * 0.02 * time_); // Slow drift
-    data.bp_systolic = 120.0 + bpVariation;
-    data.bp_diastolic = 80.0 + bpVariation * 0.5;
+    const double bpVariation = 5.0 * std::sin(2.0 * M_PI * SLOW_DRIFT_HZ * time_); // Slow drift
+    data.bp_systolic = active_.bpSystolic + bpVariation;
+    data.bp_diastolic = active_.bpDiastolic + bpVariation * 0.5;
 
     // ========================================================================
     // Temperature Generation
     // Simulates body temperature with slow drift for realism
     // ========================================================================
-    const double tempDrift = 0.2 * std::sin(2.0 * M_PI * 0.01 * time_);
+    const double tempDrift = 0.2 * std::sin(2.0 * M_PI * TEMP_DRIFT_HZ * time_);
     data.temp_cavity = 37.2 + tempDrift;      // Core temperature
     data.temp_skin = 36.8 + tempDrift * 0.8;  // Skin temperature (follows core but dampened)
 
@@ -145,15 +214,27 @@ void SignalGenerator::tick(double /* dt */)
 
 void SignalGenerator::reset()
 {
-    // Reset start time to now
-    startTime_ = std::chrono::steady_clock::now();
+    // Restart the clock, at the start of a beat and a breath
+    clock_->reset();
+    beat_.anchorTime = 0.0;
+    beat_.anchorCycles = 0.0;
+    breath_.anchorTime = 0.0;
+    breath_.anchorCycles = 0.0;
 }
 
 double SignalGenerator::getTime() const
 {
-    // Return wall-clock time since start
-    auto now = std::chrono::steady_clock::now();
-    std::chrono::duration<double> elapsed = now - startTime_;
-    return elapsed.count();
+    return clock_->now();
 }
 
+void SignalGenerator::setClock(std::shared_ptr<SimClock> clock)
+{
+    if (clock) {
+        clock_ = std::move(clock);
+    }
+}
+
+void SignalGenerator::setStore(const SensorDataStore& store)
+{
+    store_ = &store;
+}
@@ -0,0 +1,63 @@
+#include "core/sim_clock.h"
+
+#include <cmath>
+
+namespace {
+    constexpr double DEFAULT_SPEED = 1.0;
+    constexpr double DEFAULT_STEP_SECONDS = 0.05;
+}
+
+SimClock::SimClock(Mode mode, double speed, double step)
+    : mode_(mode), speed_(speed), step_(step), startNanos_(wallNanos())
+{
+}
+
+std::shared_ptr<SimClock> SimClock::real()
+{
+    return std::shared_ptr<SimClock>(new SimClock(Mode::Real, 1.0, 0.0));
+}
+
+std::shared_ptr<SimClock> SimClock::scaled(double speed)
+{
+    const bool valid = std::isfinite(speed) && speed > 0.0;
+    return std::shared_ptr<SimClock>(new SimClock(Mode::Scaled, valid ? speed : DEFAULT_SPEED, 0.0));
+}
+
+std::shared_ptr<SimClock> SimClock::fixedStep(double stepSeconds)
+{
+    const bool valid = std::isfinite(stepSeconds) && stepSeconds > 0.0;
+    return std::shared_ptr<SimClock>(
+        new SimClock(Mode::FixedStep, 1.0, valid ? stepSeconds : DEFAULT_STEP_SECONDS));
+}
+
+double SimClock::now() const
+{
+    if (mode_ == Mode::FixedStep)
+    {
+        // Multiply rather than accumulate so long runs stay exact
+        return static_cast<double>(steps_.load(std::memory_order_relaxed)) * step_;
+    }
+    const int64_t elapsed = wallNanos() - startNanos_.load(std::memory_order_relaxed);
+    return static_cast<double>(elapsed) * 1e-9 * speed_;
+}
+
+void SimClock::tick(uint64_t steps)
+{
+    if (mode_ == Mode::FixedStep)
+    {
+        steps_.fetch_add(steps, std::memory_order_relaxed);
+    }
+}
+
+void SimClock::reset()
+{
+    steps_.store(0, std::memory_order_relaxed);
+    startNanos_.store(wallNanos(), std::memory_order_relaxed);
+}
+
+int64_t SimClock::wallNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
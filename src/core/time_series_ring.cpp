@@ -0,0 +1,123 @@
+#include "core/time_series_ring.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <new>
+
+namespace {
+    constexpr std::align_val_t SLOT_ALIGNMENT{64};
+}
+
+TimeSeriesRing::TimeSeriesRing(size_t capacity) : capacity_(capacity > 0 ? capacity : 1)
+{
+    void* block = ::operator new[](capacity_ * sizeof(Slot), SLOT_ALIGNMENT);
+    Slot* slots = static_cast<Slot*>(block);
+    for (size_t i = 0; i < capacity_; ++i)
+    {
+        new (&slots[i]) Slot();
+    }
+    slots_.reset(slots);
+}
+
+void TimeSeriesRing::AlignedDelete::operator()(Slot* p) const
+{
+    // Slot is trivially destructible; only the block needs releasing
+    ::operator delete[](p, SLOT_ALIGNMENT);
+}
+
+uint64_t TimeSeriesRing::lowerBound(uint64_t lo, uint64_t hi, double from) const
+{
+    // First index in [lo, hi) whose timestamp is >= from. Slots racing with the
+    // writer may hold newer (larger) timestamps, which only moves the bound
+    // earlier; such entries are discarded by the caller's validity check.
+    while (lo < hi)
+    {
+        const uint64_t mid = lo + (hi - lo) / 2;
+        if (slots_[mid % capacity_].t.load(std::memory_order_relaxed) < from)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t TimeSeriesRing::readRange(double from, double to, std::vector<TimeSample>& out,
+                                 size_t maxSamples) const
+{
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const uint64_t oldest = head > capacity_ ? head - capacity_ : 0;
+
+    // With a limit, start maxSamples before the end of the range rather than
+    // copying all of it. Slots racing with the writer can only move the end
+    // earlier; the samples after it are still read, and trimmed below.
+    uint64_t first = lowerBound(oldest, head, from);
+    if (maxSamples > 0)
+    {
+        const uint64_t end = lowerBound(first, head, std::nextafter(to, std::numeric_limits<double>::infinity()));
+        if (end - first > maxSamples)
+        {
+            first = end - maxSamples;
+        }
+    }
+
+    const size_t start = out.size();
+    for (uint64_t i = first; i < head; ++i)
+    {
+        const Slot& slot = slots_[i % capacity_];
+        const double t = slot.t.load(std::memory_order_relaxed);
+        const double v = slot.v.load(std::memory_order_relaxed);
+
+        // Skip a slot the writer may have overwritten while we copied it; the
+        // slots after it are newer and may still be in range
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (claim_.load(std::memory_order_relaxed) > i + capacity_)
+        {
+            continue;
+        }
+        if (t < from || t > to)
+        {
+            continue;
+        }
+        out.push_back({t, v});
+    }
+
+    // Keep the newest samples when a limit is requested
+    size_t count = out.size() - start;
+    if (maxSamples > 0 && count > maxSamples)
+    {
+        out.erase(out.begin() + start, out.begin() + start + (count - maxSamples));
+        count = maxSamples;
+    }
+    return count;
+}
+
+bool TimeSeriesRing::latest(TimeSample& out) const
+{
+    for (;;)
+    {
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        if (head == 0)
+        {
+            return false;
+        }
+        const Slot& slot = slots_[(head - 1) % capacity_];
+        out.t = slot.t.load(std::memory_order_relaxed);
+        out.v = slot.v.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (claim_.load(std::memory_order_relaxed) < head + capacity_)
+        {
+            return true;
+        }
+    }
+}
+
+size_t TimeSeriesRing::size() const
+{
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    return static_cast<size_t>(std::min<uint64_t>(head, capacity_));
+}
@@ -0,0 +1,53 @@
+#include "core/waveform_kernels.h"
+
+// Loops below are written for auto-vectorization: straight-line bodies, no
+// calls other than inlined helpers and floor.
+
+namespace WaveformKernels
+{
+
+void phase(const Oscillator& osc, const double* __restrict t, size_t n, double* __restrict out)
+{
+    const double base = osc.anchorCycles;
+    const double anchor = osc.anchorTime;
+    const double hz = osc.hz;
+    for (size_t i = 0; i < n; ++i) {
+        const double cycles = base + (t[i] - anchor) * hz;
+        out[i] = cycles - std::floor(cycles);
+    }
+}
+
+void phaseSine(const double* __restrict phase, size_t n, double* __restrict out)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = fastSinCycles(phase[i]);
+    }
+}
+
+void sine(const double* __restrict t, size_t n, double freqHz, double* __restrict out)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = fastSinCycles(freqHz * t[i]);
+    }
+}
+
+const char* simdTarget()
+{
+#if defined(__AVX512F__)
+    return "AVX-512";
+#elif defined(__AVX2__)
+    return "AVX2";
+#elif defined(__AVX__)
+    return "AVX";
+#elif defined(__SSE4_1__)
+    return "SSE4.1";
+#elif defined(__ARM_NEON)
+    return "NEON";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace WaveformKernels
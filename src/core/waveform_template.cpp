@@ -0,0 +1,148 @@
+#include "core/waveform_template.h"
+
+#include <cmath>
+
+WaveformTemplate::WaveformTemplate(Shape shape, size_t cells)
+    : cells_(cells > 0 ? cells : 1),
+      scale_(static_cast<double>(cells_.size())),
+      last_(cells_.size() - 1)
+{
+    // Sample just inside each edge so a step on the edge belongs to the cell
+    // it starts, however the shape rounds at its own segment boundaries
+    constexpr double INSET = 1e-6;
+    for (size_t i = 0; i < cells_.size(); ++i)
+    {
+        const double startValue = shape((static_cast<double>(i) + INSET) / scale_);
+        const double endValue = shape((static_cast<double>(i + 1) - INSET) / scale_);
+        cells_[i].value = static_cast<float>(startValue);
+        cells_[i].slope = static_cast<float>(endValue - startValue);
+    }
+}
+
+void WaveformTemplate::render(const double* phase, size_t n, double* out) const
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = at(phase[i]);
+    }
+}
+
+namespace BeatTemplates
+{
+
+double ecgShape(double phase)
+{
+    // P wave (atrial depolarization) at 0.0-0.15
+    if (phase < 0.15) {
+        double pPhase = phase / 0.15;
+        return 0.15 * std::exp(-8.0 * std::pow(pPhase - 0.5, 2));
+    }
+    // PR segment (AV node delay) at 0.15-0.20
+    if (phase < 0.20) {
+        return 0.0;
+    }
+    // QRS complex (ventricular depolarization) at 0.20-0.30
+    if (phase < 0.30) {
+        double qrsPhase = (phase - 0.20) / 0.10;
+        if (qrsPhase < 0.2) {
+            // Q wave (small downward deflection)
+            return -0.1 * (qrsPhase / 0.2);
+        }
+        if (qrsPhase < 0.6) {
+            // R wave (tall upward spike)
+            double rPhase = (qrsPhase - 0.2) / 0.4;
+            return -0.1 + 1.2 * std::exp(-std::pow((rPhase - 0.5) * 6.0, 2));
+        }
+        // S wave (small downward deflection)
+        double sPhase = (qrsPhase - 0.6) / 0.4;
+        return -0.08 * (1.0 - sPhase);
+    }
+    // ST segment at 0.30-0.40
+    if (phase < 0.40) {
+        return 0.0;
+    }
+    // T wave (ventricular repolarization) at 0.40-0.70
+    if (phase < 0.70) {
+        double tPhase = (phase - 0.40) / 0.30;
+        return 0.3 * std::exp(-8.0 * std::pow(tPhase - 0.5, 2));
+    }
+    // Return to baseline
+    return 0.0;
+}
+
+double mockEcgShape(double phase)
+{
+    // P wave (atrial depolarization) at 0.0-0.1 of cycle
+    if (phase < 0.1) {
+        double pPhase = phase / 0.1;
+        return 0.15 * std::exp(-50.0 * std::pow(pPhase - 0.5, 2));
+    }
+    // PR segment (isoelectric) at 0.1-0.2
+    if (phase < 0.2) {
+        return 0.0;
+    }
+    // QRS complex (ventricular depolarization) at 0.2-0.3
+    if (phase < 0.3) {
+        double qrsPhase = (phase - 0.2) / 0.1;
+        // Q wave (small negative deflection)
+        if (qrsPhase < 0.2) {
+            return -0.1 * (qrsPhase / 0.2);
+        }
+        // R wave (large positive spike)
+        if (qrsPhase < 0.6) {
+            double rPhase = (qrsPhase - 0.2) / 0.4;
+            return 1.0 * std::exp(-25.0 * std::pow(rPhase - 0.5, 2));
+        }
+        // S wave (negative deflection)
+        double sPhase = (qrsPhase - 0.6) / 0.4;
+        return -0.2 * std::exp(-25.0 * std::pow(sPhase - 0.3, 2));
+    }
+    // ST segment at 0.3-0.4
+    if (phase < 0.4) {
+        return 0.0;
+    }
+    // T wave (ventricular repolarization) at 0.4-0.7
+    if (phase < 0.7) {
+        double tPhase = (phase - 0.4) / 0.3;
+        return 0.3 * std::exp(-8.0 * std::pow(tPhase - 0.5, 2));
+    }
+    // Return to baseline
+    return 0.0;
+}
+
+double plethShape(double phase)
+{
+    if (phase < 0.3) {
+        // Rapid systolic upstroke
+        double upstrokePhase = phase / 0.3;
+        return std::pow(upstrokePhase, 2.0);
+    }
+    if (phase < 0.5) {
+        // Dicrotic notch
+        double notchPhase = (phase - 0.3) / 0.2;
+        return 1.0 - 0.15 * std::sin(notchPhase * M_PI);
+    }
+    // Diastolic decay
+    double decayPhase = (phase - 0.5) / 0.5;
+    return (1.0 - 0.15) * std::exp(-3.0 * decayPhase);
+}
+
+const WaveformTemplate& ecg()
+{
+    static const WaveformTemplate instance(ecgShape);
+    return instance;
+}
+
+const WaveformTemplate& mockEcg()
+{
+    static const WaveformTemplate instance(mockEcgShape);
+    return instance;
+}
+
+const WaveformTemplate& pleth()
+{
+    static const WaveformTemplate instance(plethShape);
+    return instance;
+}
+
+} // namespace BeatTemplates
@@ -0,0 +1,359 @@
+#include "hardware/hub_emulator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint8_t ALL_SENSORS = (1 << READ_ALL_SENSOR_COUNT) - 1;
+
+    uint8_t statusBit(SensorId id)
+    {
+        for (size_t bit = 0; bit < READ_ALL_SENSOR_COUNT; ++bit)
+        {
+            if (READ_ALL_ORDER[bit] == id)
+            {
+                return static_cast<uint8_t>(1 << bit);
+            }
+        }
+        return 0;
+    }
+
+    void spinUntil(Clock::time_point until)
+    {
+        while (Clock::now() < until)
+        {
+        }
+    }
+}
+
+HubEmulator::Timing HubEmulator::atClock(uint32_t clockHz, std::chrono::nanoseconds latency)
+{
+    return {std::chrono::nanoseconds(9'000'000'000LL / clockHz), latency};
+}
+
+HubEmulator::HubEmulator()
+    : HubEmulator(Timing{})
+{
+}
+
+HubEmulator::HubEmulator(const Timing& timing)
+    : timing_(timing), presence_(ALL_SENSORS)
+{
+    sample();
+}
+
+void HubEmulator::setTiming(const Timing& timing)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    timing_ = timing;
+}
+
+void HubEmulator::setCombined(bool combined)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    combined_ = combined;
+}
+
+void HubEmulator::setStretches(bool stretches)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stretches_ = stretches;
+}
+
+void HubEmulator::setPresent(bool present)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    present_ = present;
+}
+
+void HubEmulator::setSensor(SensorId id, float value)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    presence_ |= statusBit(id);
+    values_[static_cast<size_t>(id)] = value;
+}
+
+void HubEmulator::removeSensor(SensorId id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    presence_ &= static_cast<uint8_t>(~statusBit(id));
+}
+
+uint8_t HubEmulator::sample()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Build into the back buffer, then flip: the front one is never half-written
+    Frame& frame = frames_[1 - front_];
+    frame.bytes[0] = sequence_;
+    frame.bytes[1] = presence_;
+    size_t length = 2;
+    for (size_t bit = 0; bit < READ_ALL_SENSOR_COUNT; ++bit)
+    {
+        if ((presence_ >> bit) & 1)
+        {
+            std::memcpy(frame.bytes + length, &values_[static_cast<size_t>(READ_ALL_ORDER[bit])], sizeof(float));
+            length += sizeof(float);
+        }
+    }
+    frame.bytes[length] = crc8(frame.bytes, length);
+    frame.length = length + 1;
+    front_ = 1 - front_;
+    return sequence_++;
+}
+
+void HubEmulator::corruptNextFrame()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    corruptNext_ = true;
+}
+
+bool HubEmulator::pushFifo(SensorId channel, uint32_t timestampUs, float value)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fifo_.size() >= HUB_FIFO_CAPACITY)
+    {
+        ++fifoDropped_;
+        return false;
+    }
+    fifo_.push_back({channel, timestampUs, value});
+    return true;
+}
+
+size_t HubEmulator::fifoLevel() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fifo_.size();
+}
+
+uint8_t HubEmulator::presence() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return presence_;
+}
+
+size_t HubEmulator::transfers() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return transfers_;
+}
+
+size_t HubEmulator::staleReads() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return staleReads_;
+}
+
+void HubEmulator::busTime_(size_t bytes) const
+{
+    std::chrono::nanoseconds byteTime;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        byteTime = timing_.byteTime;
+    }
+    if (byteTime.count() > 0)
+    {
+        spinUntil(Clock::now() + byteTime * static_cast<int64_t>(bytes + 1));
+    }
+}
+
+bool HubEmulator::acked_() const
+{
+    return present_ && address_ == HUB_I2C_ADDRESS;
+}
+
+void HubEmulator::command_(const uint8_t* data, size_t length)
+{
+    // What the firmware's onReceive() leaves for onRequest()
+    const auto set = [this](std::initializer_list<uint8_t> bytes) {
+        std::copy(bytes.begin(), bytes.end(), pending_);
+        pendingLength_ = bytes.size();
+    };
+
+    switch (static_cast<HubCommand>(data[0]))
+    {
+    case HubCommand::PING:
+        set({PING_RESPONSE});
+        break;
+    case HubCommand::SCAN_SENSORS:
+        set({static_cast<uint8_t>(presence_ & ~SensorStatusBits::RESPIRATORY)});
+        break;
+    case HubCommand::READ_SENSOR:
+    {
+        const SensorId id = static_cast<SensorId>(length > 1 ? data[1] : ERROR_RESPONSE);
+        if (length < 2 || !(presence_ & statusBit(id)))
+        {
+            set({ERROR_RESPONSE, ERROR_RESPONSE, ERROR_RESPONSE, ERROR_RESPONSE});
+            break;
+        }
+        std::memcpy(pending_, &values_[static_cast<size_t>(id)], sizeof(float));
+        pendingLength_ = sizeof(float);
+        break;
+    }
+    case HubCommand::GET_STATUS:
+        set({static_cast<uint8_t>((presence_ & SensorStatusBits::ECG) ? 1 : 0),
+             static_cast<uint8_t>((presence_ & SensorStatusBits::SPO2) ? 1 : 0),
+             static_cast<uint8_t>((presence_ & (SensorStatusBits::TEMP_CORE | SensorStatusBits::TEMP_SKIN)) ? 1 : 0),
+             static_cast<uint8_t>((presence_ & SensorStatusBits::NIBP) ? 1 : 0),
+             static_cast<uint8_t>((presence_ & SensorStatusBits::RESPIRATORY) ? 1 : 0)});
+        break;
+    case HubCommand::READ_ALL:
+    {
+        const Frame& frame = frames_[front_];
+        std::memcpy(pending_, frame.bytes, frame.length);
+        pendingLength_ = frame.length;
+        if (corruptNext_)
+        {
+            pending_[frame.length / 2] ^= 0x10;
+            corruptNext_ = false;
+        }
+        break;
+    }
+    case HubCommand::READ_FIFO:
+        readFifo_(length > 1 ? data[1] : 0);
+        break;
+    case HubCommand::FIFO_LEVEL:
+    {
+        const auto level = static_cast<uint16_t>(fifo_.size());
+        const auto dropped = static_cast<uint16_t>(std::min<size_t>(fifoDropped_, 0xFFFF));
+        set({static_cast<uint8_t>(level), static_cast<uint8_t>(level >> 8),
+             static_cast<uint8_t>(dropped), static_cast<uint8_t>(dropped >> 8)});
+        pending_[4] = crc8(pending_, 4);
+        pendingLength_ = FIFO_LEVEL_LENGTH;
+        fifoDropped_ = 0;
+        break;
+    }
+    default:
+        set({ERROR_RESPONSE});
+        break;
+    }
+    readyAt_ = Clock::now() + timing_.latency;
+}
+
+void HubEmulator::readFifo_(size_t requested)
+{
+    // Samples leave the FIFO as the answer is built, as in the firmware's onReceive()
+    const size_t count = std::min({requested, READ_FIFO_MAX_SAMPLES, fifo_.size()});
+    uint8_t* out = pending_ + 3;
+    for (size_t i = 0; i < count; ++i, out += FIFO_ENTRY_SIZE)
+    {
+        const FifoEntry& entry = fifo_.front();
+        out[0] = static_cast<uint8_t>(entry.channel);
+        for (int b = 0; b < 4; ++b)
+        {
+            out[1 + b] = static_cast<uint8_t>(entry.timestampUs >> (8 * b));
+        }
+        std::memcpy(out + 5, &entry.value, sizeof(float));
+        fifo_.pop_front();
+    }
+    const auto level = static_cast<uint16_t>(fifo_.size());
+    pending_[0] = static_cast<uint8_t>(count);
+    pending_[1] = static_cast<uint8_t>(level);
+    pending_[2] = static_cast<uint8_t>(level >> 8);
+    const size_t length = readFifoFrameLength(count);
+    pending_[length - 1] = crc8(pending_, length - 1);
+    pendingLength_ = length;
+
+    if (corruptNext_)
+    {
+        pending_[length / 2] ^= 0x10;
+        corruptNext_ = false;
+    }
+}
+
+void HubEmulator::respond_(uint8_t* data, size_t length)
+{
+    if (Clock::now() >= readyAt_)
+    {
+        std::memcpy(answer_, pending_, pendingLength_);
+        answerLength_ = pendingLength_;
+    }
+    else
+    {
+        ++staleReads_;
+    }
+    // Reading past the answer gets the SERCOM's idle 0xFF
+    for (size_t i = 0; i < length; ++i)
+    {
+        data[i] = i < answerLength_ ? answer_[i] : 0xFF;
+    }
+}
+
+bool HubEmulator::setAddress(uint8_t address)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    address_ = address;
+    return true;
+}
+
+bool HubEmulator::write(const uint8_t* data, size_t length)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!acked_() || length == 0)
+        {
+            return false;
+        }
+    }
+    busTime_(length);
+    std::lock_guard<std::mutex> lock(mutex_);
+    command_(data, length);
+    return true;
+}
+
+bool HubEmulator::read(uint8_t* data, size_t length)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!acked_())
+        {
+            return false;
+        }
+        respond_(data, length);
+    }
+    busTime_(length);
+    return true;
+}
+
+bool HubEmulator::transfer(Segment* segments, size_t count)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!combined_)
+        {
+            return false;
+        }
+        ++transfers_;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            address_ = segments[i].address;
+        }
+        if (!segments[i].read)
+        {
+            if (!write(segments[i].data, segments[i].length))
+            {
+                return false;
+            }
+            continue;
+        }
+
+        Clock::time_point readyAt;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            readyAt = stretches_ ? readyAt_ : Clock::time_point{};
+        }
+        spinUntil(readyAt); // Clock stretching
+        if (!read(segments[i].data, segments[i].length))
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,146 @@
+#include "hardware/i2c_bus.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr size_t MAX_SEGMENTS = 8;
+}
+
+LinuxI2CBus::LinuxI2CBus(int bus)
+    : bus_(bus)
+{
+}
+
+LinuxI2CBus::~LinuxI2CBus()
+{
+    close();
+}
+
+bool LinuxI2CBus::open()
+{
+#ifdef __linux__
+    if (fd_ >= 0)
+    {
+        return true;
+    }
+    const std::string device = "/dev/i2c-" + std::to_string(bus_);
+    fd_ = ::open(device.c_str(), O_RDWR);
+
+    if (fd_ < 0)
+    {
+        std::cerr << "[I2C] Failed to open " << device << ": " << strerror(errno) << std::endl;
+        std::cerr << "[I2C] Hint: Run 'sudo raspi-config' to enable I²C" << std::endl;
+        return false;
+    }
+
+    address_ = NO_ADDRESS;
+    std::cout << "[I2C] Opened " << device << " successfully" << std::endl;
+    return true;
+#else
+    std::cerr << "[I2C] I²C only supported on Linux. Use mock mode on other platforms." << std::endl;
+    return false;
+#endif
+}
+
+void LinuxI2CBus::close()
+{
+    if (fd_ >= 0)
+    {
+#ifdef __linux__
+        ::close(fd_);
+#endif
+        fd_ = -1;
+        address_ = NO_ADDRESS;
+    }
+}
+
+bool LinuxI2CBus::setAddress(uint8_t address)
+{
+#ifdef __linux__
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    if (address_ == address)
+    {
+        return true;
+    }
+    if (ioctl(fd_, I2C_SLAVE, address) < 0)
+    {
+        std::cerr << "[I2C] Failed to set slave address 0x" << std::hex << (int)address
+                  << std::dec << ": " << strerror(errno) << std::endl;
+        address_ = NO_ADDRESS;
+        return false;
+    }
+    address_ = address;
+    return true;
+#else
+    (void)address;
+    return false;
+#endif
+}
+
+bool LinuxI2CBus::write(const uint8_t* data, size_t length)
+{
+#ifdef __linux__
+    return fd_ >= 0 && ::write(fd_, data, length) == static_cast<ssize_t>(length);
+#else
+    (void)data;
+    (void)length;
+    return false;
+#endif
+}
+
+bool LinuxI2CBus::read(uint8_t* data, size_t length)
+{
+#ifdef __linux__
+    return fd_ >= 0 && ::read(fd_, data, length) == static_cast<ssize_t>(length);
+#else
+    (void)data;
+    (void)length;
+    return false;
+#endif
+}
+
+bool LinuxI2CBus::transfer(Segment* segments, size_t count)
+{
+#ifdef __linux__
+    if (fd_ < 0 || count == 0 || count > MAX_SEGMENTS)
+    {
+        return false;
+    }
+
+    i2c_msg messages[MAX_SEGMENTS];
+    for (size_t i = 0; i < count; ++i)
+    {
+        messages[i].addr = segments[i].address;
+        messages[i].flags = segments[i].read ? I2C_M_RD : 0;
+        messages[i].len = static_cast<__u16>(segments[i].length);
+        messages[i].buf = segments[i].data;
+    }
+
+    i2c_rdwr_ioctl_data transaction{messages, static_cast<__u32>(count)};
+    if (ioctl(fd_, I2C_RDWR, &transaction) != static_cast<int>(count))
+    {
+        std::cerr << "[I2C] Combined transaction with 0x" << std::hex << (int)segments[0].address
+                  << std::dec << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+#else
+    (void)segments;
+    (void)count;
+    return false;
+#endif
+}
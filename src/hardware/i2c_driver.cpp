@@ -1,29 +1,48 @@
 #include "hardware/i2c_driver.h"
+#include "core/waveform_template.h"
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <cstring>
 #include <cmath>
 #include <thread>
 #include <chrono>
 
-#ifdef __linux__
-#include <fcntl.h>
-#include <unistd.h>
-#include <sys/ioctl.h>
-#include <linux/i2c-dev.h>
-#include <errno.h>
-#endif
-
 namespace {
-    constexpr int PING_DELAY_MS = 5;
-    constexpr int SENSOR_READ_DELAY_MS = 10;
-    constexpr int SCAN_DELAY_MS = 50;
-    constexpr int STATUS_DELAY_MS = 10;
-    constexpr int BUS_READY_DELAY_MS = 2;
-    constexpr double MOCK_TIME_INCREMENT = 0.05;
+    // First split-transaction gap tried by measureTurnaround()
+    constexpr std::chrono::microseconds MIN_TURNAROUND{50};
+
+    // Waveform channels the hub FIFO carries, and their rates
+    struct FifoChannel
+    {
+        SensorId id;
+        uint32_t hz;
+    };
+    constexpr FifoChannel FIFO_CHANNELS[] = {
+        {SensorId::ECG, FIFO_ECG_HZ},
+        {SensorId::SPO2, FIFO_PLETH_HZ},
+        {SensorId::RESPIRATORY, FIFO_RESP_HZ},
+    };
+
+    uint16_t readU16(const uint8_t* p)
+    {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint32_t readU32(const uint8_t* p)
+    {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
 }
 
 I2CDriver::I2CDriver(int bus, bool mockMode)
-    : bus_(bus), fd_(-1), mockMode_(mockMode)
+    : busNumber_(bus), mockMode_(mockMode), clock_(SimClock::real())
+{
+}
+
+I2CDriver::I2CDriver(std::unique_ptr<I2CBus> bus)
+    : busNumber_(-1), bus_(std::move(bus)), mockMode_(false), clock_(SimClock::real())
 {
 }
 
@@ -32,6 +51,14 @@ I2CDriver::~I2CDriver()
     close();
 }
 
+void I2CDriver::setClock(std::shared_ptr<SimClock> clock)
+{
+    if (clock)
+    {
+        clock_ = std::move(clock);
+    }
+}
+
 bool I2CDriver::open()
 {
     if (mockMode_)
@@ -39,35 +66,125 @@ bool I2CDriver::open()
         std::cout << "[I2C Mock] Mock mode enabled - no hardware access" << std::endl;
         return true;
     }
+    if (bus_)
+    {
+        return true;
+    }
 
-#ifdef __linux__
-    std::string device = "/dev/i2c-" + std::to_string(bus_);
-    fd_ = ::open(device.c_str(), O_RDWR);
-
-    if (fd_ < 0)
+    auto device = std::make_unique<LinuxI2CBus>(busNumber_);
+    if (!device->open())
     {
-        std::cerr << "[I2C] Failed to open " << device << ": " << strerror(errno) << std::endl;
-        std::cerr << "[I2C] Hint: Run 'sudo raspi-config' to enable I²C" << std::endl;
         return false;
     }
-
-    std::cout << "[I2C] Opened " << device << " successfully" << std::endl;
+    device_ = device.get();
+    bus_ = std::move(device);
     return true;
-#else
-    std::cerr << "[I2C] I²C only supported on Linux. Use mock mode on other platforms." << std::endl;
-    return false;
-#endif
 }
 
 void I2CDriver::close()
 {
-    if (fd_ >= 0)
+    // An injected transport stays; only a device opened here is released
+    if (device_)
+    {
+        bus_.reset();
+        device_ = nullptr;
+    }
+}
+
+bool I2CDriver::transact(uint8_t address, const uint8_t* command, size_t commandLength,
+                         uint8_t* response, size_t responseLength)
+{
+    if (!bus_)
+    {
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    bool ok = false;
+    if (turnaround_.count() == 0)
+    {
+        // Write, repeated start, read: the hub stretches SCL until it has the answer
+        I2CBus::Segment segments[2] = {
+            {address, false, const_cast<uint8_t*>(command), commandLength},
+            {address, true, response, responseLength},
+        };
+        ok = bus_->transfer(segments, 2);
+    }
+    else
+    {
+        ok = bus_->setAddress(address) && bus_->write(command, commandLength);
+        if (ok)
+        {
+            std::this_thread::sleep_for(turnaround_);
+            ok = bus_->read(response, responseLength);
+        }
+    }
+
+    if (ok)
+    {
+        transactionLatency_.record(std::chrono::steady_clock::now() - start);
+    }
+    return ok;
+}
+
+bool I2CDriver::probeTurnaround(std::chrono::microseconds gap, std::chrono::microseconds limit)
+{
+    // Leave a SCAN answer in the hub's response buffer first. Bit 6 of a
+    // status byte is never set, so it cannot read as PING_RESPONSE, and a
+    // 0x42 below is the hub answering this PING rather than a stale buffer.
+    uint8_t command = static_cast<uint8_t>(HubCommand::SCAN_SENSORS);
+    uint8_t response = PING_RESPONSE;
+    turnaround_ = limit;
+    if (!transact(HUB_I2C_ADDRESS, &command, 1, &response, 1) || response == PING_RESPONSE)
     {
-#ifdef __linux__
-        ::close(fd_);
-#endif
-        fd_ = -1;
+        return false;
     }
+
+    command = static_cast<uint8_t>(HubCommand::PING);
+    turnaround_ = gap;
+    return transact(HUB_I2C_ADDRESS, &command, 1, &response, 1) && response == PING_RESPONSE;
+}
+
+bool I2CDriver::measureTurnaround(std::chrono::microseconds limit)
+{
+    if (mockMode_)
+    {
+        return true;
+    }
+    if (!bus_)
+    {
+        return false;
+    }
+
+    const auto previous = turnaround_;
+    for (auto gap = std::chrono::microseconds(0); gap <= limit;
+         gap = gap.count() == 0 ? MIN_TURNAROUND : gap * 2)
+    {
+        bool reliable = true;
+        for (int attempt = 0; attempt < MAX_RETRIES && reliable; ++attempt)
+        {
+            reliable = probeTurnaround(gap, limit);
+        }
+        if (reliable)
+        {
+            // A sleep may overshoot while probing, so a split gap gets 2x headroom
+            turnaround_ = gap * 2;
+            transactionLatency_.reset();
+            if (gap.count() == 0)
+            {
+                std::cout << "[I2C] Hub turnaround: combined transactions" << std::endl;
+            }
+            else
+            {
+                std::cout << "[I2C] Hub turnaround: " << gap.count() << " us" << std::endl;
+            }
+            return true;
+        }
+    }
+
+    turnaround_ = previous;
+    std::cerr << "[I2C] Hub did not answer PING within " << limit.count() << " us" << std::endl;
+    return false;
 }
 
 // ============================================================================
@@ -82,28 +199,14 @@ bool I2CDriver::pingHub()
         return true;
     }
 
-#ifdef __linux__
-    if (fd_ < 0)
-        return false;
-
     uint8_t cmd = static_cast<uint8_t>(HubCommand::PING);
-    if (!writeByte(HUB_I2C_ADDRESS, cmd))
-    {
-        return false;
-    }
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(PING_DELAY_MS));
-
-    uint8_t response;
-    if (!readByte(HUB_I2C_ADDRESS, response))
+    uint8_t response = 0;
+    if (!transact(HUB_I2C_ADDRESS, &cmd, 1, &response, 1))
     {
         return false;
     }
 
     return (response == PING_RESPONSE);
-#else
-    return false;
-#endif
 }
 
 bool I2CDriver::readSensor(SensorId sensorId, float &value)
@@ -114,31 +217,22 @@ bool I2CDriver::readSensor(SensorId sensorId, float &value)
         return true;
     }
 
-#ifdef __linux__
-    if (fd_ < 0)
-        return false;
-
-    uint8_t cmd = static_cast<uint8_t>(HubCommand::READ_SENSOR);
-    uint8_t id = static_cast<uint8_t>(sensorId);
-
-    if (!writeCommand(HUB_I2C_ADDRESS, cmd, id))
+    uint8_t cmd[2] = {static_cast<uint8_t>(HubCommand::READ_SENSOR), static_cast<uint8_t>(sensorId)};
+    uint8_t buffer[4];
+    if (!transact(HUB_I2C_ADDRESS, cmd, 2, buffer, 4))
     {
         return false;
     }
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(SENSOR_READ_DELAY_MS));
-
-    uint8_t buffer[4];
-    if (!readBytes(HUB_I2C_ADDRESS, buffer, 4))
+    // A hub that does not know the sensor (or the command) answers 0xFF bytes: NaN
+    float read = 0.0f;
+    std::memcpy(&read, buffer, sizeof(float));
+    if (!std::isfinite(read))
     {
         return false;
     }
-
-    std::memcpy(&value, buffer, sizeof(float));
+    value = read;
     return true;
-#else
-    return false;
-#endif
 }
 
 uint8_t I2CDriver::scanSensors()
@@ -149,30 +243,15 @@ uint8_t I2CDriver::scanSensors()
         return 0x1F; // All 5 bits set: ECG|SpO2|CoreTemp|NIBP|SkinTemp
     }
 
-#ifdef __linux__
-    if (fd_ < 0)
-        return 0xFF;
-
     uint8_t cmd = static_cast<uint8_t>(HubCommand::SCAN_SENSORS);
-    if (!writeByte(HUB_I2C_ADDRESS, cmd))
-    {
-        std::cerr << "[I2C] Failed to send scan command" << std::endl;
-        return 0xFF;
-    }
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(SCAN_DELAY_MS));
-
     uint8_t status = 0;
-    if (!readByte(HUB_I2C_ADDRESS, status))
+    if (!transact(HUB_I2C_ADDRESS, &cmd, 1, &status, 1))
     {
         std::cerr << "[I2C] Failed to read scan results" << std::endl;
         return 0xFF;
     }
 
     return status;
-#else
-    return 0xFF;
-#endif
 }
 bool I2CDriver::getSensorStatus(uint8_t *statusBuffer)
 {
@@ -187,27 +266,202 @@ bool I2CDriver::getSensorStatus(uint8_t *statusBuffer)
         return true;
     }
 
-#ifdef __linux__
-    if (fd_ < 0)
+    uint8_t cmd = static_cast<uint8_t>(HubCommand::GET_STATUS);
+    return transact(HUB_I2C_ADDRESS, &cmd, 1, statusBuffer, 5);
+}
+
+bool I2CDriver::HubFrame::has(SensorId id) const
+{
+    for (size_t bit = 0; bit < READ_ALL_SENSOR_COUNT; ++bit)
+    {
+        if (READ_ALL_ORDER[bit] == id)
+        {
+            return (present >> bit) & 1;
+        }
+    }
+    return false;
+}
+
+bool I2CDriver::parseHubFrame(const uint8_t* data, size_t length, HubFrame& frame)
+{
+    if (length < 3 || (data[1] >> READ_ALL_SENSOR_COUNT) != 0)
+    {
+        return false;
+    }
+    const size_t frameLength = readAllFrameLength(data[1]);
+    if (length < frameLength || crc8(data, frameLength - 1) != data[frameLength - 1])
+    {
         return false;
+    }
 
-    uint8_t cmd = static_cast<uint8_t>(HubCommand::GET_STATUS);
-    if (!writeByte(HUB_I2C_ADDRESS, cmd))
+    frame = HubFrame{};
+    frame.sequence = data[0];
+    frame.present = data[1];
+    const uint8_t* value = data + 2;
+    for (size_t bit = 0; bit < READ_ALL_SENSOR_COUNT; ++bit)
+    {
+        if ((frame.present >> bit) & 1)
+        {
+            // Little-endian on the wire, as on the Pi
+            std::memcpy(&frame.values[static_cast<size_t>(READ_ALL_ORDER[bit])], value, sizeof(float));
+            value += sizeof(float);
+        }
+    }
+    return true;
+}
+
+bool I2CDriver::readAll(HubFrame& frame)
+{
+    if (mockMode_)
+    {
+        frame = HubFrame{};
+        frame.sequence = mockSequence_++;
+        frame.present = generateMockStatusByte();
+        for (SensorId id : READ_ALL_ORDER)
+        {
+            frame.values[static_cast<size_t>(id)] = generateMockValue(id);
+        }
+        return true;
+    }
+
+    uint8_t cmd = static_cast<uint8_t>(HubCommand::READ_ALL);
+    uint8_t buffer[READ_ALL_MAX_LENGTH];
+    size_t length = readAllLength_;
+    while (true)
+    {
+        if (!transact(HUB_I2C_ADDRESS, &cmd, 1, buffer, length))
+        {
+            return false;
+        }
+        if (parseHubFrame(buffer, length, frame))
+        {
+            readAllLength_ = readAllFrameLength(frame.present);
+            return true;
+        }
+
+        ++frameErrors_;
+        if (length == READ_ALL_MAX_LENGTH)
+        {
+            return false;
+        }
+        length = READ_ALL_MAX_LENGTH; // The mask may have grown since the last frame
+    }
+}
+
+bool I2CDriver::parseFifoFrame(const uint8_t* data, size_t length, FifoBatch& batch)
+{
+    if (length < readFifoFrameLength(0) || data[0] > READ_FIFO_MAX_SAMPLES)
+    {
+        return false;
+    }
+    const size_t count = data[0];
+    const size_t frameLength = readFifoFrameLength(count);
+    if (length < frameLength || crc8(data, frameLength - 1) != data[frameLength - 1])
     {
         return false;
     }
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(STATUS_DELAY_MS));
+    const uint8_t* entry = data + 3;
+    for (size_t i = 0; i < count; ++i, entry += FIFO_ENTRY_SIZE)
+    {
+        if (entry[0] > static_cast<uint8_t>(SensorId::TEMP_SKIN))
+        {
+            return false;
+        }
+        FifoSample& sample = batch.samples[i];
+        sample.channel = static_cast<SensorId>(entry[0]);
+        sample.timestampUs = readU32(entry + 1);
+        std::memcpy(&sample.value, entry + 5, sizeof(float));
+    }
+    batch.count = count;
+    batch.level = readU16(data + 1);
+    return true;
+}
+
+bool I2CDriver::readFifo(FifoBatch& batch, size_t maxSamples)
+{
+    const size_t count = std::min(maxSamples, READ_FIFO_MAX_SAMPLES);
+
+    if (mockMode_)
+    {
+        // Sample the mock waveforms at the hub's rates, up to the clock's "now"
+        const double now = clock_->now();
+        if (!mockFifoStarted_ || now < mockFifoStart_ || mockFifoLevel(now) > HUB_FIFO_CAPACITY)
+        {
+            // First use, a clock reset, or a backlog the hub could not have held
+            startMockFifo(now);
+        }
+        batch.count = 0;
+        while (batch.count < count)
+        {
+            // Oldest due sample across the channels
+            size_t next = std::size(FIFO_CHANNELS);
+            double t = 0.0;
+            for (size_t c = 0; c < std::size(FIFO_CHANNELS); ++c)
+            {
+                const double due = mockFifoStart_ + static_cast<double>(mockFifoTaken_[c]) / FIFO_CHANNELS[c].hz;
+                if (mockFifoTaken_[c] < mockFifoDue(c, now) && (next == std::size(FIFO_CHANNELS) || due < t))
+                {
+                    next = c;
+                    t = due;
+                }
+            }
+            if (next == std::size(FIFO_CHANNELS))
+            {
+                break;
+            }
+            const SensorId id = FIFO_CHANNELS[next].id;
+            batch.samples[batch.count++] = {id, static_cast<uint32_t>(std::llround(t * 1e6)),
+                                            generateMockWaveform(id, t)};
+            ++mockFifoTaken_[next];
+        }
+        batch.level = static_cast<uint16_t>(std::min(mockFifoLevel(now), HUB_FIFO_CAPACITY));
+        return true;
+    }
 
-    if (!readBytes(HUB_I2C_ADDRESS, statusBuffer, 5))
+    uint8_t cmd[2] = {static_cast<uint8_t>(HubCommand::READ_FIFO), static_cast<uint8_t>(count)};
+    uint8_t buffer[readFifoFrameLength(READ_FIFO_MAX_SAMPLES)];
+    const size_t length = readFifoFrameLength(count);
+    if (!transact(HUB_I2C_ADDRESS, cmd, 2, buffer, length))
+    {
+        return false;
+    }
+    if (!parseFifoFrame(buffer, length, batch))
     {
+        ++frameErrors_;
         return false;
     }
+    return true;
+}
+
+bool I2CDriver::fifoLevel(FifoStatus& status)
+{
+    if (mockMode_)
+    {
+        const double now = clock_->now();
+        if (!mockFifoStarted_)
+        {
+            startMockFifo(now);
+        }
+        status.level = static_cast<uint16_t>(std::min(mockFifoLevel(now), HUB_FIFO_CAPACITY));
+        status.dropped = 0;
+        return true;
+    }
 
+    uint8_t cmd = static_cast<uint8_t>(HubCommand::FIFO_LEVEL);
+    uint8_t buffer[FIFO_LEVEL_LENGTH];
+    if (!transact(HUB_I2C_ADDRESS, &cmd, 1, buffer, FIFO_LEVEL_LENGTH))
+    {
+        return false;
+    }
+    if (crc8(buffer, FIFO_LEVEL_LENGTH - 1) != buffer[FIFO_LEVEL_LENGTH - 1])
+    {
+        ++frameErrors_;
+        return false;
+    }
+    status.level = readU16(buffer);
+    status.dropped = readU16(buffer + 2);
     return true;
-#else
-    return false;
-#endif
 }
 
 // ============================================================================
@@ -230,17 +484,16 @@ bool I2CDriver::deviceExists(uint8_t address)
         return exists;
     }
 
-#ifdef __linux__
     std::cout << "[I2C] Probing device at 0x" << std::hex << (int)address << std::dec << "..." << std::endl;
 
-    if (ioctl(fd_, I2C_SLAVE, address) < 0)
+    if (!bus_->setAddress(address))
     {
         std::cerr << "[I2C] Failed to select device 0x" << std::hex << (int)address << std::dec << std::endl;
         return false;
     }
 
     uint8_t byte;
-    if (read(fd_, &byte, 1) != 1)
+    if (!bus_->read(&byte, 1))
     {
         std::cout << "[I2C] Device 0x" << std::hex << (int)address << std::dec << " not responding" << std::endl;
         return false;
@@ -248,9 +501,6 @@ bool I2CDriver::deviceExists(uint8_t address)
 
     std::cout << "[I2C] ✓ Device 0x" << std::hex << (int)address << std::dec << " detected" << std::endl;
     return true;
-#else
-    return false;
-#endif
 }
 
 bool I2CDriver::writeByte(uint8_t address, uint8_t data)
@@ -262,33 +512,13 @@ bool I2CDriver::writeByte(uint8_t address, uint8_t data)
         return true;
     }
 
-#ifdef __linux__
-    if (fd_ < 0)
-    {
-        std::cerr << "[I2C] File descriptor invalid" << std::endl;
-        return false;
-    }
-
-    if (ioctl(fd_, I2C_SLAVE, address) < 0)
-    {
-        std::cerr << "[I2C] Failed to set slave address 0x" << std::hex << (int)address
-                  << std::dec << ": " << strerror(errno) << std::endl;
-        return false;
-    }
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(BUS_READY_DELAY_MS));
-
-    if (write(fd_, &data, 1) != 1)
+    if (!bus_ || !bus_->setAddress(address) || !bus_->write(&data, 1))
     {
-        std::cerr << "[I2C] Failed to write byte to 0x" << std::hex << (int)address
-                  << std::dec << ": " << strerror(errno) << std::endl;
+        std::cerr << "[I2C] Failed to write byte to 0x" << std::hex << (int)address << std::dec << std::endl;
         return false;
     }
 
     return true;
-#else
-    return false;
-#endif
 }
 
 bool I2CDriver::writeCommand(uint8_t address, uint8_t command, uint8_t data)
@@ -300,34 +530,14 @@ bool I2CDriver::writeCommand(uint8_t address, uint8_t command, uint8_t data)
         return true;
     }
 
-#ifdef __linux__
-    if (fd_ < 0)
-    {
-        std::cerr << "[I2C] File descriptor invalid" << std::endl;
-        return false;
-    }
-
-    if (ioctl(fd_, I2C_SLAVE, address) < 0)
-    {
-        std::cerr << "[I2C] Failed to set slave address 0x" << std::hex << (int)address
-                  << std::dec << ": " << strerror(errno) << std::endl;
-        return false;
-    }
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(BUS_READY_DELAY_MS));
-
     uint8_t buffer[2] = {command, data};
-    if (write(fd_, buffer, 2) != 2)
+    if (!bus_ || !bus_->setAddress(address) || !bus_->write(buffer, 2))
     {
-        std::cerr << "[I2C] Failed to write command to 0x" << std::hex << (int)address
-                  << std::dec << ": " << strerror(errno) << std::endl;
+        std::cerr << "[I2C] Failed to write command to 0x" << std::hex << (int)address << std::dec << std::endl;
         return false;
     }
 
     return true;
-#else
-    return false;
-#endif
 }
 
 bool I2CDriver::readByte(uint8_t address, uint8_t &data)
@@ -338,33 +548,13 @@ bool I2CDriver::readByte(uint8_t address, uint8_t &data)
         return true;
     }
 
-#ifdef __linux__
-    if (fd_ < 0)
-    {
-        std::cerr << "[I2C] File descriptor invalid" << std::endl;
-        return false;
-    }
-
-    if (ioctl(fd_, I2C_SLAVE, address) < 0)
-    {
-        std::cerr << "[I2C] Failed to set slave address 0x" << std::hex << (int)address
-                  << std::dec << ": " << strerror(errno) << std::endl;
-        return false;
-    }
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(BUS_READY_DELAY_MS));
-
-    if (read(fd_, &data, 1) != 1)
+    if (!bus_ || !bus_->setAddress(address) || !bus_->read(&data, 1))
     {
-        std::cerr << "[I2C] Failed to read byte from 0x" << std::hex << (int)address
-                  << std::dec << ": " << strerror(errno) << std::endl;
+        std::cerr << "[I2C] Failed to read byte from 0x" << std::hex << (int)address << std::dec << std::endl;
         return false;
     }
 
     return true;
-#else
-    return false;
-#endif
 }
 
 bool I2CDriver::readBytes(uint8_t address, uint8_t *buffer, size_t length)
@@ -379,33 +569,14 @@ bool I2CDriver::readBytes(uint8_t address, uint8_t *buffer, size_t length)
         return true;
     }
 
-#ifdef __linux__
-    if (fd_ < 0)
-    {
-        std::cerr << "[I2C] File descriptor invalid" << std::endl;
-        return false;
-    }
-
-    if (ioctl(fd_, I2C_SLAVE, address) < 0)
-    {
-        std::cerr << "[I2C] Failed to set slave address 0x" << std::hex << (int)address
-                  << std::dec << ": " << strerror(errno) << std::endl;
-        return false;
-    }
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(BUS_READY_DELAY_MS));
-
-    if (read(fd_, buffer, length) != (ssize_t)length)
+    if (!bus_ || !bus_->setAddress(address) || !bus_->read(buffer, length))
     {
         std::cerr << "[I2C] Failed to read " << length << " bytes from 0x" << std::hex << (int)address
-                  << std::dec << ": " << strerror(errno) << std::endl;
+                  << std::dec << std::endl;
         return false;
     }
 
     return true;
-#else
-    return false;
-#endif
 }
 
 // ============================================================================
@@ -420,52 +591,11 @@ float generateECGWaveform(double time) {
     // Position within current beat cycle (0.0 to 1.0)
     double beatPhase = std::fmod(time, beatInterval) / beatInterval;
     
-    // Baseline
-    float value = 0.0f;
-    
-    // P wave (atrial depolarization) at 0.0-0.1 of cycle
-    if (beatPhase < 0.1) {
-        double pPhase = beatPhase / 0.1;
-        value = 0.15f * std::exp(-50.0 * std::pow(pPhase - 0.5, 2));
-    }
-    // PR segment (isoelectric) at 0.1-0.2
-    else if (beatPhase < 0.2) {
-        value = 0.0f;
-    }
-    // QRS complex (ventricular depolarization) at 0.2-0.3
-    else if (beatPhase < 0.3) {
-        double qrsPhase = (beatPhase - 0.2) / 0.1;
-        // Q wave (small negative deflection)
-        if (qrsPhase < 0.2) {
-            value = -0.1f * (qrsPhase / 0.2);
-        }
-        // R wave (large positive spike)
-        else if (qrsPhase < 0.6) {
-            double rPhase = (qrsPhase - 0.2) / 0.4;
-            value = 1.0f * std::exp(-25.0 * std::pow(rPhase - 0.5, 2));
-        }
-        // S wave (negative deflection)
-        else {
-            double sPhase = (qrsPhase - 0.6) / 0.4;
-            value = -0.2f * std::exp(-25.0 * std::pow(sPhase - 0.3, 2));
-        }
-    }
-    // ST segment at 0.3-0.4
-    else if (beatPhase < 0.4) {
-        value = 0.0f;
-    }
-    // T wave (ventricular repolarization) at 0.4-0.7
-    else if (beatPhase < 0.7) {
-        double tPhase = (beatPhase - 0.4) / 0.3;
-        value = 0.3f * std::exp(-8.0 * std::pow(tPhase - 0.5, 2));
-    }
-    // Return to baseline
-    else {
-        value = 0.0f;
-    }
+    // P/QRS/T morphology is rendered once into a shared table
+    const double value = BeatTemplates::mockEcg().at(beatPhase);
     
     // Scale to typical ECG voltage range and add baseline offset
-    return 0.5f + value * 0.4f;
+    return static_cast<float>(0.5 + value * 0.4);
 }
 
 // Helper function: Generate pulsatile waveform for SpO2/Pleth
@@ -475,28 +605,13 @@ float generatePlethWaveform(double time) {
     
     double beatPhase = std::fmod(time, beatInterval) / beatInterval;
     
-    float value = 0.0f;
-    
-    if (beatPhase < 0.3) {
-        // Rapid systolic upstroke
-        double upstrokePhase = beatPhase / 0.3;
-        value = std::pow(upstrokePhase, 2.0);
-    }
-    else if (beatPhase < 0.5) {
-        // Dicrotic notch
-        double notchPhase = (beatPhase - 0.3) / 0.2;
-        value = 1.0f - 0.15f * std::sin(notchPhase * M_PI);
-    }
-    else {
-        // Diastolic decay
-        double decayPhase = (beatPhase - 0.5) / 0.5;
-        value = (1.0f - 0.15f) * std::exp(-3.0 * decayPhase);
-    }
+    // Upstroke, dicrotic notch and decay (shared with SignalGenerator)
+    double value = BeatTemplates::pleth().at(beatPhase);
     
     // Add small baseline noise for realism
-    value += 0.02f * std::sin(2.0 * M_PI * 15.0 * time);
+    value += 0.02 * std::sin(2.0 * M_PI * 15.0 * time);
     
-    return value;
+    return static_cast<float>(value);
 }
 
 // Helper function: Generate realistic respiratory waveform
@@ -528,8 +643,8 @@ float generateRespiratoryWaveform(double time) {
 
 float I2CDriver::generateMockValue(SensorId sensorId)
 {
-    static double time = 0.0;
-    time += MOCK_TIME_INCREMENT;
+    // Every channel is sampled at the same clock time, however often it is read
+    const double time = clock_->now();
 
     switch (sensorId)
     {
@@ -562,6 +677,49 @@ float I2CDriver::generateMockValue(SensorId sensorId)
 }
 
 
+float I2CDriver::generateMockWaveform(SensorId channel, double time)
+{
+    switch (channel)
+    {
+    case SensorId::ECG:
+        return generateECGWaveform(time);
+    case SensorId::SPO2:
+        return generatePlethWaveform(time);
+    case SensorId::RESPIRATORY:
+        return generateRespiratoryWaveform(time);
+    default:
+        return 0.0f;
+    }
+}
+
+void I2CDriver::startMockFifo(double now)
+{
+    mockFifoStart_ = now;
+    std::fill(std::begin(mockFifoTaken_), std::end(mockFifoTaken_), 0);
+    mockFifoStarted_ = true;
+}
+
+uint64_t I2CDriver::mockFifoDue(size_t channel, double now) const
+{
+    // Sample k is taken at start + k / hz; the nudge keeps exact multiples due
+    if (now < mockFifoStart_)
+    {
+        return 0;
+    }
+    return static_cast<uint64_t>((now - mockFifoStart_) * FIFO_CHANNELS[channel].hz + 1e-6) + 1;
+}
+
+size_t I2CDriver::mockFifoLevel(double now) const
+{
+    size_t level = 0;
+    for (size_t c = 0; c < std::size(FIFO_CHANNELS); ++c)
+    {
+        const uint64_t due = mockFifoDue(c, now);
+        level += due > mockFifoTaken_[c] ? static_cast<size_t>(due - mockFifoTaken_[c]) : 0;
+    }
+    return level;
+}
+
 uint8_t I2CDriver::generateMockStatusByte()
 {
     // In mock mode, all sensors are present
@@ -0,0 +1,301 @@
+#include "hardware/i2c_executor.h"
+
+#include <utility>
+
+namespace {
+    // A callback that fulfils a promise, for the future-returning overloads
+    template <typename T>
+    std::pair<std::function<void(const T&)>, std::future<T>> promised()
+    {
+        auto promise = std::make_shared<std::promise<T>>();
+        std::future<T> future = promise->get_future();
+        return {[promise](const T& value) { promise->set_value(value); }, std::move(future)};
+    }
+}
+
+I2CExecutor::I2CExecutor(std::unique_ptr<I2CDriver> driver)
+    : driver_(std::move(driver))
+{
+    thread_ = std::thread(&I2CExecutor::run, this);
+}
+
+I2CExecutor::~I2CExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+// ============================================================================
+// Commands
+// ============================================================================
+
+void I2CExecutor::ping(PingCallback done, Priority priority)
+{
+    Job job;
+    job.kind = Kind::Ping;
+    job.onPing = std::move(done);
+    submit(std::move(job), priority);
+}
+
+std::future<bool> I2CExecutor::ping(Priority priority)
+{
+    auto [done, result] = promised<bool>();
+    ping(PingCallback(std::move(done)), priority);
+    return std::move(result);
+}
+
+void I2CExecutor::scan(ScanCallback done, Priority priority)
+{
+    Job job;
+    job.kind = Kind::Scan;
+    job.onScan = std::move(done);
+    submit(std::move(job), priority);
+}
+
+std::future<uint8_t> I2CExecutor::scan(Priority priority)
+{
+    auto [done, result] = promised<uint8_t>();
+    scan(ScanCallback(std::move(done)), priority);
+    return std::move(result);
+}
+
+void I2CExecutor::read(SensorId sensor, ReadCallback done, Priority priority)
+{
+    Job job;
+    job.kind = Kind::Read;
+    job.sensor = sensor;
+    job.onRead = std::move(done);
+    submit(std::move(job), priority);
+}
+
+std::future<I2CExecutor::Reading> I2CExecutor::read(SensorId sensor, Priority priority)
+{
+    auto [done, result] = promised<Reading>();
+    read(sensor, ReadCallback(std::move(done)), priority);
+    return std::move(result);
+}
+
+void I2CExecutor::readAll(FrameCallback done, Priority priority)
+{
+    Job job;
+    job.kind = Kind::Read;
+    job.bulk = true;
+    job.onFrame = std::move(done);
+    submit(std::move(job), priority);
+}
+
+std::future<I2CExecutor::Frame> I2CExecutor::readAll(Priority priority)
+{
+    auto [done, result] = promised<Frame>();
+    readAll(FrameCallback(std::move(done)), priority);
+    return std::move(result);
+}
+
+std::future<I2CExecutor::Fifo> I2CExecutor::readFifo(size_t maxSamples, Priority priority)
+{
+    return call([this, maxSamples](I2CDriver& driver) {
+        ++transactions_;
+        Fifo fifo;
+        fifo.ok = driver.readFifo(fifo.batch, maxSamples);
+        return fifo;
+    }, priority);
+}
+
+std::future<I2CExecutor::FifoLevel> I2CExecutor::fifoLevel(Priority priority)
+{
+    return call([this](I2CDriver& driver) {
+        ++transactions_;
+        FifoLevel level;
+        level.ok = driver.fifoLevel(level.status);
+        return level;
+    }, priority);
+}
+
+size_t I2CExecutor::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& queue : queues_)
+    {
+        count += queue.size();
+    }
+    return count;
+}
+
+uint64_t I2CExecutor::transactions() const
+{
+    return transactions_.load(std::memory_order_relaxed);
+}
+
+uint64_t I2CExecutor::batched() const
+{
+    return batched_.load(std::memory_order_relaxed);
+}
+
+void I2CExecutor::submit(Job job, Priority priority)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queues_[static_cast<size_t>(priority)].push_back(std::move(job));
+    }
+    wake_.notify_one();
+}
+
+// ============================================================================
+// Executor thread
+// ============================================================================
+
+void I2CExecutor::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        size_t priority = 0;
+        while (priority < PRIORITIES && queues_[priority].empty())
+        {
+            ++priority;
+        }
+        if (priority == PRIORITIES)
+        {
+            if (stopping_)
+            {
+                return;
+            }
+            wake_.wait(lock);
+            continue;
+        }
+
+        std::deque<Job> batch;
+        batch.push_back(std::move(queues_[priority].front()));
+        queues_[priority].pop_front();
+        const Kind kind = batch.front().kind;
+        if (kind != Kind::Call)
+        {
+            take_(kind, batch);
+        }
+        lock.unlock();
+
+        switch (kind)
+        {
+        case Kind::Ping:
+            runPings_(batch);
+            break;
+        case Kind::Scan:
+            runScans_(batch);
+            break;
+        case Kind::Read:
+            runReads_(batch);
+            break;
+        case Kind::Call:
+            batch.front().call(*driver_);
+            break;
+        }
+        lock.lock();
+    }
+}
+
+void I2CExecutor::take_(Kind kind, std::deque<Job>& batch)
+{
+    // Caller holds mutex_; highest priority first, so callbacks keep that order
+    for (auto& queue : queues_)
+    {
+        for (auto it = queue.begin(); it != queue.end();)
+        {
+            if (it->kind == kind)
+            {
+                batch.push_back(std::move(*it));
+                it = queue.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+}
+
+void I2CExecutor::runPings_(std::deque<Job>& batch)
+{
+    ++transactions_;
+    batched_ += batch.size() - 1;
+    const bool answered = driver_->pingHub();
+    for (const Job& job : batch)
+    {
+        job.onPing(answered);
+    }
+}
+
+void I2CExecutor::runScans_(std::deque<Job>& batch)
+{
+    ++transactions_;
+    batched_ += batch.size() - 1;
+    const uint8_t status = driver_->scanSensors();
+    for (const Job& job : batch)
+    {
+        job.onScan(status);
+    }
+}
+
+void I2CExecutor::runReads_(std::deque<Job>& batch)
+{
+    // Sensors asked for, and whether anyone wants the whole frame
+    bool bulk = false;
+    uint8_t wanted = 0;
+    size_t distinct = 0;
+    for (const Job& job : batch)
+    {
+        const uint8_t bit = static_cast<uint8_t>(1 << static_cast<size_t>(job.sensor));
+        if (job.bulk)
+        {
+            bulk = true;
+        }
+        else if (!(wanted & bit))
+        {
+            wanted |= bit;
+            ++distinct;
+        }
+    }
+
+    // One READ_ALL answers everyone, unless a single sensor is all that is asked
+    Frame frame;
+    size_t transactions = 0;
+    if (bulk || distinct > 1)
+    {
+        ++transactions;
+        frame.ok = driver_->readAll(frame.frame);
+    }
+
+    Reading readings[READ_ALL_SENSOR_COUNT];
+    uint8_t done = 0;
+    for (const Job& job : batch)
+    {
+        if (job.bulk)
+        {
+            job.onFrame(frame);
+            continue;
+        }
+        const size_t id = static_cast<size_t>(job.sensor);
+        const uint8_t bit = static_cast<uint8_t>(1 << id);
+        if (!(done & bit))
+        {
+            done |= bit;
+            if (frame.ok)
+            {
+                readings[id] = {frame.frame.has(job.sensor), frame.frame.value(job.sensor)};
+            }
+            else
+            {
+                ++transactions; // No frame: this sensor on its own
+                readings[id].ok = driver_->readSensor(job.sensor, readings[id].value);
+            }
+        }
+        job.onRead(readings[id]);
+    }
+
+    transactions_ += transactions;
+    batched_ += batch.size() > transactions ? batch.size() - transactions : 0;
+}
@@ -1,23 +1,81 @@
 #include "hardware/sensor_manager.h"
 #include <nlohmann/json.hpp>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <bitset>
+#include <cmath>
+#include <cstring>
+
+#ifdef __linux__
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
 
 namespace {
     constexpr int I2C_BUS_NUMBER = 1;
     constexpr int HUB_PROCESS_DELAY_MS = 50;
+
+    // Reads per poll before giving the caller back control (hub refilling as fast as we drain)
+    constexpr size_t MAX_FIFO_READS_PER_POLL = HUB_FIFO_CAPACITY / READ_FIFO_MAX_SAMPLES + 1;
+
+    // Weight of the latest poll in the FIFO sample-rate estimate
+    constexpr double FIFO_RATE_SMOOTHING = 0.25;
+
+    // Longest the acquisition thread sleeps before checking for stop
+    constexpr std::chrono::milliseconds ACQUISITION_MAX_SLEEP(100);
+
+    // Store field for a sensor's READ_SENSOR value (TaskCount order = SensorType order)
+    // Vitals tasks come first, in SensorType order
+    constexpr size_t VITALS_TASKS = static_cast<size_t>(SensorManager::AcquisitionTask::Waveforms);
+
+    constexpr SensorDataStore::Field SENSOR_FIELDS[] = {
+        SensorDataStore::Field::Ecg,        SensorDataStore::Field::Spo2,
+        SensorDataStore::Field::TempCavity, SensorDataStore::Field::TempSkin,
+        SensorDataStore::Field::BpSystolic, SensorDataStore::Field::Resp,
+    };
+
+    constexpr const char* TASK_NAMES[] = {"ecg",  "spo2", "temp_core", "temp_skin", "nibp",
+                                          "resp", "waveforms", "hot_plug_scan"};
+
+    // Sleep until an absolute steady_clock time (CLOCK_MONOTONIC on Linux)
+    void sleepUntil(std::chrono::steady_clock::time_point deadline)
+    {
+#ifdef __linux__
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+        const timespec ts{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+        {
+        }
+#else
+        std::this_thread::sleep_until(deadline);
+#endif
+    }
 }
 
 SensorManager::SensorManager(bool mockMode)
     : mockMode_(mockMode)
 {
-    i2c_ = std::make_unique<I2CDriver>(I2C_BUS_NUMBER, mockMode);
+    hub_ = std::make_unique<I2CExecutor>(std::make_unique<I2CDriver>(I2C_BUS_NUMBER, mockMode));
+    initializeSensorMap();
+}
+
+SensorManager::SensorManager(std::unique_ptr<I2CDriver> driver)
+    : hub_(std::make_unique<I2CExecutor>(std::move(driver))), mockMode_(false)
+{
     initializeSensorMap();
 }
 
 SensorManager::~SensorManager()
 {
+    stopAcquisition();
+}
+
+void SensorManager::setClock(std::shared_ptr<SimClock> clock)
+{
+    hub_->call([clock = std::move(clock)](I2CDriver &driver) mutable { driver.setClock(std::move(clock)); }).wait();
 }
 
 void SensorManager::initializeSensorMap()
@@ -28,11 +86,17 @@ void SensorManager::initializeSensorMap()
     sensors_[SensorType::TempSkin] = {false, 0.0f, SensorId::TEMP_SKIN, "Skin Temp"};
     sensors_[SensorType::NIBP] = {false, 0.0f, SensorId::NIBP, "NIBP"};
     sensors_[SensorType::Respiratory] = {true, 0.0f, SensorId::RESPIRATORY, "Respiratory"}; // Always available (derived)
+
+    // Vitals are read directly; waveforms arrive through the hub FIFO
+    setAcquisitionRate(SensorType::SpO2, 1.0);
+    setAcquisitionRate(SensorType::TempCore, 1.0);
+    setAcquisitionRate(SensorType::TempSkin, 1.0);
+    setAcquisitionRate(SensorType::NIBP, 1.0);
 }
 
 bool SensorManager::initialize()
 {
-    if (!i2c_->open())
+    if (!hub_->call([](I2CDriver &driver) { return driver.open(); }).get())
     {
         std::cerr << "[SensorMgr] Failed to open I²C bus" << std::endl;
         if (!mockMode_)
@@ -48,7 +112,8 @@ bool SensorManager::initialize()
     std::cout << "[SensorMgr] Scanning for SensorHub..." << std::endl;
     std::cout.flush();
 
-    bool hubDetected = i2c_->deviceExists(HUB_I2C_ADDRESS);
+    bool hubDetected = hub_->call([](I2CDriver &driver) { return driver.deviceExists(HUB_I2C_ADDRESS); }).get();
+    hubDetected_ = hubDetected;
 
     if (hubDetected)
     {
@@ -56,6 +121,9 @@ bool SensorManager::initialize()
                   << std::hex << (int)HUB_I2C_ADDRESS << std::dec << std::endl;
         std::cout.flush();
 
+        // Replace fixed command delays with what this hub actually needs
+        hub_->call([](I2CDriver &driver) { return driver.measureTurnaround(); }).wait();
+
         // Scan for individual sensors using hub protocol
         int count = scanSensors();
         std::cout << "[SensorMgr] Found " << count << " sensor(s)" << std::endl;
@@ -81,7 +149,7 @@ int SensorManager::scanSensors()
     std::cout << "[SensorMgr] Requesting sensor scan from hub..." << std::endl;
     std::cout.flush();
 
-    uint8_t statusByte = i2c_->scanSensors();
+    uint8_t statusByte = hub_->scan(I2CExecutor::Priority::Scan).get();
 
     if (statusByte == 0xFF)
     {
@@ -91,8 +159,10 @@ int SensorManager::scanSensors()
         std::cerr << "  2. I2C bus is not busy or hung" << std::endl;
         std::cerr << "  3. Hub firmware is responding" << std::endl;
         std::cerr.flush();
+        hubDetected_ = false;
         return 0;
     }
+    hubDetected_ = true;
 
     std::cout << "[SensorMgr] Status byte: 0b" << std::bitset<8>(statusByte) << std::endl;
     std::cout.flush();
@@ -112,6 +182,8 @@ int SensorManager::scanSensors()
     sensors_[SensorType::TempSkin].attached = skinTempDetected;
     sensors_[SensorType::NIBP].attached = nibpDetected;
     sensors_[SensorType::Respiratory].attached = false; // Derived signal, not a physical sensor
+    attachedBits_.store(static_cast<uint8_t>(statusByte & (ECG | SPO2 | TEMP_CORE | TEMP_SKIN | NIBP)),
+                        std::memory_order_relaxed);
 
     // Count and report detected sensors
     int count = 0;
@@ -181,16 +253,23 @@ bool SensorManager::isSensorAttached(SensorType type) const
     return false;
 }
 
-bool SensorManager::readSensor(SensorType type, float &/* value */)
+bool SensorManager::readSensor(SensorType type, float &value)
 {
     auto it = sensors_.find(type);
-    if (it == sensors_.end())
+    if (it == sensors_.end() || !it->second.attached)
     {
         return false;
     }
 
     SensorInfo &info = it->second;
-    return info.attached;
+    const I2CExecutor::Reading reading = hub_->read(info.sensorId, I2CExecutor::Priority::Reading).get();
+    if (!reading.ok)
+    {
+        return false;
+    }
+    value = reading.value;
+    info.lastValue = value;
+    return true;
 }
 
 const SensorInfo &SensorManager::getSensorInfo(SensorType type) const
@@ -217,6 +296,13 @@ std::string SensorManager::getSensorStatusJson() const
     return j.dump();
 }
 
+uint8_t SensorManager::getSensorStatusBits() const
+{
+    // Mirrors getSensorStatusJson() in SensorStatusBits layout
+    using namespace SensorStatusBits;
+    return ECG | SPO2 | TEMP_CORE | TEMP_SKIN | NIBP | RESPIRATORY;
+}
+
 SensorId SensorManager::sensorTypeToId(SensorType type) const
 {
     switch (type)
@@ -237,3 +323,377 @@ SensorId SensorManager::sensorTypeToId(SensorType type) const
         return SensorId::ECG;
     }
 }
+
+bool SensorManager::sensorIdToType(SensorId id, SensorType &type) const
+{
+    for (const auto &[sensorType, info] : sensors_)
+    {
+        if (info.sensorId == id)
+        {
+            type = sensorType;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Waveform FIFO
+// ============================================================================
+
+uint64_t SensorManager::unwrapHubTime(uint32_t timestampUs)
+{
+    if (!hubClockStarted_)
+    {
+        hubClockStarted_ = true;
+        hubClockUs_ = timestampUs;
+        return hubClockUs_;
+    }
+    // Samples arrive in time order, so the step from the previous one is small;
+    // modular arithmetic carries it across the 32-bit wrap
+    const uint32_t step = timestampUs - static_cast<uint32_t>(hubClockUs_);
+    hubClockUs_ += static_cast<int32_t>(step);
+    return hubClockUs_;
+}
+
+int SensorManager::pollFifo()
+{
+    const I2CExecutor::FifoLevel fifo = hub_->fifoLevel(I2CExecutor::Priority::Waveform).get();
+    if (!fifo.ok)
+    {
+        return -1;
+    }
+    const I2CDriver::FifoStatus &status = fifo.status;
+    ++fifoStats_.polls;
+    fifoStats_.hubDropped += status.dropped;
+
+    size_t received = 0;
+    size_t level = status.level;
+    for (size_t reads = 0; level > 0 && reads < MAX_FIFO_READS_PER_POLL; ++reads)
+    {
+        const I2CExecutor::Fifo fifo =
+            hub_->readFifo(std::min(level, READ_FIFO_MAX_SAMPLES), I2CExecutor::Priority::Waveform).get();
+        if (!fifo.ok)
+        {
+            break;
+        }
+        const I2CDriver::FifoBatch &batch = fifo.batch;
+        ++fifoStats_.reads;
+
+        std::lock_guard<std::mutex> lock(waveformsMutex_);
+        for (size_t i = 0; i < batch.count; ++i)
+        {
+            const I2CDriver::FifoSample &sample = batch.samples[i];
+            const uint64_t timestampUs = unwrapHubTime(sample.timestampUs);
+            SensorType type;
+            if (!sensorIdToType(sample.channel, type))
+            {
+                continue;
+            }
+            if (!isSensorAttached(type))
+            {
+                ++fifoStats_.unattached; // Nothing sampled it: don't play it
+                continue;
+            }
+            std::deque<WaveformSample> &buffer = waveforms_[type];
+            if (buffer.size() >= WAVEFORM_BUFFER_SAMPLES)
+            {
+                buffer.pop_front();
+                ++fifoStats_.bufferDropped;
+            }
+            buffer.push_back({timestampUs, sample.value});
+        }
+        received += batch.count;
+        level = batch.level;
+        if (batch.count == 0)
+        {
+            break;
+        }
+    }
+    fifoStats_.samples += received;
+
+    // Aim for one full READ_FIFO per poll at the (smoothed) rate the hub samples at
+    if (received > 0)
+    {
+        if (lastPollUs_ != 0 && hubClockUs_ > lastPollUs_)
+        {
+            const double rate = static_cast<double>(received) / static_cast<double>(hubClockUs_ - lastPollUs_);
+            fifoRate_ = fifoRate_ > 0.0 ? fifoRate_ + FIFO_RATE_SMOOTHING * (rate - fifoRate_) : rate;
+            const auto ideal = std::chrono::microseconds(static_cast<int64_t>(READ_FIFO_MAX_SAMPLES / fifoRate_));
+            fifoPollInterval_ = std::clamp(ideal, fifoPollMin_, fifoPollMax_);
+        }
+        lastPollUs_ = hubClockUs_;
+    }
+    if (level > 0)
+    {
+        fifoPollInterval_ = fifoPollMin_; // Falling behind
+    }
+    return static_cast<int>(received);
+}
+
+size_t SensorManager::takeSamples(SensorType type, std::vector<WaveformSample> &out)
+{
+    std::lock_guard<std::mutex> lock(waveformsMutex_);
+    auto it = waveforms_.find(type);
+    if (it == waveforms_.end())
+    {
+        return 0;
+    }
+    const size_t count = it->second.size();
+    out.insert(out.end(), it->second.begin(), it->second.end());
+    it->second.clear();
+    return count;
+}
+
+void SensorManager::setFifoPollBounds(std::chrono::microseconds fastest, std::chrono::microseconds slowest)
+{
+    fifoPollMin_ = fastest;
+    fifoPollMax_ = std::max(fastest, slowest);
+    fifoPollInterval_ = std::clamp(fifoPollInterval_, fifoPollMin_, fifoPollMax_);
+}
+
+// ============================================================================
+// Acquisition
+// ============================================================================
+
+void SensorManager::setAcquisitionRate(SensorType type, double hz)
+{
+    const size_t task = static_cast<size_t>(type);
+    if (task < std::size(SENSOR_FIELDS))
+    {
+        tasks_[task].rateHz.store(std::max(0.0, hz), std::memory_order_relaxed);
+    }
+}
+
+double SensorManager::acquisitionRate(SensorType type) const
+{
+    const size_t task = static_cast<size_t>(type);
+    return task < std::size(SENSOR_FIELDS) ? tasks_[task].rateHz.load(std::memory_order_relaxed) : 0.0;
+}
+
+bool SensorManager::startAcquisition(SensorDataStore *store, const AcquisitionConfig &config)
+{
+    if (acquiring_.exchange(true))
+    {
+        return false;
+    }
+    if (acquisitionThread_.joinable())
+    {
+        acquisitionThread_.join();
+    }
+    acquisitionThread_ = std::thread(&SensorManager::acquisitionLoop, this, store, config);
+    return true;
+}
+
+void SensorManager::stopAcquisition()
+{
+    acquiring_.store(false, std::memory_order_release);
+    if (acquisitionThread_.joinable())
+    {
+        acquisitionThread_.join();
+    }
+    realtime_ = false;
+}
+
+SensorManager::AcquisitionStats SensorManager::acquisitionStats(AcquisitionTask task) const
+{
+    AcquisitionStats stats;
+    const size_t i = static_cast<size_t>(task);
+    if (i >= ACQUISITION_TASKS)
+    {
+        return stats;
+    }
+    stats.runs = tasks_[i].runs.load(std::memory_order_relaxed);
+    stats.overruns = tasks_[i].overruns.load(std::memory_order_relaxed);
+    stats.failures = tasks_[i].failures.load(std::memory_order_relaxed);
+    stats.jitter = tasks_[i].jitter.summary();
+    return stats;
+}
+
+const char *SensorManager::acquisitionTaskName(AcquisitionTask task)
+{
+    const size_t i = static_cast<size_t>(task);
+    return i < std::size(TASK_NAMES) ? TASK_NAMES[i] : "unknown";
+}
+
+void SensorManager::applyRealtime(const AcquisitionConfig &config)
+{
+#ifdef __linux__
+    if (config.cpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(config.cpu, &cpus);
+        const int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (err != 0)
+        {
+            std::cerr << "[SensorMgr] Could not pin acquisition to CPU " << config.cpu << ": " << strerror(err) << std::endl;
+        }
+    }
+    if (config.realtimePriority > 0)
+    {
+        sched_param param{};
+        param.sched_priority = std::clamp(config.realtimePriority, sched_get_priority_min(SCHED_FIFO),
+                                          sched_get_priority_max(SCHED_FIFO));
+        const int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0)
+        {
+            std::cerr << "[SensorMgr] SCHED_FIFO refused (" << strerror(err)
+                      << "), acquiring with normal scheduling. Hint: needs CAP_SYS_NICE" << std::endl;
+        }
+        realtime_ = err == 0;
+    }
+#else
+    if (config.cpu >= 0 || config.realtimePriority > 0)
+    {
+        std::cerr << "[SensorMgr] Realtime acquisition only supported on Linux" << std::endl;
+    }
+#endif
+}
+
+std::chrono::nanoseconds SensorManager::taskPeriod(size_t task, const AcquisitionConfig &config) const
+{
+    // Zero: not due at all (off, not attached, or no hub)
+    using std::chrono::nanoseconds;
+    if (task == static_cast<size_t>(AcquisitionTask::HotPlugScan))
+    {
+        return config.scanInterval;
+    }
+    if (!hubDetected_)
+    {
+        return nanoseconds(0);
+    }
+    if (task == static_cast<size_t>(AcquisitionTask::Waveforms))
+    {
+        return fifoPollInterval_;
+    }
+    const double hz = tasks_[task].rateHz.load(std::memory_order_relaxed);
+    if (hz <= 0.0 || !sensors_.at(static_cast<SensorType>(task)).attached)
+    {
+        return nanoseconds(0);
+    }
+    return nanoseconds(static_cast<int64_t>(1e9 / hz));
+}
+
+bool SensorManager::runTask(size_t task)
+{
+    if (task == static_cast<size_t>(AcquisitionTask::HotPlugScan))
+    {
+        scanSensors();
+        return hubDetected_;
+    }
+    // Samples stay buffered with their timestamps for takeSamples()
+    return pollFifo() >= 0;
+}
+
+void SensorManager::readVitals(size_t due, AcquisitionClock::time_point woke, SensorDataStore *store,
+                               const AcquisitionConfig &config)
+{
+    // One READ_ALL answers every vitals task due by now, not only the one that woke us
+    const I2CExecutor::Frame frame = hub_->readAll(I2CExecutor::Priority::Reading).get();
+    SensorDataStore::Update update;
+    for (size_t task = 0; task < VITALS_TASKS; ++task)
+    {
+        if (task != due && (taskPeriod(task, config).count() <= 0 || tasks_[task].deadline > woke))
+        {
+            continue;
+        }
+        SensorInfo &info = sensors_.at(static_cast<SensorType>(task));
+        const float value = frame.frame.value(info.sensorId);
+        const bool ok = frame.ok && frame.frame.has(info.sensorId) && std::isfinite(value);
+        if (ok)
+        {
+            info.lastValue = value;
+            update.set(SENSOR_FIELDS[task], value);
+        }
+        completeTask(task, ok, woke, config);
+    }
+    if (store && !update.empty())
+    {
+        store->apply(update); // Seqlock publish: readers never wait on it
+    }
+}
+
+void SensorManager::completeTask(size_t task, bool ok, AcquisitionClock::time_point woke,
+                                 const AcquisitionConfig &config)
+{
+    ScheduledTask &scheduled = tasks_[task];
+    scheduled.jitter.record(woke - scheduled.deadline);
+    if (!ok)
+    {
+        scheduled.failures.fetch_add(1, std::memory_order_relaxed);
+    }
+    scheduled.runs.fetch_add(1, std::memory_order_relaxed);
+
+    // The next deadline follows from this one, not from when the run ended.
+    // Deadlines already passed are skipped rather than run back to back.
+    const std::chrono::nanoseconds period = taskPeriod(task, config);
+    if (period.count() <= 0)
+    {
+        return;
+    }
+    scheduled.deadline += period;
+    const auto done = AcquisitionClock::now();
+    if (scheduled.deadline <= done)
+    {
+        const int64_t missed = (done - scheduled.deadline) / period + 1;
+        scheduled.overruns.fetch_add(static_cast<uint64_t>(missed), std::memory_order_relaxed);
+        scheduled.deadline += period * missed;
+    }
+}
+
+void SensorManager::acquisitionLoop(SensorDataStore *store, AcquisitionConfig config)
+{
+    applyRealtime(config);
+
+    const auto start = AcquisitionClock::now();
+    for (ScheduledTask &task : tasks_)
+    {
+        task.deadline = start;
+    }
+    // Scan first: sensor tasks and FIFO channels follow attachment
+    const size_t scan = static_cast<size_t>(AcquisitionTask::HotPlugScan);
+    completeTask(scan, runTask(scan), start, config);
+
+    while (acquiring_.load(std::memory_order_acquire))
+    {
+        // Earliest deadline first; tasks that are off restart from now when they come back
+        const auto now = AcquisitionClock::now();
+        size_t next = ACQUISITION_TASKS;
+        for (size_t i = 0; i < ACQUISITION_TASKS; ++i)
+        {
+            if (taskPeriod(i, config).count() <= 0)
+            {
+                tasks_[i].deadline = now;
+                continue;
+            }
+            if (next == ACQUISITION_TASKS || tasks_[i].deadline < tasks_[next].deadline)
+            {
+                next = i;
+            }
+        }
+
+        const auto wake = now + ACQUISITION_MAX_SLEEP;
+        if (next == ACQUISITION_TASKS || tasks_[next].deadline > wake)
+        {
+            sleepUntil(wake);
+            continue;
+        }
+        ScheduledTask &task = tasks_[next];
+        sleepUntil(task.deadline);
+        if (!acquiring_.load(std::memory_order_acquire))
+        {
+            break;
+        }
+
+        const auto woke = AcquisitionClock::now();
+        if (next < VITALS_TASKS)
+        {
+            readVitals(next, woke, store, config);
+        }
+        else
+        {
+            completeTask(next, runTask(next), woke, config);
+        }
+    }
+}
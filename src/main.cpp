@@ -1,9 +1,15 @@
+#include <algorithm>
 #include <iostream>
 #include <csignal>
 #include <unistd.h>
 #include <atomic>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include "server/webserver.h"
 #include "core/MQTTDriver.h"
+#include "core/mqtt_log.h"
 #include "core/SensorDataStore.h"
 
 namespace
@@ -30,13 +36,68 @@ int main(int argc, char *argv[])
     std::cout << std::endl;
 
     int port = DEFAULT_PORT;
+    int streamPort = 0; // 0 = HTTP port + 1
     std::string webRoot = DEFAULT_WEB_ROOT;
     bool mockSensors = false;
+    StreamServer::BackpressureConfig backpressure;
+    int waveformRate = -1; // -1 = server default
+    std::string clockMode = "real";
+    double clockSpeed = 1.0;
+    std::vector<std::pair<std::string, MqttPayload::Format>> payloadFormats;
+    std::string recordPath;
+    std::string replayPath;
+    double replaySpeed = 1.0;
+    bool replayToBroker = false;
+    int acquisitionPriority = 0;
+    int acquisitionCpu = -1;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--port" && i + 1 < argc) {
             port = std::atoi(argv[++i]);
+        } else if (arg == "--stream-port" && i + 1 < argc) {
+            streamPort = std::atoi(argv[++i]);
+        } else if (arg == "--slow-client" && i + 1 < argc) {
+            if (!StreamServer::policyFromName(argv[++i], backpressure.policy)) {
+                std::cerr << "Unknown slow-client policy: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--max-lag-ms" && i + 1 < argc) {
+            backpressure.maxLag = std::chrono::milliseconds(std::atoi(argv[++i]));
+        } else if (arg == "--client-queue" && i + 1 < argc) {
+            backpressure.maxQueuedFrames = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--waveform-hz" && i + 1 < argc) {
+            waveformRate = std::atoi(argv[++i]);
+        } else if (arg == "--clock" && i + 1 < argc) {
+            clockMode = argv[++i];
+            if (clockMode != "real" && clockMode != "fast" && clockMode != "step") {
+                std::cerr << "Unknown clock mode: " << clockMode << std::endl;
+                return 1;
+            }
+        } else if (arg == "--speed" && i + 1 < argc) {
+            clockSpeed = std::atof(argv[++i]);
+        } else if (arg == "--mqtt-format" && i + 1 < argc) {
+            const std::string spec = argv[++i];
+            const size_t eq = spec.find('=');
+            MqttPayload::Format format;
+            if (eq == std::string::npos ||
+                !MqttPayload::formatFromName(std::string_view(spec).substr(eq + 1), format)) {
+                std::cerr << "Bad --mqtt-format (want TOPIC=text|float32|msgpack|cbor): " << spec << std::endl;
+                return 1;
+            }
+            payloadFormats.emplace_back(spec.substr(0, eq), format);
+        } else if (arg == "--mqtt-record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--mqtt-replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--replay-speed" && i + 1 < argc) {
+            replaySpeed = std::atof(argv[++i]);
+        } else if (arg == "--replay-broker") {
+            replayToBroker = true;
+        } else if (arg == "--acq-priority" && i + 1 < argc) {
+            acquisitionPriority = std::atoi(argv[++i]);
+        } else if (arg == "--acq-cpu" && i + 1 < argc) {
+            acquisitionCpu = std::atoi(argv[++i]);
         } else if (arg == "--web-root" && i + 1 < argc) {
             webRoot = argv[++i];
         } else if (arg == "--mock") {
@@ -46,6 +107,34 @@ int main(int argc, char *argv[])
             std::cout << std::endl;
             std::cout << "Options:" << std::endl;
             std::cout << "  --port PORT         HTTP server port (default: 8080)" << std::endl;
+            std::cout << "  --stream-port PORT  WebSocket stream port (default: HTTP port + 1)"
+                      << std::endl;
+            std::cout << "  --slow-client MODE  drop | coalesce | disconnect (default: drop)"
+                      << std::endl;
+            std::cout << "  --max-lag-ms MS     Lag before 'disconnect' drops a client (default: 2000)"
+                      << std::endl;
+            std::cout << "  --client-queue N    Frames queued per stream client (default: 64)"
+                      << std::endl;
+            std::cout << "  --waveform-hz HZ    Native waveform sample rate, 0 = one per frame (default: 250)"
+                      << std::endl;
+            std::cout << "  --clock MODE        real | fast | step simulation clock (default: real)"
+                      << std::endl;
+            std::cout << "  --speed X           Simulated seconds per real second for fast/step (default: 1)"
+                      << std::endl;
+            std::cout << "  --mqtt-format T=F   Payload format of MQTT topic T: text | float32 | msgpack | cbor"
+                      << std::endl;
+            std::cout << "  --mqtt-record FILE  Record every MQTT message received to FILE"
+                      << std::endl;
+            std::cout << "  --mqtt-replay FILE  Replay a recorded MQTT log into the pipeline"
+                      << std::endl;
+            std::cout << "  --replay-speed X    Replay at X times the recorded rate, 0 = max (default: 1)"
+                      << std::endl;
+            std::cout << "  --replay-broker     Replay by publishing to the broker instead of in-process"
+                      << std::endl;
+            std::cout << "  --acq-priority N    Run sensor acquisition under SCHED_FIFO at priority N (1-99)"
+                      << std::endl;
+            std::cout << "  --acq-cpu N         Pin sensor acquisition to CPU N"
+                      << std::endl;
             std::cout << "  --web-root DIR      Web assets directory (default: ./web)"
                       << std::endl;
             std::cout << "  --mock              Enable mock sensor mode (no hardware needed)"
@@ -68,9 +157,8 @@ int main(int argc, char *argv[])
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
 
-    WebServer server(port, webRoot, mockSensors);
-    server.start();
-
+    // Everything that can still fail is checked before the servers listen
+    BedStore beds; // Ward beds from bed/<id>/... topics, outlives the server
     auto &store = SensorDataStore::instance();
 
     MQTTDriver mqtt(store);
@@ -78,9 +166,78 @@ int main(int argc, char *argv[])
 
     mqtt.setBroker("127.0.0.1", 1883); // change to broker IP if not local
     mqtt.setClientId("curecraft");     // unique client id
+    mqtt.setBedStore(&beds);           // bed/<id>/... topics for the ward
+    for (const auto &[topic, format] : payloadFormats) {
+        if (!mqtt.setPayloadFormat(topic, format)) {
+            std::cerr << "Unknown MQTT topic for --mqtt-format: " << topic << std::endl;
+            return 1;
+        }
+    }
+
+    MqttRecorder recorder;
+    if (!recordPath.empty()) {
+        if (!recorder.open(recordPath)) {
+            return 1;
+        }
+        mqtt.setRecorder(&recorder);
+    }
+    MqttReplay replay;
+    if (!replayPath.empty() && !replay.load(replayPath)) {
+        return 1;
+    }
+
+    WebServer server(port, webRoot, mockSensors);
+    server.setBedStore(&beds);
+    if (streamPort > 0) {
+        server.setStreamPort(streamPort);
+    }
+    server.setBackpressure(backpressure);
+    server.setAcquisitionScheduling(acquisitionPriority, acquisitionCpu);
+    if (waveformRate >= 0) {
+        server.setWaveformRate(waveformRate);
+    }
+    if (clockMode == "fast") {
+        server.setClock(SimClock::scaled(clockSpeed));
+    } else if (clockMode == "step") {
+        // One fixed step per frame: deterministic, and 'speed' times real time
+        server.setClock(SimClock::fixedStep(clockSpeed / server.getUpdateRate()));
+    }
+
+    // Waveforms follow the scenario: rates and baselines from the patient topics,
+    // once per batch. Beds are picked up from the store by the streamer.
+    mqtt.setBatchCallback([&](const MQTTDriver::BatchInfo &batch) {
+        if (batch.patient) {
+            server.setPhysiology(mqtt.physiology());
+        }
+        server.markIngested(batch.received);
+    });
+    server.setMqttDriver(&mqtt); // GET /api/metrics/mqtt
+    server.start();
 
     if (!mqtt.connect()) {
-        std::cerr << "MQTT connect failed\n";
+        std::cerr << "MQTT connect failed (retrying in the background)\n";
+    }
+    mqtt.startLoop(); // Network loop on its own thread; reconnects by itself
+
+    // Replay a recorded ward: through handleMessage_ in batches, or through the broker
+    std::thread replayThread;
+    if (replay.size() > 0) {
+        replayThread = std::thread([&] {
+            MqttReplay::Sink sink = [&](const MQTTDriver::Message *messages, size_t count) {
+                mqtt.ingestBatch(messages, count);
+            };
+            if (replayToBroker) {
+                sink = [&](const MQTTDriver::Message *messages, size_t count) {
+                    for (size_t i = 0; i < count; ++i) {
+                        mqtt.publish(messages[i].topic, messages[i].payload, messages[i].payloadlen);
+                    }
+                };
+            }
+            const MqttReplay::Result result = replay.replay(sink, replaySpeed, &shutdownRequested);
+            std::cout << "[Replay] " << result.messages << " messages in " << result.seconds << " s ("
+                      << result.messagesPerSecond << " msgs/s, max lag " << result.maxLagMs << " ms)"
+                      << std::endl;
+        });
     }
 
     std::cout << std::endl;
@@ -90,9 +247,14 @@ int main(int argc, char *argv[])
     std::cout << std::endl;
 
     while (!shutdownRequested) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        mqtt.loop(10);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if (replayThread.joinable()) {
+        replayThread.join();
     }
+    mqtt.stopLoop();
+    mqtt.setRecorder(nullptr);
+    recorder.close();
 
     std::cout << "Stopping server..." << std::endl;
     server.stop();
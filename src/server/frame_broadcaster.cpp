@@ -0,0 +1,78 @@
+#include "server/frame_broadcaster.h"
+
+#include <utility>
+
+FrameBroadcaster::Subscription::Subscription(FrameBroadcaster& hub) : hub_(hub)
+{
+    hub_.subscribers_.fetch_add(1, std::memory_order_relaxed);
+}
+
+FrameBroadcaster::Subscription::~Subscription()
+{
+    hub_.subscribers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+uint64_t FrameBroadcaster::publish(std::string payload)
+{
+    // Allocate outside the lock; sinks only ever see the finished buffer
+    Frame frame = std::make_shared<const std::string>(std::move(payload));
+
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        frame_.swap(frame);
+        seq = ++seq_;
+    }
+    cv_.notify_all();
+
+    // The previous frame (now in `frame`) is released here, outside the lock
+    return seq;
+}
+
+FrameBroadcaster::Frame FrameBroadcaster::waitForNext(uint64_t& lastSeq,
+                                                      std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (!cv_.wait_for(lock, timeout, [&] { return closed_ || seq_ > lastSeq; }))
+    {
+        return nullptr;
+    }
+    if (closed_)
+    {
+        return nullptr;
+    }
+
+    lastSeq = seq_;
+    return frame_;
+}
+
+FrameBroadcaster::Frame FrameBroadcaster::latest(uint64_t* seq) const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (seq)
+    {
+        *seq = seq_;
+    }
+    return frame_;
+}
+
+uint64_t FrameBroadcaster::sequence() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return seq_;
+}
+
+void FrameBroadcaster::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        closed_ = true;
+    }
+    cv_.notify_all();
+}
+
+void FrameBroadcaster::reopen()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    closed_ = false;
+}
@@ -0,0 +1,341 @@
+#include "server/frame_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    constexpr char BASE64_ALPHABET[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    void putU32(uint8_t* p, uint32_t v)
+    {
+        p[0] = static_cast<uint8_t>(v);
+        p[1] = static_cast<uint8_t>(v >> 8);
+        p[2] = static_cast<uint8_t>(v >> 16);
+        p[3] = static_cast<uint8_t>(v >> 24);
+    }
+
+    uint32_t getU32(const uint8_t* p)
+    {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    void putF32(uint8_t* p, double v)
+    {
+        const float f = static_cast<float>(v);
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        putU32(p, bits);
+    }
+
+    double getF32(const uint8_t* p)
+    {
+        const uint32_t bits = getU32(p);
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    uint32_t timestampMs(double timestamp)
+    {
+        const double ms = timestamp > 0.0 ? std::round(timestamp * 1000.0) : 0.0;
+        return static_cast<uint32_t>(static_cast<uint64_t>(ms));
+    }
+
+    // Channel values in SensorDataStore::Field order
+    double* channelSlots(SignalGenerator::SensorData& d, size_t i)
+    {
+        double* slots[] = {&d.ecg, &d.spo2, &d.resp, &d.pleth,
+                           &d.bp_systolic, &d.bp_diastolic, &d.temp_cavity, &d.temp_skin};
+        return slots[i];
+    }
+
+    void appendU16(std::vector<uint8_t>& out, uint16_t v)
+    {
+        out.push_back(static_cast<uint8_t>(v));
+        out.push_back(static_cast<uint8_t>(v >> 8));
+    }
+
+    void appendU32(std::vector<uint8_t>& out, uint32_t v)
+    {
+        uint8_t bytes[4];
+        putU32(bytes, v);
+        out.insert(out.end(), bytes, bytes + 4);
+    }
+
+    void appendF32(std::vector<uint8_t>& out, double v)
+    {
+        uint8_t bytes[4];
+        putF32(bytes, v);
+        out.insert(out.end(), bytes, bytes + 4);
+    }
+}
+
+namespace FrameCodec
+{
+
+double channelValue(const SignalGenerator::SensorData& d, size_t channel)
+{
+    const double values[] = {d.ecg, d.spo2, d.resp, d.pleth,
+                             d.bp_systolic, d.bp_diastolic, d.temp_cavity, d.temp_skin};
+    return channel < 8 ? values[channel] : 0.0;
+}
+
+size_t blockSlice(const SampleBlock& block, uint32_t step, size_t& first)
+{
+    step = step > 0 ? step : 1;
+    const uint64_t kept = ((block.firstIndex + step - 1) / step) * step;
+    if (block.count == 0 || kept >= block.firstIndex + block.count)
+    {
+        first = 0;
+        return 0;
+    }
+    first = static_cast<size_t>(kept - block.firstIndex);
+    return (block.count - first - 1) / step + 1;
+}
+
+void encodeBinary(const SignalGenerator::SensorData& data, uint8_t sensors, uint32_t seq,
+                  uint8_t* out)
+{
+    out[0] = BINARY_FRAME_VERSION;
+    out[1] = sensors;
+    putU32(out + 2, seq);
+    putU32(out + 6, timestampMs(data.timestamp));
+    putF32(out + 10, data.ecg);
+    putF32(out + 14, data.spo2);
+    putF32(out + 18, data.resp);
+    putF32(out + 22, data.pleth);
+    putF32(out + 26, data.bp_systolic);
+    putF32(out + 30, data.bp_diastolic);
+    putF32(out + 34, data.temp_cavity);
+    putF32(out + 38, data.temp_skin);
+}
+
+size_t encodeBinaryChannels(const SignalGenerator::SensorData& data, uint8_t sensors, uint32_t seq,
+                            uint16_t channels, uint8_t* out)
+{
+    channels &= ALL_CHANNELS;
+
+    out[0] = BINARY_CHANNELS_FRAME_VERSION;
+    out[1] = sensors;
+    putU32(out + 2, seq);
+    putU32(out + 6, timestampMs(data.timestamp));
+    out[10] = static_cast<uint8_t>(channels);
+    out[11] = static_cast<uint8_t>(channels >> 8);
+
+    size_t n = BINARY_CHANNELS_HEADER_SIZE;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        if (channels & (1u << i))
+        {
+            putF32(out + n, channelValue(data, i));
+            n += 4;
+        }
+    }
+    return n;
+}
+
+void encodeBinaryBlock(const SignalGenerator::SensorData& latest, uint8_t sensors, uint32_t seq,
+                       uint16_t channels, const SampleBlock& block, uint16_t blockChannels,
+                       const uint32_t* steps, std::vector<uint8_t>& out)
+{
+    channels &= ALL_CHANNELS;
+    blockChannels &= channels & WAVEFORM_CHANNELS;
+    const uint32_t ms = timestampMs(latest.timestamp);
+
+    out.resize(BINARY_BLOCK_HEADER_SIZE);
+    out[0] = BINARY_BLOCK_FRAME_VERSION;
+    out[1] = sensors;
+    putU32(&out[2], seq);
+    putU32(&out[6], ms);
+    out[10] = static_cast<uint8_t>(channels);
+    out[11] = static_cast<uint8_t>(channels >> 8);
+    out[12] = static_cast<uint8_t>(blockChannels);
+    out[13] = static_cast<uint8_t>(blockChannels >> 8);
+
+    const double rate = block.rateHz > 0 ? block.rateHz : 1.0;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        if (!(channels & (1u << i)))
+        {
+            continue;
+        }
+        if (!(blockChannels & (1u << i)))
+        {
+            appendF32(out, channelValue(latest, i));
+            continue;
+        }
+
+        const uint32_t step = steps[i] > 0 ? steps[i] : 1;
+        size_t first = 0;
+        const size_t count = std::min<size_t>(blockSlice(block, step, first), 0xFFFF);
+        const double t0 = (block.firstIndex + first) / rate;
+        appendU32(out, static_cast<uint32_t>(static_cast<int32_t>(std::lround((t0 - ms / 1000.0) * 1e6))));
+        appendU32(out, static_cast<uint32_t>(std::lround(step * 1e6 / rate)));
+        appendU16(out, static_cast<uint16_t>(count));
+        for (size_t n = 0; n < count; ++n)
+        {
+            appendF32(out, channelValue(block.samples[first + n * step], i));
+        }
+    }
+}
+
+bool decodeBinary(const uint8_t* in, size_t len, BinaryFrame& out)
+{
+    if (in && len >= BINARY_BLOCK_HEADER_SIZE && in[0] == BINARY_BLOCK_FRAME_VERSION)
+    {
+        const uint16_t channels = static_cast<uint16_t>(in[10] | (in[11] << 8));
+        const uint16_t blockChannels = static_cast<uint16_t>(in[12] | (in[13] << 8));
+        if ((channels & ~ALL_CHANNELS) || (blockChannels & ~channels))
+        {
+            return false;
+        }
+
+        out.version = in[0];
+        out.sensors = in[1];
+        out.seq = getU32(in + 2);
+        out.channels = channels;
+        out.blockChannels = blockChannels;
+        out.data = SignalGenerator::SensorData{};
+        out.data.timestamp = getU32(in + 6) / 1000.0;
+
+        size_t n = BINARY_BLOCK_HEADER_SIZE;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            out.runs[i] = BinaryFrame::Run{};
+            if (!(channels & (1u << i)))
+            {
+                continue;
+            }
+            if (!(blockChannels & (1u << i)))
+            {
+                if (len < n + 4)
+                {
+                    return false;
+                }
+                *channelSlots(out.data, i) = getF32(in + n);
+                n += 4;
+                continue;
+            }
+
+            if (len < n + BINARY_BLOCK_RUN_HEADER_SIZE)
+            {
+                return false;
+            }
+            BinaryFrame::Run& run = out.runs[i];
+            run.t0 = out.data.timestamp + static_cast<int32_t>(getU32(in + n)) / 1e6;
+            run.dt = getU32(in + n + 4) / 1e6;
+            const size_t count = static_cast<size_t>(in[n + 8] | (in[n + 9] << 8));
+            n += BINARY_BLOCK_RUN_HEADER_SIZE;
+            if (len < n + count * 4)
+            {
+                return false;
+            }
+            run.values.resize(count);
+            for (size_t k = 0; k < count; ++k)
+            {
+                run.values[k] = getF32(in + n + k * 4);
+            }
+            n += count * 4;
+            if (count > 0)
+            {
+                *channelSlots(out.data, i) = run.values.back();
+            }
+        }
+        return true;
+    }
+
+    if (in && len >= BINARY_CHANNELS_HEADER_SIZE && in[0] == BINARY_CHANNELS_FRAME_VERSION)
+    {
+        const uint16_t channels = static_cast<uint16_t>(in[10] | (in[11] << 8));
+        size_t n = BINARY_CHANNELS_HEADER_SIZE;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            n += (channels & (1u << i)) ? 4 : 0;
+        }
+        if ((channels & ~ALL_CHANNELS) || len < n)
+        {
+            return false;
+        }
+
+        out.version = in[0];
+        out.sensors = in[1];
+        out.seq = getU32(in + 2);
+        out.channels = channels;
+        out.blockChannels = 0;
+        out.data = SignalGenerator::SensorData{};
+        out.data.timestamp = getU32(in + 6) / 1000.0;
+        n = BINARY_CHANNELS_HEADER_SIZE;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            if (channels & (1u << i))
+            {
+                *channelSlots(out.data, i) = getF32(in + n);
+                n += 4;
+            }
+        }
+        return true;
+    }
+
+    if (!in || len < BINARY_FRAME_SIZE || in[0] != BINARY_FRAME_VERSION)
+    {
+        return false;
+    }
+
+    out.version = in[0];
+    out.channels = ALL_CHANNELS;
+    out.blockChannels = 0;
+    out.sensors = in[1];
+    out.seq = getU32(in + 2);
+    out.data.timestamp = getU32(in + 6) / 1000.0;
+    out.data.ecg = getF32(in + 10);
+    out.data.spo2 = getF32(in + 14);
+    out.data.resp = getF32(in + 18);
+    out.data.pleth = getF32(in + 22);
+    out.data.bp_systolic = getF32(in + 26);
+    out.data.bp_diastolic = getF32(in + 30);
+    out.data.temp_cavity = getF32(in + 34);
+    out.data.temp_skin = getF32(in + 38);
+    return true;
+}
+
+size_t encodeBinarySse(const SignalGenerator::SensorData& data, uint8_t sensors, uint32_t seq,
+                       char* out)
+{
+    uint8_t raw[BINARY_FRAME_SIZE];
+    encodeBinary(data, sensors, seq, raw);
+
+    std::memcpy(out, "data: ", 6);
+    size_t n = 6 + base64Encode(raw, sizeof(raw), out + 6);
+    out[n++] = '\n';
+    out[n++] = '\n';
+    return n;
+}
+
+size_t base64Encode(const uint8_t* in, size_t len, char* out)
+{
+    size_t o = 0;
+    size_t i = 0;
+    for (; i + 2 < len; i += 3)
+    {
+        const uint32_t v = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+        out[o++] = BASE64_ALPHABET[(v >> 18) & 0x3F];
+        out[o++] = BASE64_ALPHABET[(v >> 12) & 0x3F];
+        out[o++] = BASE64_ALPHABET[(v >> 6) & 0x3F];
+        out[o++] = BASE64_ALPHABET[v & 0x3F];
+    }
+
+    if (i < len)
+    {
+        const uint32_t v = (in[i] << 16) | (i + 1 < len ? in[i + 1] << 8 : 0);
+        out[o++] = BASE64_ALPHABET[(v >> 18) & 0x3F];
+        out[o++] = BASE64_ALPHABET[(v >> 12) & 0x3F];
+        out[o++] = (i + 1 < len) ? BASE64_ALPHABET[(v >> 6) & 0x3F] : '=';
+        out[o++] = '=';
+    }
+    return o;
+}
+
+} // namespace FrameCodec
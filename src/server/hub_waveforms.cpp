@@ -0,0 +1,127 @@
+#include "server/hub_waveforms.h"
+
+#include <cmath>
+
+namespace {
+    using Field = SensorDataStore::Field;
+    using SensorData = SignalGenerator::SensorData;
+
+    constexpr uint16_t bit(Field field)
+    {
+        return static_cast<uint16_t>(1u << static_cast<unsigned>(field));
+    }
+}
+
+HubWaveforms::HubWaveforms()
+    : channels_{{{SensorType::ECG, &SensorData::ecg, bit(Field::Ecg), SensorStatusBits::ECG},
+                 {SensorType::SpO2, &SensorData::pleth, bit(Field::Pleth), SensorStatusBits::SPO2},
+                 {SensorType::Respiratory, &SensorData::resp, bit(Field::Resp), SensorStatusBits::RESPIRATORY}}}
+{
+}
+
+uint16_t HubWaveforms::apply(SensorManager& sensors, SensorData* samples, size_t n)
+{
+    take_(sensors);
+
+    const uint8_t attached = sensors.attachedSensorBits();
+    uint16_t written = 0;
+    for (Channel& channel : channels_)
+    {
+        if (!(attached & channel.sensorBit))
+        {
+            reset_(channel); // Keep the synthesized waveform
+            continue;
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            double value = 0.0;
+            if (play_(channel, samples[i].timestamp, value))
+            {
+                samples[i].*channel.value = value;
+                written |= channel.bit;
+            }
+        }
+    }
+    return written;
+}
+
+void HubWaveforms::discard(SensorManager& sensors)
+{
+    take_(sensors);
+    for (Channel& channel : channels_)
+    {
+        reset_(channel);
+    }
+}
+
+void HubWaveforms::reset_(Channel& channel)
+{
+    channel.pending.clear();
+    channel.anchored = false;
+    channel.playing = false;
+}
+
+void HubWaveforms::take_(SensorManager& sensors)
+{
+    for (Channel& channel : channels_)
+    {
+        taken_.clear();
+        if (sensors.takeSamples(channel.type, taken_) > 0)
+        {
+            channel.pending.insert(channel.pending.end(), taken_.begin(), taken_.end());
+        }
+    }
+}
+
+bool HubWaveforms::play_(Channel& channel, double time, double& value)
+{
+    if (channel.anchored && time < channel.lastTime)
+    {
+        channel.anchored = false; // Stream time went backwards (clock reset)
+    }
+    channel.lastTime = time;
+
+    if (!channel.anchored)
+    {
+        if (channel.pending.empty())
+        {
+            return false;
+        }
+        channel.anchored = true;
+        channel.anchorTime = time;
+        channel.anchorHubUs = static_cast<int64_t>(channel.pending.back().timestampUs) - PLAYOUT_DELAY_US;
+        channel.playing = false;
+    }
+
+    int64_t hubUs = channel.anchorHubUs + std::llround((time - channel.anchorTime) * 1e6);
+    if (!channel.pending.empty())
+    {
+        const int64_t newest = static_cast<int64_t>(channel.pending.back().timestampUs);
+        if (newest - hubUs > MAX_BACKLOG_US)
+        {
+            // Too far behind the hub: skip ahead to the playout delay
+            channel.anchorHubUs += newest - PLAYOUT_DELAY_US - hubUs;
+            hubUs = newest - PLAYOUT_DELAY_US;
+        }
+    }
+
+    while (!channel.pending.empty() && static_cast<int64_t>(channel.pending.front().timestampUs) <= hubUs)
+    {
+        channel.current = channel.pending.front();
+        channel.pending.pop_front();
+        channel.playing = true;
+    }
+    if (!channel.playing)
+    {
+        return false; // Nothing due yet
+    }
+    if (hubUs - static_cast<int64_t>(channel.current.timestampUs) > MAX_HOLD_US)
+    {
+        // The hub stopped sending; anchor again when it resumes
+        channel.anchored = false;
+        channel.playing = false;
+        return false;
+    }
+    value = channel.current.value;
+    return true;
+}
@@ -0,0 +1,1126 @@
+#include "server/stream_server.h"
+#include "server/frame_codec.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+    constexpr size_t MAX_HANDSHAKE_SIZE = 8192;
+    constexpr size_t MAX_MESSAGE_SIZE = 64 * 1024;
+    constexpr size_t MAX_QUEUED_FRAMES = 1024; // Hard cap including protocol frames
+    constexpr size_t READ_CHUNK_SIZE = 4096;
+    constexpr size_t MAX_READS_PER_EVENT = 16;   // 64 KiB, then the other clients get a turn
+    constexpr size_t MAX_FRAME_HEADER_SIZE = 14; // 64-bit length and masking key
+    constexpr int LISTEN_BACKLOG = 1024;
+    constexpr int MAX_EVENTS = 256;
+    constexpr int HOUSEKEEPING_INTERVAL_MS = 1000;
+    constexpr auto HANDSHAKE_TIMEOUT = std::chrono::seconds(10);
+    constexpr auto PING_INTERVAL = std::chrono::seconds(15);
+    constexpr auto CLIENT_TIMEOUT = std::chrono::seconds(45);
+
+    constexpr char SSE_RESPONSE[] = "HTTP/1.1 200 OK\r\n"
+                                    "Content-Type: text/event-stream\r\n"
+                                    "Cache-Control: no-cache\r\n"
+                                    "Connection: keep-alive\r\n"
+                                    "Access-Control-Allow-Origin: *\r\n\r\n";
+    constexpr char SSE_KEEPALIVE[] = ": keepalive\n\n";
+
+    std::string httpError(int status, const char* reason, const std::string& extraHeaders = "")
+    {
+        return "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\n" + extraHeaders +
+               "Content-Length: 0\r\nConnection: close\r\n\r\n";
+    }
+
+    std::string sseEvent(StreamServer::Format format, const void* payload, size_t len)
+    {
+        std::string event;
+        if (format == StreamServer::Format::Binary)
+        {
+            event.resize(6 + ((len + 2) / 3) * 4 + 2);
+            std::memcpy(&event[0], "data: ", 6);
+            const size_t n = FrameCodec::base64Encode(static_cast<const uint8_t*>(payload), len, &event[6]);
+            event.resize(6 + n);
+        }
+        else
+        {
+            event.reserve(len + 8);
+            event.append("data: ").append(static_cast<const char*>(payload), len);
+        }
+        event.append("\n\n");
+        return event;
+    }
+}
+
+StreamServer::StreamServer() = default;
+
+StreamServer::~StreamServer()
+{
+    stop();
+}
+
+bool StreamServer::start(int port, const std::string& bindAddress)
+{
+    if (running_)
+    {
+        return true;
+    }
+
+    auto fail = [this](const char* what) {
+        std::cerr << "[StreamServer] " << what << ": " << std::strerror(errno) << std::endl;
+        for (int* fd : {&listenFd_, &epollFd_, &wakeFd_, &timerFd_})
+        {
+            if (*fd >= 0) close(*fd);
+            *fd = -1;
+        }
+        return false;
+    };
+
+    listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0)
+    {
+        return fail("socket() failed");
+    }
+
+    const int one = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, bindAddress.c_str(), &addr.sin_addr) != 1)
+    {
+        errno = EINVAL;
+        return fail("Invalid bind address");
+    }
+
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listenFd_, LISTEN_BACKLOG) != 0)
+    {
+        return fail("Cannot listen");
+    }
+
+    socklen_t addrLen = sizeof(addr);
+    getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &addrLen);
+    port_ = ntohs(addr.sin_port);
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0 || timerFd_ < 0)
+    {
+        return fail("Cannot create reactor descriptors");
+    }
+
+    for (int fd : {listenFd_, wakeFd_, timerFd_})
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) != 0)
+        {
+            return fail("epoll_ctl() failed");
+        }
+    }
+
+    armTimer(tickHz_.load());
+    ticks_ = 0;
+    missedTicks_ = 0;
+    lastLateUs_ = 0;
+    maxLateUs_ = 0;
+    maxHandlerUs_ = 0;
+
+    running_ = true;
+    thread_ = std::make_unique<std::thread>(&StreamServer::reactorThread, this);
+    return true;
+}
+
+void StreamServer::stop()
+{
+    if (!running_)
+    {
+        return;
+    }
+
+    running_ = false;
+    wake();
+    if (thread_ && thread_->joinable())
+    {
+        thread_->join();
+    }
+    thread_.reset();
+
+    for (int* fd : {&listenFd_, &epollFd_, &wakeFd_, &timerFd_})
+    {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+void StreamServer::setMessageHandler(MessageHandler handler)
+{
+    messageHandler_ = std::move(handler);
+}
+
+void StreamServer::setTickHandler(TickHandler handler)
+{
+    tickHandler_ = std::move(handler);
+}
+
+void StreamServer::setTickRate(int hz)
+{
+    // The reactor owns the timer; it re-arms when it sees the new rate
+    tickHz_ = hz > 0 ? hz : 0;
+    wake();
+}
+
+void StreamServer::setBackpressure(const BackpressureConfig& config)
+{
+    backpressure_ = config;
+    if (backpressure_.maxQueuedFrames == 0)
+    {
+        backpressure_.maxQueuedFrames = 1;
+    }
+}
+
+StreamServer::TickStats StreamServer::tickStats() const
+{
+    TickStats stats;
+    stats.ticks = ticks_.load(std::memory_order_relaxed);
+    stats.missed = missedTicks_.load(std::memory_order_relaxed);
+    stats.lastLateMs = lastLateUs_.load(std::memory_order_relaxed) / 1000.0;
+    stats.maxLateMs = maxLateUs_.load(std::memory_order_relaxed) / 1000.0;
+    stats.maxHandlerMs = maxHandlerUs_.load(std::memory_order_relaxed) / 1000.0;
+    return stats;
+}
+
+const char* StreamServer::policyName(SlowClientPolicy policy)
+{
+    switch (policy)
+    {
+    case SlowClientPolicy::DropOldest: return "drop";
+    case SlowClientPolicy::Coalesce:   return "coalesce";
+    case SlowClientPolicy::Disconnect: return "disconnect";
+    }
+    return "drop";
+}
+
+bool StreamServer::policyFromName(const std::string& name, SlowClientPolicy& out)
+{
+    for (auto policy : {SlowClientPolicy::DropOldest, SlowClientPolicy::Coalesce, SlowClientPolicy::Disconnect})
+    {
+        if (name == policyName(policy))
+        {
+            out = policy;
+            return true;
+        }
+    }
+    return false;
+}
+
+void StreamServer::armTimer(int hz)
+{
+    // Absolute deadlines on a fixed grid: tick k is due at anchor + k * period,
+    // however long earlier ticks took
+    armedHz_ = hz;
+    tickIndex_ = 0;
+
+    itimerspec spec{};
+    if (hz > 0)
+    {
+        tickPeriod_ = std::chrono::nanoseconds(1000000000L / hz);
+        tickAnchor_ = Clock::now();
+
+        const auto first = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            (tickAnchor_ + tickPeriod_).time_since_epoch()).count();
+        const auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(tickPeriod_).count();
+        spec.it_value.tv_sec = first / 1000000000L;
+        spec.it_value.tv_nsec = first % 1000000000L;
+        spec.it_interval.tv_sec = period / 1000000000L;
+        spec.it_interval.tv_nsec = period % 1000000000L;
+    }
+    // steady_clock is CLOCK_MONOTONIC on Linux, matching the timerfd clock
+    timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void StreamServer::onTimer(uint64_t expirations)
+{
+    tickIndex_ += expirations;
+    const auto late = Clock::now() - (tickAnchor_ + tickIndex_ * tickPeriod_);
+    const int64_t lateUs = std::max<int64_t>(
+        0, std::chrono::duration_cast<std::chrono::microseconds>(late).count());
+
+    ticks_.fetch_add(1, std::memory_order_relaxed);
+    missedTicks_.fetch_add(expirations - 1, std::memory_order_relaxed);
+    lastLateUs_.store(lateUs, std::memory_order_relaxed);
+    if (lateUs > maxLateUs_.load(std::memory_order_relaxed))
+    {
+        maxLateUs_.store(lateUs, std::memory_order_relaxed);
+    }
+}
+
+void StreamServer::broadcast(Format format, const void* payload, size_t len)
+{
+    const int f = static_cast<int>(format);
+    const bool toWs = openClients_[static_cast<int>(Transport::WebSocket)][f].load(std::memory_order_relaxed) > 0;
+    const bool toSse = openClients_[static_cast<int>(Transport::Sse)][f].load(std::memory_order_relaxed) > 0;
+    if (toWs || toSse)
+    {
+        deliver(format, 0, payload, len, toWs, toSse);
+    }
+}
+
+void StreamServer::broadcast(uint32_t groupId, const void* payload, size_t len)
+{
+    Format format = Format::Json;
+    bool toWs = false;
+    bool toSse = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Group& group : groups_)
+        {
+            if (group.id == groupId)
+            {
+                format = group.format;
+                toWs = group.clients[static_cast<int>(Transport::WebSocket)] > 0;
+                toSse = group.clients[static_cast<int>(Transport::Sse)] > 0;
+                break;
+            }
+        }
+    }
+    if (toWs || toSse)
+    {
+        deliver(format, groupId, payload, len, toWs, toSse);
+    }
+}
+
+std::vector<StreamServer::SubscriptionGroup> StreamServer::subscriptionGroups() const
+{
+    std::vector<SubscriptionGroup> out;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.reserve(groups_.size());
+    for (const Group& group : groups_)
+    {
+        SubscriptionGroup info;
+        info.id = group.id;
+        info.format = group.format;
+        info.subscription = group.subscription;
+        info.clients = group.clients[0] + group.clients[1];
+        out.push_back(info);
+    }
+    return out;
+}
+
+bool StreamServer::setSubscription(uint64_t clientId, const StreamSubscription& subscription)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : connections_)
+    {
+        Connection& conn = entry.second;
+        if (conn.id == clientId && conn.state == State::Open && !conn.dead)
+        {
+            leaveGroup(conn);
+            conn.subscription = subscription;
+            joinGroup(conn);
+            return true;
+        }
+    }
+    return false;
+}
+
+void StreamServer::deliver(Format format, uint32_t groupId, const void* payload, size_t len, bool toWs, bool toSse)
+{
+    // Wrap once per transport; every client of that transport shares the buffer
+    WireFrame wsFrame, sseFrame;
+    if (toWs)
+    {
+        const auto opcode = (format == Format::Binary) ? WebSocket::Opcode::Binary : WebSocket::Opcode::Text;
+        wsFrame = std::make_shared<const std::string>(WebSocket::encodeFrame(opcode, payload, len));
+    }
+    if (toSse)
+    {
+        sseFrame = std::make_shared<const std::string>(sseEvent(format, payload, len));
+    }
+
+    bool reap = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = Clock::now();
+        for (auto& entry : connections_)
+        {
+            Connection& conn = entry.second;
+            if (conn.state != State::Open || conn.format != format || conn.dead ||
+                (groupId != 0 && conn.group != groupId))
+            {
+                continue;
+            }
+
+            const WireFrame& frame = (conn.transport == Transport::Sse) ? sseFrame : wsFrame;
+            if (!frame)
+            {
+                continue; // Opened after the counters were read; joins from the next frame
+            }
+            // A stalled socket only affects this client's queue, never the tick
+            if (conn.policy == SlowClientPolicy::Disconnect && lag(conn, now) > backpressure_.maxLag)
+            {
+                conn.dead = true;
+            }
+            else
+            {
+                enqueueData(conn, frame, now);
+            }
+
+            // Write through immediately when nothing was pending; otherwise EPOLLOUT is armed
+            if (conn.dead || (conn.outbound.size() == 1 && !flush(conn)))
+            {
+                conn.dead = true;
+                deadFds_.push_back(conn.fd);
+                reap = true;
+                continue;
+            }
+            updateInterest(conn);
+        }
+    }
+
+    if (reap)
+    {
+        wake();
+    }
+}
+
+bool StreamServer::send(uint64_t clientId, const std::string& text)
+{
+    auto frame = std::make_shared<const std::string>(
+        WebSocket::encodeFrame(WebSocket::Opcode::Text, text.data(), text.size()));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : connections_)
+    {
+        Connection& conn = entry.second;
+        if (conn.id == clientId && conn.state == State::Open && conn.transport == Transport::WebSocket &&
+            !conn.dead)
+        {
+            enqueue(conn, std::move(frame));
+            updateInterest(conn);
+            return true;
+        }
+    }
+    return false;
+}
+
+int StreamServer::clientCount() const
+{
+    return clientCount(Format::Json) + clientCount(Format::Binary);
+}
+
+int StreamServer::clientCount(Format format) const
+{
+    const int f = static_cast<int>(format);
+    return openClients_[0][f].load(std::memory_order_relaxed) + openClients_[1][f].load(std::memory_order_relaxed);
+}
+
+std::vector<StreamServer::ClientInfo> StreamServer::clients() const
+{
+    const auto now = Clock::now();
+    std::vector<ClientInfo> out;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.reserve(connections_.size());
+    for (const auto& entry : connections_)
+    {
+        const Connection& conn = entry.second;
+        if (conn.state != State::Open)
+        {
+            continue;
+        }
+
+        ClientInfo info;
+        info.id = conn.id;
+        info.remote = conn.remote;
+        info.transport = conn.transport;
+        info.format = conn.format;
+        info.connectedSeconds = std::chrono::duration<double>(now - conn.connectedAt).count();
+        info.framesSent = conn.framesSent;
+        info.bytesSent = conn.bytesSent;
+        info.queuedFrames = conn.outbound.size();
+        info.policy = conn.policy;
+        info.framesDropped = conn.framesDropped;
+        info.lagMs = std::chrono::duration<double, std::milli>(lag(conn, now)).count();
+        info.maxLagMs = std::chrono::duration<double, std::milli>(conn.maxLag).count();
+        info.subscription = conn.subscription.key();
+        out.push_back(std::move(info));
+    }
+    return out;
+}
+
+// ============================================================================
+// Reactor thread
+// ============================================================================
+
+void StreamServer::reactorThread()
+{
+    epoll_event events[MAX_EVENTS];
+    std::vector<PendingMessage> messages;
+    std::vector<int> toClose;
+    auto lastHousekeeping = Clock::now();
+
+    while (running_)
+    {
+        const int n = epoll_wait(epollFd_, events, MAX_EVENTS, HOUSEKEEPING_INTERVAL_MS);
+        if (n < 0 && errno != EINTR)
+        {
+            std::cerr << "[StreamServer] epoll_wait() failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        bool tick = false;
+        messages.clear();
+        toClose.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            for (int i = 0; i < n; ++i)
+            {
+                const int fd = events[i].data.fd;
+                const uint32_t ev = events[i].events;
+
+                if (fd == listenFd_)
+                {
+                    acceptClients();
+                    continue;
+                }
+                if (fd == wakeFd_ || fd == timerFd_)
+                {
+                    uint64_t count = 0;
+                    if (read(fd, &count, sizeof(count)) == sizeof(count) && fd == timerFd_ && count > 0)
+                    {
+                        onTimer(count);
+                        tick = true;
+                    }
+                    continue;
+                }
+
+                auto it = connections_.find(fd);
+                if (it == connections_.end() || it->second.dead)
+                {
+                    continue;
+                }
+                Connection& conn = it->second;
+
+                bool keep = true;
+                if (ev & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                {
+                    keep = readFrom(conn, messages);
+                }
+                // Replies queued by the read (handshake, pong, close) go out right away
+                if (keep && !conn.outbound.empty())
+                {
+                    keep = flush(conn);
+                }
+                if (keep && !conn.dead)
+                {
+                    updateInterest(conn);
+                }
+                else
+                {
+                    toClose.push_back(fd);
+                }
+            }
+
+            if (tickHz_.load() != armedHz_)
+            {
+                armTimer(tickHz_.load());
+            }
+
+            const auto now = Clock::now();
+            if (now - lastHousekeeping >= std::chrono::milliseconds(HOUSEKEEPING_INTERVAL_MS))
+            {
+                lastHousekeeping = now;
+                housekeeping(now);
+            }
+
+            for (int fd : toClose)
+            {
+                closeConnection(fd);
+            }
+            for (int fd : deadFds_)
+            {
+                closeConnection(fd);
+            }
+            deadFds_.clear();
+        }
+
+        // Handlers run outside the lock so they may call send() / broadcast()
+        if (messageHandler_)
+        {
+            for (const auto& msg : messages)
+            {
+                messageHandler_(msg.clientId, msg.text);
+            }
+        }
+        if (tick && tickHandler_)
+        {
+            const auto start = Clock::now();
+            tickHandler_();
+            const int64_t us =
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+            if (us > maxHandlerUs_.load(std::memory_order_relaxed))
+            {
+                maxHandlerUs_.store(us, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Best-effort close handshake on shutdown
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : connections_)
+    {
+        if (entry.second.state == State::Open && entry.second.transport == Transport::WebSocket)
+        {
+            beginClose(entry.second, WebSocket::CloseCode::GOING_AWAY, "Server shutting down");
+            flush(entry.second);
+        }
+    }
+    while (!connections_.empty())
+    {
+        closeConnection(connections_.begin()->first);
+    }
+    deadFds_.clear();
+}
+
+void StreamServer::wake()
+{
+    if (wakeFd_ >= 0)
+    {
+        const uint64_t one = 1;
+        (void)write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+void StreamServer::acceptClients()
+{
+    while (true)
+    {
+        sockaddr_in addr{};
+        socklen_t addrLen = sizeof(addr);
+        const int fd = accept4(listenFd_, reinterpret_cast<sockaddr*>(&addr), &addrLen,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                std::cerr << "[StreamServer] accept() failed: " << std::strerror(errno) << std::endl;
+            }
+            return;
+        }
+
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) != 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        char host[INET_ADDRSTRLEN] = "?";
+        inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+
+        Connection& conn = connections_[fd];
+        conn.fd = fd;
+        conn.id = nextClientId_++;
+        conn.events = EPOLLIN;
+        conn.remote = std::string(host) + ":" + std::to_string(ntohs(addr.sin_port));
+        conn.connectedAt = conn.lastReceived = conn.lastPing = Clock::now();
+    }
+}
+
+bool StreamServer::readFrom(Connection& conn, std::vector<PendingMessage>& messages)
+{
+    // Unparsed input is held to one request or one frame. Level-triggered epoll
+    // reports whatever is left after MAX_READS_PER_EVENT again.
+    const auto limit = [&conn] {
+        return conn.state == State::Handshake ? MAX_HANDSHAKE_SIZE : MAX_MESSAGE_SIZE + MAX_FRAME_HEADER_SIZE;
+    };
+    char buf[READ_CHUNK_SIZE];
+    for (size_t reads = 0; reads < MAX_READS_PER_EVENT; ++reads)
+    {
+        const ssize_t n = recv(conn.fd, buf, sizeof(buf), 0);
+        if (n > 0)
+        {
+            // SSE is one-way; anything after the request is ignored
+            if (conn.transport != Transport::Sse || conn.state == State::Handshake)
+            {
+                conn.inbound.append(buf, static_cast<size_t>(n));
+            }
+            if (conn.inbound.size() > limit())
+            {
+                // Parse what is complete; what is left over must fit
+                if (!parseInbound(conn, messages) || conn.inbound.size() > limit())
+                {
+                    return false;
+                }
+            }
+            continue;
+        }
+        if (n == 0)
+        {
+            return false; // Peer closed
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            break;
+        }
+        if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+
+    conn.lastReceived = Clock::now();
+    return parseInbound(conn, messages);
+}
+
+bool StreamServer::parseInbound(Connection& conn, std::vector<PendingMessage>& messages)
+{
+    if (conn.state == State::Handshake && !handleRequest(conn))
+    {
+        return false;
+    }
+    if (conn.state != State::Handshake && conn.transport == Transport::WebSocket)
+    {
+        return handleFrames(conn, messages);
+    }
+    return true;
+}
+
+bool StreamServer::handleRequest(Connection& conn)
+{
+    const size_t end = conn.inbound.find("\r\n\r\n");
+    if (end == std::string::npos)
+    {
+        return conn.inbound.size() <= MAX_HANDSHAKE_SIZE;
+    }
+
+    WebSocket::HttpRequest req;
+    std::string response;
+    if (!WebSocket::parseHttpRequest(conn.inbound.substr(0, end + 4), req))
+    {
+        response = httpError(400, "Bad Request");
+    }
+    else if (req.path != "/ws")
+    {
+        response = httpError(404, "Not Found");
+    }
+    else if (req.method != "GET")
+    {
+        response = httpError(405, "Method Not Allowed", "Allow: GET\r\n");
+    }
+    else if (!req.header("upgrade").empty() && !WebSocket::isUpgradeRequest(req))
+    {
+        response = httpError(426, "Upgrade Required", "Sec-WebSocket-Version: 13\r\n");
+    }
+    else if (!StreamSubscription::parse(req.query, conn.subscription))
+    {
+        response = httpError(400, "Bad Request"); // Unknown channel or invalid rate
+    }
+
+    if (!response.empty())
+    {
+        // Reply, then drop the connection once the response is written
+        conn.inbound.clear();
+        conn.state = State::Closing;
+        enqueue(conn, std::make_shared<const std::string>(std::move(response)));
+        return true;
+    }
+
+    conn.inbound.erase(0, end + 4);
+    conn.format = (req.param("format") == "binary") ? Format::Binary : Format::Json;
+    if (!policyFromName(req.param("policy"), conn.policy))
+    {
+        conn.policy = backpressure_.policy;
+    }
+
+    if (WebSocket::isUpgradeRequest(req))
+    {
+        conn.transport = Transport::WebSocket;
+        enqueue(conn, std::make_shared<const std::string>(WebSocket::handshakeResponse(req)));
+    }
+    else
+    {
+        conn.transport = Transport::Sse;
+        conn.inbound.clear();
+        enqueue(conn, std::make_shared<const std::string>(SSE_RESPONSE, sizeof(SSE_RESPONSE) - 1));
+    }
+    markOpen(conn);
+    return true;
+}
+
+bool StreamServer::handleFrames(Connection& conn, std::vector<PendingMessage>& messages)
+{
+    using WebSocket::Opcode;
+
+    size_t offset = 0;
+    bool keep = true;
+    while (keep && offset < conn.inbound.size())
+    {
+        WebSocket::Frame frame;
+        size_t consumed = 0;
+        const auto result = WebSocket::parseFrame(
+            reinterpret_cast<const uint8_t*>(conn.inbound.data()) + offset, conn.inbound.size() - offset,
+            frame, consumed, MAX_MESSAGE_SIZE);
+
+        if (result == WebSocket::ParseResult::NeedMore)
+        {
+            break;
+        }
+        if (result == WebSocket::ParseResult::Error || !frame.masked)
+        {
+            // Clients must mask every frame (RFC 6455 section 5.1)
+            beginClose(conn, WebSocket::CloseCode::PROTOCOL_ERROR, "Protocol error");
+            conn.inbound.clear();
+            return true;
+        }
+        offset += consumed;
+
+        switch (frame.opcode)
+        {
+        case Opcode::Ping:
+            if (conn.state == State::Open)
+            {
+                enqueue(conn, std::make_shared<const std::string>(
+                                  WebSocket::encodeFrame(Opcode::Pong, frame.payload.data(), frame.payload.size())));
+            }
+            break;
+
+        case Opcode::Pong:
+            break;
+
+        case Opcode::Close:
+            if (conn.state == State::Closing)
+            {
+                keep = false; // Reply to our close; done
+            }
+            else
+            {
+                uint16_t code = WebSocket::CloseCode::NORMAL;
+                if (frame.payload.size() >= 2)
+                {
+                    code = static_cast<uint16_t>((static_cast<uint8_t>(frame.payload[0]) << 8) |
+                                                 static_cast<uint8_t>(frame.payload[1]));
+                }
+                beginClose(conn, code, "");
+            }
+            break;
+
+        case Opcode::Text:
+        case Opcode::Binary:
+        case Opcode::Continuation:
+        {
+            if (conn.state != State::Open)
+            {
+                break;
+            }
+
+            const bool continuation = (frame.opcode == Opcode::Continuation);
+            if (continuation != conn.inMessage ||
+                conn.message.size() + frame.payload.size() > MAX_MESSAGE_SIZE)
+            {
+                beginClose(conn, continuation ? WebSocket::CloseCode::PROTOCOL_ERROR : WebSocket::CloseCode::TOO_BIG,
+                           "Bad message");
+                break;
+            }
+
+            if (!continuation)
+            {
+                conn.messageOpcode = frame.opcode;
+                conn.message.clear();
+            }
+            conn.message += frame.payload;
+            conn.inMessage = !frame.fin;
+
+            if (frame.fin && conn.messageOpcode == Opcode::Text)
+            {
+                messages.push_back({conn.id, std::move(conn.message)});
+                conn.message.clear();
+            }
+            break;
+        }
+        }
+    }
+
+    conn.inbound.erase(0, offset);
+    return keep;
+}
+
+bool StreamServer::flush(Connection& conn)
+{
+    while (!conn.outbound.empty())
+    {
+        const std::string& frame = *conn.outbound.front().bytes;
+        const ssize_t n = ::send(conn.fd, frame.data() + conn.outboundOffset,
+                                 frame.size() - conn.outboundOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            {
+                return true;
+            }
+            return false;
+        }
+
+        conn.outboundOffset += static_cast<size_t>(n);
+        conn.bytesSent += static_cast<uint64_t>(n);
+        if (conn.outboundOffset < frame.size())
+        {
+            return true; // Socket buffer full
+        }
+
+        const QueuedFrame& done = conn.outbound.front();
+        if (done.data)
+        {
+            --conn.queuedData;
+            conn.maxLag = std::max(conn.maxLag, Clock::now() - done.queuedAt);
+        }
+        conn.outbound.pop_front();
+        conn.outboundOffset = 0;
+        ++conn.framesSent;
+    }
+
+    // Closing connections are dropped once everything queued has been written
+    return conn.state != State::Closing;
+}
+
+void StreamServer::updateInterest(Connection& conn)
+{
+    const uint32_t wanted = conn.outbound.empty() ? EPOLLIN : (EPOLLIN | EPOLLOUT);
+    if (wanted != conn.events)
+    {
+        epoll_event ev{};
+        ev.events = wanted;
+        ev.data.fd = conn.fd;
+        epoll_ctl(epollFd_, EPOLL_CTL_MOD, conn.fd, &ev);
+        conn.events = wanted;
+    }
+}
+
+void StreamServer::enqueue(Connection& conn, WireFrame frame)
+{
+    if (conn.outbound.size() >= MAX_QUEUED_FRAMES)
+    {
+        conn.dead = true; // Not even protocol frames drain; dropped by the reactor
+        return;
+    }
+    conn.outbound.push_back({std::move(frame), Clock::now(), false});
+}
+
+void StreamServer::enqueueData(Connection& conn, const WireFrame& frame, Clock::time_point now)
+{
+    if (conn.policy == SlowClientPolicy::Coalesce)
+    {
+        // Latest snapshot wins: replace whatever has not started going out
+        while (dropPendingData(conn))
+        {
+        }
+    }
+    else if (conn.queuedData >= backpressure_.maxQueuedFrames)
+    {
+        dropPendingData(conn);
+    }
+
+    if (conn.outbound.size() >= MAX_QUEUED_FRAMES)
+    {
+        conn.dead = true;
+        return;
+    }
+    conn.outbound.push_back({frame, now, true});
+    ++conn.queuedData;
+}
+
+bool StreamServer::dropPendingData(Connection& conn)
+{
+    // The front frame may be partially written and must then be finished
+    auto it = conn.outbound.begin();
+    if (conn.outboundOffset > 0 && it != conn.outbound.end())
+    {
+        ++it;
+    }
+    for (; it != conn.outbound.end(); ++it)
+    {
+        if (it->data)
+        {
+            conn.outbound.erase(it);
+            --conn.queuedData;
+            ++conn.framesDropped;
+            return true;
+        }
+    }
+    return false;
+}
+
+StreamServer::Clock::duration StreamServer::lag(const Connection& conn, Clock::time_point now) const
+{
+    if (conn.queuedData == 0)
+    {
+        return Clock::duration::zero();
+    }
+    for (const QueuedFrame& frame : conn.outbound)
+    {
+        if (frame.data)
+        {
+            return now - frame.queuedAt;
+        }
+    }
+    return Clock::duration::zero();
+}
+
+std::atomic<int>& StreamServer::openCounter(const Connection& conn)
+{
+    return openClients_[static_cast<int>(conn.transport)][static_cast<int>(conn.format)];
+}
+
+void StreamServer::markOpen(Connection& conn)
+{
+    conn.state = State::Open;
+    openCounter(conn).fetch_add(1, std::memory_order_relaxed);
+    joinGroup(conn);
+}
+
+void StreamServer::markClosed(Connection& conn)
+{
+    openCounter(conn).fetch_sub(1, std::memory_order_relaxed);
+    leaveGroup(conn);
+}
+
+void StreamServer::joinGroup(Connection& conn)
+{
+    const std::string key = conn.subscription.key();
+    auto it = std::find_if(groups_.begin(), groups_.end(), [&](const Group& group) {
+        return group.format == conn.format && group.key == key;
+    });
+    if (it == groups_.end())
+    {
+        groups_.push_back({nextGroupId_++, conn.format, key, conn.subscription, {0, 0}});
+        it = groups_.end() - 1;
+    }
+    ++it->clients[static_cast<int>(conn.transport)];
+    conn.group = it->id;
+}
+
+void StreamServer::leaveGroup(Connection& conn)
+{
+    auto it = std::find_if(groups_.begin(), groups_.end(),
+                           [&](const Group& group) { return group.id == conn.group; });
+    if (it != groups_.end() && --it->clients[static_cast<int>(conn.transport)] <= 0 &&
+        it->clients[0] + it->clients[1] <= 0)
+    {
+        groups_.erase(it);
+    }
+    conn.group = 0;
+}
+
+void StreamServer::beginClose(Connection& conn, uint16_t code, const std::string& reason)
+{
+    if (conn.state == State::Open)
+    {
+        markClosed(conn);
+    }
+    if (conn.state != State::Closing)
+    {
+        conn.state = State::Closing;
+        enqueue(conn, std::make_shared<const std::string>(WebSocket::encodeClose(code, reason)));
+    }
+}
+
+void StreamServer::housekeeping(Clock::time_point now)
+{
+    static const WireFrame ping = std::make_shared<const std::string>(
+        WebSocket::encodeFrame(WebSocket::Opcode::Ping, nullptr, 0));
+    static const WireFrame keepalive =
+        std::make_shared<const std::string>(SSE_KEEPALIVE, sizeof(SSE_KEEPALIVE) - 1);
+
+    for (auto& entry : connections_)
+    {
+        Connection& conn = entry.second;
+        if (conn.dead)
+        {
+            deadFds_.push_back(conn.fd);
+        }
+        else if (conn.state == State::Handshake && now - conn.connectedAt > HANDSHAKE_TIMEOUT)
+        {
+            conn.state = State::Closing;
+            enqueue(conn, std::make_shared<const std::string>(httpError(408, "Request Timeout")));
+        }
+        else if (conn.state == State::Open && conn.policy == SlowClientPolicy::Disconnect &&
+                 lag(conn, now) > backpressure_.maxLag)
+        {
+            // Too far behind even without new broadcasts
+            conn.dead = true;
+            deadFds_.push_back(conn.fd);
+            continue;
+        }
+        else if (conn.state == State::Open && conn.transport == Transport::Sse)
+        {
+            // SSE clients never talk back; a comment line surfaces dead peers as write errors
+            if (now - conn.lastPing > PING_INTERVAL)
+            {
+                conn.lastPing = now;
+                enqueue(conn, keepalive);
+            }
+        }
+        else if (conn.state == State::Open)
+        {
+            if (now - conn.lastReceived > CLIENT_TIMEOUT)
+            {
+                beginClose(conn, WebSocket::CloseCode::GOING_AWAY, "Timeout");
+            }
+            else if (now - conn.lastReceived > PING_INTERVAL && now - conn.lastPing > PING_INTERVAL)
+            {
+                conn.lastPing = now;
+                enqueue(conn, ping);
+            }
+        }
+
+        if (!conn.dead && !conn.outbound.empty())
+        {
+            if (!flush(conn))
+            {
+                deadFds_.push_back(conn.fd);
+            }
+            else
+            {
+                updateInterest(conn);
+            }
+        }
+    }
+}
+
+void StreamServer::closeConnection(int fd)
+{
+    auto it = connections_.find(fd);
+    if (it == connections_.end())
+    {
+        return;
+    }
+
+    if (it->second.state == State::Open)
+    {
+        markClosed(it->second);
+    }
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(it);
+}
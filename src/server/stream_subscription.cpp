@@ -0,0 +1,248 @@
+#include "server/stream_subscription.h"
+#include "core/bed_store.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    using Field = SensorDataStore::Field;
+
+    constexpr char SENSORS_NAME[] = "sensors";
+    constexpr char WAVEFORM_RATE_PARAM[] = "waveform_hz";
+    constexpr char VITALS_RATE_PARAM[] = "vitals_hz";
+    constexpr char BED_PARAM[] = "bed";
+    constexpr double MAX_RATE_HZ = 10000.0;
+
+    bool parseRate(const std::string& text, double& out)
+    {
+        if (text.empty())
+        {
+            return false;
+        }
+        char* end = nullptr;
+        const double v = std::strtod(text.c_str(), &end);
+        if (end != text.c_str() + text.size() || !std::isfinite(v) || v <= 0.0 || v > MAX_RATE_HZ)
+        {
+            return false;
+        }
+        out = v;
+        return true;
+    }
+
+    bool fail(std::string* error, const std::string& reason)
+    {
+        if (error)
+        {
+            *error = reason;
+        }
+        return false;
+    }
+}
+
+bool StreamSubscription::parse(const std::map<std::string, std::string>& params, StreamSubscription& out,
+                               std::string* error)
+{
+    StreamSubscription sub;
+
+    auto it = params.find("channels");
+    if (it != params.end())
+    {
+        uint16_t mask = 0;
+        bool sensors = false;
+        size_t pos = 0;
+        const std::string& list = it->second;
+        while (pos <= list.size())
+        {
+            size_t comma = list.find(',', pos);
+            if (comma == std::string::npos)
+            {
+                comma = list.size();
+            }
+            const std::string name = list.substr(pos, comma - pos);
+            pos = comma + 1;
+
+            Field field;
+            if (name.empty())
+            {
+                continue;
+            }
+            if (name == SENSORS_NAME)
+            {
+                sensors = true;
+            }
+            else if (SensorDataStore::fieldFromName(name, field) && field != Field::Timestamp)
+            {
+                mask |= static_cast<uint16_t>(1u << static_cast<unsigned>(field));
+            }
+            else
+            {
+                return fail(error, "Unknown channel: " + name);
+            }
+        }
+        if (mask == 0 && !sensors)
+        {
+            return fail(error, "Empty channel list");
+        }
+        sub.setChannels(mask, sensors);
+    }
+
+    // Group rates first so that per-channel rates override them
+    for (const bool waveform : {true, false})
+    {
+        const char* group = waveform ? WAVEFORM_RATE_PARAM : VITALS_RATE_PARAM;
+        it = params.find(group);
+        if (it == params.end())
+        {
+            continue;
+        }
+        double hz = 0.0;
+        if (!parseRate(it->second, hz))
+        {
+            return fail(error, std::string("Invalid rate: ") + group);
+        }
+        for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+        {
+            if (isWaveform(static_cast<Field>(i)) == waveform)
+            {
+                sub.setRate(static_cast<Field>(i), hz);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+    {
+        const std::string param = std::string(SensorDataStore::fieldName(static_cast<Field>(i))) + "_hz";
+        it = params.find(param);
+        if (it == params.end())
+        {
+            continue;
+        }
+        double hz = 0.0;
+        if (!parseRate(it->second, hz))
+        {
+            return fail(error, "Invalid rate: " + param);
+        }
+        sub.setRate(static_cast<Field>(i), hz);
+    }
+
+    it = params.find(BED_PARAM);
+    if (it != params.end())
+    {
+        if (!BedStore::validId(it->second))
+        {
+            return fail(error, "Invalid bed: " + it->second);
+        }
+        sub.setBed(it->second);
+    }
+
+    out = sub;
+    return true;
+}
+
+double StreamSubscription::rateHz(SensorDataStore::Field field) const
+{
+    const size_t i = static_cast<size_t>(field);
+    return i < CHANNEL_COUNT ? rateHz_[i] : 0.0;
+}
+
+uint32_t StreamSubscription::decimation(SensorDataStore::Field field, int baseHz) const
+{
+    const double hz = rateHz(field);
+    if (hz <= 0.0 || baseHz <= 0)
+    {
+        return 1;
+    }
+    const double factor = std::round(baseHz / hz);
+    return factor > 1.0 ? static_cast<uint32_t>(factor) : 1;
+}
+
+uint16_t StreamSubscription::dueChannels(uint64_t tick, int tickHz) const
+{
+    uint16_t due = 0;
+    for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+    {
+        const uint16_t bit = static_cast<uint16_t>(1u << i);
+        if ((channels_ & bit) && tick % decimation(static_cast<Field>(i), tickHz) == 0)
+        {
+            due |= bit;
+        }
+    }
+    return due;
+}
+
+bool StreamSubscription::isDefault() const
+{
+    if (channels_ != ALL_CHANNELS || !sensors_ || !bed_.empty())
+    {
+        return false;
+    }
+    for (double hz : rateHz_)
+    {
+        if (hz > 0.0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string StreamSubscription::key() const
+{
+    std::string key;
+    for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+    {
+        if (!(channels_ & (1u << i)))
+        {
+            continue;
+        }
+        if (!key.empty())
+        {
+            key += ',';
+        }
+        key += SensorDataStore::fieldName(static_cast<Field>(i));
+        if (rateHz_[i] > 0.0)
+        {
+            char rate[32];
+            std::snprintf(rate, sizeof(rate), "@%g", rateHz_[i]);
+            key += rate;
+        }
+    }
+    if (sensors_)
+    {
+        key += key.empty() ? SENSORS_NAME : std::string(",") + SENSORS_NAME;
+    }
+    if (!bed_.empty())
+    {
+        key = "bed/" + bed_ + ":" + key;
+    }
+    return key;
+}
+
+void StreamSubscription::setChannels(uint16_t mask, bool sensors)
+{
+    channels_ = mask & ALL_CHANNELS;
+    sensors_ = sensors;
+}
+
+void StreamSubscription::setRate(SensorDataStore::Field field, double hz)
+{
+    const size_t i = static_cast<size_t>(field);
+    if (i < CHANNEL_COUNT)
+    {
+        rateHz_[i] = hz > 0.0 ? hz : 0.0;
+    }
+}
+
+void StreamSubscription::setBed(const std::string& bed)
+{
+    if (bed.empty() || BedStore::validId(bed))
+    {
+        bed_ = bed;
+    }
+}
+
+bool StreamSubscription::isWaveform(SensorDataStore::Field field)
+{
+    return field == Field::Ecg || field == Field::Resp || field == Field::Pleth;
+}
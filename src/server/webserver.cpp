@@ -2,27 +2,48 @@
 #include "httplib.h"
 #include "server/auth.h"
 #include "hardware/sensor_manager.h"
+#include "core/MQTTDriver.h"
+#include "core/SensorDataStore.h"
+#include "server/frame_codec.h"
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <fstream>
 #include <chrono>
 #include <thread>
 #include <iomanip>
+#include <limits>
 
 namespace {
     constexpr int DEFAULT_PORT = 8080;
     constexpr int DEFAULT_UPDATE_RATE_HZ = 20;
     constexpr int MAX_UPDATE_RATE_HZ = 120;
+    constexpr int DEFAULT_WAVEFORM_RATE_HZ = 250;
+    constexpr int MAX_WAVEFORM_RATE_HZ = 1000;
     constexpr int SENSOR_SCAN_INTERVAL_SEC = 3;
+    constexpr int SSE_WAIT_TIMEOUT_MS = 500;
+    constexpr size_t MAX_HISTORY_POINTS = 30000;
 }
 
 WebServer::WebServer(int port, const std::string& webRoot, bool mockSensors)
-    : port_(port), webRoot_(webRoot), running_(false), updateRateHz_(DEFAULT_UPDATE_RATE_HZ), mockMode_(mockSensors)
+    : port_(port), streamPort_(port + 1), webRoot_(webRoot), running_(false), updateRateHz_(DEFAULT_UPDATE_RATE_HZ), mockMode_(mockSensors),
+      clock_(SimClock::real()), waveformRateHz_(DEFAULT_WAVEFORM_RATE_HZ)
 {
     // Initialize sensor manager
     sensorMgr_ = std::make_unique<SensorManager>(mockMode_);
+    signalGen_.setClock(clock_);
+    sensorMgr_->setClock(clock_);
+    acquisition_.scanInterval = std::chrono::seconds(SENSOR_SCAN_INTERVAL_SEC);
+    
+    // The stream server's timerfd drives frame production on its reactor thread
+    streamServer_.setTickHandler([this]() { publishFrame(); });
+    streamServer_.setMessageHandler([this](uint64_t clientId, const std::string& message) {
+        handleStreamMessage(clientId, message);
+    });
 }
 
 WebServer::~WebServer()
@@ -42,19 +63,41 @@ void WebServer::start()
     }
 
     running_ = true;
+    broadcaster_.reopen();
+    binaryBroadcaster_.reopen();
+    
+    streamServer_.setTickRate(updateRateHz_.load());
+    const bool streaming = streamServer_.start(streamPort_);
+    if (!streaming) {
+        std::cerr << "Warning: Stream server failed to start on port " << streamPort_
+                  << ", falling back to the HTTP port only" << std::endl;
+    }
     
     // Launch server thread
     server_ = std::make_unique<httplib::Server>();
     serverThreadHandle_ = std::make_unique<std::thread>(&WebServer::serverThread, this);
     
-    // Launch data streaming thread
-    dataThreadHandle_ = std::make_unique<std::thread>(&WebServer::dataStreamThread, this);
+    // Without the reactor, a plain thread produces the frames for the legacy SSE route
+    if (!streaming) {
+        dataThreadHandle_ = std::make_unique<std::thread>(&WebServer::dataStreamThread, this);
+    }
     
-    sensorScanThreadHandle_ = std::make_unique<std::thread>(&WebServer::sensorScanThread, this);
+    // One thread owns the hub: paced sensor reads, FIFO drains and hot-plug scans.
+    // Mock readings stay out of the store, which carries the simulated patient.
+    sensorMgr_->startAcquisition(mockMode_ ? nullptr : &SensorDataStore::instance(), acquisition_);
+    std::cout << "[WebServer] Sensor acquisition started (hot-plug scan every "
+              << acquisition_.scanInterval.count() / 1000 << " seconds";
+    if (sensorMgr_->acquisitionRealtime()) {
+        std::cout << ", SCHED_FIFO priority " << acquisition_.realtimePriority;
+    }
+    std::cout << ")" << std::endl;
     
     std::cout << "🌐 Web Server started on http://localhost:" << port_ << std::endl;
     std::cout << "📂 Serving files from: " << webRoot_ << std::endl;
     std::cout << "🔌 Data endpoint: http://localhost:" << port_ << "/ws" << std::endl;
+    if (streaming) {
+        std::cout << "🔌 Stream endpoint (WebSocket/SSE): localhost:" << streamPort_ << "/ws" << std::endl;
+    }
     if (mockMode_) {
         std::cout << "🎭 Mock mode: Sensors simulated" << std::endl;
     }
@@ -67,6 +110,9 @@ void WebServer::stop()
     std::cout << "[WebServer] Stopping..." << std::endl;
     running_ = false;
     shutdownCv_.notify_all();
+    broadcaster_.close();
+    binaryBroadcaster_.close();
+    streamServer_.stop();
     
     if (server_) {
         server_->stop();
@@ -78,9 +124,7 @@ void WebServer::stop()
     if (dataThreadHandle_ && dataThreadHandle_->joinable()) {
         dataThreadHandle_->join();
     }
-    if (sensorScanThreadHandle_ && sensorScanThreadHandle_->joinable()) {
-        sensorScanThreadHandle_->join();
-    }
+    sensorMgr_->stopAcquisition();
     
     std::cout << "[WebServer] Server stopped cleanly" << std::endl;
 }
@@ -89,14 +133,58 @@ void WebServer::setUpdateRate(int hz)
 {
     if (hz > 0 && hz <= MAX_UPDATE_RATE_HZ) {
         updateRateHz_ = hz;
+        streamServer_.setTickRate(hz);
         std::cout << "Update rate set to " << hz << " Hz" << std::endl;
     }
 }
 
+void WebServer::setAcquisitionScheduling(int realtimePriority, int cpu)
+{
+    acquisition_.realtimePriority = std::max(0, realtimePriority);
+    acquisition_.cpu = cpu;
+}
+
+void WebServer::setWaveformRate(int hz)
+{
+    if (hz >= 0 && hz <= MAX_WAVEFORM_RATE_HZ) {
+        waveformRateHz_ = hz;
+    }
+}
+
+void WebServer::setPhysiology(const SignalGenerator::Physiology& physiology)
+{
+    signalGen_.setPhysiology(physiology);
+}
+
+void WebServer::markIngested(std::chrono::steady_clock::time_point receivedAt)
+{
+    // Keep the oldest: the next frame carries everything ingested since the last one
+    int64_t expected = 0;
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(receivedAt.time_since_epoch());
+    ingestPendingNs_.compare_exchange_strong(expected, ns.count(), std::memory_order_relaxed);
+}
+
+void WebServer::setClock(std::shared_ptr<SimClock> clock)
+{
+    if (!clock || running_) {
+        return;
+    }
+    clock_ = std::move(clock);
+    signalGen_.setClock(clock_);
+    sensorMgr_->setClock(clock_);
+}
+
+void WebServer::setBedStore(BedStore* beds)
+{
+    if (!running_) {
+        beds_ = beds;
+    }
+}
+
 int WebServer::getClientCount() const
 {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    return clients_.size();
+    return streamServer_.clientCount() + broadcaster_.subscriberCount() +
+           binaryBroadcaster_.subscriberCount();
 }
 
 void WebServer::serverThread()
@@ -190,8 +278,13 @@ void WebServer::serverThread()
         res.set_content(response.dump(), "application/json");
     });
     
-    // Server-Sent Events endpoint for real-time data
-    server_->Get("/ws", [this](const httplib::Request& /* req */, httplib::Response& res) {
+    // Server-Sent Events endpoint for real-time data on the HTTP port
+    // Optional ?format=binary selects base64-encoded binary frames (see frame_codec.h)
+    // Legacy path: each client holds an httplib worker thread. Dashboards should use
+    // the stream port (same /ws URL), which is served by the epoll reactor.
+    server_->Get("/ws", [this](const httplib::Request& req, httplib::Response& res) {
+        FrameBroadcaster* hub = (req.get_param_value("format") == "binary") ? &binaryBroadcaster_ : &broadcaster_;
+        
         res.set_header("Content-Type", "text/event-stream");
         res.set_header("Cache-Control", "no-cache");
         res.set_header("Connection", "keep-alive");
@@ -199,22 +292,21 @@ void WebServer::serverThread()
         
         res.set_content_provider(
             "text/event-stream",
-            [this](size_t /* offset */, httplib::DataSink& sink) {
-                const int intervalMs = 1000 / updateRateHz_.load();
+            [this, hub](size_t /* offset */, httplib::DataSink& sink) {
+                // Frames are produced once per tick by publishFrame();
+                // this sink only forwards the shared buffer.
+                FrameBroadcaster::Subscription subscription(*hub);
+                uint64_t lastSeq = hub->sequence();
                 
                 while (running_ && sink.is_writable()) {
-                    auto data = signalGen_.generate();
-                    std::string json = generateJsonData(data);
-                    
-                    std::ostringstream oss;
-                    oss << "data: " << json << "\n\n";
+                    auto frame = hub->waitForNext(lastSeq, std::chrono::milliseconds(SSE_WAIT_TIMEOUT_MS));
+                    if (!frame) {
+                        continue;
+                    }
                     
-                    if (!sink.write(oss.str().c_str(), oss.str().size())) {
+                    if (!sink.write(frame->data(), frame->size())) {
                         break;
                     }
-                    
-                    signalGen_.tick(intervalMs / 1000.0);
-                    std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
                 }
                 
                 return true;
@@ -222,6 +314,104 @@ void WebServer::serverThread()
         );
     });
     
+    // History backfill: GET /api/history?channel=ecg&from=<s>&to=<s>[&max_points=N][&bed=ID]
+    // Times are stream timestamps (seconds), as carried in every frame.
+    server_->Get("/api/history", [this](const httplib::Request& req, httplib::Response& res) {
+        using json = nlohmann::json;
+        
+        const SensorDataStore* store = &SensorDataStore::instance();
+        if (req.has_param("bed")) {
+            const BedStore::Shard* bed = beds_ ? beds_->find(req.get_param_value("bed")) : nullptr;
+            if (!bed) {
+                json error;
+                error["error"] = "Unknown bed";
+                res.status = 404;
+                res.set_content(error.dump(), "application/json");
+                return;
+            }
+            store = &bed->store;
+        }
+        
+        SensorDataStore::Field field;
+        if (!SensorDataStore::fieldFromName(req.get_param_value("channel"), field) ||
+            field == SensorDataStore::Field::Timestamp) {
+            json error;
+            error["error"] = "Unknown channel";
+            res.status = 400;
+            res.set_content(error.dump(), "application/json");
+            return;
+        }
+        
+        double from = -std::numeric_limits<double>::infinity();
+        double to = std::numeric_limits<double>::infinity();
+        size_t maxPoints = MAX_HISTORY_POINTS;
+        try {
+            if (req.has_param("from")) from = std::stod(req.get_param_value("from"));
+            if (req.has_param("to")) to = std::stod(req.get_param_value("to"));
+            if (req.has_param("max_points")) {
+                // 0 would mean unlimited to readHistory(); the cap always applies here
+                const size_t requested = std::stoul(req.get_param_value("max_points"));
+                maxPoints = requested == 0 ? MAX_HISTORY_POINTS : std::min(requested, MAX_HISTORY_POINTS);
+            }
+        } catch (const std::exception&) {
+            json error;
+            error["error"] = "Invalid range";
+            res.status = 400;
+            res.set_content(error.dump(), "application/json");
+            return;
+        }
+        
+        std::vector<TimeSample> samples;
+        store->readHistory(field, from, to, samples, maxPoints);
+        
+        std::vector<double> t, v;
+        t.reserve(samples.size());
+        v.reserve(samples.size());
+        for (const auto& s : samples) {
+            t.push_back(s.t);
+            v.push_back(s.v);
+        }
+        
+        json j;
+        j["channel"] = SensorDataStore::fieldName(field);
+        j["t"] = std::move(t);
+        j["v"] = std::move(v);
+        res.set_content(j.dump(), "application/json");
+    });
+    
+    // Ward overview: GET /api/beds lists every bed with its physiology and latest vitals
+    server_->Get("/api/beds", [this](const httplib::Request& /* req */, httplib::Response& res) {
+        using json = nlohmann::json;
+        using Field = SensorDataStore::Field;
+        
+        json beds = json::array();
+        const size_t count = beds_ ? beds_->size() : 0;
+        for (size_t i = 0; i < count; ++i) {
+            const BedStore::Shard* bed = beds_->at(i);
+            const SignalGenerator::Physiology physiology = bed->physiology();
+            const SensorDataStore::Snapshot snapshot = bed->store.snapshot();
+            
+            json vitals = json::object();
+            for (Field f : {Field::Spo2, Field::BpSystolic, Field::BpDiastolic, Field::Pleth}) {
+                if (snapshot.has(f)) {
+                    vitals[SensorDataStore::fieldName(f)] = snapshot.value(f);
+                }
+            }
+            beds.push_back({{"id", bed->id},
+                            {"physiology", {{"heartRate", physiology.heartRateBpm},
+                                            {"respRate", physiology.respRateBpm},
+                                            {"spo2", physiology.spo2},
+                                            {"bpSystolic", physiology.bpSystolic},
+                                            {"bpDiastolic", physiology.bpDiastolic}}},
+                            {"vitals", std::move(vitals)}});
+        }
+        
+        json j;
+        j["beds"] = std::move(beds);
+        j["maxBeds"] = BedStore::MAX_BEDS;
+        res.set_content(j.dump(), "application/json");
+    });
+    
     // API endpoint to get server status
     server_->Get("/api/status", [this](const httplib::Request& /* req */, httplib::Response& res) {
         using json = nlohmann::json;
@@ -229,12 +419,131 @@ void WebServer::serverThread()
         j["running"] = true;
         j["clients"] = getClientCount();
         j["updateRate"] = updateRateHz_.load();
+        j["waveformRate"] = waveformRateHz_;
         j["time"] = signalGen_.getTime();
+        j["clock"] = {{"mode", clock_->mode() == SimClock::Mode::Real ? "real"
+                               : clock_->mode() == SimClock::Mode::Scaled ? "scaled" : "step"},
+                      {"speed", clock_->speed()},
+                      {"step", clock_->step()}};
+        const SignalGenerator::Physiology physiology = signalGen_.physiology();
+        j["physiology"] = {{"heartRate", physiology.heartRateBpm},
+                           {"respRate", physiology.respRateBpm},
+                           {"spo2", physiology.spo2},
+                           {"bpSystolic", physiology.bpSystolic},
+                           {"bpDiastolic", physiology.bpDiastolic}};
+        j["beds"] = beds_ ? beds_->size() : 0;
         j["mockMode"] = mockMode_;
+        j["streamPort"] = streamPort_;
+        
+        json streamClients = json::array();
+        for (const auto& client : streamServer_.clients()) {
+            json c;
+            c["id"] = client.id;
+            c["remote"] = client.remote;
+            c["transport"] = (client.transport == StreamServer::Transport::Sse) ? "sse" : "websocket";
+            c["format"] = (client.format == StreamServer::Format::Binary) ? "binary" : "json";
+            c["connectedSeconds"] = client.connectedSeconds;
+            c["framesSent"] = client.framesSent;
+            c["bytesSent"] = client.bytesSent;
+            c["queuedFrames"] = client.queuedFrames;
+            c["policy"] = StreamServer::policyName(client.policy);
+            c["framesDropped"] = client.framesDropped;
+            c["lagMs"] = client.lagMs;
+            c["maxLagMs"] = client.maxLagMs;
+            c["subscription"] = client.subscription;
+            streamClients.push_back(std::move(c));
+        }
+        j["streamClients"] = std::move(streamClients);
+        
+        const auto tick = streamServer_.tickStats();
+        json t;
+        t["ticks"] = tick.ticks;
+        t["missed"] = tick.missed;
+        t["lastLateMs"] = tick.lastLateMs;
+        t["maxLateMs"] = tick.maxLateMs;
+        t["maxHandlerMs"] = tick.maxHandlerMs;
+        j["tick"] = std::move(t);
+        
+        const LatencyHistogram::Summary ingest = ingestLatency_.summary();
+        j["ingestLatencyUs"] = {{"count", ingest.count},
+                                {"mean", ingest.meanUs},
+                                {"p50", ingest.p50Us},
+                                {"p90", ingest.p90Us},
+                                {"p99", ingest.p99Us},
+                                {"p999", ingest.p999Us},
+                                {"max", ingest.maxUs}};
         
         res.set_content(j.dump(), "application/json");
     });
     
+    // MQTT ingestion: GET /api/metrics/mqtt gives counters, per-topic rates and publish latency
+    server_->Get("/api/metrics/mqtt", [this](const httplib::Request& /* req */, httplib::Response& res) {
+        using json = nlohmann::json;
+        using Counter = MqttStats::Counter;
+        const MQTTDriver* mqtt = mqtt_.load();
+        if (!mqtt) {
+            res.status = 503;
+            res.set_content(R"({"error": "MQTT not enabled"})", "application/json");
+            return;
+        }
+
+        const MqttStats::Snapshot s = mqtt->stats().snapshot();
+        json j;
+        j["connected"] = mqtt->isConnected();
+        j["uptimeSeconds"] = s.uptimeSeconds;
+        j["received"] = s.count(Counter::Received);
+        j["receivedRate"] = s.receivedRate;
+        j["unknownTopics"] = s.count(Counter::UnknownTopic);
+        j["parseFailures"] = s.count(Counter::ParseFailure);
+        j["bedsFull"] = s.count(Counter::BedFull);
+        j["batches"] = s.count(Counter::Batch);
+        j["connects"] = s.count(Counter::Connect);
+        j["reconnects"] = s.count(Counter::Reconnect);
+        j["disconnects"] = s.count(Counter::Disconnect);
+
+        json topics = json::object();
+        for (size_t i = 0; !MQTTDriver::statsTopic(i).empty(); ++i) {
+            topics[std::string(MQTTDriver::statsTopic(i))] = {{"received", s.topicReceived[i]},
+                                                               {"parseFailures", s.topicFailures[i]},
+                                                               {"rate", s.topicRates[i]}};
+        }
+        j["topics"] = std::move(topics);
+
+        const LatencyHistogram::Summary latency = mqtt->stats().publishLatency().summary();
+        j["publishLatencyUs"] = {{"count", latency.count},
+                                 {"mean", latency.meanUs},
+                                 {"p50", latency.p50Us},
+                                 {"p90", latency.p90Us},
+                                 {"p99", latency.p99Us},
+                                 {"p999", latency.p999Us},
+                                 {"max", latency.maxUs}};
+
+        res.set_content(j.dump(), "application/json");
+    });
+
+    // Sensor acquisition: GET /api/metrics/acquisition gives runs, overruns and wake-up jitter per task
+    server_->Get("/api/metrics/acquisition", [this](const httplib::Request& /* req */, httplib::Response& res) {
+        using json = nlohmann::json;
+        using Task = SensorManager::AcquisitionTask;
+        json j;
+        j["running"] = sensorMgr_->isAcquiring();
+        j["realtime"] = sensorMgr_->acquisitionRealtime();
+
+        json tasks = json::object();
+        for (size_t i = 0; i < static_cast<size_t>(Task::Count); ++i) {
+            const Task task = static_cast<Task>(i);
+            const SensorManager::AcquisitionStats s = sensorMgr_->acquisitionStats(task);
+            tasks[SensorManager::acquisitionTaskName(task)] = {{"runs", s.runs},
+                                                               {"overruns", s.overruns},
+                                                               {"failures", s.failures},
+                                                               {"jitterUs", {{"p50", s.jitter.p50Us},
+                                                                             {"p99", s.jitter.p99Us},
+                                                                             {"max", s.jitter.maxUs}}}};
+        }
+        j["tasks"] = std::move(tasks);
+        res.set_content(j.dump(), "application/json");
+    });
+    
     // Helper to determine mime type
     auto getMimeType = [](const std::string& path) -> std::string {
         if (path.find(".html") != std::string::npos) return "text/html";
@@ -285,58 +594,319 @@ void WebServer::serverThread()
 
 void WebServer::dataStreamThread()
 {
-    // This thread manages the signal generator timing
-    // The actual data is sent via SSE in the serverThread
+    // Fallback producer used only when the stream server could not start
+    
+    // Deadlines are absolute so the time spent publishing does not stretch the period
+    auto deadline = std::chrono::steady_clock::now();
     
     while (running_) {
-        const int intervalMs = 1000 / updateRateHz_.load();
+        const auto interval = std::chrono::milliseconds(1000 / updateRateHz_.load());
+        
+        publishFrame();
+        
+        deadline += interval;
+        const auto now = std::chrono::steady_clock::now();
+        while (deadline <= now) {
+            deadline += interval; // Skip missed ticks rather than bursting to catch up
+        }
         
         std::unique_lock<std::mutex> lock(shutdownMutex_);
-        if (shutdownCv_.wait_for(lock, std::chrono::milliseconds(intervalMs), [this]{ return !running_; })) {
+        if (shutdownCv_.wait_until(lock, deadline, [this]{ return !running_; })) {
             break;
         }
     }
 }
 
-void WebServer::sensorScanThread()
+void WebServer::sampleFrame(SignalGenerator& gen, SensorDataStore& history, int tickHz, WaveformSource& src,
+                            HubWaveforms* hub)
+{
+    // Waveforms are sampled at their native rate and every frame carries the
+    // samples since the previous one; the other channels use the newest sample
+    if (waveformRateHz_ > 0) {
+        sampleWaveforms(gen, history, tickHz, src, hub);
+        src.data = src.block.count > 0 ? src.block.samples[src.block.count - 1] : gen.generate();
+    } else {
+        src.block = FrameCodec::SampleBlock();
+        src.data = gen.generate();
+        if (hub) {
+            hub->apply(*sensorMgr_, &src.data, 1);
+        }
+        history.recordHistory(src.data);
+    }
+}
+
+void WebServer::sampleWaveforms(SignalGenerator& gen, SensorDataStore& history, int tickHz, WaveformSource& src,
+                                HubWaveforms* hub)
 {
-    std::cout << "[WebServer] Sensor hot-plug detection enabled (scans every " << SENSOR_SCAN_INTERVAL_SEC << " seconds)" << std::endl;
+    const int rate = waveformRateHz_;
+    const int64_t last = static_cast<int64_t>(std::floor(gen.getTime() * rate));
     
-    while (running_) {
-        {
-            std::unique_lock<std::mutex> lock(shutdownMutex_);
-            if (shutdownCv_.wait_for(lock, std::chrono::seconds(SENSOR_SCAN_INTERVAL_SEC), [this]{ return !running_; })) {
-                break;
-            }
+    // Start one tick back on the first frame, and after a stall of more than a
+    // second of wall-clock time rather than replaying the gap. A fixed-step
+    // clock only moves between frames, so it never stalls.
+    const bool stalled = clock_->mode() != SimClock::Mode::FixedStep &&
+                         last - src.nextSample >= static_cast<int64_t>(rate * clock_->speed());
+    if (src.nextSample < 0 || stalled) {
+        src.nextSample = std::max<int64_t>(0, last + 1 - std::max(1, rate / std::max(1, tickHz)));
+    }
+    
+    const size_t n = last >= src.nextSample ? static_cast<size_t>(last - src.nextSample + 1) : 0;
+    src.samples.resize(n);
+    gen.generateBlock(static_cast<double>(src.nextSample) / rate, 1.0 / rate, n, src.samples.data());
+    if (hub) {
+        hub->apply(*sensorMgr_, src.samples.data(), n); // Hardware waveforms replace the synthesized ones
+    }
+    for (const auto& sample : src.samples) {
+        history.recordHistory(sample);
+    }
+    
+    src.block.samples = src.samples.data();
+    src.block.count = n;
+    src.block.firstIndex = static_cast<uint64_t>(src.nextSample);
+    src.block.rateHz = rate;
+    src.nextSample += static_cast<int64_t>(n);
+}
+
+void WebServer::sampleBeds(int tickHz)
+{
+    // Beds are only ever added, so the streams mirror the store by index
+    for (size_t i = bedStreams_.size(); i < beds_->size(); ++i) {
+        auto stream = std::make_unique<BedStream>();
+        stream->bed = beds_->at(i);
+        stream->signalGen.setClock(clock_);
+        stream->signalGen.setStore(stream->bed->store); // Not the main patient's live values
+        bedStreams_.push_back(std::move(stream));
+    }
+    
+    for (auto& stream : bedStreams_) {
+        const uint64_t version = stream->bed->physiologyVersion();
+        if (version != stream->physiologyVersion) {
+            stream->physiologyVersion = version;
+            stream->signalGen.setPhysiology(stream->bed->physiology());
+        }
+        sampleFrame(stream->signalGen, stream->bed->store, tickHz, stream->source);
+    }
+}
+
+const WebServer::WaveformSource* WebServer::bedSource(const std::string& bed) const
+{
+    for (const auto& stream : bedStreams_) {
+        if (stream->bed->id == bed) {
+            return &stream->source;
+        }
+    }
+    return nullptr; // Not heard from yet
+}
+
+void WebServer::publishFrame()
+{
+    const uint32_t seq = ++frameSeq_;
+    const int tickHz = updateRateHz_.load();
+    clock_->tick(); // Simulated time per frame (fixed-step clocks only)
+    
+    // Every patient is sampled whether or not anyone watches, so histories have no gaps
+    // Hub FIFO waveforms are played into the own patient's samples; in mock mode
+    // they are only drained, as the simulated patient owns the stream
+    if (mockMode_) {
+        hubWaveforms_.discard(*sensorMgr_);
+    }
+    sampleFrame(signalGen_, SensorDataStore::instance(), tickHz, local_, mockMode_ ? nullptr : &hubWaveforms_);
+    if (beds_) {
+        sampleBeds(tickHz);
+    }
+    const FrameCodec::SampleBlock& block = local_.block;
+    const SignalGenerator::SensorData& data = local_.data;
+    
+    const auto groups = streamServer_.subscriptionGroups();
+    const bool legacyJson = broadcaster_.subscriberCount() > 0;
+    const bool legacyBinary = binaryBroadcaster_.subscriberCount() > 0;
+    if (groups.empty() && !legacyJson && !legacyBinary) {
+        ingestPendingNs_.store(0, std::memory_order_relaxed); // Nobody to deliver it to
+        return;
+    }
+    
+    // Sensor status is validated once per tick and shared by every JSON frame
+    std::string sensorsJson;
+    const bool anyJson = legacyJson || std::any_of(groups.begin(), groups.end(), [](const auto& g) {
+        return g.format == StreamServer::Format::Json && g.subscription.sensors();
+    });
+    if (anyJson) {
+        auto sensors = nlohmann::json::parse(sensorMgr_->getSensorStatusJson(), nullptr, false);
+        sensorsJson = sensors.is_discarded() ? "{}" : sensors.dump();
+    }
+    const uint8_t sensorBits = sensorMgr_->getSensorStatusBits();
+    const uint16_t fullRuns = block.count > 0 ? FrameCodec::WAVEFORM_CHANNELS : 0;
+    const uint32_t fullSteps[StreamSubscription::CHANNEL_COUNT] = {1, 1, 1, 1, 1, 1, 1, 1};
+    
+    // One payload per subscription group, holding only the channels due this tick.
+    // The stream server wraps it for WebSocket and SSE itself.
+    std::string fullJson; // Everything plus sensors; shared with the legacy hub
+    for (const auto& group : groups) {
+        const StreamSubscription& sub = group.subscription;
+        
+        // Beds have samples of their own but no sensor hardware
+        const WaveformSource* src = sub.bed().empty() ? &local_ : bedSource(sub.bed());
+        if (!src) {
+            continue; // Bed not heard from yet
         }
+        const bool own = src == &local_;
+        const FrameCodec::SampleBlock& frameBlock = src->block;
+        const SignalGenerator::SensorData& frameData = src->data;
+        const uint8_t frameBits = own ? sensorBits : 0;
         
-        if (!running_) break;
+        uint16_t due = sub.dueChannels(seq, tickHz);
+        uint16_t runs = 0;
+        uint32_t steps[StreamSubscription::CHANNEL_COUNT] = {1, 1, 1, 1, 1, 1, 1, 1};
+        if (waveformRateHz_ > 0) {
+            // Waveform rates decimate the native samples instead of the ticks
+            due &= ~FrameCodec::WAVEFORM_CHANNELS;
+            for (size_t i = 0; i < StreamSubscription::CHANNEL_COUNT; ++i) {
+                if (!(sub.channels() & FrameCodec::WAVEFORM_CHANNELS & (1u << i))) {
+                    continue;
+                }
+                steps[i] = sub.decimation(static_cast<SensorDataStore::Field>(i), waveformRateHz_);
+                size_t first = 0;
+                if (FrameCodec::blockSlice(frameBlock, steps[i], first) > 0) {
+                    runs |= static_cast<uint16_t>(1u << i);
+                }
+            }
+            due |= runs;
+        }
+        if (due == 0 && sub.channels() != 0) {
+            continue; // Decimated away this tick
+        }
         
-        sensorMgr_->scanSensors();
+        if (group.format == StreamServer::Format::Json) {
+            if (sub.isDefault() && due == StreamSubscription::ALL_CHANNELS) {
+                if (fullJson.empty()) {
+                    fullJson = generateJsonData(data, StreamSubscription::ALL_CHANNELS, sensorsJson, &block,
+                                                fullRuns, fullSteps);
+                }
+                streamServer_.broadcast(group.id, fullJson.data(), fullJson.size());
+            } else {
+                const std::string json = generateJsonData(frameData, due,
+                                                          own && sub.sensors() ? sensorsJson : std::string(),
+                                                          &frameBlock, runs, steps);
+                streamServer_.broadcast(group.id, json.data(), json.size());
+            }
+        } else if (runs != 0) {
+            FrameCodec::encodeBinaryBlock(frameData, frameBits, seq, due, frameBlock, runs, steps, binaryBlock_);
+            streamServer_.broadcast(group.id, binaryBlock_.data(), binaryBlock_.size());
+        } else if (due == StreamSubscription::ALL_CHANNELS) {
+            uint8_t raw[FrameCodec::BINARY_FRAME_SIZE];
+            FrameCodec::encodeBinary(frameData, frameBits, seq, raw);
+            streamServer_.broadcast(group.id, raw, sizeof(raw));
+        } else {
+            uint8_t raw[FrameCodec::BINARY_CHANNELS_FRAME_MAX_SIZE];
+            const size_t n = FrameCodec::encodeBinaryChannels(frameData, frameBits, seq, due, raw);
+            streamServer_.broadcast(group.id, raw, n);
+        }
+    }
+    
+    // Legacy HTTP-port hubs always get complete frames (binary: newest sample only)
+    if (legacyJson) {
+        if (fullJson.empty()) {
+            fullJson = generateJsonData(data, StreamSubscription::ALL_CHANNELS, sensorsJson, &block,
+                                        fullRuns, fullSteps);
+        }
+        std::string frame;
+        frame.reserve(fullJson.size() + 8);
+        frame.append("data: ").append(fullJson).append("\n\n");
+        broadcaster_.publish(std::move(frame));
+    }
+    if (legacyBinary) {
+        char frame[FrameCodec::BINARY_SSE_FRAME_SIZE];
+        const size_t n = FrameCodec::encodeBinarySse(data, sensorBits, seq, frame);
+        binaryBroadcaster_.publish(std::string(frame, n));
+    }
+    
+    // The oldest data ingested since the previous frame is now on its way to the clients
+    const int64_t ingested = ingestPendingNs_.exchange(0, std::memory_order_relaxed);
+    if (ingested != 0) {
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+        ingestLatency_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now) -
+                              std::chrono::nanoseconds(ingested));
     }
 }
 
-std::string WebServer::generateJsonData(const SignalGenerator::SensorData& data)
+void WebServer::handleStreamMessage(uint64_t clientId, const std::string& message)
 {
     using json = nlohmann::json;
     
-    // Parse sensor status JSON from sensor manager
-    json sensors = json::parse(sensorMgr_->getSensorStatusJson(), nullptr, false);
-    if (sensors.is_discarded()) {
-        sensors = json::object();
+    // {"type":"subscribe","channels":["ecg","pleth"],"ecg_hz":250,"vitals_hz":1}
+    // takes the same keys as the /ws query string
+    json request = json::parse(message, nullptr, false);
+    if (request.is_discarded() || !request.is_object() || request.value("type", "") != "subscribe") {
+        return;
     }
     
+    std::map<std::string, std::string> params;
+    for (auto it = request.begin(); it != request.end(); ++it) {
+        if (it.key() == "type") {
+            continue;
+        }
+        std::string value;
+        if (it->is_array()) {
+            for (const auto& item : *it) {
+                if (!value.empty()) value += ',';
+                value += item.is_string() ? item.get<std::string>() : item.dump();
+            }
+        } else {
+            value = it->is_string() ? it->get<std::string>() : it->dump();
+        }
+        params[it.key()] = value;
+    }
+    
+    json reply;
+    StreamSubscription subscription;
+    std::string error;
+    if (StreamSubscription::parse(params, subscription, &error)) {
+        streamServer_.setSubscription(clientId, subscription);
+        reply["type"] = "subscribed";
+        reply["subscription"] = subscription.key();
+    } else {
+        reply["type"] = "error";
+        reply["error"] = error;
+    }
+    streamServer_.send(clientId, reply.dump());
+}
+
+std::string WebServer::generateJsonData(const SignalGenerator::SensorData& data, uint16_t channels,
+                                        const std::string& sensorsJson, const FrameCodec::SampleBlock* block,
+                                        uint16_t blockChannels, const uint32_t* steps)
+{
+    using json = nlohmann::json;
+    using Field = SensorDataStore::Field;
+    
     json j;
-    j["ecg"] = data.ecg;
-    j["spo2"] = data.spo2;
-    j["resp"] = data.resp;
-    j["pleth"] = data.pleth;
-    j["bp_systolic"] = data.bp_systolic;
-    j["bp_diastolic"] = data.bp_diastolic;
-    j["temp_cavity"] = data.temp_cavity;
-    j["temp_skin"] = data.temp_skin;
+    for (size_t i = 0; i < StreamSubscription::CHANNEL_COUNT; ++i) {
+        if (!(channels & (1u << i))) {
+            continue;
+        }
+        const char* name = SensorDataStore::fieldName(static_cast<Field>(i));
+        if (!block || !(blockChannels & (1u << i))) {
+            j[name] = FrameCodec::channelValue(data, i);
+            continue;
+        }
+        
+        // Sample run: {"t0": first sample time, "dt": interval, "v": [samples]}
+        size_t first = 0;
+        const size_t count = FrameCodec::blockSlice(*block, steps[i], first);
+        json values = json::array();
+        for (size_t n = 0; n < count; ++n) {
+            values.push_back(FrameCodec::channelValue(block->samples[first + n * steps[i]], i));
+        }
+        j[name] = {{"t0", static_cast<double>(block->firstIndex + first) / block->rateHz},
+                   {"dt", static_cast<double>(steps[i]) / block->rateHz},
+                   {"v", std::move(values)}};
+    }
     j["timestamp"] = data.timestamp;
-    j["sensors"] = sensors;
     
-    return j.dump();
+    std::string out = j.dump();
+    if (!sensorsJson.empty()) {
+        // Spliced in as text so the status is parsed once per tick, not per frame
+        out.pop_back();
+        out.append(",\"sensors\":").append(sensorsJson).push_back('}');
+    }
+    return out;
 }
@@ -0,0 +1,382 @@
+#include "server/websocket.h"
+#include "server/frame_codec.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+namespace {
+    constexpr char HANDSHAKE_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+    uint32_t rotl(uint32_t v, int n)
+    {
+        return (v << n) | (v >> (32 - n));
+    }
+
+    std::string toLower(std::string s)
+    {
+        for (char& c : s)
+        {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return s;
+    }
+
+    std::string trim(const std::string& s)
+    {
+        size_t b = 0;
+        size_t e = s.size();
+        while (b < e && std::isspace(static_cast<unsigned char>(s[b]))) ++b;
+        while (e > b && std::isspace(static_cast<unsigned char>(s[e - 1]))) --e;
+        return s.substr(b, e - b);
+    }
+
+    int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    std::string urlDecode(const std::string& s)
+    {
+        std::string out;
+        out.reserve(s.size());
+        for (size_t i = 0; i < s.size(); ++i)
+        {
+            if (s[i] == '+')
+            {
+                out += ' ';
+            }
+            else if (s[i] == '%' && i + 2 < s.size() && hexValue(s[i + 1]) >= 0 &&
+                     hexValue(s[i + 2]) >= 0)
+            {
+                out += static_cast<char>(hexValue(s[i + 1]) * 16 + hexValue(s[i + 2]));
+                i += 2;
+            }
+            else
+            {
+                out += s[i];
+            }
+        }
+        return out;
+    }
+}
+
+namespace WebSocket
+{
+
+// ============================================================================
+// Framing
+// ============================================================================
+
+ParseResult parseFrame(const uint8_t* data, size_t len, Frame& out, size_t& consumed,
+                       size_t maxPayload)
+{
+    if (len < 2)
+    {
+        return ParseResult::NeedMore;
+    }
+
+    const bool fin = (data[0] & 0x80) != 0;
+    const uint8_t rsv = data[0] & 0x70;
+    const uint8_t op = data[0] & 0x0F;
+    const bool masked = (data[1] & 0x80) != 0;
+    uint64_t payloadLen = data[1] & 0x7F;
+    size_t pos = 2;
+
+    // No extensions are negotiated, so reserved bits must be clear
+    if (rsv != 0)
+    {
+        return ParseResult::Error;
+    }
+
+    const bool control = (op & 0x08) != 0;
+    if (op != 0x0 && op != 0x1 && op != 0x2 && op != 0x8 && op != 0x9 && op != 0xA)
+    {
+        return ParseResult::Error;
+    }
+    if (control && (!fin || payloadLen > 125))
+    {
+        return ParseResult::Error;
+    }
+
+    if (payloadLen == 126)
+    {
+        if (len < pos + 2) return ParseResult::NeedMore;
+        payloadLen = (static_cast<uint64_t>(data[pos]) << 8) | data[pos + 1];
+        pos += 2;
+    }
+    else if (payloadLen == 127)
+    {
+        if (len < pos + 8) return ParseResult::NeedMore;
+        payloadLen = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            payloadLen = (payloadLen << 8) | data[pos + i];
+        }
+        pos += 8;
+    }
+
+    if (payloadLen > maxPayload)
+    {
+        return ParseResult::Error;
+    }
+
+    uint8_t mask[4] = {0, 0, 0, 0};
+    if (masked)
+    {
+        if (len < pos + 4) return ParseResult::NeedMore;
+        std::memcpy(mask, data + pos, 4);
+        pos += 4;
+    }
+
+    if (len - pos < payloadLen)
+    {
+        return ParseResult::NeedMore;
+    }
+
+    out.opcode = static_cast<Opcode>(op);
+    out.fin = fin;
+    out.masked = masked;
+    out.payload.assign(reinterpret_cast<const char*>(data + pos), static_cast<size_t>(payloadLen));
+    if (masked)
+    {
+        for (size_t i = 0; i < out.payload.size(); ++i)
+        {
+            out.payload[i] = static_cast<char>(out.payload[i] ^ mask[i & 3]);
+        }
+    }
+
+    consumed = pos + static_cast<size_t>(payloadLen);
+    return ParseResult::Ok;
+}
+
+size_t writeHeader(uint8_t* out, Opcode opcode, uint64_t payloadLen, bool fin, const uint8_t* mask)
+{
+    size_t pos = 0;
+    out[pos++] = static_cast<uint8_t>((fin ? 0x80 : 0x00) | static_cast<uint8_t>(opcode));
+
+    const uint8_t maskBit = mask ? 0x80 : 0x00;
+    if (payloadLen < 126)
+    {
+        out[pos++] = static_cast<uint8_t>(maskBit | payloadLen);
+    }
+    else if (payloadLen <= 0xFFFF)
+    {
+        out[pos++] = static_cast<uint8_t>(maskBit | 126);
+        out[pos++] = static_cast<uint8_t>(payloadLen >> 8);
+        out[pos++] = static_cast<uint8_t>(payloadLen);
+    }
+    else
+    {
+        out[pos++] = static_cast<uint8_t>(maskBit | 127);
+        for (int i = 7; i >= 0; --i)
+        {
+            out[pos++] = static_cast<uint8_t>(payloadLen >> (8 * i));
+        }
+    }
+
+    if (mask)
+    {
+        std::memcpy(out + pos, mask, 4);
+        pos += 4;
+    }
+    return pos;
+}
+
+std::string encodeFrame(Opcode opcode, const void* payload, size_t len, const uint8_t* mask)
+{
+    uint8_t header[MAX_HEADER_SIZE];
+    const size_t headerLen = writeHeader(header, opcode, len, true, mask);
+
+    std::string frame;
+    frame.reserve(headerLen + len);
+    frame.append(reinterpret_cast<const char*>(header), headerLen);
+    if (len > 0)
+    {
+        frame.append(static_cast<const char*>(payload), len);
+    }
+
+    if (mask)
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            frame[headerLen + i] = static_cast<char>(frame[headerLen + i] ^ mask[i & 3]);
+        }
+    }
+    return frame;
+}
+
+std::string encodeClose(uint16_t code, const std::string& reason)
+{
+    std::string payload;
+    payload += static_cast<char>(code >> 8);
+    payload += static_cast<char>(code & 0xFF);
+    payload += reason.substr(0, 123);
+    return encodeFrame(Opcode::Close, payload.data(), payload.size());
+}
+
+// ============================================================================
+// Handshake
+// ============================================================================
+
+void sha1(const uint8_t* data, size_t len, uint8_t digest[20])
+{
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    // Message padded to a multiple of 64 bytes with the bit length at the end
+    const uint64_t bitLen = static_cast<uint64_t>(len) * 8;
+    std::string msg(reinterpret_cast<const char*>(data), len);
+    msg += static_cast<char>(0x80);
+    while (msg.size() % 64 != 56)
+    {
+        msg += static_cast<char>(0x00);
+    }
+    for (int i = 7; i >= 0; --i)
+    {
+        msg += static_cast<char>((bitLen >> (8 * i)) & 0xFF);
+    }
+
+    for (size_t chunk = 0; chunk < msg.size(); chunk += 64)
+    {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i)
+        {
+            const auto* p = reinterpret_cast<const uint8_t*>(msg.data() + chunk + i * 4);
+            w[i] = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                   (static_cast<uint32_t>(p[2]) << 8) | p[3];
+        }
+        for (int i = 16; i < 80; ++i)
+        {
+            w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i)
+        {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+
+            const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotl(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    for (int i = 0; i < 5; ++i)
+    {
+        digest[i * 4] = static_cast<uint8_t>(h[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(h[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(h[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(h[i]);
+    }
+}
+
+std::string acceptKey(const std::string& clientKey)
+{
+    const std::string input = clientKey + HANDSHAKE_GUID;
+    uint8_t digest[20];
+    sha1(reinterpret_cast<const uint8_t*>(input.data()), input.size(), digest);
+
+    char encoded[28];
+    const size_t n = FrameCodec::base64Encode(digest, sizeof(digest), encoded);
+    return std::string(encoded, n);
+}
+
+// ============================================================================
+// HTTP request head
+// ============================================================================
+
+std::string HttpRequest::header(const std::string& lowerName) const
+{
+    auto it = headers.find(lowerName);
+    return it != headers.end() ? it->second : std::string();
+}
+
+std::string HttpRequest::param(const std::string& name) const
+{
+    auto it = query.find(name);
+    return it != query.end() ? it->second : std::string();
+}
+
+bool parseHttpRequest(const std::string& head, HttpRequest& out)
+{
+    std::istringstream in(head);
+    std::string line;
+    if (!std::getline(in, line))
+    {
+        return false;
+    }
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+
+    std::istringstream requestLine(line);
+    std::string version;
+    if (!(requestLine >> out.method >> out.target >> version) || version.rfind("HTTP/1.", 0) != 0)
+    {
+        return false;
+    }
+
+    const size_t q = out.target.find('?');
+    out.path = out.target.substr(0, q);
+    out.query.clear();
+    if (q != std::string::npos)
+    {
+        std::istringstream params(out.target.substr(q + 1));
+        std::string pair;
+        while (std::getline(params, pair, '&'))
+        {
+            if (pair.empty()) continue;
+            const size_t eq = pair.find('=');
+            out.query[urlDecode(pair.substr(0, eq))] =
+                eq == std::string::npos ? std::string() : urlDecode(pair.substr(eq + 1));
+        }
+    }
+
+    out.headers.clear();
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) break;
+
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos)
+        {
+            return false;
+        }
+        out.headers[toLower(trim(line.substr(0, colon)))] = trim(line.substr(colon + 1));
+    }
+    return true;
+}
+
+bool isUpgradeRequest(const HttpRequest& req)
+{
+    return req.method == "GET" && toLower(req.header("upgrade")) == "websocket" &&
+           toLower(req.header("connection")).find("upgrade") != std::string::npos &&
+           !req.header("sec-websocket-key").empty() && req.header("sec-websocket-version") == "13";
+}
+
+std::string handshakeResponse(const HttpRequest& req)
+{
+    return "HTTP/1.1 101 Switching Protocols\r\n"
+           "Upgrade: websocket\r\n"
+           "Connection: Upgrade\r\n"
+           "Sec-WebSocket-Accept: " +
+           acceptKey(req.header("sec-websocket-key")) + "\r\n\r\n";
+}
+
+} // namespace WebSocket
@@ -0,0 +1,245 @@
+/**
+ * @file test_bed_store.cpp
+ * @brief Unit tests and ward scaling benchmark for the per-bed sharded store
+ */
+
+#include "catch_amalgamated.hpp"
+#include "core/bed_store.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Short histories keep a full test ward small
+constexpr double TEST_HISTORY_SECONDS = 1.0;
+
+} // namespace
+
+TEST_CASE("BedStore - Shards are per bed and cache-line isolated", "[bed_store]") {
+    BedStore beds(TEST_HISTORY_SECONDS);
+    REQUIRE(beds.size() == 0);
+    REQUIRE(beds.find("1") == nullptr);
+
+    BedStore::Shard* a = beds.acquire("1");
+    BedStore::Shard* b = beds.acquire("icu-2");
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    REQUIRE(a != b);
+    REQUIRE(beds.acquire("1") == a);
+    REQUIRE(beds.find("icu-2") == b);
+    REQUIRE(beds.size() == 2);
+    REQUIRE(beds.at(0) == a);
+    REQUIRE(beds.at(1) == b);
+
+    STATIC_REQUIRE(alignof(BedStore::Shard) == BedStore::CACHE_LINE);
+    STATIC_REQUIRE(sizeof(BedStore::Shard) % BedStore::CACHE_LINE == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(a) % BedStore::CACHE_LINE == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(b) % BedStore::CACHE_LINE == 0);
+
+    a->store.setSpo2(91.0);
+    REQUIRE(a->store.getSpo2() == 91.0);
+    REQUIRE_FALSE(b->store.hasSpo2());
+}
+
+TEST_CASE("BedStore - Ids and topics", "[bed_store]") {
+    SECTION("Valid ids") {
+        for (const char* id : {"1", "12", "icu-3", "Ward_B"}) {
+            INFO(id);
+            REQUIRE(BedStore::validId(id));
+        }
+        for (const char* id : {"", "a/b", "+", "#", "bed 1", "\xc3\xa9"}) {
+            INFO(id);
+            REQUIRE_FALSE(BedStore::validId(id));
+        }
+        REQUIRE_FALSE(BedStore::validId(std::string(BedStore::MAX_ID_LENGTH + 1, 'x')));
+    }
+
+    SECTION("Bed topics are split into bed and patient topic") {
+        std::string_view id;
+        std::string_view rest;
+        REQUIRE(BedStore::splitTopic("bed/12/heart/heartRate", id, rest));
+        REQUIRE(id == "12");
+        REQUIRE(rest == "heart/heartRate");
+
+        for (const char* topic : {"heart/heartRate", "bed/12", "bed/12/", "bed//heart/map", "beds/1/heart/map",
+                                  "bed/a b/heart/map"}) {
+            INFO(topic);
+            REQUIRE_FALSE(BedStore::splitTopic(topic, id, rest));
+        }
+    }
+
+    SECTION("Invalid ids are not added") {
+        BedStore beds(TEST_HISTORY_SECONDS);
+        REQUIRE(beds.acquire("a/b") == nullptr);
+        REQUIRE(beds.size() == 0);
+    }
+}
+
+TEST_CASE("BedStore - Ward capacity", "[bed_store]") {
+    BedStore beds(TEST_HISTORY_SECONDS);
+    for (size_t i = 0; i < BedStore::MAX_BEDS; ++i) {
+        REQUIRE(beds.acquire(std::to_string(i)) != nullptr);
+    }
+    REQUIRE(beds.size() == BedStore::MAX_BEDS);
+    REQUIRE(beds.acquire("overflow") == nullptr);
+    REQUIRE(beds.acquire("0") == beds.at(0)); // Existing beds still resolve
+}
+
+TEST_CASE("BedStore - Physiology per bed", "[bed_store]") {
+    BedStore beds(TEST_HISTORY_SECONDS);
+    BedStore::Shard* bed = beds.acquire("3");
+    const uint64_t before = bed->physiologyVersion();
+    REQUIRE(bed->physiology().heartRateBpm == SignalGenerator::Physiology().heartRateBpm);
+
+    bed->updatePhysiology([](SignalGenerator::Physiology& p) { p.heartRateBpm = 140.0; });
+    REQUIRE(bed->physiology().heartRateBpm == 140.0);
+    REQUIRE(bed->physiologyVersion() == before + 1);
+    REQUIRE(beds.acquire("4")->physiology().heartRateBpm == SignalGenerator::Physiology().heartRateBpm);
+}
+
+TEST_CASE("BedStore - Bed waveforms ignore the main patient's live values", "[bed_store]") {
+    BedStore beds(TEST_HISTORY_SECONDS);
+    BedStore::Shard* bed = beds.acquire("7");
+    SignalGenerator bedGen;
+    bedGen.setStore(bed->store);
+    SignalGenerator mainGen;
+
+    SensorDataStore& main = SensorDataStore::instance();
+    main.clear();
+    main.setEcg(-3.0);
+    main.setSpo2(42.0);
+
+    SignalGenerator::SensorData block[4];
+    bedGen.generateBlock(0.0, 0.004, 4, block);
+    const SignalGenerator::SensorData sample = bedGen.generateAt(0.1);
+    REQUIRE(mainGen.generateAt(0.1).ecg == -3.0);
+    main.clear();
+
+    for (const auto& data : block) {
+        REQUIRE(data.ecg != -3.0);
+        REQUIRE(data.spo2 != 42.0);
+    }
+    REQUIRE(sample.ecg != -3.0);
+    REQUIRE(sample.spo2 != 42.0);
+
+    // The bed's own live values still apply
+    bed->store.setEcg(0.25);
+    REQUIRE(bedGen.generateAt(0.1).ecg == 0.25);
+}
+
+TEST_CASE("BedStore - Concurrent writers and bed discovery", "[bed_store]") {
+    constexpr int WRITERS = 4;
+    constexpr int BEDS_PER_WRITER = 8;
+    constexpr int UPDATES = 2000;
+    BedStore beds(TEST_HISTORY_SECONDS);
+
+    // Writers race to add overlapping beds and then write their own
+    std::vector<std::thread> writers;
+    for (int w = 0; w < WRITERS; ++w) {
+        writers.emplace_back([&beds, w] {
+            for (int i = 0; i < WRITERS * BEDS_PER_WRITER; ++i) {
+                beds.acquire(std::to_string(i));
+            }
+            for (int n = 1; n <= UPDATES; ++n) {
+                for (int i = 0; i < BEDS_PER_WRITER; ++i) {
+                    BedStore::Shard* bed = beds.find(std::to_string(w * BEDS_PER_WRITER + i));
+                    bed->store.setSpo2(n);
+                    bed->updatePhysiology([n](SignalGenerator::Physiology& p) { p.heartRateBpm = n; });
+                }
+            }
+        });
+    }
+    for (auto& t : writers) {
+        t.join();
+    }
+
+    REQUIRE(beds.size() == WRITERS * BEDS_PER_WRITER);
+    bool consistent = true;
+    for (size_t i = 0; i < beds.size(); ++i) {
+        consistent = consistent && beds.find(beds.at(i)->id) == beds.at(i);
+        consistent = consistent && beds.at(i)->store.getSpo2() == UPDATES &&
+                     beds.at(i)->physiology().heartRateBpm == UPDATES &&
+                     beds.at(i)->physiologyVersion() == static_cast<uint64_t>(UPDATES);
+    }
+    REQUIRE(consistent);
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("BedStore - Ward scaling from 1 to 64 beds", "[.benchmark][bed_store]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t MESSAGES_PER_BED = 20000;
+    constexpr double RATE_HZ = 250.0;
+    constexpr double TICK_HZ = 20.0;
+    constexpr size_t TICKS = 200;
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "\n[BENCHMARK] Ward scaling (" << cores << " hardware threads)" << std::endl;
+    for (size_t bedCount = 1; bedCount <= BedStore::MAX_BEDS; bedCount *= 2) {
+        BedStore beds(TEST_HISTORY_SECONDS);
+        std::vector<std::string> topics;
+        for (size_t i = 0; i < bedCount; ++i) {
+            topics.push_back("bed/" + std::to_string(i) + "/lung/oxygenSaturation");
+        }
+
+        // MQTT-style routing: split the topic, look the bed up, write its shard.
+        // One writer per bed up to the core count, each owning a slice of the ward.
+        const size_t writerCount = std::min(bedCount, cores);
+        auto start = Clock::now();
+        std::vector<std::thread> writers;
+        for (size_t w = 0; w < writerCount; ++w) {
+            writers.emplace_back([&, w] {
+                std::string_view id;
+                std::string_view rest;
+                for (size_t n = 0; n < MESSAGES_PER_BED; ++n) {
+                    for (size_t i = w; i < bedCount; i += writerCount) {
+                        BedStore::splitTopic(topics[i], id, rest);
+                        BedStore::Shard* bed = beds.acquire(id);
+                        bed->store.setSpo2(static_cast<double>(n));
+                        bed->updatePhysiology([n](SignalGenerator::Physiology& p) { p.spo2 = static_cast<double>(n); });
+                    }
+                }
+            });
+        }
+        for (auto& t : writers) {
+            t.join();
+        }
+        const double routeSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        const double messages = static_cast<double>(MESSAGES_PER_BED * bedCount);
+
+        // Streamer tick: every bed's waveforms for one frame, plus history
+        std::vector<std::unique_ptr<SignalGenerator>> generators;
+        for (size_t i = 0; i < bedCount; ++i) {
+            generators.push_back(std::make_unique<SignalGenerator>());
+        }
+        const size_t perTick = static_cast<size_t>(RATE_HZ / TICK_HZ);
+        std::vector<SignalGenerator::SensorData> block(perTick);
+        start = Clock::now();
+        for (size_t tick = 0; tick < TICKS; ++tick) {
+            for (size_t i = 0; i < bedCount; ++i) {
+                generators[i]->generateBlock(tick * perTick / RATE_HZ, 1.0 / RATE_HZ, perTick, block.data());
+                for (const auto& sample : block) {
+                    beds.at(i)->store.recordHistory(sample);
+                }
+            }
+        }
+        const double tickUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / TICKS;
+
+        std::cout << "  " << bedCount << " beds: " << messages / routeSeconds / 1e6 << " M msgs/s ("
+                  << writerCount << " writers), stream tick " << tickUs << " us ("
+                  << tickUs * TICK_HZ / 1e4 << "% of a core)" << std::endl;
+
+        bool written = true;
+        for (size_t i = 0; i < bedCount; ++i) {
+            written = written && beds.at(i)->store.getSpo2() == MESSAGES_PER_BED - 1;
+        }
+        REQUIRE(written);
+        REQUIRE(beds.size() == bedCount);
+    }
+}
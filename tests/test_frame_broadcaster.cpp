@@ -0,0 +1,226 @@
+/**
+ * @file test_frame_broadcaster.cpp
+ * @brief Unit tests and fan-out benchmark for the SSE frame broadcaster
+ */
+
+#include "catch_amalgamated.hpp"
+#include "server/frame_broadcaster.h"
+#include "core/signal_generator.h"
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Mirrors WebServer::generateJsonData() so the benchmark pays a realistic encode cost
+std::string encodeFrame(const SignalGenerator::SensorData& data)
+{
+    using json = nlohmann::json;
+    json sensors = {{"ecg", true}, {"spo2", true}, {"temp_core", true},
+                    {"temp_skin", true}, {"nibp", true}, {"resp", true}};
+    json j;
+    j["ecg"] = data.ecg;
+    j["spo2"] = data.spo2;
+    j["resp"] = data.resp;
+    j["pleth"] = data.pleth;
+    j["bp_systolic"] = data.bp_systolic;
+    j["bp_diastolic"] = data.bp_diastolic;
+    j["temp_cavity"] = data.temp_cavity;
+    j["temp_skin"] = data.temp_skin;
+    j["timestamp"] = data.timestamp;
+    j["sensors"] = sensors;
+    return "data: " + j.dump() + "\n\n";
+}
+
+double processCpuSeconds()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+double threadCpuSeconds()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+} // namespace
+
+TEST_CASE("FrameBroadcaster - Publish and wait", "[frame_broadcaster]") {
+    FrameBroadcaster hub;
+
+    SECTION("No frame before first publish") {
+        REQUIRE(hub.sequence() == 0);
+        REQUIRE(hub.latest() == nullptr);
+
+        uint64_t seq = 0;
+        REQUIRE(hub.waitForNext(seq, std::chrono::milliseconds(1)) == nullptr);
+    }
+
+    SECTION("Waiter receives the newest frame and its sequence") {
+        hub.publish("a");
+        uint64_t seq = hub.publish("b");
+        REQUIRE(seq == 2);
+
+        uint64_t last = 0;
+        auto frame = hub.waitForNext(last, std::chrono::milliseconds(10));
+        REQUIRE(frame != nullptr);
+        REQUIRE(*frame == "b");
+        REQUIRE(last == 2);
+
+        // Nothing newer yet
+        REQUIRE(hub.waitForNext(last, std::chrono::milliseconds(1)) == nullptr);
+    }
+
+    SECTION("All sinks share one buffer") {
+        hub.publish("frame");
+        uint64_t a = 0, b = 0;
+        auto fa = hub.waitForNext(a, std::chrono::milliseconds(10));
+        auto fb = hub.waitForNext(b, std::chrono::milliseconds(10));
+        REQUIRE(fa.get() == fb.get());
+    }
+
+    SECTION("Blocked waiter is woken by publish") {
+        uint64_t last = hub.sequence();
+        std::thread producer([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            hub.publish("late");
+        });
+        auto frame = hub.waitForNext(last, std::chrono::seconds(2));
+        producer.join();
+        REQUIRE(frame != nullptr);
+        REQUIRE(*frame == "late");
+    }
+
+    SECTION("Close wakes waiters and reopen restores delivery") {
+        uint64_t last = 0;
+        std::thread closer([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            hub.close();
+        });
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(hub.waitForNext(last, std::chrono::seconds(2)) == nullptr);
+        closer.join();
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+
+        hub.reopen();
+        hub.publish("again");
+        REQUIRE(hub.waitForNext(last, std::chrono::milliseconds(10)) != nullptr);
+    }
+}
+
+TEST_CASE("FrameBroadcaster - Subscriber accounting", "[frame_broadcaster]") {
+    FrameBroadcaster hub;
+    REQUIRE(hub.subscriberCount() == 0);
+    {
+        FrameBroadcaster::Subscription a(hub);
+        FrameBroadcaster::Subscription b(hub);
+        REQUIRE(hub.subscriberCount() == 2);
+    }
+    REQUIRE(hub.subscriberCount() == 0);
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("FrameBroadcaster - Per-tick CPU vs client count", "[.benchmark][frame_broadcaster]") {
+    constexpr int TICKS = 100;
+    constexpr auto TICK = std::chrono::milliseconds(5);
+    const std::vector<int> clientCounts = {1, 10, 50, 100, 200};
+
+    // "producer" is the encode + publish cost on the producer thread alone; the
+    // remaining hub cost is waking the thread-per-client httplib sinks.
+    std::cout << "\nclients   per-client encode (us/tick)   broadcast hub (us/tick)   producer (us/tick)\n";
+
+    for (int clients : clientCounts)
+    {
+        // --- Legacy: every sink generates and encodes its own frame ---
+        // The hub is still used as the tick signal so both variants pay the same wake-up cost.
+        double legacyUs = 0.0;
+        {
+            FrameBroadcaster ticker;
+            std::atomic<bool> stop{false};
+            std::vector<std::thread> sinks;
+            for (int i = 0; i < clients; ++i)
+            {
+                sinks.emplace_back([&] {
+                    FrameBroadcaster::Subscription sub(ticker);
+                    SignalGenerator local;
+                    uint64_t last = 0;
+                    volatile size_t bytes = 0;
+                    while (!stop)
+                    {
+                        if (ticker.waitForNext(last, std::chrono::milliseconds(50)))
+                        {
+                            bytes = bytes + encodeFrame(local.generate()).size();
+                        }
+                    }
+                });
+            }
+            while (ticker.subscriberCount() < clients) std::this_thread::yield();
+
+            const double cpu0 = processCpuSeconds();
+            for (int t = 0; t < TICKS; ++t)
+            {
+                ticker.publish(std::string());
+                std::this_thread::sleep_for(TICK);
+            }
+            const double cpu1 = processCpuSeconds();
+            stop = true;
+            ticker.close();
+            for (auto& s : sinks) s.join();
+            legacyUs = (cpu1 - cpu0) * 1e6 / TICKS;
+        }
+
+        // --- Broadcast hub: one encode per tick, sinks forward the shared buffer ---
+        double hubUs = 0.0;
+        double producerUs = 0.0;
+        {
+            SignalGenerator gen;
+            FrameBroadcaster hub;
+            std::atomic<bool> stop{false};
+            std::vector<std::thread> sinks;
+            for (int i = 0; i < clients; ++i)
+            {
+                sinks.emplace_back([&] {
+                    FrameBroadcaster::Subscription sub(hub);
+                    uint64_t last = 0;
+                    volatile size_t bytes = 0;
+                    while (!stop)
+                    {
+                        auto frame = hub.waitForNext(last, std::chrono::milliseconds(50));
+                        if (frame) bytes = bytes + frame->size();
+                    }
+                });
+            }
+            while (hub.subscriberCount() < clients) std::this_thread::yield();
+
+            const double cpu0 = processCpuSeconds();
+            double producerCpu = 0.0;
+            for (int t = 0; t < TICKS; ++t)
+            {
+                const double p0 = threadCpuSeconds();
+                hub.publish(encodeFrame(gen.generate()));
+                producerCpu += threadCpuSeconds() - p0;
+                std::this_thread::sleep_for(TICK);
+            }
+            const double cpu1 = processCpuSeconds();
+            stop = true;
+            hub.close();
+            for (auto& s : sinks) s.join();
+            hubUs = (cpu1 - cpu0) * 1e6 / TICKS;
+            producerUs = producerCpu * 1e6 / TICKS;
+        }
+
+        std::cout << std::setw(7) << clients << std::setw(30) << std::fixed << std::setprecision(1)
+                  << legacyUs << std::setw(26) << hubUs << std::setw(21) << producerUs << "\n";
+    }
+
+    SUCCEED();
+}
@@ -0,0 +1,231 @@
+/**
+ * @file test_frame_codec.cpp
+ * @brief Unit tests for the compact binary stream frame encoding
+ */
+
+#include "catch_amalgamated.hpp"
+#include "server/frame_codec.h"
+#include "hardware/i2c_protocol.h"
+#include <nlohmann/json.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+SignalGenerator::SensorData sampleFrame()
+{
+    SignalGenerator::SensorData d{};
+    d.ecg = 0.5312345678912;
+    d.spo2 = 97.81234567891;
+    d.resp = -0.412345678912;
+    d.pleth = 0.7912345678;
+    d.bp_systolic = 121.2345678912;
+    d.bp_diastolic = 80.61234567891;
+    d.temp_cavity = 37.212345678912;
+    d.temp_skin = 36.91234567891;
+    d.timestamp = 1234.567891234;
+    return d;
+}
+
+} // namespace
+
+TEST_CASE("FrameCodec - Base64", "[frame_codec]") {
+    // RFC 4648 test vectors
+    const std::string input = "foobar";
+    const std::vector<std::string> expected = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+
+    for (size_t n = 0; n <= input.size(); ++n)
+    {
+        char out[16];
+        const size_t len = FrameCodec::base64Encode(reinterpret_cast<const uint8_t*>(input.data()), n, out);
+        REQUIRE(std::string(out, len) == expected[n]);
+    }
+}
+
+TEST_CASE("FrameCodec - Binary round trip", "[frame_codec]") {
+    const auto data = sampleFrame();
+    const uint8_t sensors = SensorStatusBits::ECG | SensorStatusBits::NIBP;
+
+    uint8_t raw[FrameCodec::BINARY_FRAME_SIZE];
+    FrameCodec::encodeBinary(data, sensors, 0xA1B2C3D4u, raw);
+
+    SECTION("Header is little-endian") {
+        REQUIRE(raw[0] == FrameCodec::BINARY_FRAME_VERSION);
+        REQUIRE(raw[1] == sensors);
+        REQUIRE(raw[2] == 0xD4);
+        REQUIRE(raw[5] == 0xA1);
+    }
+
+    SECTION("Decoded values match at float32 precision") {
+        FrameCodec::BinaryFrame out;
+        REQUIRE(FrameCodec::decodeBinary(raw, sizeof(raw), out));
+        REQUIRE(out.seq == 0xA1B2C3D4u);
+        REQUIRE(out.sensors == sensors);
+        REQUIRE(out.data.timestamp == Catch::Approx(1234.568).margin(1e-9));
+        REQUIRE(out.data.ecg == Catch::Approx(data.ecg).epsilon(1e-6));
+        REQUIRE(out.data.spo2 == Catch::Approx(data.spo2).epsilon(1e-6));
+        REQUIRE(out.data.resp == Catch::Approx(data.resp).epsilon(1e-6));
+        REQUIRE(out.data.pleth == Catch::Approx(data.pleth).epsilon(1e-6));
+        REQUIRE(out.data.bp_systolic == Catch::Approx(data.bp_systolic).epsilon(1e-6));
+        REQUIRE(out.data.bp_diastolic == Catch::Approx(data.bp_diastolic).epsilon(1e-6));
+        REQUIRE(out.data.temp_cavity == Catch::Approx(data.temp_cavity).epsilon(1e-6));
+        REQUIRE(out.data.temp_skin == Catch::Approx(data.temp_skin).epsilon(1e-6));
+    }
+
+    SECTION("Truncated or unknown frames are rejected") {
+        FrameCodec::BinaryFrame out;
+        REQUIRE_FALSE(FrameCodec::decodeBinary(raw, sizeof(raw) - 1, out));
+        raw[0] = 99;
+        REQUIRE_FALSE(FrameCodec::decodeBinary(raw, sizeof(raw), out));
+    }
+}
+
+TEST_CASE("FrameCodec - SSE framing is at least 5x smaller than JSON", "[frame_codec]") {
+    using json = nlohmann::json;
+    const auto data = sampleFrame();
+
+    char sse[FrameCodec::BINARY_SSE_FRAME_SIZE];
+    const size_t n = FrameCodec::encodeBinarySse(data, 0x3F, 1, sse);
+    const std::string frame(sse, n);
+
+    REQUIRE(n == FrameCodec::BINARY_SSE_FRAME_SIZE);
+    REQUIRE(frame.rfind("data: ", 0) == 0);
+    REQUIRE(frame.substr(frame.size() - 2) == "\n\n");
+    REQUIRE(frame.find('=') == std::string::npos); // 42 bytes need no padding
+
+    // Same shape as WebServer::generateJsonData()
+    json j;
+    j["ecg"] = data.ecg;
+    j["spo2"] = data.spo2;
+    j["resp"] = data.resp;
+    j["pleth"] = data.pleth;
+    j["bp_systolic"] = data.bp_systolic;
+    j["bp_diastolic"] = data.bp_diastolic;
+    j["temp_cavity"] = data.temp_cavity;
+    j["temp_skin"] = data.temp_skin;
+    j["timestamp"] = data.timestamp;
+    j["sensors"] = {{"ecg", true}, {"spo2", true}, {"temp_core", true},
+                    {"temp_skin", true}, {"nibp", true}, {"resp", true}};
+    const size_t jsonSize = ("data: " + j.dump() + "\n\n").size();
+
+    REQUIRE(jsonSize >= 5 * n);
+}
+
+TEST_CASE("FrameCodec - Channel subset frames", "[frame_codec]") {
+    const auto data = sampleFrame();
+    const uint16_t channels = (1u << 0) | (1u << 3) | (1u << 7); // ecg, pleth, temp_skin
+
+    uint8_t raw[FrameCodec::BINARY_CHANNELS_FRAME_MAX_SIZE];
+    const size_t n = FrameCodec::encodeBinaryChannels(data, 0x05, 42, channels, raw);
+
+    SECTION("Only selected channels are encoded") {
+        REQUIRE(n == FrameCodec::BINARY_CHANNELS_HEADER_SIZE + 3 * 4);
+        REQUIRE(raw[0] == FrameCodec::BINARY_CHANNELS_FRAME_VERSION);
+        REQUIRE(raw[10] == channels);
+        REQUIRE(raw[11] == 0);
+    }
+
+    SECTION("Decoded frame carries the mask and the selected values") {
+        FrameCodec::BinaryFrame out;
+        REQUIRE(FrameCodec::decodeBinary(raw, n, out));
+        REQUIRE(out.version == FrameCodec::BINARY_CHANNELS_FRAME_VERSION);
+        REQUIRE(out.channels == channels);
+        REQUIRE(out.seq == 42);
+        REQUIRE(out.sensors == 0x05);
+        REQUIRE(out.data.timestamp == Catch::Approx(1234.568).margin(1e-9));
+        REQUIRE(out.data.ecg == Catch::Approx(data.ecg).epsilon(1e-6));
+        REQUIRE(out.data.pleth == Catch::Approx(data.pleth).epsilon(1e-6));
+        REQUIRE(out.data.temp_skin == Catch::Approx(data.temp_skin).epsilon(1e-6));
+        REQUIRE(out.data.spo2 == 0.0);
+        REQUIRE(out.data.bp_systolic == 0.0);
+    }
+
+    SECTION("Timestamp-only frame") {
+        const size_t empty = FrameCodec::encodeBinaryChannels(data, 0, 1, 0, raw);
+        FrameCodec::BinaryFrame out;
+        REQUIRE(empty == FrameCodec::BINARY_CHANNELS_HEADER_SIZE);
+        REQUIRE(FrameCodec::decodeBinary(raw, empty, out));
+        REQUIRE(out.channels == 0);
+    }
+
+    SECTION("Truncated frames and unknown channel bits are rejected") {
+        FrameCodec::BinaryFrame out;
+        REQUIRE_FALSE(FrameCodec::decodeBinary(raw, n - 1, out));
+        raw[11] = 0x01;
+        REQUIRE_FALSE(FrameCodec::decodeBinary(raw, n, out));
+    }
+
+    SECTION("Version 1 frames report every channel") {
+        uint8_t full[FrameCodec::BINARY_FRAME_SIZE];
+        FrameCodec::encodeBinary(data, 0, 1, full);
+        FrameCodec::BinaryFrame out;
+        REQUIRE(FrameCodec::decodeBinary(full, sizeof(full), out));
+        REQUIRE(out.channels == FrameCodec::ALL_CHANNELS);
+    }
+}
+
+TEST_CASE("FrameCodec - Sample run frames", "[frame_codec]") {
+    constexpr int RATE = 250;
+    std::vector<SignalGenerator::SensorData> samples(13);
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        samples[i] = sampleFrame();
+        samples[i].ecg = 0.01 * static_cast<double>(i);
+        samples[i].pleth = -0.01 * static_cast<double>(i);
+        samples[i].timestamp = (1000 + i) / static_cast<double>(RATE);
+    }
+
+    FrameCodec::SampleBlock block;
+    block.samples = samples.data();
+    block.count = samples.size();
+    block.firstIndex = 1000;
+    block.rateHz = RATE;
+
+    SECTION("Decimated slices stay aligned to the sample number") {
+        size_t first = 0;
+        REQUIRE(FrameCodec::blockSlice(block, 1, first) == 13);
+        REQUIRE(first == 0);
+        REQUIRE(FrameCodec::blockSlice(block, 3, first) == 4); // 1002, 1005, 1008, 1011
+        REQUIRE(first == 2);
+        REQUIRE(FrameCodec::blockSlice(block, 50, first) == 1); // 1000
+        REQUIRE(FrameCodec::blockSlice(block, 7, first) == 2);  // 1001, 1008
+        REQUIRE(first == 1);
+        block.firstIndex = 1001;
+        REQUIRE(FrameCodec::blockSlice(block, 50, first) == 0);
+    }
+
+    SECTION("Runs and scalars round trip") {
+        const uint16_t channels = (1u << 0) | (1u << 1) | (1u << 3); // ecg, spo2, pleth
+        const uint16_t runs = (1u << 0) | (1u << 3);
+        const uint32_t steps[8] = {1, 1, 1, 3, 1, 1, 1, 1};
+        const auto& latest = samples.back();
+
+        std::vector<uint8_t> raw;
+        FrameCodec::encodeBinaryBlock(latest, 0x01, 77, channels, block, runs, steps, raw);
+        REQUIRE(raw.size() == FrameCodec::BINARY_BLOCK_HEADER_SIZE + 2 * FrameCodec::BINARY_BLOCK_RUN_HEADER_SIZE +
+                                  (13 + 4) * 4 + 4);
+
+        FrameCodec::BinaryFrame out;
+        REQUIRE(FrameCodec::decodeBinary(raw.data(), raw.size(), out));
+        REQUIRE(out.version == FrameCodec::BINARY_BLOCK_FRAME_VERSION);
+        REQUIRE(out.seq == 77);
+        REQUIRE(out.channels == channels);
+        REQUIRE(out.blockChannels == runs);
+        REQUIRE(out.data.spo2 == Catch::Approx(latest.spo2).epsilon(1e-6));
+
+        const auto& ecg = out.runs[0];
+        REQUIRE(ecg.values.size() == 13);
+        REQUIRE(ecg.t0 == Catch::Approx(1000.0 / RATE).margin(2e-6));
+        REQUIRE(ecg.dt == Catch::Approx(1.0 / RATE).margin(1e-6));
+        REQUIRE(ecg.values[12] == Catch::Approx(0.12).epsilon(1e-6));
+
+        const auto& pleth = out.runs[3];
+        REQUIRE(pleth.values.size() == 4);
+        REQUIRE(pleth.t0 == Catch::Approx(1002.0 / RATE).margin(2e-6));
+        REQUIRE(pleth.dt == Catch::Approx(3.0 / RATE).margin(1e-6));
+        REQUIRE(pleth.values[1] == Catch::Approx(-0.05).epsilon(1e-6));
+
+        REQUIRE_FALSE(FrameCodec::decodeBinary(raw.data(), raw.size() - 1, out));
+    }
+}
@@ -0,0 +1,227 @@
+/**
+ * @file test_hub_waveforms.cpp
+ * @brief Hub FIFO waveform samples played into stream blocks and history
+ *
+ * A SensorManager on a HubEmulator drains the emulated FIFO; HubWaveforms
+ * writes the samples over SignalGenerator blocks, which are then encoded as
+ * stream frames and recorded in a history store, as the web server does.
+ */
+
+#include "catch_amalgamated.hpp"
+#include "core/SensorDataStore.h"
+#include "hardware/hub_emulator.h"
+#include "hardware/sensor_manager.h"
+#include "server/frame_codec.h"
+#include "server/hub_waveforms.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace {
+
+using Field = SensorDataStore::Field;
+using SensorData = SignalGenerator::SensorData;
+
+constexpr int STREAM_HZ = 250;
+constexpr double DT = 1.0 / STREAM_HZ;
+constexpr uint64_t ECG_PERIOD_US = 1000000 / FIFO_ECG_HZ;
+
+constexpr uint16_t bit(Field field)
+{
+    return static_cast<uint16_t>(1u << static_cast<unsigned>(field));
+}
+
+// A hub with only the ECG sensor attached
+std::unique_ptr<SensorManager> makeManager(HubEmulator*& hub)
+{
+    auto bus = std::make_unique<HubEmulator>();
+    hub = bus.get();
+    for (SensorId id : {SensorId::SPO2, SensorId::TEMP_CORE, SensorId::TEMP_SKIN, SensorId::NIBP}) {
+        hub->removeSensor(id);
+    }
+    auto mgr = std::make_unique<SensorManager>(std::make_unique<I2CDriver>(std::move(bus)));
+    REQUIRE(mgr->scanSensors() == 1);
+    return mgr;
+}
+
+// ECG sample i is stamped i * ECG_PERIOD_US on the hub clock and reads i
+void pushEcg(HubEmulator& hub, uint64_t& next, uint64_t untilUs)
+{
+    for (; next * ECG_PERIOD_US <= untilUs; ++next)
+    {
+        hub.pushFifo(SensorId::ECG, static_cast<uint32_t>(next * ECG_PERIOD_US), static_cast<float>(next));
+    }
+}
+
+void drain(SensorManager& mgr, HubEmulator& hub)
+{
+    while (hub.fifoLevel() > 0)
+    {
+        REQUIRE(mgr.pollFifo() > 0);
+    }
+}
+
+} // namespace
+
+TEST_CASE("HubWaveforms - FIFO samples reach the streamed frame and the history", "[hub_waveforms]") {
+    HubEmulator* hub = nullptr;
+    auto mgr = makeManager(hub);
+    uint64_t next = 0;
+    pushEcg(*hub, next, 300000); // 0.3 s at 500 Hz: samples 0-150
+    drain(*mgr, *hub);
+
+    SignalGenerator gen;
+    std::vector<SensorData> samples(25);
+    gen.generateBlock(1.0, DT, samples.size(), samples.data());
+    const double spo2 = samples[0].spo2;
+    const double pleth = samples[0].pleth;
+
+    HubWaveforms waveforms;
+    REQUIRE(waveforms.apply(*mgr, samples.data(), samples.size()) == bit(Field::Ecg));
+
+    // Played PLAYOUT_DELAY behind the newest sample: 250 Hz takes every other 500 Hz sample
+    const double first = 150.0 - HubWaveforms::PLAYOUT_DELAY_US / static_cast<double>(ECG_PERIOD_US);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        REQUIRE(samples[i].ecg == first + 2.0 * static_cast<double>(i));
+    }
+    REQUIRE(samples[0].spo2 == spo2);   // Other channels keep their values
+    REQUIRE(samples[0].pleth == pleth); // No pleth samples from the hub
+
+    SECTION("In a version 3 stream frame") {
+        FrameCodec::SampleBlock block;
+        block.samples = samples.data();
+        block.count = samples.size();
+        block.firstIndex = STREAM_HZ;
+        block.rateHz = STREAM_HZ;
+        const uint32_t steps[8] = {1, 1, 1, 1, 1, 1, 1, 1};
+        std::vector<uint8_t> frame;
+        FrameCodec::encodeBinaryBlock(samples.back(), 0, 1, bit(Field::Ecg), block, bit(Field::Ecg), steps, frame);
+
+        FrameCodec::BinaryFrame decoded;
+        REQUIRE(FrameCodec::decodeBinary(frame.data(), frame.size(), decoded));
+        REQUIRE(decoded.blockChannels == bit(Field::Ecg));
+        const std::vector<double>& run = decoded.runs[static_cast<size_t>(Field::Ecg)].values;
+        REQUIRE(run.size() == samples.size());
+        for (size_t i = 0; i < run.size(); ++i) {
+            REQUIRE(run[i] == first + 2.0 * static_cast<double>(i)); // Not one held value
+        }
+    }
+
+    SECTION("In the history") {
+        SensorDataStore history(10.0);
+        for (const SensorData& sample : samples) {
+            history.recordHistory(sample);
+        }
+        std::vector<TimeSample> ecg;
+        REQUIRE(history.readHistory(Field::Ecg, 1.0, 2.0, ecg) == samples.size());
+        REQUIRE(ecg.front().v == first);
+        REQUIRE(ecg.back().v == first + 2.0 * static_cast<double>(samples.size() - 1));
+    }
+}
+
+TEST_CASE("HubWaveforms - Frames play the hub stream without gaps or repeats", "[hub_waveforms]") {
+    HubEmulator* hub = nullptr;
+    auto mgr = makeManager(hub);
+    SignalGenerator gen;
+    HubWaveforms waveforms;
+    uint64_t next = 0;
+
+    // 25 Hz frames; the hub clock runs HUB_AHEAD_US ahead of stream time
+    constexpr size_t PER_FRAME = STREAM_HZ / 25;
+    constexpr uint64_t HUB_AHEAD_US = 500000;
+    std::vector<double> played;
+    std::vector<SensorData> samples(PER_FRAME);
+    for (size_t frame = 0; frame < 40; ++frame) {
+        const double t0 = static_cast<double>(frame * PER_FRAME) * DT;
+        pushEcg(*hub, next, HUB_AHEAD_US + static_cast<uint64_t>(std::llround((t0 + PER_FRAME * DT) * 1e6)));
+        drain(*mgr, *hub);
+        gen.generateBlock(t0, DT, PER_FRAME, samples.data());
+        REQUIRE(waveforms.apply(*mgr, samples.data(), PER_FRAME) == bit(Field::Ecg));
+        for (const SensorData& sample : samples) {
+            played.push_back(sample.ecg);
+        }
+    }
+
+    for (size_t i = 1; i < played.size(); ++i) {
+        REQUIRE(played[i] - played[i - 1] == 2.0);
+    }
+
+    SECTION("A hub that stops sending falls back to the synthesized waveform") {
+        const double lastPlayed = played.back();
+        size_t held = 0;
+        size_t synthesized = 0;
+        for (size_t frame = 40; frame < 50; ++frame) {
+            gen.generateBlock(static_cast<double>(frame * PER_FRAME) * DT, DT, PER_FRAME, samples.data());
+            const uint16_t written = waveforms.apply(*mgr, samples.data(), PER_FRAME);
+            held += written ? 1 : 0;
+            synthesized += written ? 0 : 1;
+        }
+        REQUIRE(held > 0);             // Buffered samples, then the last one held for a while
+        REQUIRE(synthesized > 0);      // Until the hold runs out
+        REQUIRE(lastPlayed < static_cast<double>(next));
+
+        // When the hub resumes, its samples are played again
+        pushEcg(*hub, next, HUB_AHEAD_US + static_cast<uint64_t>(std::llround(60 * PER_FRAME * DT * 1e6)));
+        drain(*mgr, *hub);
+        gen.generateBlock(static_cast<double>(50 * PER_FRAME) * DT, DT, PER_FRAME, samples.data());
+        REQUIRE(waveforms.apply(*mgr, samples.data(), PER_FRAME) == bit(Field::Ecg));
+        REQUIRE(samples.back().ecg - samples.front().ecg == 2.0 * (PER_FRAME - 1));
+    }
+}
+
+TEST_CASE("HubWaveforms - Discarded samples are not played", "[hub_waveforms]") {
+    HubEmulator* hub = nullptr;
+    auto mgr = makeManager(hub);
+    uint64_t next = 0;
+    pushEcg(*hub, next, 100000);
+    drain(*mgr, *hub);
+
+    HubWaveforms waveforms;
+    waveforms.discard(*mgr);
+    std::vector<WaveformSample> left;
+    REQUIRE(mgr->takeSamples(SensorType::ECG, left) == 0);
+
+    SensorData sample{};
+    REQUIRE(waveforms.apply(*mgr, &sample, 1) == 0);
+}
+
+TEST_CASE("HubWaveforms - Channels without an attached sensor keep their synthesized values", "[hub_waveforms]") {
+    HubEmulator* hub = nullptr;
+    auto mgr = makeManager(hub);
+    uint64_t next = 0;
+    pushEcg(*hub, next, 300000);
+    // An unattached channel in the FIFO: nothing samples it, so it reads 0
+    for (uint32_t t = 0; t <= 300000; t += 1000000 / FIFO_RESP_HZ) {
+        hub->pushFifo(SensorId::RESPIRATORY, t, 0.0f);
+        hub->pushFifo(SensorId::SPO2, t, 0.0f);
+    }
+    drain(*mgr, *hub);
+
+    SignalGenerator gen;
+    std::vector<SensorData> samples(25);
+    gen.generateBlock(1.0, DT, samples.size(), samples.data());
+    std::vector<SensorData> synthesized = samples;
+
+    HubWaveforms waveforms;
+    REQUIRE(waveforms.apply(*mgr, samples.data(), samples.size()) == bit(Field::Ecg));
+    for (size_t i = 0; i < samples.size(); ++i) {
+        REQUIRE(samples[i].resp == synthesized[i].resp);
+        REQUIRE(samples[i].pleth == synthesized[i].pleth);
+    }
+
+    SECTION("A sensor unplugged with samples still buffered") {
+        pushEcg(*hub, next, 400000);
+        drain(*mgr, *hub);
+        hub->removeSensor(SensorId::ECG);
+        REQUIRE(mgr->scanSensors() == 0);
+
+        gen.generateBlock(1.1, DT, samples.size(), samples.data());
+        synthesized = samples;
+        REQUIRE(waveforms.apply(*mgr, samples.data(), samples.size()) == 0);
+        for (size_t i = 0; i < samples.size(); ++i) {
+            REQUIRE(samples[i].ecg == synthesized[i].ecg);
+        }
+    }
+}
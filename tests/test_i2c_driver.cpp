@@ -0,0 +1,526 @@
+/**
+ * @file test_i2c_driver.cpp
+ * @brief Hub transaction tests and read-rate benchmark for I2CDriver
+ *
+ * Runs the driver against a HubEmulator that keeps real time: each byte
+ * takes as long as it would at 100 kHz, and the hub needs a moment after a
+ * command before its answer is ready.
+ */
+
+#include "catch_amalgamated.hpp"
+#include "hardware/hub_emulator.h"
+#include "hardware/i2c_driver.h"
+#include "core/sim_clock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::microseconds;
+
+const SensorId ALL_SENSORS[] = {SensorId::ECG,       SensorId::SPO2,        SensorId::TEMP_CORE,
+                                SensorId::NIBP,      SensorId::RESPIRATORY, SensorId::TEMP_SKIN};
+
+float reading(SensorId id)
+{
+    return 100.0f + static_cast<float>(id);
+}
+
+// Hub at 100 kHz answering 150 us after each command, every sensor reading reading(id)
+HubEmulator::Timing hubTiming(microseconds latency = microseconds(150))
+{
+    return HubEmulator::atClock(100000, latency);
+}
+
+// Driver on a fresh emulated hub; hub stays valid while the driver lives
+std::unique_ptr<I2CDriver> makeDriver(HubEmulator*& hub, const HubEmulator::Timing& timing = hubTiming())
+{
+    auto bus = std::make_unique<HubEmulator>(timing);
+    for (SensorId id : ALL_SENSORS)
+    {
+        bus->setSensor(id, reading(id));
+    }
+    bus->sample();
+    hub = bus.get();
+    return std::make_unique<I2CDriver>(std::move(bus));
+}
+
+} // namespace
+
+TEST_CASE("I2CDriver - Combined transactions read fresh values", "[i2c_driver]") {
+    HubEmulator* hub = nullptr;
+    auto driver = makeDriver(hub);
+    REQUIRE(driver->isOpen());
+    REQUIRE(driver->turnaround() == microseconds(0));
+
+    REQUIRE(driver->pingHub());
+    REQUIRE(driver->scanSensors() == 0x1F);
+    for (SensorId id : ALL_SENSORS) {
+        float value = 0.0f;
+        REQUIRE(driver->readSensor(id, value));
+        REQUIRE(value == reading(id));
+    }
+    uint8_t status[5] = {};
+    REQUIRE(driver->getSensorStatus(status));
+    REQUIRE(status[3] == 1);
+    REQUIRE(status[4] == 1);
+
+    // One transfer per command and no early reads
+    REQUIRE(hub->transfers() == 9);
+    REQUIRE(hub->staleReads() == 0);
+    REQUIRE(driver->transactionLatency().count() == 9);
+}
+
+TEST_CASE("I2CDriver - A sensor the hub cannot read is not a reading", "[i2c_driver]") {
+    HubEmulator* hub = nullptr;
+    auto driver = makeDriver(hub);
+    hub->removeSensor(SensorId::NIBP);
+
+    // The hub answers 0xFF bytes, which read as NaN
+    float value = 1.0f;
+    REQUIRE_FALSE(driver->readSensor(SensorId::NIBP, value));
+    REQUIRE(value == 1.0f);
+}
+
+TEST_CASE("I2CDriver - A split read that comes too early gets the previous answer", "[i2c_driver]") {
+    HubEmulator* hub = nullptr;
+    auto driver = makeDriver(hub, hubTiming(microseconds(2000)));
+    hub->setCombined(false);
+
+    // Combined transactions are not available on this adapter
+    REQUIRE_FALSE(driver->pingHub());
+
+    driver->setTurnaround(microseconds(10));
+    float ecg = 0.0f;
+    float spo2 = 0.0f;
+    // Too early for an answer: the idle 0xFF bytes are rejected, not taken as a value
+    REQUIRE_FALSE(driver->readSensor(SensorId::ECG, ecg));
+    REQUIRE_FALSE(driver->readSensor(SensorId::SPO2, spo2));
+    REQUIRE(hub->staleReads() == 2);
+
+    driver->setTurnaround(microseconds(3000));
+    REQUIRE(driver->readSensor(SensorId::SPO2, spo2));
+    REQUIRE(spo2 == reading(SensorId::SPO2));
+    REQUIRE(hub->staleReads() == 2);
+}
+
+TEST_CASE("I2CDriver - Turnaround is measured from the hub", "[i2c_driver]") {
+    const auto limit = std::chrono::milliseconds(2);
+
+    SECTION("A stretching hub needs no gap") {
+        HubEmulator* hub = nullptr;
+        auto driver = makeDriver(hub);
+        driver->setTurnaround(microseconds(5000));
+        REQUIRE(driver->measureTurnaround(limit));
+        REQUIRE(driver->turnaround() == microseconds(0));
+        REQUIRE(driver->transactionLatency().count() == 0); // Probes are not counted
+    }
+
+    SECTION("Without combined transactions the shortest safe gap is chosen") {
+        HubEmulator* hub = nullptr;
+        auto driver = makeDriver(hub, hubTiming(microseconds(700)));
+        hub->setCombined(false);
+        REQUIRE(driver->measureTurnaround(limit));
+        // Twice 800 us, the first doubling past the latency (400 if a sleep overshot)
+        REQUIRE(driver->turnaround() >= microseconds(800));
+        REQUIRE(driver->turnaround() <= microseconds(1600));
+
+        const size_t staleBefore = hub->staleReads();
+        for (SensorId id : ALL_SENSORS) {
+            float value = 0.0f;
+            REQUIRE(driver->readSensor(id, value));
+            REQUIRE(value == reading(id));
+        }
+        REQUIRE(hub->staleReads() == staleBefore);
+    }
+
+    SECTION("A hub that never stretches is not fooled by its stale buffer") {
+        HubEmulator* hub = nullptr;
+        auto driver = makeDriver(hub, hubTiming(microseconds(700)));
+        hub->setStretches(false);
+        REQUIRE(driver->measureTurnaround(limit));
+        REQUIRE(driver->turnaround() >= microseconds(800));
+        REQUIRE(driver->turnaround() <= microseconds(1600));
+    }
+
+    SECTION("A missing hub leaves the setting alone") {
+        HubEmulator* hub = nullptr;
+        auto driver = makeDriver(hub);
+        hub->setPresent(false);
+        driver->setTurnaround(microseconds(700));
+        REQUIRE_FALSE(driver->measureTurnaround(limit));
+        REQUIRE(driver->turnaround() == microseconds(700));
+        REQUIRE_FALSE(driver->deviceExists(HUB_I2C_ADDRESS));
+    }
+
+    SECTION("Mock mode has nothing to measure") {
+        I2CDriver driver(1, true);
+        REQUIRE(driver.measureTurnaround(limit));
+    }
+}
+
+TEST_CASE("I2CDriver - Low-level operations use the injected bus", "[i2c_driver]") {
+    HubEmulator* hub = nullptr;
+    auto driver = makeDriver(hub);
+    REQUIRE(driver->deviceExists(HUB_I2C_ADDRESS));
+    REQUIRE_FALSE(driver->deviceExists(0x40));
+    REQUIRE(driver->writeCommand(HUB_I2C_ADDRESS, static_cast<uint8_t>(HubCommand::READ_SENSOR), 0x02));
+    REQUIRE_FALSE(driver->writeByte(0x40, 0x00));
+
+    // Closing keeps an injected bus
+    driver->close();
+    REQUIRE(driver->isOpen());
+}
+
+TEST_CASE("I2CDriver - CRC-8 is the SMBus PEC", "[i2c_driver]") {
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    REQUIRE(crc8(check, sizeof(check)) == 0xF4);
+    REQUIRE(crc8(check, 0) == 0x00);
+    REQUIRE(readAllFrameLength(0) == 3);
+    REQUIRE(readAllFrameLength(0x3F) == READ_ALL_MAX_LENGTH);
+}
+
+TEST_CASE("I2CDriver - READ_ALL frames are checked before they are unpacked", "[i2c_driver]") {
+    // ECG and skin temperature: bits 0 and 4
+    uint8_t frame[READ_ALL_MAX_LENGTH];
+    const float ecg = 0.75f;
+    const float skin = 36.5f;
+    frame[0] = 9;
+    frame[1] = SensorStatusBits::ECG | SensorStatusBits::TEMP_SKIN;
+    std::memcpy(frame + 2, &ecg, 4);
+    std::memcpy(frame + 6, &skin, 4);
+    frame[10] = crc8(frame, 10);
+    std::fill(frame + 11, frame + READ_ALL_MAX_LENGTH, 0xFF);
+
+    I2CDriver::HubFrame parsed;
+    REQUIRE(I2CDriver::parseHubFrame(frame, 11, parsed));
+    REQUIRE(parsed.sequence == 9);
+    REQUIRE(parsed.has(SensorId::ECG));
+    REQUIRE(parsed.has(SensorId::TEMP_SKIN));
+    REQUIRE_FALSE(parsed.has(SensorId::TEMP_CORE));
+    REQUIRE(parsed.value(SensorId::ECG) == ecg);
+    REQUIRE(parsed.value(SensorId::TEMP_SKIN) == skin);
+    REQUIRE(parsed.value(SensorId::SPO2) == 0.0f);
+
+    REQUIRE(I2CDriver::parseHubFrame(frame, READ_ALL_MAX_LENGTH, parsed)); // Padding is ignored
+    REQUIRE_FALSE(I2CDriver::parseHubFrame(frame, 10, parsed));            // Truncated
+
+    for (size_t i = 0; i < 11; ++i) {
+        for (int bit = 0; bit < 8; ++bit) {
+            uint8_t damaged[READ_ALL_MAX_LENGTH];
+            std::memcpy(damaged, frame, sizeof(frame));
+            damaged[i] ^= static_cast<uint8_t>(1 << bit);
+            INFO("byte " << i << " bit " << bit);
+            REQUIRE_FALSE(I2CDriver::parseHubFrame(damaged, sizeof(damaged), parsed));
+        }
+    }
+}
+
+TEST_CASE("I2CDriver - READ_ALL returns every sensor in one transaction", "[i2c_driver]") {
+    HubEmulator* hub = nullptr;
+    auto driver = makeDriver(hub);
+
+    I2CDriver::HubFrame frame;
+    REQUIRE(driver->readAll(frame));
+    REQUIRE(hub->transfers() == 1);
+    REQUIRE(frame.present == 0x3F);
+    for (SensorId id : ALL_SENSORS) {
+        REQUIRE(frame.has(id));
+        REQUIRE(frame.value(id) == reading(id));
+    }
+
+    // The sequence moves once per hub sample, not per read
+    const uint8_t first = frame.sequence;
+    REQUIRE(driver->readAll(frame));
+    REQUIRE(frame.sequence == first);
+    hub->setSensor(SensorId::ECG, 0.5f);
+    REQUIRE(hub->sample() == static_cast<uint8_t>(first + 1));
+    REQUIRE(driver->readAll(frame));
+    REQUIRE(frame.sequence == static_cast<uint8_t>(first + 1));
+    REQUIRE(frame.value(SensorId::ECG) == 0.5f);
+    REQUIRE(driver->frameErrors() == 0);
+}
+
+TEST_CASE("I2CDriver - READ_ALL reads only as many bytes as the sensors need", "[i2c_driver]") {
+    HubEmulator* hub = nullptr;
+    auto driver = makeDriver(hub, HubEmulator::Timing{});
+    I2CDriver::HubFrame frame;
+
+    SECTION("Detached sensors shorten the next read") {
+        hub->removeSensor(SensorId::NIBP);
+        hub->removeSensor(SensorId::TEMP_CORE);
+        hub->sample();
+        REQUIRE(driver->readAll(frame)); // Full length: the mask is not known yet
+        REQUIRE_FALSE(frame.has(SensorId::NIBP));
+        REQUIRE(frame.value(SensorId::TEMP_SKIN) == reading(SensorId::TEMP_SKIN));
+
+        REQUIRE(driver->readAll(frame)); // 19 bytes
+        REQUIRE(hub->transfers() == 2);
+        REQUIRE(driver->frameErrors() == 0);
+    }
+
+    SECTION("A newly attached sensor costs one full-length retry") {
+        hub->removeSensor(SensorId::SPO2);
+        hub->sample();
+        REQUIRE(driver->readAll(frame));
+        REQUIRE_FALSE(frame.has(SensorId::SPO2));
+
+        hub->setSensor(SensorId::SPO2, 98.0f);
+        hub->sample();
+        REQUIRE(driver->readAll(frame));
+        REQUIRE(frame.value(SensorId::SPO2) == 98.0f);
+        REQUIRE(hub->transfers() == 3);
+        REQUIRE(driver->frameErrors() == 1);
+    }
+
+    SECTION("A corrupted frame is rejected") {
+        hub->corruptNextFrame();
+        REQUIRE_FALSE(driver->readAll(frame)); // Already at full length: no retry
+        REQUIRE(driver->frameErrors() == 1);
+        REQUIRE(driver->readAll(frame));
+        REQUIRE(frame.present == 0x3F);
+    }
+
+    SECTION("A missing hub fails without a frame error") {
+        hub->setPresent(false);
+        REQUIRE_FALSE(driver->readAll(frame));
+        REQUIRE(driver->frameErrors() == 0);
+    }
+}
+
+TEST_CASE("I2CDriver - Mock READ_ALL carries every sensor", "[i2c_driver]") {
+    I2CDriver driver(1, true);
+    I2CDriver::HubFrame first;
+    I2CDriver::HubFrame second;
+    REQUIRE(driver.readAll(first));
+    REQUIRE(driver.readAll(second));
+    REQUIRE(second.sequence == static_cast<uint8_t>(first.sequence + 1));
+    for (SensorId id : ALL_SENSORS) {
+        REQUIRE(first.has(id));
+    }
+    REQUIRE(first.value(SensorId::TEMP_CORE) == Catch::Approx(37.2f).margin(0.1f));
+}
+
+TEST_CASE("I2CDriver - READ_FIFO frames are checked before they are unpacked", "[i2c_driver]") {
+    // Two samples, 7 more queued on the hub
+    uint8_t frame[readFifoFrameLength(2)] = {2, 7, 0};
+    const float ecg = 0.75f;
+    const float pleth = -1.5f;
+    frame[3] = static_cast<uint8_t>(SensorId::ECG);
+    frame[4] = 0x78; frame[5] = 0x56; frame[6] = 0x34; frame[7] = 0x12;
+    std::memcpy(frame + 8, &ecg, sizeof(float));
+    frame[12] = static_cast<uint8_t>(SensorId::SPO2);
+    frame[13] = 0xFF; frame[14] = 0xFF; frame[15] = 0xFF; frame[16] = 0xFF;
+    std::memcpy(frame + 17, &pleth, sizeof(float));
+    frame[sizeof(frame) - 1] = crc8(frame, sizeof(frame) - 1);
+
+    I2CDriver::FifoBatch batch;
+    REQUIRE(I2CDriver::parseFifoFrame(frame, sizeof(frame), batch));
+    REQUIRE(batch.count == 2);
+    REQUIRE(batch.level == 7);
+    REQUIRE(batch.samples[0].channel == SensorId::ECG);
+    REQUIRE(batch.samples[0].timestampUs == 0x12345678u);
+    REQUIRE(batch.samples[0].value == ecg);
+    REQUIRE(batch.samples[1].channel == SensorId::SPO2);
+    REQUIRE(batch.samples[1].timestampUs == 0xFFFFFFFFu);
+    REQUIRE(batch.samples[1].value == pleth);
+
+    SECTION("Any flipped bit is caught") {
+        for (size_t bit = 0; bit < sizeof(frame) * 8; ++bit) {
+            uint8_t corrupt[sizeof(frame)];
+            std::memcpy(corrupt, frame, sizeof(frame));
+            corrupt[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+            REQUIRE_FALSE(I2CDriver::parseFifoFrame(corrupt, sizeof(corrupt), batch));
+        }
+    }
+
+    SECTION("Short reads, oversized counts and unknown channels are rejected") {
+        REQUIRE_FALSE(I2CDriver::parseFifoFrame(frame, sizeof(frame) - 1, batch));
+
+        uint8_t tooMany[readFifoFrameLength(0)] = {READ_FIFO_MAX_SAMPLES + 1, 0, 0};
+        tooMany[3] = crc8(tooMany, 3);
+        REQUIRE_FALSE(I2CDriver::parseFifoFrame(tooMany, sizeof(tooMany), batch));
+
+        uint8_t unknown[sizeof(frame)];
+        std::memcpy(unknown, frame, sizeof(frame));
+        unknown[3] = 0x20;
+        unknown[sizeof(unknown) - 1] = crc8(unknown, sizeof(unknown) - 1);
+        REQUIRE_FALSE(I2CDriver::parseFifoFrame(unknown, sizeof(unknown), batch));
+    }
+}
+
+TEST_CASE("I2CDriver - READ_FIFO drains the hub FIFO in order", "[i2c_driver]") {
+    HubEmulator* hub = nullptr;
+    auto driver = makeDriver(hub);
+
+    I2CDriver::FifoStatus status;
+    REQUIRE(driver->fifoLevel(status));
+    REQUIRE(status.level == 0);
+
+    for (uint32_t i = 0; i < 40; ++i) {
+        REQUIRE(hub->pushFifo(i % 2 ? SensorId::SPO2 : SensorId::ECG, 2000 * i, static_cast<float>(i)));
+    }
+    REQUIRE(driver->fifoLevel(status));
+    REQUIRE(status.level == 40);
+    REQUIRE(status.dropped == 0);
+
+    I2CDriver::FifoBatch batch;
+    const size_t transfers = hub->transfers();
+    REQUIRE(driver->readFifo(batch));
+    REQUIRE(hub->transfers() == transfers + 1);
+    REQUIRE(batch.count == READ_FIFO_MAX_SAMPLES);
+    REQUIRE(batch.level == 40 - READ_FIFO_MAX_SAMPLES);
+    REQUIRE(driver->readFifo(batch, batch.level));
+    REQUIRE(batch.count == 40 - READ_FIFO_MAX_SAMPLES);
+    REQUIRE(batch.level == 0);
+    REQUIRE(batch.samples[0].timestampUs == 2000 * READ_FIFO_MAX_SAMPLES);
+    REQUIRE(batch.samples[batch.count - 1].channel == SensorId::SPO2);
+    REQUIRE(batch.samples[batch.count - 1].value == 39.0f);
+    REQUIRE(hub->fifoLevel() == 0);
+
+    SECTION("Asking for more than is queued gets what there is") {
+        REQUIRE(hub->pushFifo(SensorId::RESPIRATORY, 1, 0.5f));
+        REQUIRE(driver->readFifo(batch, 10));
+        REQUIRE(batch.count == 1);
+        REQUIRE(batch.samples[0].channel == SensorId::RESPIRATORY);
+    }
+
+    SECTION("A full FIFO drops new samples and reports them once") {
+        for (size_t i = 0; i < HUB_FIFO_CAPACITY; ++i) {
+            REQUIRE(hub->pushFifo(SensorId::ECG, static_cast<uint32_t>(i), 0.0f));
+        }
+        REQUIRE_FALSE(hub->pushFifo(SensorId::ECG, 0, 0.0f));
+        REQUIRE_FALSE(hub->pushFifo(SensorId::ECG, 0, 0.0f));
+        REQUIRE(driver->fifoLevel(status));
+        REQUIRE(status.level == HUB_FIFO_CAPACITY);
+        REQUIRE(status.dropped == 2);
+        REQUIRE(driver->fifoLevel(status));
+        REQUIRE(status.dropped == 0);
+    }
+
+    SECTION("A corrupt answer fails, and its samples are gone") {
+        REQUIRE(hub->pushFifo(SensorId::ECG, 1, 0.5f));
+        REQUIRE(hub->pushFifo(SensorId::ECG, 2, 0.5f));
+        hub->corruptNextFrame();
+        REQUIRE_FALSE(driver->readFifo(batch, 2));
+        REQUIRE(driver->frameErrors() == 1);
+        REQUIRE(hub->fifoLevel() == 0);
+    }
+
+    SECTION("No hub, no samples") {
+        hub->setPresent(false);
+        REQUIRE_FALSE(driver->fifoLevel(status));
+        REQUIRE_FALSE(driver->readFifo(batch));
+    }
+}
+
+TEST_CASE("I2CDriver - Mock FIFO samples each waveform at its hub rate", "[i2c_driver]") {
+    auto clock = SimClock::fixedStep(0.001);
+    I2CDriver driver(1, true);
+    driver.setClock(clock);
+
+    I2CDriver::FifoStatus status;
+    REQUIRE(driver.fifoLevel(status));
+    clock->tick(100); // 100 ms
+    REQUIRE(driver.fifoLevel(status));
+    REQUIRE(status.level == 51 + 11 + 3); // Each channel's first sample is due at 0
+
+    size_t counts[READ_ALL_SENSOR_COUNT] = {};
+    uint32_t previous = 0;
+    I2CDriver::FifoBatch batch;
+    do {
+        REQUIRE(driver.readFifo(batch));
+        for (size_t i = 0; i < batch.count; ++i) {
+            REQUIRE(batch.samples[i].timestampUs >= previous);
+            previous = batch.samples[i].timestampUs;
+            ++counts[static_cast<size_t>(batch.samples[i].channel)];
+        }
+    } while (batch.level > 0);
+    REQUIRE(counts[static_cast<size_t>(SensorId::ECG)] == 51);
+    REQUIRE(counts[static_cast<size_t>(SensorId::SPO2)] == 11);
+    REQUIRE(counts[static_cast<size_t>(SensorId::RESPIRATORY)] == 3);
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("I2CDriver - Sensor sweep rate by turnaround strategy", "[.benchmark][i2c_driver]") {
+    auto sweeps = [](I2CDriver& driver, int count) {
+        const auto start = Clock::now();
+        for (int i = 0; i < count; ++i) {
+            for (SensorId id : ALL_SENSORS) {
+                float value = 0.0f;
+                REQUIRE(driver.readSensor(id, value));
+                REQUIRE(value == reading(id));
+            }
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return count * std::size(ALL_SENSORS) / seconds;
+    };
+
+    // Before: 2 ms before each of the write and the read, 10 ms in between
+    HubEmulator* fixedHub = nullptr;
+    auto fixed = makeDriver(fixedHub);
+    fixedHub->setCombined(false);
+    fixed->setTurnaround(std::chrono::milliseconds(14));
+    const double fixedRate = sweeps(*fixed, 5);
+
+    HubEmulator* splitHub = nullptr;
+    auto split = makeDriver(splitHub);
+    splitHub->setCombined(false);
+    REQUIRE(split->measureTurnaround());
+    const size_t staleProbes = splitHub->staleReads();
+    const double splitRate = sweeps(*split, 200);
+
+    HubEmulator* combinedHub = nullptr;
+    auto combined = makeDriver(combinedHub);
+    REQUIRE(combined->measureTurnaround());
+    const double combinedRate = sweeps(*combined, 200);
+    const LatencyHistogram::Summary latency = combined->transactionLatency().summary();
+
+    std::cout << "\n[BENCHMARK] Hub reads at 100 kHz, 150 us hub latency:"
+              << "\n[BENCHMARK]   fixed 14 ms sleeps:  " << fixedRate << " reads/s"
+              << "\n[BENCHMARK]   measured split (" << split->turnaround().count() << " us): " << splitRate
+              << " reads/s (" << splitRate / fixedRate << "x)"
+              << "\n[BENCHMARK]   combined I2C_RDWR:   " << combinedRate << " reads/s (" << combinedRate / fixedRate
+              << "x), p50 " << latency.p50Us << " us, p99 " << latency.p99Us << " us" << std::endl;
+
+    REQUIRE(combinedRate > fixedRate);
+    REQUIRE(splitHub->staleReads() == staleProbes);
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("I2CDriver - Six channels by READ_SENSOR and by READ_ALL", "[.benchmark][i2c_driver]") {
+    constexpr int SWEEPS = 300;
+    auto rate = [](uint32_t clockHz, bool bulk) {
+        HubEmulator* hub = nullptr;
+        auto driver = makeDriver(hub, HubEmulator::atClock(clockHz, microseconds(150)));
+        const auto start = Clock::now();
+        for (int i = 0; i < SWEEPS; ++i) {
+            if (bulk) {
+                I2CDriver::HubFrame frame;
+                REQUIRE(driver->readAll(frame));
+                REQUIRE(frame.value(SensorId::TEMP_SKIN) == reading(SensorId::TEMP_SKIN));
+                continue;
+            }
+            for (SensorId id : ALL_SENSORS) {
+                float value = 0.0f;
+                REQUIRE(driver->readSensor(id, value));
+            }
+        }
+        return SWEEPS / std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    std::cout << "\n[BENCHMARK] Six-channel sweeps/s (150 us hub latency):";
+    for (uint32_t clockHz : {100000u, 400000u}) {
+        const double single = rate(clockHz, false);
+        const double bulk = rate(clockHz, true);
+        std::cout << "\n[BENCHMARK]   " << clockHz / 1000 << " kHz: 6x READ_SENSOR " << single << ", READ_ALL " << bulk
+                  << " (" << bulk / single << "x)";
+        REQUIRE(bulk > single);
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,296 @@
+/**
+ * @file test_i2c_executor.cpp
+ * @brief Ordering, batching and threading tests for the I2C command queue
+ *
+ * Runs an I2CExecutor on a HubEmulator. Tests that check ordering or
+ * batching first hold the executor thread in a call(), queue their commands
+ * behind it, and then let it go.
+ */
+
+#include "catch_amalgamated.hpp"
+#include "hardware/hub_emulator.h"
+#include "hardware/i2c_executor.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Priority = I2CExecutor::Priority;
+
+const SensorId ALL_SENSORS[] = {SensorId::ECG,       SensorId::SPO2,        SensorId::TEMP_CORE,
+                                SensorId::NIBP,      SensorId::RESPIRATORY, SensorId::TEMP_SKIN};
+
+float reading(SensorId id)
+{
+    return 200.0f + static_cast<float>(id);
+}
+
+// Executor on a fresh emulated hub; hub stays valid while the executor lives
+std::unique_ptr<I2CExecutor> makeExecutor(HubEmulator*& hub, const HubEmulator::Timing& timing = {})
+{
+    auto bus = std::make_unique<HubEmulator>(timing);
+    for (SensorId id : ALL_SENSORS)
+    {
+        bus->setSensor(id, reading(id));
+    }
+    bus->sample();
+    hub = bus.get();
+    return std::make_unique<I2CExecutor>(std::make_unique<I2CDriver>(std::move(bus)));
+}
+
+// Holds the executor thread until release()
+class Hold
+{
+public:
+    explicit Hold(I2CExecutor& executor)
+        : released_(gate_.get_future().share())
+    {
+        std::promise<void> started;
+        std::future<void> running = started.get_future();
+        executor.call([this, &started](I2CDriver&) {
+            started.set_value();
+            released_.wait();
+        });
+        running.wait();
+    }
+
+    void release() { gate_.set_value(); }
+
+private:
+    std::promise<void> gate_;
+    std::shared_future<void> released_;
+};
+
+} // namespace
+
+TEST_CASE("I2CExecutor - Commands answer through futures", "[i2c_executor]") {
+    HubEmulator* hub = nullptr;
+    auto executor = makeExecutor(hub);
+    hub->removeSensor(SensorId::NIBP);
+    hub->sample();
+    hub->pushFifo(SensorId::ECG, 1000, 0.5f);
+
+    REQUIRE(executor->ping().get());
+    REQUIRE(executor->scan().get() == static_cast<uint8_t>(hub->presence() & ~SensorStatusBits::RESPIRATORY));
+
+    const I2CExecutor::Reading temp = executor->read(SensorId::TEMP_CORE).get();
+    REQUIRE(temp.ok);
+    REQUIRE(temp.value == reading(SensorId::TEMP_CORE));
+    REQUIRE_FALSE(executor->read(SensorId::NIBP).get().ok); // The hub's 0xFF error bytes
+
+    const I2CExecutor::Frame frame = executor->readAll().get();
+    REQUIRE(frame.ok);
+    REQUIRE(frame.frame.value(SensorId::SPO2) == reading(SensorId::SPO2));
+    REQUIRE_FALSE(frame.frame.has(SensorId::NIBP));
+
+    const I2CExecutor::FifoLevel level = executor->fifoLevel().get();
+    REQUIRE(level.ok);
+    REQUIRE(level.status.level == 1);
+    const I2CExecutor::Fifo fifo = executor->readFifo(level.status.level).get();
+    REQUIRE(fifo.ok);
+    REQUIRE(fifo.batch.count == 1);
+    REQUIRE(fifo.batch.samples[0].value == 0.5f);
+
+    REQUIRE(executor->call([](I2CDriver& driver) { return driver.isOpen(); }).get());
+    REQUIRE(executor->transactions() == 7);
+    REQUIRE(executor->pending() == 0);
+
+    SECTION("No hub: every command reports failure") {
+        hub->setPresent(false);
+        REQUIRE_FALSE(executor->ping().get());
+        REQUIRE(executor->scan().get() == 0xFF);
+        REQUIRE_FALSE(executor->read(SensorId::ECG).get().ok);
+        REQUIRE_FALSE(executor->readAll().get().ok);
+        REQUIRE_FALSE(executor->fifoLevel().get().ok);
+    }
+}
+
+TEST_CASE("I2CExecutor - Higher priorities run first", "[i2c_executor]") {
+    HubEmulator* hub = nullptr;
+    auto executor = makeExecutor(hub);
+    std::vector<std::string> order; // Only touched on the executor thread until the futures are ready
+
+    Hold hold(*executor);
+    executor->scan([&](uint8_t) { order.push_back("scan"); }, Priority::Scan);
+    executor->ping([&](bool) { order.push_back("ping"); }, Priority::Reading);
+    executor->read(SensorId::ECG, [&](const I2CExecutor::Reading&) { order.push_back("ecg"); }, Priority::Waveform);
+    std::future<void> housekeeping = executor->call([&](I2CDriver&) { order.push_back("call"); });
+    std::future<I2CExecutor::FifoLevel> level = executor->fifoLevel();
+    REQUIRE(executor->pending() == 5);
+    hold.release();
+
+    REQUIRE(level.get().ok);
+    housekeeping.get();
+    // The Waveform FIFO query was queued last but runs right after the other Waveform command
+    REQUIRE(order == std::vector<std::string>{"ecg", "ping", "scan", "call"});
+    REQUIRE(executor->pending() == 0);
+}
+
+TEST_CASE("I2CExecutor - Queued commands share transactions", "[i2c_executor]") {
+    HubEmulator* hub = nullptr;
+    auto executor = makeExecutor(hub);
+
+    Hold hold(*executor);
+    std::vector<std::future<I2CExecutor::Reading>> reads;
+    for (SensorId id : ALL_SENSORS) {
+        reads.push_back(executor->read(id, Priority::Reading));
+    }
+    reads.push_back(executor->read(SensorId::ECG, Priority::Scan)); // Rides along from a lower priority
+    std::future<I2CExecutor::Frame> frame = executor->readAll();
+    std::vector<std::future<uint8_t>> scans;
+    for (int i = 0; i < 3; ++i) {
+        scans.push_back(executor->scan());
+    }
+    std::future<bool> ping1 = executor->ping();
+    std::future<bool> ping2 = executor->ping();
+    const size_t transfers = hub->transfers();
+    hold.release();
+
+    for (size_t i = 0; i < reads.size(); ++i) {
+        const I2CExecutor::Reading result = reads[i].get();
+        REQUIRE(result.ok);
+        REQUIRE(result.value == reading(i < std::size(ALL_SENSORS) ? ALL_SENSORS[i] : SensorId::ECG));
+    }
+    REQUIRE(frame.get().frame.value(SensorId::TEMP_SKIN) == reading(SensorId::TEMP_SKIN));
+    for (auto& scan : scans) {
+        REQUIRE(scan.get() == 0x1F);
+    }
+    REQUIRE(ping1.get());
+    REQUIRE(ping2.get());
+
+    // One READ_ALL, one SCAN and one PING for 13 commands
+    REQUIRE(executor->transactions() == 3);
+    REQUIRE(executor->batched() == 10);
+    REQUIRE(hub->transfers() == transfers + 3);
+
+    SECTION("A lone read is a READ_SENSOR") {
+        const size_t before = hub->transfers();
+        REQUIRE(executor->read(SensorId::SPO2).get().value == reading(SensorId::SPO2));
+        REQUIRE(hub->transfers() == before + 1);
+        REQUIRE(executor->batched() == 10);
+    }
+}
+
+TEST_CASE("I2CExecutor - Many threads share one bus", "[i2c_executor]") {
+    HubEmulator* hub = nullptr;
+    auto executor = makeExecutor(hub, HubEmulator::atClock(400000, std::chrono::microseconds(50)));
+    constexpr int THREADS = 4;
+    constexpr int READS = 100;
+
+    std::vector<std::thread> threads;
+    std::vector<int> wrong(THREADS, 0);
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            const SensorId id = ALL_SENSORS[t];
+            for (int i = 0; i < READS; ++i) {
+                const I2CExecutor::Reading result = executor->read(id).get();
+                if (!result.ok || result.value != reading(id)) {
+                    ++wrong[t];
+                }
+                if (i % 25 == 0) {
+                    executor->scan([](uint8_t) {});
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    executor->call([](I2CDriver&) {}).wait(); // Drain the scans
+
+    REQUIRE(wrong == std::vector<int>(THREADS, 0));
+    REQUIRE(executor->transactions() + executor->batched() == THREADS * READS + THREADS * READS / 25);
+    REQUIRE(hub->staleReads() == 0);
+}
+
+TEST_CASE("I2CExecutor - Commands queued at destruction still run", "[i2c_executor]") {
+    HubEmulator* hub = nullptr;
+    auto executor = makeExecutor(hub);
+    std::future<I2CExecutor::Reading> read;
+    std::future<uint8_t> scan;
+    {
+        Hold hold(*executor);
+        read = executor->read(SensorId::NIBP);
+        scan = executor->scan();
+        hold.release();
+        executor.reset();
+    }
+    REQUIRE(read.get().value == reading(SensorId::NIBP));
+    REQUIRE(scan.get() == 0x1F);
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("I2CExecutor - Six readers with a shared lock and through the queue", "[.benchmark][i2c_executor]") {
+    constexpr int READS = 100;
+    const HubEmulator::Timing timing = HubEmulator::atClock(100000, std::chrono::microseconds(150));
+    std::atomic<int> failures{0};
+
+    // Each thread reads its own sensor; the bus is serialized by a mutex
+    auto locked = [&]() {
+        auto bus = std::make_unique<HubEmulator>(timing);
+        for (SensorId id : ALL_SENSORS) {
+            bus->setSensor(id, reading(id));
+        }
+        bus->sample();
+        I2CDriver driver(std::move(bus));
+        std::mutex busMutex;
+        std::vector<std::thread> threads;
+        const auto start = Clock::now();
+        for (SensorId id : ALL_SENSORS) {
+            threads.emplace_back([&, id]() {
+                for (int i = 0; i < READS; ++i) {
+                    float value = 0.0f;
+                    std::lock_guard<std::mutex> lock(busMutex);
+                    if (!driver.readSensor(id, value)) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        return std::size(ALL_SENSORS) * READS / std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    auto queued = [&](uint64_t& transactions) {
+        HubEmulator* hub = nullptr;
+        auto executor = makeExecutor(hub, timing);
+        std::vector<std::thread> threads;
+        const auto start = Clock::now();
+        for (SensorId id : ALL_SENSORS) {
+            threads.emplace_back([&, id]() {
+                for (int i = 0; i < READS; ++i) {
+                    if (!executor->read(id).get().ok) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        transactions = executor->transactions();
+        return std::size(ALL_SENSORS) * READS / std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    const double lockedRate = locked();
+    uint64_t transactions = 0;
+    const double queuedRate = queued(transactions);
+    std::cout << "\n[BENCHMARK] Six threads reading one sensor each at 100 kHz:"
+              << "\n[BENCHMARK]   mutex around READ_SENSOR: " << lockedRate << " reads/s"
+              << "\n[BENCHMARK]   I2CExecutor:              " << queuedRate << " reads/s (" << queuedRate / lockedRate
+              << "x), " << transactions << " transactions for " << std::size(ALL_SENSORS) * READS << " reads"
+              << std::endl;
+    REQUIRE(failures == 0);
+    REQUIRE(queuedRate > lockedRate);
+}
@@ -0,0 +1,112 @@
+/**
+ * @file test_latency_histogram.cpp
+ * @brief Unit tests and recording benchmark for the lock-free latency histogram
+ */
+
+#include "catch_amalgamated.hpp"
+#include "core/latency_histogram.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using std::chrono::microseconds;
+
+TEST_CASE("LatencyHistogram - Empty and exact small values", "[latency_histogram]") {
+    LatencyHistogram h;
+    REQUIRE(h.count() == 0);
+    REQUIRE(h.percentileUs(0.5) == 0.0);
+    REQUIRE(h.summary().count == 0);
+
+    for (int us = 0; us < 8; ++us) {
+        h.record(microseconds(us));
+    }
+    h.record(std::chrono::nanoseconds(-5)); // Clock skew counts as zero
+
+    const LatencyHistogram::Summary s = h.summary();
+    REQUIRE(s.count == 9);
+    REQUIRE(s.maxUs == 7.0);
+    REQUIRE(h.percentileUs(0.5) == 3.0);
+    REQUIRE(h.percentileUs(1.0) == 7.0);
+    REQUIRE(s.meanUs == Catch::Approx(28.0 / 9.0));
+
+    h.reset();
+    REQUIRE(h.count() == 0);
+    REQUIRE(h.summary().maxUs == 0.0);
+}
+
+TEST_CASE("LatencyHistogram - Percentiles within bucket resolution", "[latency_histogram]") {
+    LatencyHistogram h;
+    std::mt19937 rng(7);
+    std::lognormal_distribution<double> latency(std::log(2000.0), 1.0); // ~2 ms median, long tail
+
+    std::vector<uint64_t> samples;
+    for (int i = 0; i < 100000; ++i) {
+        const auto us = static_cast<uint64_t>(latency(rng));
+        samples.push_back(us);
+        h.record(microseconds(us));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    for (double q : {0.5, 0.9, 0.99, 0.999}) {
+        INFO("q = " << q);
+        const auto exact = static_cast<double>(samples[static_cast<size_t>(std::ceil(q * samples.size())) - 1]);
+        const double reported = h.percentileUs(q);
+        REQUIRE(reported >= exact);          // Bucket upper edges never under-report
+        REQUIRE(reported <= exact * 1.125);  // ... and are at most one sub-bucket high
+    }
+    REQUIRE(h.summary().maxUs == static_cast<double>(samples.back()));
+
+    // Beyond the last bucket still counts
+    h.record(std::chrono::hours(24 * 365));
+    REQUIRE(h.count() == samples.size() + 1);
+}
+
+TEST_CASE("LatencyHistogram - Concurrent recording loses nothing", "[latency_histogram]") {
+    LatencyHistogram h;
+    constexpr int THREADS = 4;
+    constexpr int PER_THREAD = 50000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&h, t] {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                h.record(microseconds(100 * (t + 1)));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    const LatencyHistogram::Summary s = h.summary();
+    REQUIRE(s.count == THREADS * PER_THREAD);
+    REQUIRE(s.maxUs == 400.0);
+    REQUIRE(s.meanUs == Catch::Approx(250.0));
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("LatencyHistogram - Recording cost", "[.benchmark][latency_histogram]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr int SAMPLES = 10000000;
+    LatencyHistogram h;
+
+    const auto start = Clock::now();
+    for (int i = 0; i < SAMPLES; ++i) {
+        h.record(microseconds(i & 0xFFFF));
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    const auto summaryStart = Clock::now();
+    const LatencyHistogram::Summary s = h.summary();
+    const double summaryUs = std::chrono::duration<double, std::micro>(Clock::now() - summaryStart).count();
+
+    std::cout << "\n[BENCHMARK] LatencyHistogram: record " << seconds * 1e9 / SAMPLES << " ns, summary "
+              << summaryUs << " us (p99 " << s.p99Us << " us)" << std::endl;
+
+    REQUIRE(s.count == static_cast<uint64_t>(SAMPLES));
+}
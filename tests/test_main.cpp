@@ -6,6 +6,25 @@
  * Tests are organized in separate files:
  *   - test_signal_generator.cpp - ECG/SpO2 waveform generation tests
  *   - test_sensor_manager.cpp - Sensor lifecycle tests
+ *   - test_frame_broadcaster.cpp - SSE frame fan-out tests
+ *   - test_sensor_data_store.cpp - Seqlock data store tests
+ *   - test_time_series_ring.cpp - History ring buffer tests
+ *   - test_frame_codec.cpp - Binary stream frame encoding tests
+ *   - test_websocket.cpp - WebSocket protocol and stream server tests
+ *   - test_stream_subscription.cpp - Stream channel subscription tests
+ *   - test_waveform_template.cpp - Beat template table tests
+ *   - test_sim_clock.cpp - Simulation clock tests
+ *   - test_bed_store.cpp - Per-bed sharded store tests
+ *   - test_mqtt_driver.cpp - MQTT topic dispatch and ingestion tests
+ *   - test_mqtt_payload.cpp - MQTT payload parser tests
+ *   - test_latency_histogram.cpp - Latency histogram tests
+ *   - test_mqtt_stats.cpp - MQTT ingestion counter tests
+ *   - test_mqtt_log.cpp - MQTT record and replay tests
+ *   - test_i2c_driver.cpp - I2C hub transaction tests
+ *   - test_i2c_executor.cpp - I2C command queue tests
+ *   - test_hub_waveforms.cpp - Hub FIFO waveforms in the stream
+ *
+ * Benchmarks are hidden from the default run; use: curecraft_tests "[benchmark]"
  */
 
 #define CATCH_CONFIG_MAIN
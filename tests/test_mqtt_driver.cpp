@@ -0,0 +1,528 @@
+/**
+ * @file test_mqtt_driver.cpp
+ * @brief Unit tests and ingestion benchmark for MQTT topic dispatch
+ *
+ * Messages are fed through MQTTDriver::ingest(), the path the broker callback
+ * takes, so no broker is needed.
+ */
+
+#include "catch_amalgamated.hpp"
+#include "core/MQTTDriver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using PatientData = MQTTDriver::PatientData;
+
+struct TopicField
+{
+    const char* topic;
+    float PatientData::*value;
+    bool PatientData::*present;
+};
+
+// Every subscribed per-patient topic and the field it fills
+const std::vector<TopicField>& topicFields()
+{
+    static const std::vector<TopicField> fields = {
+        {"heart/heartRate", &PatientData::heartRate, &PatientData::has_heartRate},
+        {"heart/systolicBP", &PatientData::systolicBP, &PatientData::has_systolicBP},
+        {"heart/diastolicBP", &PatientData::diastolicBP, &PatientData::has_diastolicBP},
+        {"heart/strokeVolume", &PatientData::strokeVolume, &PatientData::has_strokeVolume},
+        {"heart/contractility", &PatientData::contractility, &PatientData::has_contractility},
+        {"heart/cardiacOutput", &PatientData::cardiacOutput, &PatientData::has_cardiacOutput},
+        {"heart/map", &PatientData::meanArterialPressure, &PatientData::has_meanArterialPressure},
+        {"heart/prefactor", &PatientData::preFactor, &PatientData::has_preFactor},
+        {"heart/rhytm", &PatientData::rhythm, &PatientData::has_rhythm},
+        {"lung/oxygenSaturation", &PatientData::oxygenSaturation, &PatientData::has_oxygenSaturation},
+        {"lung/respiratoryRate", &PatientData::respiratoryRate, &PatientData::has_respiratoryRate},
+        {"lung/airwayObstruction", &PatientData::airwayObstruction, &PatientData::has_airwayObstruction},
+        {"conditions/septic", &PatientData::septic, &PatientData::has_septic},
+        {"conditions/anaphylaxis", &PatientData::anaphylaxis, &PatientData::has_anaphylaxis},
+        {"conditions/diabetesHypo", &PatientData::diabetesHypo, &PatientData::has_diabetesHypo},
+        {"conditions/diabetsKeto", &PatientData::diabetesKeto, &PatientData::has_diabetesKeto},
+        {"conditions/cardiacArrest", &PatientData::cardiacArrest, &PatientData::has_cardiacArrest},
+    };
+    return fields;
+}
+
+void send(MQTTDriver& mqtt, const std::string& topic, const char* payload)
+{
+    mqtt.ingest(topic, payload, static_cast<int>(std::strlen(payload)));
+}
+
+// Packed vitals record: little-endian mask, then one float per set bit
+std::string packVitals(const std::vector<std::pair<size_t, float>>& fields)
+{
+    uint32_t mask = 0;
+    for (const auto& f : fields) mask |= 1u << f.first;
+    std::string record(reinterpret_cast<const char*>(&mask), 4); // Little-endian hosts only
+    for (size_t bit = 0; bit < 32; ++bit) {
+        for (const auto& f : fields) {
+            if (f.first == bit) record.append(reinterpret_cast<const char*>(&f.second), 4);
+        }
+    }
+    return record;
+}
+
+} // namespace
+
+TEST_CASE("MQTTDriver - Every topic reaches its field", "[mqtt_driver]") {
+    SensorDataStore store(1.0);
+    MQTTDriver mqtt(store);
+
+    float value = 1.0f;
+    for (const auto& f : topicFields()) {
+        INFO(f.topic);
+        const bool condition = std::strncmp(f.topic, "conditions/", 11) == 0;
+        const float expected = condition ? 1.0f : value;
+        send(mqtt, f.topic, condition ? "true" : std::to_string(value).c_str());
+
+        const PatientData p = mqtt.getPatientDataSnapshot();
+        REQUIRE(p.*f.present);
+        REQUIRE(p.*f.value == Catch::Approx(expected));
+        value += 1.0f;
+    }
+
+    // Vitals that are samples also reach the store
+    REQUIRE(store.getSpo2() == Catch::Approx(10.0));
+    REQUIRE(store.getBpSystolic() == Catch::Approx(2.0));
+    REQUIRE(store.getBpDiastolic() == Catch::Approx(3.0));
+    REQUIRE(store.hasPleth());
+
+    // ... and the rates reach the physiology
+    const SignalGenerator::Physiology phys = mqtt.physiology();
+    REQUIRE(phys.heartRateBpm == Catch::Approx(1.0));
+    REQUIRE(phys.respRateBpm == Catch::Approx(11.0));
+}
+
+TEST_CASE("MQTTDriver - Unknown topics and bad payloads are ignored", "[mqtt_driver]") {
+    SensorDataStore store(1.0);
+    MQTTDriver mqtt(store);
+    int updates = 0;
+    mqtt.setUpdateCallback([&](std::string_view, float) { ++updates; });
+
+    for (const char* topic : {"heart/heartrate", "heart/heartRate/x", "heart/", "", "xheart/heartRate",
+                              "heart/heartRat", "conditions/diabetesKeto", "bed/1/heart/heartRate"}) {
+        INFO(topic);
+        send(mqtt, topic, "80");
+    }
+    send(mqtt, "heart/heartRate", "fast");
+    send(mqtt, "heart/heartRate", "");
+    REQUIRE(updates == 0);
+    REQUIRE_FALSE(mqtt.getPatientDataSnapshot().has_heartRate);
+
+    send(mqtt, "heart/heartRate", " 72 ");
+    REQUIRE(updates == 1);
+    REQUIRE(mqtt.getPatientDataSnapshot().heartRate == Catch::Approx(72.0));
+}
+
+TEST_CASE("MQTTDriver - Bed topics go to the bed's shard", "[mqtt_driver]") {
+    SensorDataStore store(1.0);
+    BedStore beds(1.0);
+    MQTTDriver mqtt(store);
+    mqtt.setBedStore(&beds);
+    std::string lastTopic;
+    mqtt.setUpdateCallback([&](std::string_view topic, float) { lastTopic = std::string(topic); });
+
+    send(mqtt, "bed/7/heart/heartRate", "130");
+    send(mqtt, "bed/7/lung/oxygenSaturation", "88");
+    send(mqtt, "bed/9/conditions/septic", "yes");
+    send(mqtt, "bed/9/heart/unknown", "1"); // Unknown topics do not add beds
+
+    REQUIRE(lastTopic == "bed/9/conditions/septic");
+    REQUIRE(beds.size() == 2);
+    const BedStore::Shard* bed = beds.find("7");
+    REQUIRE(bed != nullptr);
+    REQUIRE(bed->physiology().heartRateBpm == Catch::Approx(130.0));
+    REQUIRE(bed->physiology().spo2 == Catch::Approx(88.0));
+    REQUIRE(bed->store.getSpo2() == Catch::Approx(88.0));
+
+    // The monitor's own patient is untouched
+    REQUIRE_FALSE(mqtt.getPatientDataSnapshot().has_heartRate);
+    REQUIRE_FALSE(store.hasSpo2());
+}
+
+TEST_CASE("MQTTDriver - Binary payloads on configured topics", "[mqtt_driver]") {
+    SensorDataStore store(1.0);
+    BedStore beds(1.0);
+    MQTTDriver mqtt(store);
+    mqtt.setBedStore(&beds);
+
+    REQUIRE(mqtt.setPayloadFormat("heart/heartRate", MqttPayload::Format::Float32));
+    REQUIRE(mqtt.setPayloadFormat("lung/oxygenSaturation", MqttPayload::Format::MessagePack));
+    REQUIRE(mqtt.setPayloadFormat("conditions/septic", MqttPayload::Format::Cbor));
+    REQUIRE_FALSE(mqtt.setPayloadFormat("heart/unknown", MqttPayload::Format::Cbor));
+
+    const float rate = 88.5f;
+    char raw[4];
+    std::memcpy(raw, &rate, sizeof(raw)); // Little-endian hosts only, like the hub
+    mqtt.ingest("heart/heartRate", raw, 4);
+    mqtt.ingest("bed/3/heart/heartRate", raw, 4);
+    const char spo2[] = {static_cast<char>(0xCC), 97}; // MessagePack uint8
+    mqtt.ingest("lung/oxygenSaturation", spo2, 2);
+    const char yes[] = {static_cast<char>(0xF5)}; // CBOR true
+    mqtt.ingest("conditions/septic", yes, 1);
+
+    PatientData p = mqtt.getPatientDataSnapshot();
+    REQUIRE(p.heartRate == 88.5f);
+    REQUIRE(p.oxygenSaturation == 97.0f);
+    REQUIRE(p.septic == 1.0f);
+    REQUIRE(beds.find("3")->physiology().heartRateBpm == Catch::Approx(88.5));
+
+    // Configured topics no longer take text; the others still do
+    send(mqtt, "heart/heartRate", "60");
+    send(mqtt, "heart/systolicBP", "120");
+    p = mqtt.getPatientDataSnapshot();
+    REQUIRE(p.heartRate == 88.5f);
+    REQUIRE(p.systolicBP == 120.0f);
+}
+
+TEST_CASE("MQTTDriver - A batch is published once with the latest values", "[mqtt_driver]") {
+    SensorDataStore store(1.0);
+    BedStore beds(1.0);
+    MQTTDriver mqtt(store);
+    mqtt.setBedStore(&beds);
+
+    std::vector<std::pair<std::string, float>> updates;
+    mqtt.setUpdateCallback([&](std::string_view topic, float value) {
+        // Everything in the batch is already visible
+        if (topic == "heart/heartRate") REQUIRE(mqtt.getPatientDataSnapshot().heartRate == value);
+        updates.emplace_back(std::string(topic), value);
+    });
+    std::vector<MQTTDriver::BatchInfo> batches;
+    mqtt.setBatchCallback([&](const MQTTDriver::BatchInfo& batch) { batches.push_back(batch); });
+
+    const auto before = std::chrono::steady_clock::now();
+    const MQTTDriver::Message messages[] = {
+        {"heart/heartRate", "70", 2},
+        {"lung/oxygenSaturation", "95", 2},
+        {"bed/1/lung/oxygenSaturation", "90", 2},
+        {"heart/heartRate", "80", 2},
+        {"heart/systolicBP", "120", 3},
+        {"heart/unknown", "1", 1},
+        {"bed/1/heart/heartRate", "100", 3},
+    };
+    mqtt.ingestBatch(messages, std::size(messages));
+
+    REQUIRE(batches.size() == 1);
+    REQUIRE(batches[0].messages == 6);
+    REQUIRE(batches[0].patient);
+    REQUIRE(batches[0].received >= before);
+
+    // One callback per topic and patient, with its latest value
+    REQUIRE(updates.size() == 5);
+    REQUIRE(std::count(updates.begin(), updates.end(), std::make_pair(std::string("heart/heartRate"), 80.0f)) == 1);
+    REQUIRE(std::count(updates.begin(), updates.end(),
+                       std::make_pair(std::string("bed/1/lung/oxygenSaturation"), 90.0f)) == 1);
+    REQUIRE(std::count(updates.begin(), updates.end(), std::make_pair(std::string("bed/1/heart/heartRate"), 100.0f)) == 1);
+
+    // Each store got the batch in a single publish
+    const SensorDataStore::Snapshot snap = store.snapshot();
+    REQUIRE(snap.value(SensorDataStore::Field::Spo2) == 95.0);
+    REQUIRE(snap.lastUpdate(SensorDataStore::Field::Spo2) == snap.lastUpdate(SensorDataStore::Field::BpSystolic));
+    REQUIRE(mqtt.getPatientDataSnapshot().heartRate == 80.0f);
+    REQUIRE(mqtt.physiology().heartRateBpm == Catch::Approx(80.0));
+
+    const BedStore::Shard* bed = beds.find("1");
+    REQUIRE(bed->store.getSpo2() == Catch::Approx(90.0));
+    REQUIRE(bed->physiology().heartRateBpm == Catch::Approx(100.0));
+    REQUIRE(bed->physiologyVersion() == 1);
+
+    // A batch for beds only leaves the own patient alone
+    const MQTTDriver::Message bedOnly[] = {{"bed/2/heart/heartRate", "60", 2}};
+    mqtt.ingestBatch(bedOnly, 1);
+    REQUIRE(batches.size() == 2);
+    REQUIRE_FALSE(batches[1].patient);
+
+    // Nothing parsed, nothing published
+    const MQTTDriver::Message junk[] = {{"heart/heartRate", "x", 1}};
+    mqtt.ingestBatch(junk, 1);
+    REQUIRE(batches.size() == 2);
+}
+
+TEST_CASE("MQTTDriver - A vitals message is applied whole in one publish", "[mqtt_driver]") {
+    SensorDataStore store(1.0);
+    BedStore beds(1.0);
+    MQTTDriver mqtt(store);
+    mqtt.setBedStore(&beds);
+
+    std::vector<std::pair<std::string, float>> updates;
+    mqtt.setUpdateCallback([&](std::string_view topic, float value) { updates.emplace_back(std::string(topic), value); });
+    std::vector<MQTTDriver::BatchInfo> batches;
+    mqtt.setBatchCallback([&](const MQTTDriver::BatchInfo& batch) { batches.push_back(batch); });
+
+    send(mqtt, "patient/vitals",
+         R"({"heart/heartRate": 72, "heart": {"systolicBP": 118, "diastolicBP": "76"},
+             "lung": {"oxygenSaturation": 97.5}, "conditions/septic": true, "monitor": "ICU-3", "extra": [1, 2]})");
+    REQUIRE(batches.size() == 1);
+    REQUIRE(batches[0].messages == 1);
+    REQUIRE(updates.size() == 5);
+
+    PatientData p = mqtt.getPatientDataSnapshot();
+    REQUIRE(p.heartRate == 72.0f);
+    REQUIRE(p.systolicBP == 118.0f);
+    REQUIRE(p.diastolicBP == 76.0f);
+    REQUIRE(p.oxygenSaturation == 97.5f);
+    REQUIRE(p.septic == 1.0f);
+    REQUIRE_FALSE(p.has_respiratoryRate);
+
+    // All of it landed in one store update
+    const SensorDataStore::Snapshot snap = store.snapshot();
+    REQUIRE(snap.value(SensorDataStore::Field::Spo2) == 97.5);
+    REQUIRE(snap.lastUpdate(SensorDataStore::Field::Spo2) == snap.lastUpdate(SensorDataStore::Field::BpDiastolic));
+
+    // One bad known value rejects the message; nothing changes
+    send(mqtt, "patient/vitals", R"({"heart/heartRate": 90, "lung/oxygenSaturation": "high"})");
+    send(mqtt, "patient/vitals", R"({"heart/heartRate": 90,)");
+    send(mqtt, "patient/vitals", R"({"monitor": "ICU-3"})");
+    REQUIRE(batches.size() == 1);
+    REQUIRE(mqtt.getPatientDataSnapshot().heartRate == 72.0f);
+
+    send(mqtt, "bed/7/patient/vitals", R"({"heart/heartRate": 101, "lung/respiratoryRate": 22})");
+    REQUIRE(beds.find("7")->physiology().heartRateBpm == Catch::Approx(101.0));
+    REQUIRE(beds.find("7")->physiology().respRateBpm == Catch::Approx(22.0));
+    REQUIRE(mqtt.getPatientDataSnapshot().heartRate == 72.0f);
+}
+
+TEST_CASE("MQTTDriver - Packed vitals records", "[mqtt_driver]") {
+    SensorDataStore store(1.0);
+    MQTTDriver mqtt(store);
+
+    // Bits follow the topic table
+    REQUIRE(MQTTDriver::vitalsField(0) == "heart/heartRate");
+    REQUIRE(MQTTDriver::vitalsField(9) == "lung/oxygenSaturation");
+    REQUIRE(MQTTDriver::vitalsField(12) == "conditions/septic");
+    REQUIRE(MQTTDriver::vitalsField(topicFields().size()).empty());
+    for (size_t bit = 0; bit < topicFields().size(); ++bit) {
+        REQUIRE(MQTTDriver::vitalsField(bit) == topicFields()[bit].topic);
+    }
+
+    REQUIRE_FALSE(mqtt.setPayloadFormat(MQTTDriver::VITALS_TOPIC, MqttPayload::Format::MessagePack));
+    REQUIRE(mqtt.setPayloadFormat(MQTTDriver::VITALS_TOPIC, MqttPayload::Format::Float32));
+
+    const std::string record = packVitals({{0, 64.0f}, {9, 93.0f}, {12, 2.0f}});
+    REQUIRE(record.size() == 16);
+    mqtt.ingest(MQTTDriver::VITALS_TOPIC, record.data(), static_cast<int>(record.size()));
+    PatientData p = mqtt.getPatientDataSnapshot();
+    REQUIRE(p.heartRate == 64.0f);
+    REQUIRE(p.oxygenSaturation == 93.0f);
+    REQUIRE(p.septic == 1.0f); // Conditions are 0 or 1
+    REQUIRE_FALSE(p.has_systolicBP);
+
+    // Length must match the mask; unknown bits are rejected
+    const std::string shortRecord = record.substr(0, 12);
+    mqtt.ingest(MQTTDriver::VITALS_TOPIC, shortRecord.data(), static_cast<int>(shortRecord.size()));
+    std::string unknownBit = packVitals({{0, 50.0f}, {31, 1.0f}});
+    mqtt.ingest(MQTTDriver::VITALS_TOPIC, unknownBit.data(), static_cast<int>(unknownBit.size()));
+    send(mqtt, "patient/vitals", R"({"heart/heartRate": 50})"); // JSON no longer accepted
+    REQUIRE(mqtt.getPatientDataSnapshot().heartRate == 64.0f);
+}
+
+TEST_CASE("MQTTDriver - Ingestion is counted per topic", "[mqtt_driver]") {
+    using Counter = MqttStats::Counter;
+    SensorDataStore store(1.0);
+    MQTTDriver mqtt(store);
+
+    send(mqtt, "heart/heartRate", "72");
+    send(mqtt, "heart/heartRate", "abc");
+    mqtt.ingest("heart/heartRate", "", 0);
+    send(mqtt, "heart/unknown", "1");
+    send(mqtt, "bed/1/heart/heartRate", "60"); // No bed store: an unknown topic
+    send(mqtt, "patient/vitals", R"({"lung/oxygenSaturation": 95})");
+    send(mqtt, "patient/vitals", "{");
+
+    const MqttStats::Snapshot s = mqtt.stats().snapshot();
+    REQUIRE(s.count(Counter::Received) == 7);
+    REQUIRE(s.count(Counter::UnknownTopic) == 2);
+    REQUIRE(s.count(Counter::ParseFailure) == 3);
+    REQUIRE(s.count(Counter::Batch) == 2);
+    REQUIRE(mqtt.stats().publishLatency().count() == 2);
+
+    REQUIRE(MQTTDriver::statsTopic(0) == "heart/heartRate");
+    REQUIRE(s.topicReceived[0] == 3);
+    REQUIRE(s.topicFailures[0] == 2);
+    size_t vitals = 0;
+    while (MQTTDriver::statsTopic(vitals) != MQTTDriver::VITALS_TOPIC) ++vitals;
+    REQUIRE(MQTTDriver::statsTopic(vitals + 1).empty());
+    REQUIRE(s.topicReceived[vitals] == 2);
+    REQUIRE(s.topicFailures[vitals] == 1);
+
+    // A full ward drops further beds
+    BedStore beds(1.0);
+    mqtt.setBedStore(&beds);
+    for (size_t i = 0; i <= BedStore::MAX_BEDS; ++i) {
+        send(mqtt, "bed/" + std::to_string(i) + "/heart/heartRate", "60");
+    }
+    REQUIRE(mqtt.stats().snapshot().count(Counter::BedFull) == 1);
+    REQUIRE(mqtt.stats().snapshot().count(Counter::Connect) == 0);
+}
+
+TEST_CASE("MQTTDriver - Network thread starts and stops without a broker", "[mqtt_driver]") {
+    SensorDataStore store(1.0);
+    MQTTDriver mqtt(store);
+
+    REQUIRE(mqtt.startLoop());
+    REQUIRE_FALSE(mqtt.startLoop()); // Already running
+
+    const auto start = std::chrono::steady_clock::now();
+    mqtt.stopLoop();
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+    REQUIRE_FALSE(mqtt.isConnected());
+
+    // Messages still go through ingest() meanwhile and afterwards
+    send(mqtt, "heart/heartRate", "75");
+    REQUIRE(mqtt.getPatientDataSnapshot().heartRate == 75.0f);
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("MQTTDriver - Batched versus per-message publishing", "[.benchmark][mqtt_driver]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t MESSAGES = 100000;
+
+    std::vector<std::string> payloads;
+    std::vector<MQTTDriver::Message> messages;
+    payloads.reserve(MESSAGES);
+    messages.reserve(MESSAGES);
+    for (size_t i = 0; i < MESSAGES; ++i) {
+        payloads.push_back(std::to_string(60.0 + static_cast<double>(i % 400) / 10.0));
+    }
+    for (size_t i = 0; i < MESSAGES; ++i) {
+        const auto& f = topicFields()[i % topicFields().size()];
+        const bool condition = std::strncmp(f.topic, "conditions/", 11) == 0;
+        messages.push_back({f.topic, condition ? "true" : payloads[i].c_str(),
+                            static_cast<int>(condition ? 4 : payloads[i].size())});
+    }
+
+    auto run = [&](size_t batchSize) {
+        SensorDataStore store(1.0);
+        MQTTDriver mqtt(store);
+        size_t batches = 0;
+        mqtt.setBatchCallback([&](const MQTTDriver::BatchInfo&) { ++batches; });
+
+        const auto start = Clock::now();
+        for (size_t i = 0; i < MESSAGES; i += batchSize) {
+            mqtt.ingestBatch(&messages[i], std::min(batchSize, MESSAGES - i));
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "\n[BENCHMARK] MQTT batches of " << batchSize << ": " << seconds * 1e9 / MESSAGES
+                  << " ns/msg, " << batches << " publishes";
+        return seconds;
+    };
+
+    const double single = run(1);
+    run(16);
+    const double batched = run(MQTTDriver::MAX_BATCH);
+    std::cout << "\n[BENCHMARK] Batching speedup: " << single / batched << "x" << std::endl;
+
+    REQUIRE(batched < single);
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("MQTTDriver - Per-topic versus vitals updates", "[.benchmark][mqtt_driver]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t UPDATES = 20000; // Full patient updates, 17 values each
+
+    std::vector<std::string> values;
+    for (size_t k = 0; k < topicFields().size(); ++k) {
+        values.push_back(std::strncmp(topicFields()[k].topic, "conditions/", 11) == 0 ? "false"
+                                                                                     : std::to_string(60 + k));
+    }
+    std::string json = "{";
+    std::vector<std::pair<size_t, float>> packed;
+    for (size_t k = 0; k < topicFields().size(); ++k) {
+        json += std::string(k ? ", \"" : "\"") + topicFields()[k].topic + "\": " + values[k];
+        packed.emplace_back(k, values[k] == "false" ? 0.0f : std::stof(values[k]));
+    }
+    json += "}";
+    const std::string record = packVitals(packed);
+
+    auto run = [&](const char* label, MqttPayload::Format format, auto&& update) {
+        SensorDataStore store(1.0);
+        MQTTDriver mqtt(store);
+        mqtt.setPayloadFormat(MQTTDriver::VITALS_TOPIC, format);
+        size_t publishes = 0;
+        mqtt.setBatchCallback([&](const MQTTDriver::BatchInfo&) { ++publishes; });
+
+        const auto start = Clock::now();
+        for (size_t i = 0; i < UPDATES; ++i) {
+            update(mqtt);
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "\n[BENCHMARK] " << label << ": " << seconds * 1e9 / UPDATES << " ns/update, "
+                  << publishes / UPDATES << " publishes/update";
+        REQUIRE(mqtt.getPatientDataSnapshot().has_cardiacArrest);
+        return seconds;
+    };
+
+    const double perTopic = run("17 per-topic messages", MqttPayload::Format::Text, [&](MQTTDriver& mqtt) {
+        for (size_t k = 0; k < values.size(); ++k) {
+            mqtt.ingest(topicFields()[k].topic, values[k].data(), static_cast<int>(values[k].size()));
+        }
+    });
+    const double viaJson = run("JSON vitals message", MqttPayload::Format::Text, [&](MQTTDriver& mqtt) {
+        mqtt.ingest(MQTTDriver::VITALS_TOPIC, json.data(), static_cast<int>(json.size()));
+    });
+    const double viaRecord = run("Packed vitals record", MqttPayload::Format::Float32, [&](MQTTDriver& mqtt) {
+        mqtt.ingest(MQTTDriver::VITALS_TOPIC, record.data(), static_cast<int>(record.size()));
+    });
+    std::cout << "\n[BENCHMARK] Vitals speedup: JSON " << perTopic / viaJson << "x, packed "
+              << perTopic / viaRecord << "x" << std::endl;
+
+    REQUIRE(viaRecord < perTopic);
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("MQTTDriver - Ingestion at 100k msgs/s", "[.benchmark][mqtt_driver]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t MESSAGES = 100000; // One second at the target rate
+    constexpr size_t BEDS = 16;
+
+    struct Message
+    {
+        std::string topic;
+        std::string payload;
+    };
+
+    // Realistic mix: the monitor's own topics and the same topics for a ward
+    std::vector<Message> messages;
+    messages.reserve(MESSAGES);
+    for (size_t i = 0; i < MESSAGES; ++i) {
+        const auto& f = topicFields()[i % topicFields().size()];
+        const bool condition = std::strncmp(f.topic, "conditions/", 11) == 0;
+        std::string topic = (i / topicFields().size()) % 2 == 0
+                                ? std::string(f.topic)
+                                : "bed/" + std::to_string(i % BEDS) + "/" + f.topic;
+        messages.push_back({std::move(topic), condition ? (i % 3 ? "false" : "true")
+                                                        : std::to_string(60.0 + static_cast<double>(i % 400) / 10.0)});
+    }
+
+    SensorDataStore store(1.0);
+    BedStore beds(1.0);
+    MQTTDriver mqtt(store);
+    mqtt.setBedStore(&beds);
+    size_t updates = 0;
+    mqtt.setUpdateCallback([&](std::string_view, float) { ++updates; });
+
+    const auto start = Clock::now();
+    for (const auto& m : messages) {
+        mqtt.ingest(m.topic, m.payload.data(), static_cast<int>(m.payload.size()));
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << "\n[BENCHMARK] MQTT ingestion: " << seconds * 1e9 / MESSAGES << " ns/msg, "
+              << MESSAGES / seconds / 1e6 << " M msgs/s, " << seconds * 100.0
+              << "% of a core at 100k msgs/s" << std::endl;
+
+    REQUIRE(updates == MESSAGES);
+    REQUIRE(beds.size() == BEDS);
+    REQUIRE(seconds < 1.0);
+}
@@ -0,0 +1,260 @@
+/**
+ * @file test_mqtt_log.cpp
+ * @brief Unit tests and replay benchmark for MQTT record and replay
+ *
+ * Logs are written to the system temp directory and removed afterwards.
+ */
+
+#include "catch_amalgamated.hpp"
+#include "core/mqtt_log.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using PatientData = MQTTDriver::PatientData;
+
+// Temp file removed when the test ends
+struct TempLog
+{
+    explicit TempLog(const char* name)
+        : path((std::filesystem::temp_directory_path() / name).string())
+    {
+    }
+    ~TempLog() { std::remove(path.c_str()); }
+
+    std::string path;
+};
+
+void record(MqttRecorder& recorder, const std::string& topic, const std::string& payload,
+            std::chrono::steady_clock::time_point at)
+{
+    recorder.record(topic, payload.data(), static_cast<int>(payload.size()), at);
+}
+
+} // namespace
+
+TEST_CASE("MqttLog - Messages round-trip with their timing", "[mqtt_log]") {
+    TempLog log("curecraft_test_roundtrip.mqlog");
+    const auto t0 = std::chrono::steady_clock::now();
+    {
+        MqttRecorder recorder;
+        REQUIRE(recorder.open(log.path));
+        record(recorder, "heart/heartRate", "72", t0);
+        record(recorder, "bed/3/lung/oxygenSaturation", "97", t0 + std::chrono::milliseconds(5));
+        record(recorder, "heart/heartRate", "", t0 + std::chrono::milliseconds(5));
+        record(recorder, "patient/vitals", std::string("\x01\x00\x00\x00\x00\x00\x90\x42", 8),
+               t0 + std::chrono::seconds(2));
+        REQUIRE(recorder.count() == 4);
+    } // Closing flushes
+
+    MqttReplay replay;
+    REQUIRE(replay.load(log.path));
+    REQUIRE(replay.size() == 4);
+    REQUIRE(replay.topic(0) == "heart/heartRate");
+    REQUIRE(replay.payload(0) == "72");
+    REQUIRE(replay.topic(1) == "bed/3/lung/oxygenSaturation");
+    REQUIRE(replay.offset(1) == std::chrono::milliseconds(5));
+    REQUIRE(replay.topic(2) == "heart/heartRate");
+    REQUIRE(replay.payload(2).empty());
+    REQUIRE(replay.payload(3) == std::string_view("\x01\x00\x00\x00\x00\x00\x90\x42", 8));
+    REQUIRE(replay.duration() == std::chrono::seconds(2));
+
+    // Header, then each record: delta, topic reference, [length, name], length, payload.
+    // The repeated topic costs a one-byte reference instead of its name.
+    REQUIRE(std::filesystem::file_size(log.path) == 8 + (1 + 1 + 1 + 15 + 1 + 2) + (4 + 1 + 1 + 27 + 1 + 2) +
+                                                        (1 + 1 + 1) + (5 + 1 + 1 + 14 + 1 + 8));
+}
+
+TEST_CASE("MqttLog - Damaged logs are rejected", "[mqtt_log]") {
+    TempLog log("curecraft_test_damaged.mqlog");
+    {
+        MqttRecorder recorder;
+        REQUIRE(recorder.open(log.path));
+        const auto now = std::chrono::steady_clock::now();
+        record(recorder, "heart/heartRate", "72", now);
+        record(recorder, "heart/heartRate", "73", now);
+    }
+    std::string bytes;
+    {
+        std::ifstream in(log.path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    auto loads = [&](const std::string& content) {
+        std::ofstream(log.path, std::ios::binary | std::ios::trunc) << content;
+        MqttReplay replay;
+        return replay.load(log.path);
+    };
+    REQUIRE(loads(bytes));
+    REQUIRE(loads(bytes.substr(0, 8))); // Header only: an empty log
+    REQUIRE_FALSE(loads("not a log at all"));
+    const size_t firstRecord = 8 + 1 + 1 + 1 + 15 + 1 + 2;
+    for (size_t cut = 9; cut < bytes.size(); ++cut) {
+        INFO("cut at " << cut);
+        REQUIRE(loads(bytes.substr(0, cut)) == (cut == firstRecord)); // Only whole records load
+    }
+    std::string badRef = bytes;
+    badRef[firstRecord + 1] = 9; // Second record: a topic that was never defined
+    REQUIRE_FALSE(loads(badRef));
+
+    MqttReplay missing;
+    REQUIRE_FALSE(missing.load(log.path + ".missing"));
+}
+
+TEST_CASE("MqttLog - A recorded driver replays to the same state", "[mqtt_log]") {
+    TempLog log("curecraft_test_driver.mqlog");
+    PatientData recorded;
+    {
+        SensorDataStore store(1.0);
+        BedStore beds(1.0);
+        MQTTDriver mqtt(store);
+        mqtt.setBedStore(&beds);
+        MqttRecorder recorder;
+        REQUIRE(recorder.open(log.path));
+        mqtt.setRecorder(&recorder);
+
+        const MQTTDriver::Message messages[] = {
+            {"heart/heartRate", "70", 2},
+            {"heart/unknown", "1", 1},    // Recorded even though it is ignored
+            {"lung/oxygenSaturation", "x", 1},
+            {"bed/2/heart/heartRate", "88", 2},
+            {"patient/vitals", R"({"heart/systolicBP": 121})", 25},
+        };
+        mqtt.ingestBatch(messages, std::size(messages));
+        recorded = mqtt.getPatientDataSnapshot();
+        mqtt.setRecorder(nullptr);
+        mqtt.ingest("heart/heartRate", "99", 2); // Not recorded
+        REQUIRE(recorder.count() == 5);
+    }
+
+    MqttReplay replay;
+    REQUIRE(replay.load(log.path));
+    SensorDataStore store(1.0);
+    BedStore beds(1.0);
+    MQTTDriver mqtt(store);
+    mqtt.setBedStore(&beds);
+    const MqttReplay::Result result =
+        replay.replay([&](const MQTTDriver::Message* m, size_t n) { mqtt.ingestBatch(m, n); }, 0.0);
+
+    REQUIRE(result.messages == 5);
+    REQUIRE(result.batches == 1);
+    const PatientData p = mqtt.getPatientDataSnapshot();
+    REQUIRE(p.heartRate == recorded.heartRate);
+    REQUIRE(p.systolicBP == 121.0f);
+    REQUIRE_FALSE(p.has_oxygenSaturation);
+    REQUIRE(beds.find("2")->physiology().heartRateBpm == Catch::Approx(88.0));
+    REQUIRE(mqtt.stats().snapshot().count(MqttStats::Counter::UnknownTopic) == 1);
+}
+
+TEST_CASE("MqttLog - Paced replay keeps the recorded timing", "[mqtt_log]") {
+    TempLog log("curecraft_test_paced.mqlog");
+    const auto t0 = std::chrono::steady_clock::now();
+    {
+        MqttRecorder recorder;
+        REQUIRE(recorder.open(log.path));
+        for (int i = 0; i < 20; ++i) {
+            record(recorder, "heart/heartRate", std::to_string(60 + i), t0 + std::chrono::milliseconds(10 * i));
+        }
+    }
+    MqttReplay replay;
+    REQUIRE(replay.load(log.path));
+    REQUIRE(replay.duration() == std::chrono::milliseconds(190));
+
+    std::vector<std::chrono::steady_clock::time_point> arrivals;
+    auto sink = [&](const MQTTDriver::Message*, size_t n) {
+        arrivals.insert(arrivals.end(), n, std::chrono::steady_clock::now());
+    };
+
+    // 2x: 95 ms, in order and never early
+    const auto start = std::chrono::steady_clock::now();
+    const MqttReplay::Result paced = replay.replay(sink, 2.0);
+    REQUIRE(paced.messages == 20);
+    REQUIRE(paced.seconds >= 0.095);
+    for (size_t i = 0; i < arrivals.size(); ++i) {
+        REQUIRE(arrivals[i] - start >= std::chrono::milliseconds(5 * i));
+    }
+
+    // Stopping ends a replay early
+    std::atomic<bool> stop{true};
+    REQUIRE(replay.replay(sink, 1.0, &stop).messages == 0);
+}
+
+TEST_CASE("MqttLog - A stop during a long gap ends the replay promptly", "[mqtt_log]") {
+    TempLog log("curecraft_test_gap.mqlog");
+    const auto t0 = std::chrono::steady_clock::now();
+    {
+        MqttRecorder recorder;
+        REQUIRE(recorder.open(log.path));
+        record(recorder, "heart/heartRate", "60", t0);
+        record(recorder, "heart/heartRate", "61", t0 + std::chrono::minutes(10));
+    }
+    MqttReplay replay;
+    REQUIRE(replay.load(log.path));
+
+    std::atomic<bool> stop{false};
+    size_t received = 0;
+    auto sink = [&](const MQTTDriver::Message*, size_t n) { received += n; };
+    std::thread stopper([&stop] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        stop = true;
+    });
+    const auto start = std::chrono::steady_clock::now();
+    const MqttReplay::Result result = replay.replay(sink, 1.0, &stop);
+    const auto took = std::chrono::steady_clock::now() - start;
+    stopper.join();
+
+    REQUIRE(result.messages == 1);
+    REQUIRE(received == 1);
+    REQUIRE(took < std::chrono::seconds(1));
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("MqttLog - Replaying a ward at maximum speed", "[.benchmark][mqtt_log]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t MESSAGES = 200000;
+    constexpr size_t BEDS = 32;
+    const char* topics[] = {"heart/heartRate", "heart/systolicBP", "lung/oxygenSaturation", "lung/respiratoryRate",
+                            "conditions/septic"};
+
+    TempLog log("curecraft_bench_ward.mqlog");
+    const auto t0 = Clock::now();
+    double recordSeconds = 0.0;
+    {
+        MqttRecorder recorder;
+        REQUIRE(recorder.open(log.path));
+        const auto start = Clock::now();
+        for (size_t i = 0; i < MESSAGES; ++i) {
+            const std::string topic = "bed/" + std::to_string(i % BEDS) + "/" + topics[i % std::size(topics)];
+            const std::string payload = (i % std::size(topics)) == 4 ? "false" : std::to_string(60 + i % 40);
+            record(recorder, topic, payload, t0 + std::chrono::microseconds(10 * i)); // 100k msgs/s
+        }
+        recordSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    const auto bytes = std::filesystem::file_size(log.path);
+
+    MqttReplay replay;
+    REQUIRE(replay.load(log.path));
+    SensorDataStore store(1.0);
+    BedStore beds(1.0);
+    MQTTDriver mqtt(store);
+    mqtt.setBedStore(&beds);
+    const MqttReplay::Result result =
+        replay.replay([&](const MQTTDriver::Message* m, size_t n) { mqtt.ingestBatch(m, n); }, 0.0);
+
+    std::cout << "\n[BENCHMARK] MQTT log: " << static_cast<double>(bytes) / MESSAGES << " bytes/msg, record "
+              << recordSeconds * 1e9 / MESSAGES << " ns/msg"
+              << "\n[BENCHMARK] Ward replay at max speed: " << result.messagesPerSecond / 1e6 << " M msgs/s ("
+              << replay.duration().count() / 1e9 / result.seconds << "x the recorded rate)" << std::endl;
+
+    REQUIRE(result.messages == MESSAGES);
+    REQUIRE(beds.size() == BEDS);
+}
@@ -0,0 +1,504 @@
+/**
+ * @file test_mqtt_payload.cpp
+ * @brief Unit, fuzz and throughput tests for the MQTT payload parsers
+ *
+ * Text parsing is checked against strtof on random strings, JSON objects
+ * against nlohmann::json on mutated documents, and the binary parsers
+ * against local encoders and random bytes.
+ */
+
+#include "catch_amalgamated.hpp"
+#include "core/mqtt_payload.h"
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using MqttPayload::Format;
+
+namespace {
+
+std::string bigEndian(uint64_t v, size_t n)
+{
+    std::string out(n, '\0');
+    for (size_t i = 0; i < n; ++i) {
+        out[n - 1 - i] = static_cast<char>(v >> (8 * i));
+    }
+    return out;
+}
+
+std::string littleEndian(uint64_t v, size_t n)
+{
+    std::string out(n, '\0');
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<char>(v >> (8 * i));
+    }
+    return out;
+}
+
+uint32_t floatBits(float f)
+{
+    uint32_t b;
+    std::memcpy(&b, &f, sizeof(b));
+    return b;
+}
+
+uint64_t doubleBits(double d)
+{
+    uint64_t b;
+    std::memcpy(&b, &d, sizeof(b));
+    return b;
+}
+
+std::string msgpackInt(int64_t v)
+{
+    if (v >= 0 && v <= 0x7F) return std::string(1, static_cast<char>(v));
+    if (v < 0 && v >= -32) return std::string(1, static_cast<char>(static_cast<int8_t>(v)));
+    if (v >= 0) {
+        if (v <= 0xFF) return "\xCC" + bigEndian(static_cast<uint64_t>(v), 1);
+        if (v <= 0xFFFF) return "\xCD" + bigEndian(static_cast<uint64_t>(v), 2);
+        if (v <= 0xFFFFFFFFll) return "\xCE" + bigEndian(static_cast<uint64_t>(v), 4);
+        return "\xCF" + bigEndian(static_cast<uint64_t>(v), 8);
+    }
+    if (v >= INT8_MIN) return "\xD0" + bigEndian(static_cast<uint64_t>(v), 1);
+    if (v >= INT16_MIN) return "\xD1" + bigEndian(static_cast<uint64_t>(v), 2);
+    if (v >= INT32_MIN) return "\xD2" + bigEndian(static_cast<uint64_t>(v), 4);
+    return "\xD3" + bigEndian(static_cast<uint64_t>(v), 8);
+}
+
+std::string cborInt(int64_t v)
+{
+    const uint8_t major = v < 0 ? 0x20 : 0x00;
+    const uint64_t arg = v < 0 ? static_cast<uint64_t>(-1 - v) : static_cast<uint64_t>(v);
+    if (arg < 24) return std::string(1, static_cast<char>(major | arg));
+    if (arg <= 0xFF) return std::string(1, static_cast<char>(major | 24)) + bigEndian(arg, 1);
+    if (arg <= 0xFFFF) return std::string(1, static_cast<char>(major | 25)) + bigEndian(arg, 2);
+    if (arg <= 0xFFFFFFFFull) return std::string(1, static_cast<char>(major | 26)) + bigEndian(arg, 4);
+    return std::string(1, static_cast<char>(major | 27)) + bigEndian(arg, 8);
+}
+
+// What the parser should accept: strtof over the trimmed text, consuming all
+// of it, finite. -1 when strtof reports ERANGE (under/overflow edge cases are
+// left to the implementation).
+int referenceNumber(const std::string& text, float& out)
+{
+    const size_t first = text.find_first_not_of(" \t\r\n\f\v");
+    if (first == std::string::npos) return 0;
+    const std::string s = text.substr(first, text.find_last_not_of(" \t\r\n\f\v") - first + 1);
+    // strtof also reads hex floats; the fuzz alphabet has no 'x'
+    char* end = nullptr;
+    errno = 0;
+    const float v = std::strtof(s.c_str(), &end);
+    if (end == s.c_str() || *end != '\0') return 0;
+    if (errno == ERANGE) return -1;
+    if (!std::isfinite(v)) return 0;
+    out = v;
+    return 1;
+}
+
+} // namespace
+
+TEST_CASE("MqttPayload - Text numbers", "[mqtt_payload]") {
+    struct Case
+    {
+        const char* text;
+        bool ok;
+        float value;
+    };
+    const Case cases[] = {
+        {"72", true, 72.0f},       {" 72.5\n", true, 72.5f},    {"\t-3.25 ", true, -3.25f},
+        {"+4", true, 4.0f},        {"1e2", true, 100.0f},       {".5", true, 0.5f},
+        {"5.", true, 5.0f},        {"-0", true, -0.0f},         {"", false, 0.0f},
+        {"   ", false, 0.0f},      {"+", false, 0.0f},          {"+-1", false, 0.0f},
+        {"++1", false, 0.0f},      {"1 2", false, 0.0f},        {"72bpm", false, 0.0f},
+        {"fast", false, 0.0f},     {"nan", false, 0.0f},        {"inf", false, 0.0f},
+        {"-infinity", false, 0.0f}, {"1e99", false, 0.0f},      {"1e", false, 0.0f},
+        {".", false, 0.0f},        {"0x10", false, 0.0f},       {"true", false, 0.0f},
+    };
+    for (const Case& c : cases) {
+        INFO("'" << c.text << "'");
+        float v = 123.0f;
+        REQUIRE(MqttPayload::parseNumber(c.text, v) == c.ok);
+        if (c.ok) {
+            REQUIRE(v == c.value);
+        } else {
+            REQUIRE(v == 123.0f); // Untouched on failure
+        }
+    }
+
+    // Views need not be terminated: only the viewed bytes count
+    float v = 0.0f;
+    REQUIRE(MqttPayload::parseNumber(std::string_view("98.6garbage", 4), v));
+    REQUIRE(v == Catch::Approx(98.6));
+}
+
+TEST_CASE("MqttPayload - Boolish keywords in any case", "[mqtt_payload]") {
+    struct Case
+    {
+        const char* text;
+        bool ok;
+        float value;
+    };
+    const Case cases[] = {
+        {"true", true, 1.0f},  {"TRUE", true, 1.0f}, {" On\n", true, 1.0f},  {"yEs", true, 1.0f},
+        {"false", true, 0.0f}, {"Off", true, 0.0f},  {"NO ", true, 0.0f},    {"1", true, 1.0f},
+        {"0", true, 0.0f},     {"0.0", true, 0.0f},  {"-3", true, 1.0f},     {"tru", false, 0.0f},
+        {"truee", false, 0.0f}, {"", false, 0.0f},   {"y", false, 0.0f},     {"nan", false, 0.0f},
+    };
+    for (const Case& c : cases) {
+        INFO("'" << c.text << "'");
+        float v = 123.0f;
+        REQUIRE(MqttPayload::parseBoolish(c.text, v) == c.ok);
+        if (c.ok) REQUIRE(v == c.value);
+    }
+}
+
+TEST_CASE("MqttPayload - Text fuzz agrees with strtof", "[mqtt_payload]") {
+    std::mt19937 rng(1234);
+    const std::string alphabet = "0123456789+-.eE \t\ninfatyrsoNAI";
+    std::uniform_int_distribution<size_t> length(0, 12);
+    std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+
+    size_t accepted = 0;
+    for (int i = 0; i < 200000; ++i) {
+        std::string text(length(rng), ' ');
+        for (char& c : text) c = alphabet[pick(rng)];
+
+        float expected = 0.0f;
+        float got = 0.0f;
+        const int ref = referenceNumber(text, expected);
+        const bool ok = MqttPayload::parseNumber(text, got);
+        INFO("'" << text << "'");
+        if (ref < 0) {
+            if (ok) REQUIRE(std::isfinite(got));
+            continue;
+        }
+        REQUIRE(ok == (ref == 1));
+        if (ok) {
+            REQUIRE(floatBits(got) == floatBits(expected));
+            ++accepted;
+        }
+    }
+    REQUIRE(accepted > 1000); // The alphabet produces plenty of valid numbers
+
+    // Any finite float printed round-trip exactly, whatever its spelling
+    std::uniform_int_distribution<uint32_t> bits;
+    for (int i = 0; i < 100000; ++i) {
+        const uint32_t b = bits(rng);
+        float f;
+        std::memcpy(&f, &b, sizeof(f));
+        if (!std::isfinite(f)) continue;
+        char text[48];
+        std::snprintf(text, sizeof(text), i % 2 ? "%.9g" : " %+.9e\r\n", static_cast<double>(f));
+        float got = 0.0f;
+        INFO(text);
+        REQUIRE(MqttPayload::parseNumber(text, got));
+        REQUIRE(floatBits(got) == b);
+    }
+}
+
+TEST_CASE("MqttPayload - Raw IEEE floats", "[mqtt_payload]") {
+    float v = 0.0f;
+    REQUIRE(MqttPayload::parseRawFloat(littleEndian(floatBits(72.5f), 4), v));
+    REQUIRE(v == 72.5f);
+    REQUIRE(MqttPayload::parseRawFloat(littleEndian(doubleBits(-0.125), 8), v));
+    REQUIRE(v == -0.125f);
+
+    REQUIRE_FALSE(MqttPayload::parseRawFloat(littleEndian(floatBits(NAN), 4), v));
+    REQUIRE_FALSE(MqttPayload::parseRawFloat(littleEndian(floatBits(INFINITY), 4), v));
+    REQUIRE_FALSE(MqttPayload::parseRawFloat(littleEndian(doubleBits(1e300), 8), v)); // Beyond float
+    for (size_t n : {0, 1, 3, 5, 7, 9}) {
+        REQUIRE_FALSE(MqttPayload::parseRawFloat(std::string(n, '\0'), v));
+    }
+}
+
+TEST_CASE("MqttPayload - MessagePack scalars", "[mqtt_payload]") {
+    float v = 0.0f;
+    for (int64_t i : {0ll, 1ll, 127ll, 128ll, 255ll, 256ll, 65535ll, 65536ll, 4294967295ll, 4294967296ll,
+                      -1ll, -32ll, -33ll, -128ll, -129ll, -32768ll, -32769ll, -2147483648ll, -2147483649ll}) {
+        INFO(i);
+        REQUIRE(MqttPayload::parseMessagePack(msgpackInt(i), v));
+        REQUIRE(v == static_cast<float>(i));
+    }
+    REQUIRE(MqttPayload::parseMessagePack("\xCA" + bigEndian(floatBits(98.5f), 4), v));
+    REQUIRE(v == 98.5f);
+    REQUIRE(MqttPayload::parseMessagePack("\xCB" + bigEndian(doubleBits(-7.25), 8), v));
+    REQUIRE(v == -7.25f);
+    REQUIRE(MqttPayload::parseMessagePack("\xC3", v));
+    REQUIRE(v == 1.0f);
+    REQUIRE(MqttPayload::parseMessagePack("\xC2", v));
+    REQUIRE(v == 0.0f);
+
+    REQUIRE_FALSE(MqttPayload::parseMessagePack("", v));
+    REQUIRE_FALSE(MqttPayload::parseMessagePack(std::string("\xC0", 1), v));                 // nil
+    REQUIRE_FALSE(MqttPayload::parseMessagePack("\xA2hi", v));                                // string
+    REQUIRE_FALSE(MqttPayload::parseMessagePack("\xCA" + bigEndian(floatBits(NAN), 4), v));   // NaN
+    REQUIRE_FALSE(MqttPayload::parseMessagePack("\xCA" + bigEndian(floatBits(1.0f), 3), v));  // Truncated
+    REQUIRE_FALSE(MqttPayload::parseMessagePack(std::string("\x05\x05", 2), v));              // Trailing byte
+}
+
+TEST_CASE("MqttPayload - CBOR scalars", "[mqtt_payload]") {
+    float v = 0.0f;
+    for (int64_t i : {0ll, 23ll, 24ll, 255ll, 256ll, 65535ll, 65536ll, 4294967296ll,
+                      -1ll, -24ll, -25ll, -256ll, -257ll, -65537ll}) {
+        INFO(i);
+        REQUIRE(MqttPayload::parseCbor(cborInt(i), v));
+        REQUIRE(v == static_cast<float>(i));
+    }
+
+    // Half floats (RFC 8949 appendix A)
+    struct Half
+    {
+        uint16_t bits;
+        float value;
+    };
+    for (const Half& h : {Half{0x3C00, 1.0f}, Half{0xC000, -2.0f}, Half{0x3E00, 1.5f}, Half{0x7BFF, 65504.0f},
+                          Half{0x0001, 5.960464477539063e-8f}, Half{0x0400, 0.00006103515625f}, Half{0x8000, -0.0f}}) {
+        INFO(h.bits);
+        REQUIRE(MqttPayload::parseCbor("\xF9" + bigEndian(h.bits, 2), v));
+        REQUIRE(floatBits(v) == floatBits(h.value));
+    }
+    REQUIRE_FALSE(MqttPayload::parseCbor("\xF9" + bigEndian(0x7C00, 2), v)); // Infinity
+    REQUIRE_FALSE(MqttPayload::parseCbor("\xF9" + bigEndian(0x7E00, 2), v)); // NaN
+
+    REQUIRE(MqttPayload::parseCbor("\xFA" + bigEndian(floatBits(36.6f), 4), v));
+    REQUIRE(v == 36.6f);
+    REQUIRE(MqttPayload::parseCbor("\xFB" + bigEndian(doubleBits(120.0), 8), v));
+    REQUIRE(v == 120.0f);
+    REQUIRE(MqttPayload::parseCbor("\xF5", v));
+    REQUIRE(v == 1.0f);
+    REQUIRE(MqttPayload::parseCbor("\xF4", v));
+    REQUIRE(v == 0.0f);
+
+    REQUIRE_FALSE(MqttPayload::parseCbor("", v));
+    REQUIRE_FALSE(MqttPayload::parseCbor("\xF6", v));                              // null
+    REQUIRE_FALSE(MqttPayload::parseCbor("\x62hi", v));                            // text string
+    REQUIRE_FALSE(MqttPayload::parseCbor("\x1C", v));                              // reserved length
+    REQUIRE_FALSE(MqttPayload::parseCbor("\xFA" + bigEndian(0, 2), v));            // Truncated
+    REQUIRE_FALSE(MqttPayload::parseCbor(std::string("\x01\x00", 2), v));          // Trailing byte
+}
+
+TEST_CASE("MqttPayload - Random bytes never yield a bad value", "[mqtt_payload]") {
+    std::mt19937 rng(99);
+    std::uniform_int_distribution<size_t> length(0, 10);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    for (int i = 0; i < 200000; ++i) {
+        std::string bytes(length(rng), '\0');
+        for (char& c : bytes) c = static_cast<char>(byte(rng));
+        for (Format f : {Format::Text, Format::Float32, Format::MessagePack, Format::Cbor}) {
+            for (bool boolish : {false, true}) {
+                float v = 0.0f;
+                if (MqttPayload::parse(f, bytes, boolish, v)) {
+                    REQUIRE(std::isfinite(v));
+                    if (boolish) REQUIRE((v == 0.0f || v == 1.0f));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("MqttPayload - Format dispatch and names", "[mqtt_payload]") {
+    float v = 0.0f;
+    REQUIRE(MqttPayload::parse(Format::Text, "yes", true, v));
+    REQUIRE(v == 1.0f);
+    REQUIRE_FALSE(MqttPayload::parse(Format::Text, "yes", false, v));
+    REQUIRE(MqttPayload::parse(Format::MessagePack, msgpackInt(5), true, v));
+    REQUIRE(v == 1.0f);
+    REQUIRE(MqttPayload::parse(Format::Cbor, cborInt(-4), false, v));
+    REQUIRE(v == -4.0f);
+    REQUIRE_FALSE(MqttPayload::parse(Format::Float32, "72", false, v)); // Text is not binary
+
+    for (Format f : {Format::Text, Format::Float32, Format::MessagePack, Format::Cbor}) {
+        Format parsed = Format::Text;
+        REQUIRE(MqttPayload::formatFromName(MqttPayload::formatName(f), parsed));
+        REQUIRE(parsed == f);
+    }
+    Format parsed = Format::Text;
+    REQUIRE(MqttPayload::formatFromName("CBOR", parsed));
+    REQUIRE(parsed == Format::Cbor);
+    REQUIRE_FALSE(MqttPayload::formatFromName("json", parsed));
+}
+
+TEST_CASE("MqttPayload - JSON objects are flattened in place", "[mqtt_payload]") {
+    MqttPayload::JsonMember members[8];
+    size_t count = 0;
+
+    const std::string json = R"( {"heart/heartRate": 72.5, "lung": {"oxygenSaturation": 97, "x": {"deep": 1}},
+                                 "conditions/septic": true, "note": "a \"quoted\" \u0041", "skip": [1, {"a": null}],
+                                 "gone": null, "h\u0065art/map": -1e2 } )";
+    REQUIRE(MqttPayload::parseJsonObject(json, members, 8, count));
+    REQUIRE(count == 5);
+    REQUIRE(members[0].name() == "heart/heartRate");
+    REQUIRE(members[0].value == "72.5");
+    REQUIRE_FALSE(members[0].isString);
+    REQUIRE(members[1].name() == "lung/oxygenSaturation"); // Grouped keys are joined; deeper ones skipped
+    REQUIRE(members[1].value == "97");
+    REQUIRE(members[2].name() == "conditions/septic");
+    REQUIRE(members[2].value == "true");
+    REQUIRE(members[3].name() == "note");
+    REQUIRE(members[3].isString);
+    REQUIRE(members[3].value == R"(a \"quoted\" \u0041)"); // Values keep their escapes
+    REQUIRE(members[4].name() == "heart/map");              // Keys are unescaped
+    REQUIRE(members[4].value == "-1e2");
+
+    // Every value points into the payload
+    for (size_t i = 0; i < count; ++i) {
+        REQUIRE(members[i].value.data() >= json.data());
+        REQUIRE(members[i].value.data() + members[i].value.size() <= json.data() + json.size());
+    }
+
+    REQUIRE(MqttPayload::parseJsonObject("{}", members, 8, count));
+    REQUIRE(count == 0);
+    REQUIRE_FALSE(MqttPayload::parseJsonObject(R"({"a":1,"b":2,"c":3})", members, 2, count)); // Too many
+
+    for (const char* bad : {"", "[]", "72", "{", "{\"a\"}", "{\"a\":}", "{\"a\":1,}", "{\"a\":01}", "{\"a\":.5}",
+                            "{\"a\":1.}", "{\"a\":+1}", "{\"a\":tru}", "{\"a\":\"x\\q\"}", "{\"a\":1} x",
+                            "{'a':1}", "{\"a\":\"\n\"}"}) {
+        INFO(bad);
+        REQUIRE_FALSE(MqttPayload::parseJsonObject(bad, members, 8, count));
+    }
+}
+
+TEST_CASE("MqttPayload - JSON fuzz agrees with nlohmann", "[mqtt_payload]") {
+    std::mt19937 rng(2024);
+    const std::vector<std::string> seeds = {
+        R"({"heart/heartRate": 72, "lung": {"oxygenSaturation": 97.5, "respiratoryRate": 14}})",
+        R"({"a": [1, 2, {"b": [true, false, null]}], "c": "x\"y", "d": -0.5e-3})",
+        R"({ "conditions": { "septic": false }, "e": {} , "f": [] })",
+    };
+    const std::string alphabet = "{}[]:,\"\\ 0123456789.-+eEabtrfalsn\t";
+    std::uniform_int_distribution<int> edits(1, 3);
+    std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+    std::uniform_int_distribution<int> op(0, 2);
+
+    MqttPayload::JsonMember members[64];
+    size_t accepted = 0;
+    for (int i = 0; i < 50000; ++i) {
+        std::string doc = seeds[static_cast<size_t>(i) % seeds.size()];
+        for (int e = edits(rng); e > 0 && !doc.empty(); --e) {
+            const size_t at = std::uniform_int_distribution<size_t>(0, doc.size() - 1)(rng);
+            switch (op(rng)) {
+            case 0: doc.erase(at, 1); break;
+            case 1: doc.insert(at, 1, alphabet[pick(rng)]); break;
+            default: doc[at] = alphabet[pick(rng)]; break;
+            }
+        }
+
+        size_t count = 0;
+        const bool ok = MqttPayload::parseJsonObject(doc, members, 64, count);
+        const nlohmann::json parsed = nlohmann::json::parse(doc, nullptr, false);
+        INFO(doc);
+        REQUIRE(ok == (!parsed.is_discarded() && parsed.is_object()));
+        if (!ok) continue;
+        ++accepted;
+
+        // Every recorded member is a scalar nlohmann finds at the same path
+        for (size_t m = 0; m < count; ++m) {
+            const std::string name(members[m].name());
+            const nlohmann::json* v = parsed.contains(name) ? &parsed[name] : nullptr;
+            for (size_t slash = name.find('/'); !v && slash != std::string::npos; slash = name.find('/', slash + 1)) {
+                const std::string outer = name.substr(0, slash);
+                const std::string inner = name.substr(slash + 1);
+                if (parsed.contains(outer) && parsed[outer].is_object() && parsed[outer].contains(inner)) {
+                    v = &parsed[outer][inner];
+                }
+            }
+            REQUIRE(v != nullptr);
+            REQUIRE(v->is_primitive());
+            REQUIRE_FALSE(v->is_null());
+        }
+    }
+    REQUIRE(accepted > 1000);
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("MqttPayload - Parser throughput", "[.benchmark][mqtt_payload]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t PAYLOADS = 1000000;
+
+    std::vector<std::string> text, raw, msgpack, cbor;
+    text.reserve(PAYLOADS);
+    for (size_t i = 0; i < PAYLOADS; ++i) {
+        const float value = 60.0f + static_cast<float>(i % 4000) / 100.0f;
+        text.push_back(std::to_string(value));
+        raw.push_back(littleEndian(floatBits(value), 4));
+        msgpack.push_back("\xCA" + bigEndian(floatBits(value), 4));
+        cbor.push_back("\xFA" + bigEndian(floatBits(value), 4));
+    }
+
+    // The previous parser: copy, trim into a std::string, strtof
+    auto strtofParse = [](const std::string& payload, float& out) {
+        char buf[64];
+        const size_t n = std::min(payload.size(), sizeof(buf) - 1);
+        std::memcpy(buf, payload.data(), n);
+        buf[n] = '\0';
+        std::string s(buf);
+        s.erase(0, s.find_first_not_of(" \t\r\n"));
+        s.erase(s.find_last_not_of(" \t\r\n") + 1);
+        char* end = nullptr;
+        out = std::strtof(s.c_str(), &end);
+        return end != s.c_str() && *end == '\0';
+    };
+
+    auto run = [&](const char* name, const std::vector<std::string>& payloads, auto&& parse) {
+        double sum = 0.0;
+        size_t parsed = 0;
+        const auto start = Clock::now();
+        for (const std::string& p : payloads) {
+            float v;
+            if (parse(p, v)) {
+                sum += v;
+                ++parsed;
+            }
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "\n[BENCHMARK] " << name << ": " << seconds * 1e9 / PAYLOADS << " ns/payload, "
+                  << PAYLOADS / seconds / 1e6 << " M payloads/s (sum " << sum << ")";
+        REQUIRE(parsed == PAYLOADS);
+        return seconds;
+    };
+
+    const double before = run("strtof + std::string (previous)", text, strtofParse);
+    const double after = run("from_chars text", text, [](const std::string& p, float& v) {
+        return MqttPayload::parseNumber(p, v);
+    });
+    run("raw float32", raw, [](const std::string& p, float& v) { return MqttPayload::parseRawFloat(p, v); });
+    run("MessagePack float32", msgpack, [](const std::string& p, float& v) {
+        return MqttPayload::parseMessagePack(p, v);
+    });
+    run("CBOR float32", cbor, [](const std::string& p, float& v) { return MqttPayload::parseCbor(p, v); });
+
+    // A full vitals record: 17 members, parsed into views
+    std::vector<std::string> vitals(PAYLOADS / 10, R"({"heart": {"heartRate": 72.5, "systolicBP": 120, "diastolicBP": 80,
+        "strokeVolume": 70, "contractility": 1, "cardiacOutput": 5.1, "map": 93, "prefactor": 1, "rhytm": 0},
+        "lung": {"oxygenSaturation": 97, "respiratoryRate": 14, "airwayObstruction": 0},
+        "conditions": {"septic": false, "anaphylaxis": false, "diabetesHypo": false, "diabetsKeto": false,
+        "cardiacArrest": false}})");
+    {
+        MqttPayload::JsonMember members[32];
+        size_t total = 0;
+        const auto start = Clock::now();
+        for (const std::string& p : vitals) {
+            size_t count = 0;
+            if (MqttPayload::parseJsonObject(p, members, 32, count)) total += count;
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "\n[BENCHMARK] JSON vitals record (" << vitals[0].size() << " bytes): "
+                  << seconds * 1e9 / vitals.size() << " ns/record";
+        REQUIRE(total == vitals.size() * 17);
+    }
+    std::cout << "\n[BENCHMARK] Text speedup over previous parser: " << before / after << "x" << std::endl;
+
+    REQUIRE(after < before);
+}
@@ -0,0 +1,143 @@
+/**
+ * @file test_mqtt_stats.cpp
+ * @brief Unit tests and counting benchmark for the per-thread MQTT counters
+ */
+
+#include "catch_amalgamated.hpp"
+#include "core/mqtt_stats.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using Counter = MqttStats::Counter;
+
+TEST_CASE("MqttStats - Counters and topics add up", "[mqtt_stats]") {
+    MqttStats stats;
+    REQUIRE(stats.snapshot().count(Counter::Received) == 0);
+
+    stats.topic(0, true);
+    stats.topic(0, true);
+    stats.topic(3, false);
+    stats.topic(MqttStats::MAX_TOPICS, true); // Out of range is ignored
+    stats.add(Counter::Received);
+    stats.add(Counter::UnknownTopic);
+    stats.add(Counter::Reconnect, 2);
+
+    const MqttStats::Snapshot s = stats.snapshot();
+    REQUIRE(s.count(Counter::Received) == 4);
+    REQUIRE(s.count(Counter::ParseFailure) == 1);
+    REQUIRE(s.count(Counter::UnknownTopic) == 1);
+    REQUIRE(s.count(Counter::Reconnect) == 2);
+    REQUIRE(s.topicReceived[0] == 2);
+    REQUIRE(s.topicReceived[3] == 1);
+    REQUIRE(s.topicFailures[3] == 1);
+    REQUIRE(s.topicFailures[0] == 0);
+
+    // Before the first window completes, rates cover the whole lifetime
+    REQUIRE(s.uptimeSeconds > 0.0);
+    REQUIRE(s.receivedRate > 0.0);
+    REQUIRE(s.topicRates[0] == Catch::Approx(s.receivedRate / 2.0));
+    REQUIRE(s.topicRates[1] == 0.0);
+
+    stats.recordPublish(std::chrono::microseconds(250));
+    REQUIRE(stats.publishLatency().count() == 1);
+}
+
+TEST_CASE("MqttStats - Instances on one thread stay separate", "[mqtt_stats]") {
+    MqttStats a;
+    {
+        MqttStats b;
+        a.add(Counter::Batch);
+        b.add(Counter::Batch, 5);
+        a.add(Counter::Batch);
+        REQUIRE(b.snapshot().count(Counter::Batch) == 5);
+    }
+    // Likely at the same address as the old b; must not inherit its cached block
+    MqttStats c;
+    c.add(Counter::Batch);
+    REQUIRE(c.snapshot().count(Counter::Batch) == 1);
+    REQUIRE(a.snapshot().count(Counter::Batch) == 2);
+}
+
+TEST_CASE("MqttStats - More writers than blocks lose nothing", "[mqtt_stats]") {
+    MqttStats stats;
+    constexpr int THREADS = static_cast<int>(MqttStats::MAX_THREADS) + 4; // Some share the overflow block
+    constexpr int PER_THREAD = 20000;
+
+    std::atomic<bool> reading{true};
+    bool monotonic = true;
+    std::thread reader([&] {
+        uint64_t last = 0;
+        while (reading) {
+            const uint64_t now = stats.snapshot().count(Counter::Received);
+            monotonic &= now >= last; // Totals never go backwards
+            last = now;
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&stats, t] {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                stats.topic(static_cast<size_t>(t), i % 10 != 0);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    reading = false;
+    reader.join();
+    REQUIRE(monotonic);
+
+    const MqttStats::Snapshot s = stats.snapshot();
+    REQUIRE(s.count(Counter::Received) == static_cast<uint64_t>(THREADS) * PER_THREAD);
+    REQUIRE(s.count(Counter::ParseFailure) == static_cast<uint64_t>(THREADS) * PER_THREAD / 10);
+    for (int t = 0; t < THREADS; ++t) {
+        REQUIRE(s.topicReceived[static_cast<size_t>(t)] == PER_THREAD);
+    }
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("MqttStats - Counting cost", "[.benchmark][mqtt_stats]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr int COUNTS = 20000000;
+    constexpr int THREADS = 4;
+
+    auto perCount = [&](auto&& count) {
+        std::vector<std::thread> threads;
+        const auto start = Clock::now();
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < COUNTS / THREADS; ++i) {
+                    count(static_cast<size_t>((t + i) & 15));
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        return std::chrono::duration<double>(Clock::now() - start).count() * 1e9 / COUNTS;
+    };
+
+    MqttStats stats;
+    const double perThread = perCount([&](size_t topic) { stats.topic(topic, true); });
+
+    // The alternative: one set of shared atomic counters
+    std::array<std::atomic<uint64_t>, MqttStats::MAX_TOPICS> shared{};
+    std::atomic<uint64_t> sharedReceived{0};
+    const double atomics = perCount([&](size_t topic) {
+        sharedReceived.fetch_add(1, std::memory_order_relaxed);
+        shared[topic].fetch_add(1, std::memory_order_relaxed);
+    });
+
+    std::cout << "\n[BENCHMARK] MqttStats with " << THREADS << " threads: per-thread blocks " << perThread
+              << " ns/msg, shared atomics " << atomics << " ns/msg" << std::endl;
+
+    REQUIRE(stats.snapshot().count(Counter::Received) == static_cast<uint64_t>(COUNTS));
+    REQUIRE(sharedReceived == static_cast<uint64_t>(COUNTS));
+}
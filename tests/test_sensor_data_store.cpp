@@ -0,0 +1,203 @@
+/**
+ * @file test_sensor_data_store.cpp
+ * @brief Unit tests and contention benchmark for the seqlock-backed SensorDataStore
+ */
+
+#include "catch_amalgamated.hpp"
+#include "core/SensorDataStore.h"
+#include "core/seqlock.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using Field = SensorDataStore::Field;
+
+TEST_CASE("Seqlock - Load returns last store", "[sensor_data_store]") {
+    struct Pair { uint64_t a; uint64_t b; };
+    Seqlock<Pair> lock;
+
+    REQUIRE(lock.load().a == 0);
+    lock.store({1, 2});
+    REQUIRE(lock.load().a == 1);
+    REQUIRE(lock.load().b == 2);
+
+    lock.update([](Pair& p) { p.b = 7; });
+    REQUIRE(lock.load().a == 1);
+    REQUIRE(lock.load().b == 7);
+    REQUIRE(lock.version() == 3);
+}
+
+TEST_CASE("SensorDataStore - Setters, getters and flags", "[sensor_data_store]") {
+    auto& store = SensorDataStore::instance();
+    store.clear();
+
+    SECTION("Fields start absent") {
+        REQUIRE_FALSE(store.hasEcg());
+        REQUIRE(store.getEcg() == 0.0);
+        REQUIRE(store.snapshot().present == 0);
+    }
+
+    SECTION("Setting a field marks it present and stamps it") {
+        const auto before = SensorDataStore::Clock::now();
+        store.setSpo2(97.0);
+        auto snap = store.snapshot();
+
+        REQUIRE(snap.has(Field::Spo2));
+        REQUIRE_FALSE(snap.has(Field::Ecg));
+        REQUIRE(snap.value(Field::Spo2) == 97.0);
+        REQUIRE(snap.lastUpdate(Field::Spo2) >= before);
+        REQUIRE(store.getSpo2() == 97.0);
+        REQUIRE(store.hasSpo2());
+    }
+
+    SECTION("setBulk publishes provided fields together") {
+        store.setBulk(0.5, 98.0, std::nullopt, 0.7, 120.0, 80.0, std::nullopt, std::nullopt, 0.0);
+        auto snap = store.snapshot();
+
+        REQUIRE(snap.has(Field::Ecg));
+        REQUIRE(snap.has(Field::BpDiastolic));
+        REQUIRE_FALSE(snap.has(Field::Resp));
+        REQUIRE_FALSE(snap.has(Field::TempSkin));
+        REQUIRE(snap.has(Field::Timestamp)); // 0.0 is a value, not "absent"
+        REQUIRE(snap.lastUpdate(Field::Ecg) == snap.lastUpdate(Field::BpSystolic));
+    }
+
+    SECTION("apply publishes exactly the fields it sets, zeros included") {
+        store.setResp(0.4);
+        SensorDataStore::Update update;
+        REQUIRE(update.empty());
+        update.set(Field::Spo2, 0.0);
+        update.set(Field::BpSystolic, 110.0);
+        store.apply(update);
+        auto snap = store.snapshot();
+
+        REQUIRE(snap.has(Field::Spo2));
+        REQUIRE(snap.value(Field::Spo2) == 0.0);
+        REQUIRE(snap.value(Field::BpSystolic) == 110.0);
+        REQUIRE(snap.value(Field::Resp) == 0.4); // Untouched
+        REQUIRE_FALSE(snap.has(Field::Ecg));
+        REQUIRE(snap.lastUpdate(Field::Spo2) == snap.lastUpdate(Field::BpSystolic));
+    }
+
+    store.clear();
+}
+
+TEST_CASE("SensorDataStore - Snapshot is never torn", "[sensor_data_store]") {
+    auto& store = SensorDataStore::instance();
+    store.clear();
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        for (double i = 1.0; !stop; i += 1.0)
+        {
+            store.setBulk(i, i, i, i, i, i, i, i, i);
+        }
+    });
+
+    bool torn = false;
+    for (int n = 0; n < 200000 && !torn; ++n)
+    {
+        const auto snap = store.snapshot();
+        const double v = snap.data.ecg;
+        torn = snap.data.spo2 != v || snap.data.resp != v || snap.data.pleth != v ||
+               snap.data.bp_systolic != v || snap.data.bp_diastolic != v ||
+               snap.data.temp_cavity != v || snap.data.temp_skin != v || snap.data.timestamp != v;
+    }
+
+    stop = true;
+    writer.join();
+    store.clear();
+
+    REQUIRE_FALSE(torn);
+}
+
+namespace {
+
+// The store as it was before the seqlock: one mutex around every access
+class MutexStore
+{
+public:
+    void setBulk(double v)
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        snap_.data = {v, v, v, v, v, v, v, v, v};
+        snap_.present = 0x1FF;
+    }
+    SensorDataStore::Snapshot snapshot() const
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return snap_;
+    }
+
+private:
+    mutable std::mutex mtx_;
+    SensorDataStore::Snapshot snap_;
+};
+
+template <typename ReadFn, typename WriteFn>
+double readsPerSecond(int readers, ReadFn read, WriteFn write)
+{
+    constexpr auto DURATION = std::chrono::milliseconds(300);
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0};
+
+    std::thread writer([&] {
+        for (double i = 1.0; !stop; i += 1.0)
+        {
+            write(i);
+            std::this_thread::sleep_for(std::chrono::microseconds(100)); // ~10 kHz producer
+        }
+    });
+
+    std::vector<std::thread> pool;
+    for (int r = 0; r < readers; ++r)
+    {
+        pool.emplace_back([&] {
+            uint64_t local = 0;
+            volatile double sink = 0.0;
+            while (!stop)
+            {
+                sink = sink + read().data.ecg;
+                ++local;
+            }
+            reads += local;
+        });
+    }
+
+    std::this_thread::sleep_for(DURATION);
+    stop = true;
+    writer.join();
+    for (auto& t : pool) t.join();
+
+    return reads.load() / std::chrono::duration<double>(DURATION).count();
+}
+
+} // namespace
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("SensorDataStore - Reader contention vs mutex", "[.benchmark][sensor_data_store]") {
+    auto& store = SensorDataStore::instance();
+    MutexStore baseline;
+
+    std::cout << "\nreaders   mutex (Mreads/s)   seqlock (Mreads/s)\n";
+    for (int readers : {1, 2, 4, 8})
+    {
+        const double mutexRate = readsPerSecond(
+            readers, [&] { return baseline.snapshot(); }, [&](double v) { baseline.setBulk(v); });
+        const double seqRate = readsPerSecond(
+            readers, [&] { return store.snapshot(); },
+            [&](double v) { store.setBulk(v, v, v, v, v, v, v, v, v); });
+
+        std::cout << std::setw(7) << readers << std::fixed << std::setprecision(2) << std::setw(19)
+                  << mutexRate / 1e6 << std::setw(21) << seqRate / 1e6 << "\n";
+    }
+
+    store.clear();
+    SUCCEED();
+}
@@ -5,9 +5,75 @@
 
 #include "catch_amalgamated.hpp"
 #include "hardware/sensor_manager.h"
+#include "hardware/hub_emulator.h"
 #include "hardware/i2c_protocol.h"
 
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
 #include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Hub sampling loop: pushes each waveform's due samples into the emulated FIFO
+class HubSampler
+{
+public:
+    HubSampler(HubEmulator& hub, uint32_t startUs)
+        : hub_(hub), startUs_(startUs)
+    {
+    }
+
+    // Take every sample due up to elapsedUs after the start
+    void runUntil(uint64_t elapsedUs)
+    {
+        for (bool pushed = true; pushed;)
+        {
+            pushed = false;
+            for (Channel& channel : channels_)
+            {
+                const uint64_t t = channel.taken * 1000000ULL / channel.hz;
+                if (t <= elapsedUs)
+                {
+                    hub_.pushFifo(channel.id, static_cast<uint32_t>(startUs_ + t), value(channel.id, channel.taken));
+                    ++channel.taken;
+                    pushed = true;
+                }
+            }
+        }
+    }
+
+    static float value(SensorId id, uint64_t index)
+    {
+        return static_cast<float>(id) * 10000.0f + static_cast<float>(index % 1000);
+    }
+
+private:
+    struct Channel
+    {
+        SensorId id;
+        uint64_t hz;
+        uint64_t taken;
+    };
+
+    HubEmulator& hub_;
+    uint32_t startUs_;
+    Channel channels_[3] = {{SensorId::ECG, FIFO_ECG_HZ, 0},
+                            {SensorId::SPO2, FIFO_PLETH_HZ, 0},
+                            {SensorId::RESPIRATORY, FIFO_RESP_HZ, 0}};
+};
+
+std::unique_ptr<SensorManager> makeManager(HubEmulator*& hub, const HubEmulator::Timing& timing = {})
+{
+    auto bus = std::make_unique<HubEmulator>(timing);
+    hub = bus.get();
+    return std::make_unique<SensorManager>(std::make_unique<I2CDriver>(std::move(bus)));
+}
+
+} // namespace
 
 TEST_CASE("SensorManager - Construction and Destruction", "[sensor_manager]") {
     SECTION("Mock mode construction") {
@@ -227,3 +293,310 @@ TEST_CASE("SensorManager - Lifecycle Flow", "[sensor_manager]") {
         REQUIRE(true);
     }
 }
+
+TEST_CASE("SensorManager - Waveform FIFO keeps every sample and its hub time", "[sensor_manager]") {
+    HubEmulator* hub = nullptr;
+    auto mgr = makeManager(hub);
+    // Start a second before the hub's 32-bit microsecond clock wraps
+    const uint32_t startUs = 0xFFFFFFFFu - 999999u;
+    HubSampler sampler(*hub, startUs);
+    REQUIRE(mgr->scanSensors() == 5); // Respiration has no sensor: its samples are dropped
+
+    // Two seconds of 500 Hz ECG, 100 Hz pleth and 25 Hz resp, polled at 50 Hz
+    constexpr uint64_t POLL_US = 20000;
+    for (uint64_t t = 0; t <= 2000000; t += POLL_US) {
+        sampler.runUntil(t);
+        REQUIRE(mgr->pollFifo() >= 0);
+        REQUIRE(hub->fifoLevel() == 0);
+    }
+
+    const struct {
+        SensorType type;
+        SensorId id;
+        uint64_t hz;
+    } channels[] = {{SensorType::ECG, SensorId::ECG, FIFO_ECG_HZ},
+                    {SensorType::SpO2, SensorId::SPO2, FIFO_PLETH_HZ}};
+    for (const auto& channel : channels) {
+        std::vector<WaveformSample> samples;
+        REQUIRE(mgr->takeSamples(channel.type, samples) == 2 * channel.hz + 1);
+        for (size_t i = 0; i < samples.size(); ++i) {
+            // Unwrapped: keeps counting past 2^32
+            REQUIRE(samples[i].timestampUs == startUs + i * 1000000ULL / channel.hz);
+            REQUIRE(samples[i].value == HubSampler::value(channel.id, i));
+        }
+        REQUIRE(mgr->takeSamples(channel.type, samples) == 0);
+    }
+
+    std::vector<WaveformSample> none;
+    REQUIRE(mgr->takeSamples(SensorType::NIBP, none) == 0);
+    REQUIRE(mgr->takeSamples(SensorType::Respiratory, none) == 0); // No sensor attached
+
+    const SensorManager::FifoStats& stats = mgr->fifoStats();
+    REQUIRE(stats.polls == 101);
+    REQUIRE(stats.samples == 1001 + 201 + 51);
+    REQUIRE(stats.reads <= stats.polls);  // 12.5 samples per poll: one READ_FIFO each
+    REQUIRE(stats.hubDropped == 0);
+    REQUIRE(stats.bufferDropped == 0);
+    REQUIRE(stats.unattached == 51);
+}
+
+TEST_CASE("SensorManager - Waveform FIFO drops channels with no sensor attached", "[sensor_manager]") {
+    HubEmulator* hub = nullptr;
+    auto mgr = makeManager(hub);
+    for (SensorId id : {SensorId::SPO2, SensorId::TEMP_CORE, SensorId::TEMP_SKIN, SensorId::NIBP}) {
+        hub->removeSensor(id);
+    }
+    REQUIRE(mgr->scanSensors() == 1);
+    REQUIRE(mgr->attachedSensorBits() == SensorStatusBits::ECG);
+
+    hub->pushFifo(SensorId::ECG, 1000, 0.5f);
+    hub->pushFifo(SensorId::SPO2, 1000, 0.0f);
+    hub->pushFifo(SensorId::RESPIRATORY, 1000, 0.0f);
+    REQUIRE(mgr->pollFifo() == 3);
+
+    std::vector<WaveformSample> samples;
+    REQUIRE(mgr->takeSamples(SensorType::ECG, samples) == 1);
+    REQUIRE(mgr->takeSamples(SensorType::SpO2, samples) == 0);
+    REQUIRE(mgr->takeSamples(SensorType::Respiratory, samples) == 0);
+    REQUIRE(mgr->fifoStats().unattached == 2);
+
+    // Unplugged: its samples are dropped from the next scan on
+    hub->removeSensor(SensorId::ECG);
+    REQUIRE(mgr->scanSensors() == 0);
+    hub->pushFifo(SensorId::ECG, 3000, 0.5f);
+    REQUIRE(mgr->pollFifo() == 1);
+    REQUIRE(mgr->takeSamples(SensorType::ECG, samples) == 0);
+}
+
+TEST_CASE("SensorManager - Waveform FIFO poll interval follows the sample rate", "[sensor_manager]") {
+    HubEmulator* hub = nullptr;
+    auto mgr = makeManager(hub);
+    HubSampler sampler(*hub, 0);
+    REQUIRE(mgr->scanSensors() == 5);
+    using std::chrono::microseconds;
+
+    SECTION("Polls are spaced for one full READ_FIFO each") {
+        mgr->setFifoPollBounds(microseconds(1000), microseconds(100000));
+        for (uint64_t t = 0; t <= 200000; t += 20000) {
+            sampler.runUntil(t);
+            REQUIRE(mgr->pollFifo() > 0);
+        }
+        // 625 samples/s: 28 samples take 44.8 ms
+        REQUIRE(mgr->fifoPollInterval().count() == Catch::Approx(44800).epsilon(0.05));
+    }
+
+    SECTION("The interval stays within its bounds") {
+        for (uint64_t t = 0; t <= 200000; t += 20000) {
+            sampler.runUntil(t);
+            REQUIRE(mgr->pollFifo() > 0);
+        }
+        REQUIRE(mgr->fifoPollInterval() == microseconds(20000));
+    }
+
+    SECTION("A backlog is drained in several reads and polled for again at once") {
+        sampler.runUntil(0);
+        REQUIRE(mgr->pollFifo() == 3);
+        sampler.runUntil(300000); // 150 ECG + 30 pleth + 7 resp
+        REQUIRE(mgr->pollFifo() == 187);
+        REQUIRE(mgr->fifoStats().reads == 1 + 7);
+        REQUIRE(hub->fifoLevel() == 0);
+
+        // A hub that fills faster than a poll can drain it
+        for (size_t i = 0; i < HUB_FIFO_CAPACITY + 5; ++i) {
+            hub->pushFifo(SensorId::ECG, static_cast<uint32_t>(400000 + i), 0.0f);
+        }
+        REQUIRE(mgr->pollFifo() == static_cast<int>(HUB_FIFO_CAPACITY));
+        REQUIRE(mgr->fifoStats().hubDropped == 5);
+    }
+
+    SECTION("Untaken samples are dropped oldest first") {
+        for (uint64_t t = 0; t <= 11000000; t += 20000) {
+            sampler.runUntil(t);
+            REQUIRE(mgr->pollFifo() >= 0);
+        }
+        std::vector<WaveformSample> ecg;
+        REQUIRE(mgr->takeSamples(SensorType::ECG, ecg) == SensorManager::WAVEFORM_BUFFER_SAMPLES);
+        REQUIRE(ecg.back().timestampUs == 11000000);
+        REQUIRE(ecg.front().timestampUs == 11000000 - (SensorManager::WAVEFORM_BUFFER_SAMPLES - 1) * 2000);
+        REQUIRE(mgr->fifoStats().bufferDropped == 5501 - SensorManager::WAVEFORM_BUFFER_SAMPLES);
+    }
+
+    SECTION("No hub") {
+        hub->setPresent(false);
+        REQUIRE(mgr->pollFifo() == -1);
+    }
+}
+
+TEST_CASE("SensorManager - readSensor returns the hub's reading", "[sensor_manager]") {
+    HubEmulator* hub = nullptr;
+    auto mgr = makeManager(hub);
+    hub->setSensor(SensorId::TEMP_CORE, 37.5f);
+    hub->removeSensor(SensorId::NIBP);
+    REQUIRE(mgr->scanSensors() > 0);
+
+    float value = 0.0f;
+    REQUIRE(mgr->readSensor(SensorType::TempCore, value));
+    REQUIRE(value == 37.5f);
+    REQUIRE(mgr->getSensorInfo(SensorType::TempCore).lastValue == 37.5f);
+    REQUIRE_FALSE(mgr->readSensor(SensorType::NIBP, value));
+}
+
+TEST_CASE("SensorManager - Acquisition publishes readings into the store and buffers the FIFO", "[sensor_manager]") {
+    using Task = SensorManager::AcquisitionTask;
+    HubEmulator* hub = nullptr;
+    auto mgr = makeManager(hub);
+    hub->setSensor(SensorId::TEMP_CORE, 37.5f);
+    hub->setSensor(SensorId::TEMP_SKIN, 33.0f);
+    hub->setSensor(SensorId::SPO2, 97.0f);
+    hub->setSensor(SensorId::NIBP, 120.0f);
+    hub->pushFifo(SensorId::ECG, 1000, 0.25f);
+    hub->pushFifo(SensorId::ECG, 3000, 0.5f);
+    hub->pushFifo(SensorId::SPO2, 3000, 0.75f);
+    hub->sample(); // The READ_ALL frame the vitals come from
+
+    SensorDataStore store(1.0);
+    mgr->setAcquisitionRate(SensorType::TempCore, 200.0);
+    mgr->setAcquisitionRate(SensorType::TempSkin, 0.0);
+    SensorManager::AcquisitionConfig config;
+    config.scanInterval = std::chrono::milliseconds(50);
+    REQUIRE(mgr->startAcquisition(&store, config));
+    REQUIRE(mgr->isAcquiring());
+    REQUIRE_FALSE(mgr->startAcquisition(&store, config));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    hub->removeSensor(SensorId::NIBP); // Hot-unplug, picked up by the next scan
+    hub->sample();
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    mgr->stopAcquisition();
+    REQUIRE_FALSE(mgr->isAcquiring());
+
+    const SensorDataStore::Snapshot snapshot = store.snapshot();
+    REQUIRE(snapshot.value(SensorDataStore::Field::TempCavity) == Catch::Approx(37.5));
+    REQUIRE(snapshot.value(SensorDataStore::Field::Spo2) == Catch::Approx(97.0));
+    REQUIRE(snapshot.value(SensorDataStore::Field::BpSystolic) == Catch::Approx(120.0));
+    REQUIRE_FALSE(snapshot.has(SensorDataStore::Field::Ecg));                      // FIFO samples stay buffered
+    REQUIRE_FALSE(snapshot.has(SensorDataStore::Field::Pleth));
+    REQUIRE_FALSE(snapshot.has(SensorDataStore::Field::TempSkin));                 // Rate 0
+    REQUIRE_FALSE(mgr->isSensorAttached(SensorType::NIBP));
+
+    std::vector<WaveformSample> ecg;
+    REQUIRE(mgr->takeSamples(SensorType::ECG, ecg) == 2);
+    REQUIRE(ecg[0].timestampUs == 1000);
+    REQUIRE(ecg[0].value == 0.25f);
+    REQUIRE(ecg[1].timestampUs == 3000);
+    REQUIRE(ecg[1].value == 0.5f);
+    std::vector<WaveformSample> pleth;
+    REQUIRE(mgr->takeSamples(SensorType::SpO2, pleth) == 1);
+    REQUIRE(pleth[0].value == 0.75f);
+
+    // 200 Hz for 0.4 s; a loaded machine may run late, but never more often
+    const SensorManager::AcquisitionStats temp = mgr->acquisitionStats(Task::TempCore);
+    REQUIRE(temp.runs > 10);
+    REQUIRE(temp.runs <= 81);
+    REQUIRE(temp.failures == 0);
+    REQUIRE(temp.jitter.count == temp.runs);
+    REQUIRE(mgr->acquisitionStats(Task::TempSkin).runs == 0);
+    REQUIRE(mgr->acquisitionStats(Task::HotPlugScan).runs >= 2);
+    REQUIRE(mgr->acquisitionStats(Task::Waveforms).runs > 0);
+    REQUIRE(std::string(SensorManager::acquisitionTaskName(Task::TempCore)) == "temp_core");
+}
+
+TEST_CASE("SensorManager - Acquisition reads the vitals due together in one READ_ALL", "[sensor_manager]") {
+    using Task = SensorManager::AcquisitionTask;
+    HubEmulator* hub = nullptr;
+    auto mgr = makeManager(hub);
+    hub->setSensor(SensorId::TEMP_CORE, 37.5f);
+    hub->setSensor(SensorId::TEMP_SKIN, std::numeric_limits<float>::quiet_NaN()); // A sensor fault
+    hub->removeSensor(SensorId::ECG);
+    hub->removeSensor(SensorId::SPO2);
+    hub->removeSensor(SensorId::NIBP);
+    hub->sample();
+    mgr->setAcquisitionRate(SensorType::TempCore, 50.0);
+    mgr->setAcquisitionRate(SensorType::TempSkin, 50.0);
+    mgr->setFifoPollBounds(std::chrono::seconds(10), std::chrono::seconds(10));
+
+    SensorDataStore store(1.0);
+    SensorManager::AcquisitionConfig config;
+    config.scanInterval = std::chrono::seconds(10);
+    const uint64_t before = hub->transfers();
+    REQUIRE(mgr->startAcquisition(&store, config));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    mgr->stopAcquisition();
+
+    const SensorManager::AcquisitionStats core = mgr->acquisitionStats(Task::TempCore);
+    const SensorManager::AcquisitionStats skin = mgr->acquisitionStats(Task::TempSkin);
+    REQUIRE(core.runs > 0);
+    REQUIRE(core.failures == 0);
+    REQUIRE(skin.runs == core.runs);
+    REQUIRE(skin.failures == skin.runs);  // NaN is never published
+    // The first scan and FIFO_LEVEL, then one transfer per due tick for both sensors
+    REQUIRE(hub->transfers() - before == 2 + core.runs);
+
+    const SensorDataStore::Snapshot snapshot = store.snapshot();
+    REQUIRE(snapshot.value(SensorDataStore::Field::TempCavity) == 37.5);
+    REQUIRE_FALSE(snapshot.has(SensorDataStore::Field::TempSkin));
+}
+
+TEST_CASE("SensorManager - Acquisition counts the deadlines a slow read overruns", "[sensor_manager]") {
+    using Task = SensorManager::AcquisitionTask;
+    HubEmulator* hub = nullptr;
+    // 2 kHz bus: one full-length READ_ALL takes about 125 ms
+    auto mgr = makeManager(hub, HubEmulator::atClock(2000, std::chrono::microseconds(0)));
+    hub->setSensor(SensorId::TEMP_CORE, 37.5f);
+    hub->sample();
+    for (SensorType type : {SensorType::SpO2, SensorType::TempSkin, SensorType::NIBP}) {
+        mgr->setAcquisitionRate(type, 0.0);
+    }
+    mgr->setAcquisitionRate(SensorType::TempCore, 100.0);
+    mgr->setFifoPollBounds(std::chrono::seconds(10), std::chrono::seconds(10));
+
+    SensorManager::AcquisitionConfig config;
+    config.scanInterval = std::chrono::seconds(10);
+    REQUIRE(mgr->startAcquisition(nullptr, config));
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    mgr->stopAcquisition();
+
+    const SensorManager::AcquisitionStats temp = mgr->acquisitionStats(Task::TempCore);
+    REQUIRE(temp.runs >= 1);
+    REQUIRE(temp.overruns >= 5 * temp.runs);
+    REQUIRE(temp.runs + temp.overruns <= 60);
+}
+
+TEST_CASE("SensorManager - Acquisition pinned to a CPU keeps normal scheduling", "[sensor_manager]") {
+    SensorManager mgr(true);
+    SensorManager::AcquisitionConfig config;
+    config.cpu = 0;
+    REQUIRE(mgr.startAcquisition(nullptr, config));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(mgr.isAcquiring());
+    REQUIRE_FALSE(mgr.acquisitionRealtime()); // Not requested
+    mgr.stopAcquisition();
+    REQUIRE(mgr.acquisitionStats(SensorManager::AcquisitionTask::HotPlugScan).runs == 1);
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("SensorManager - Acquisition wake-up jitter", "[.benchmark][sensor_manager]") {
+    using Task = SensorManager::AcquisitionTask;
+    auto run = [](int priority) {
+        HubEmulator* hub = nullptr;
+        auto mgr = makeManager(hub);
+        mgr->setAcquisitionRate(SensorType::ECG, 500.0);
+        SensorManager::AcquisitionConfig config;
+        config.realtimePriority = priority;
+        config.cpu = 0;
+        REQUIRE(mgr->startAcquisition(nullptr, config));
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+        const bool realtime = mgr->acquisitionRealtime();
+        mgr->stopAcquisition();
+        const SensorManager::AcquisitionStats stats = mgr->acquisitionStats(Task::ECG);
+        std::cout << "\n[BENCHMARK]   " << (realtime ? "SCHED_FIFO:   " : "SCHED_OTHER:  ") << stats.runs << " runs, "
+                  << stats.overruns << " overruns, jitter p50 " << stats.jitter.p50Us << " us, p99 "
+                  << stats.jitter.p99Us << " us, max " << stats.jitter.maxUs << " us";
+        REQUIRE(stats.runs > 0);
+    };
+
+    std::cout << "\n[BENCHMARK] 500 Hz READ_SENSOR on absolute deadlines, 2 s:";
+    run(0);
+    run(50);
+    std::cout << std::endl;
+}
@@ -5,10 +5,16 @@
 
 #include "catch_amalgamated.hpp"
 #include "core/signal_generator.h"
+#include "core/waveform_kernels.h"
+#include "core/SensorDataStore.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <iostream>
 #include <thread>
 #include <chrono>
+#include <vector>
 
 TEST_CASE("SignalGenerator - Basic Initialization", "[signal_generator]") {
     SignalGenerator gen;
@@ -222,3 +228,250 @@ TEST_CASE("SignalGenerator - Complete SensorData Structure", "[signal_generator]
         REQUIRE_FALSE(std::isnan(data.timestamp));
     }
 }
+
+TEST_CASE("SignalGenerator - Sample blocks", "[signal_generator]") {
+    SignalGenerator gen;
+    constexpr double RATE = 250.0;
+    constexpr size_t N = 250;
+    std::vector<SignalGenerator::SensorData> block(N);
+    gen.generateBlock(10.0, 1.0 / RATE, N, block.data());
+    
+    SECTION("Samples are taken at t0 + i * dt") {
+        for (size_t i = 0; i < N; ++i) {
+            REQUIRE(block[i].timestamp == Catch::Approx(10.0 + i / RATE).margin(1e-12));
+        }
+    }
+    
+    SECTION("A block equals the same samples taken one at a time") {
+        for (size_t i = 0; i < N; i += 17) {
+            SignalGenerator::SensorData one;
+            gen.generateBlock(10.0 + i / RATE, 1.0 / RATE, 1, &one);
+            REQUIRE(one.ecg == Catch::Approx(block[i].ecg).margin(1e-9));
+            REQUIRE(one.pleth == Catch::Approx(block[i].pleth).margin(1e-9));
+            REQUIRE(one.resp == Catch::Approx(block[i].resp).margin(1e-9));
+        }
+    }
+    
+    SECTION("Native rate resolves the R wave that 20 Hz sampling misses") {
+        // The R peak is about 10 ms wide; at 20 Hz (50 ms) most beats miss it
+        double peak250 = 0.0;
+        for (const auto& s : block) {
+            peak250 = std::max(peak250, s.ecg);
+        }
+        double peak20 = 0.0;
+        for (size_t i = 0; i < N; i += static_cast<size_t>(RATE / 20.0)) {
+            peak20 = std::max(peak20, block[i].ecg);
+        }
+        REQUIRE(peak250 > 0.9);
+        REQUIRE(peak250 > peak20 + 0.2);
+    }
+    
+    SECTION("Empty block writes nothing") {
+        gen.generateBlock(0.0, 0.004, 0, nullptr);
+    }
+}
+
+TEST_CASE("SignalGenerator - Block synthesis matches the scalar path", "[signal_generator]") {
+    SECTION("fastSinCycles") {
+        double sinError = 0.0;
+        for (double c = -3.0; c <= 3.0; c += 0.0001) {
+            sinError = std::max(sinError, std::abs(WaveformKernels::fastSinCycles(c) - std::sin(2.0 * M_PI * c)));
+        }
+        REQUIRE(sinError < 1e-9);
+    }
+    
+    SECTION("Blocks agree with generateAt() on every channel") {
+        SignalGenerator gen;
+        // Offsets keep sample times off the exact segment boundaries, where
+        // either side is a correct answer
+        for (double rate : {250.0, 500.0, 1000.0}) {
+            const double t0 = 3600.0013;
+            const size_t n = static_cast<size_t>(rate * 10);
+            std::vector<SignalGenerator::SensorData> block(n);
+            gen.generateBlock(t0, 1.0 / rate, n, block.data());
+            
+            double maxError = 0.0;
+            double maxBeatError = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                const auto ref = gen.generateAt(t0 + static_cast<double>(i) / rate);
+                const auto& s = block[i];
+                for (double e : {s.spo2 - ref.spo2, s.resp - ref.resp, s.bp_systolic - ref.bp_systolic,
+                                 s.bp_diastolic - ref.bp_diastolic, s.temp_cavity - ref.temp_cavity,
+                                 s.temp_skin - ref.temp_skin}) {
+                    maxError = std::max(maxError, std::abs(e));
+                }
+                // ECG and pleth are interpolated from the beat templates
+                maxBeatError = std::max({maxBeatError, std::abs(s.ecg - ref.ecg), std::abs(s.pleth - ref.pleth)});
+            }
+            INFO("rate " << rate << " Hz, max error " << maxError << ", beat shapes " << maxBeatError);
+            REQUIRE(maxError < 1e-6);
+            REQUIRE(maxBeatError < 1e-3);
+        }
+    }
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("SignalGenerator - Block synthesis vs scalar", "[.benchmark][signal_generator]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr double RATE = 1000.0;
+    constexpr size_t N = 1000000;
+    SignalGenerator gen;
+    std::vector<SignalGenerator::SensorData> out(N);
+    
+    auto start = Clock::now();
+    for (size_t i = 0; i < N; ++i) {
+        out[i] = gen.generateAt(static_cast<double>(i) / RATE);
+    }
+    const double scalarNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / N;
+    const double scalarCheck = out[N / 3].ecg;
+    
+    // Blocks of one second, as a multi-patient simulator would request them
+    start = Clock::now();
+    for (size_t i = 0; i < N; i += static_cast<size_t>(RATE)) {
+        gen.generateBlock(static_cast<double>(i) / RATE, 1.0 / RATE, static_cast<size_t>(RATE), &out[i]);
+    }
+    const double blockNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / N;
+    
+    std::cout << "\n[BENCHMARK] Waveform synthesis, all channels (" << WaveformKernels::simdTarget()
+              << " kernels)" << std::endl;
+    std::cout << "  scalar generateAt(): " << scalarNs << " ns/sample" << std::endl;
+    std::cout << "  generateBlock():     " << blockNs << " ns/sample (" << scalarNs / blockNs << "x)"
+              << std::endl;
+    
+    REQUIRE(out[N / 3].ecg == Catch::Approx(scalarCheck).margin(1e-6));
+}
+
+TEST_CASE("SignalGenerator - Physiology drives the waveforms", "[signal_generator]") {
+    constexpr double RATE = 500.0;
+    
+    // Times of R peaks (local ECG maxima above 0.9) in a block
+    auto rPeaks = [](const std::vector<SignalGenerator::SensorData>& block) {
+        std::vector<double> peaks;
+        for (size_t i = 1; i + 1 < block.size(); ++i) {
+            if (block[i].ecg > 0.9 && block[i].ecg >= block[i - 1].ecg && block[i].ecg > block[i + 1].ecg) {
+                peaks.push_back(block[i].timestamp);
+            }
+        }
+        return peaks;
+    };
+    
+    SECTION("Defaults match the original fixed values") {
+        SignalGenerator gen;
+        const auto p = gen.physiology();
+        REQUIRE(p.heartRateBpm == 75.0);
+        REQUIRE(p.respRateBpm == 18.0);
+        REQUIRE(p.spo2 == 97.5);
+        REQUIRE(p.bpSystolic == 120.0);
+        REQUIRE(p.bpDiastolic == 80.0);
+    }
+    
+    SECTION("Heart rate sets the beat interval") {
+        SignalGenerator gen;
+        SignalGenerator::Physiology p;
+        p.heartRateBpm = 120.0;
+        gen.setPhysiology(p);
+        
+        std::vector<SignalGenerator::SensorData> block(static_cast<size_t>(RATE * 4));
+        gen.generateBlock(0.0013, 1.0 / RATE, block.size(), block.data());
+        const auto peaks = rPeaks(block);
+        REQUIRE(peaks.size() >= 7);
+        for (size_t i = 1; i < peaks.size(); ++i) {
+            REQUIRE(peaks[i] - peaks[i - 1] == Catch::Approx(0.5).margin(2.0 / RATE));
+        }
+    }
+    
+    SECTION("Rate changes are phase-continuous") {
+        SignalGenerator steady;
+        SignalGenerator changed;
+        const size_t n = static_cast<size_t>(RATE);
+        std::vector<SignalGenerator::SensorData> before(n);
+        std::vector<SignalGenerator::SensorData> after(n * 3);
+        changed.generateBlock(0.0013, 1.0 / RATE, n, before.data());
+        
+        SignalGenerator::Physiology p;
+        p.heartRateBpm = 150.0;
+        p.respRateBpm = 30.0;
+        changed.setPhysiology(p);
+        const double t1 = 0.0013 + n / RATE;
+        changed.generateBlock(t1, 1.0 / RATE, after.size(), after.data());
+        
+        // The first sample after the change continues where the old rate left off...
+        const auto reference = steady.generateAt(t1);
+        REQUIRE(after[0].ecg == Catch::Approx(reference.ecg).margin(1e-3));
+        REQUIRE(after[0].pleth == Catch::Approx(reference.pleth).margin(1e-3));
+        REQUIRE(after[0].resp == Catch::Approx(reference.resp).margin(1e-6));
+        
+        // ...with no larger step than the waveform makes anyway
+        const double seam = std::abs(after[0].pleth - before.back().pleth);
+        double largestStep = 0.0;
+        for (size_t i = 1; i < before.size(); ++i) {
+            largestStep = std::max(largestStep, std::abs(before[i].pleth - before[i - 1].pleth));
+        }
+        REQUIRE(seam <= largestStep);
+        
+        // ...and then runs at the new rate
+        const auto peaks = rPeaks(after);
+        REQUIRE(peaks.size() >= 6);
+        for (size_t i = 1; i < peaks.size(); ++i) {
+            REQUIRE(peaks[i] - peaks[i - 1] == Catch::Approx(0.4).margin(2.0 / RATE));
+        }
+    }
+    
+    SECTION("SpO2 and blood pressure follow their baselines") {
+        SignalGenerator gen;
+        SignalGenerator::Physiology p;
+        p.spo2 = 88.0;
+        p.bpSystolic = 90.0;
+        p.bpDiastolic = 55.0;
+        gen.setPhysiology(p);
+        
+        const auto data = gen.generateAt(100.0);
+        REQUIRE(data.bp_systolic == Catch::Approx(90.0).margin(5.0));
+        REQUIRE(data.bp_diastolic == Catch::Approx(55.0).margin(2.5));
+        // The live store value, when present, still wins over the simulation
+        if (!SensorDataStore::instance().hasSpo2()) {
+            REQUIRE(data.spo2 == Catch::Approx(88.0).margin(1.0));
+        }
+    }
+    
+    SECTION("Implausible values are clamped") {
+        SignalGenerator gen;
+        SignalGenerator::Physiology p;
+        p.heartRateBpm = 1000.0;
+        p.respRateBpm = std::nan("");
+        p.spo2 = 120.0;
+        p.bpSystolic = 100.0;
+        p.bpDiastolic = 150.0;
+        gen.setPhysiology(p);
+        
+        const auto q = gen.physiology();
+        REQUIRE(q.heartRateBpm == 300.0);
+        REQUIRE(q.respRateBpm == 18.0);
+        REQUIRE(q.spo2 == 100.0);
+        REQUIRE(q.bpDiastolic == 100.0);
+    }
+    
+    SECTION("Updates from another thread while generating") {
+        SignalGenerator gen;
+        std::atomic<bool> done{false};
+        std::thread writer([&] {
+            SignalGenerator::Physiology p;
+            for (int i = 0; !done.load(); ++i) {
+                p.heartRateBpm = 60.0 + (i % 60);
+                gen.setPhysiology(p);
+            }
+        });
+        std::vector<SignalGenerator::SensorData> block(250);
+        bool finite = true;
+        for (int i = 0; i < 200; ++i) {
+            gen.generateBlock(i, 1.0 / 250.0, block.size(), block.data());
+            for (const auto& s : block) {
+                finite = finite && std::isfinite(s.ecg) && std::isfinite(s.pleth);
+            }
+        }
+        done = true;
+        writer.join();
+        REQUIRE(finite);
+        REQUIRE(gen.physiology().heartRateBpm >= 60.0);
+    }
+}
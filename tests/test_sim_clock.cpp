@@ -0,0 +1,155 @@
+/**
+ * @file test_sim_clock.cpp
+ * @brief Unit tests and accelerated-run benchmark for the simulation clock
+ */
+
+#include "catch_amalgamated.hpp"
+#include "core/sim_clock.h"
+#include "core/signal_generator.h"
+#include "core/SensorDataStore.h"
+#include "hardware/i2c_driver.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+TEST_CASE("SimClock - Fixed step", "[sim_clock]") {
+    auto clock = SimClock::fixedStep(0.004);
+    REQUIRE(clock->mode() == SimClock::Mode::FixedStep);
+    REQUIRE(clock->step() == 0.004);
+
+    SECTION("Time only moves on tick()") {
+        REQUIRE(clock->now() == 0.0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        REQUIRE(clock->now() == 0.0);
+
+        clock->tick();
+        REQUIRE(clock->now() == Catch::Approx(0.004));
+        clock->tick(249);
+        REQUIRE(clock->now() == Catch::Approx(1.0));
+    }
+
+    SECTION("Long runs do not accumulate rounding error") {
+        clock->tick(900000); // An hour at 250 Hz
+        REQUIRE(clock->now() == 900000 * 0.004);
+    }
+
+    SECTION("reset() returns to zero") {
+        clock->tick(10);
+        clock->reset();
+        REQUIRE(clock->now() == 0.0);
+    }
+
+    SECTION("Invalid steps fall back to the default") {
+        REQUIRE(SimClock::fixedStep(0.0)->step() > 0.0);
+        REQUIRE(SimClock::fixedStep(-1.0)->step() > 0.0);
+    }
+}
+
+TEST_CASE("SimClock - Real and scaled", "[sim_clock]") {
+    SECTION("Real time advances with the wall clock") {
+        auto clock = SimClock::real();
+        REQUIRE(clock->speed() == 1.0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        REQUIRE(clock->now() >= 0.02);
+        REQUIRE(clock->now() < 1.0);
+
+        clock->tick(100); // No effect outside FixedStep
+        REQUIRE(clock->now() < 1.0);
+    }
+
+    SECTION("Scaled time runs speed times faster") {
+        auto clock = SimClock::scaled(100.0);
+        REQUIRE(clock->mode() == SimClock::Mode::Scaled);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        REQUIRE(clock->now() >= 2.0);
+
+        clock->reset();
+        REQUIRE(clock->now() < 2.0);
+    }
+
+    SECTION("Invalid speeds fall back to real time") {
+        REQUIRE(SimClock::scaled(0.0)->speed() == 1.0);
+        REQUIRE(SimClock::scaled(-5.0)->speed() == 1.0);
+    }
+}
+
+TEST_CASE("SimClock - Shared fixed clock makes runs reproducible", "[sim_clock]") {
+    SECTION("Mock sensors read identical values") {
+        auto clock = SimClock::fixedStep(0.002);
+        I2CDriver a(1, true);
+        I2CDriver b(1, true);
+        a.setClock(clock);
+        b.setClock(clock);
+
+        bool identical = true;
+        for (int i = 0; i < 1000; ++i) {
+            float va = 0.0f;
+            float vb = 0.0f;
+            REQUIRE(a.readSensor(SensorId::ECG, va));
+            REQUIRE(b.readSensor(SensorId::ECG, vb));
+            identical = identical && va == vb;
+            clock->tick();
+        }
+        REQUIRE(identical);
+    }
+
+    SECTION("Signal generators on equal clocks produce equal frames") {
+        SignalGenerator a;
+        SignalGenerator b;
+        a.setClock(SimClock::fixedStep(0.004));
+        b.setClock(SimClock::fixedStep(0.004));
+
+        bool identical = true;
+        for (int i = 0; i < 500; ++i) {
+            const auto fa = a.generate();
+            const auto fb = b.generate();
+            identical = identical && fa.ecg == fb.ecg && fa.spo2 == fb.spo2 && fa.resp == fb.resp &&
+                        fa.timestamp == fb.timestamp;
+            a.clock()->tick();
+            b.clock()->tick();
+        }
+        REQUIRE(identical);
+        REQUIRE(a.getTime() == Catch::Approx(2.0));
+    }
+
+    SECTION("Null clocks are ignored") {
+        SignalGenerator gen;
+        auto clock = gen.clock();
+        gen.setClock(nullptr);
+        REQUIRE(gen.clock() == clock);
+    }
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("SimClock - An hour of simulated monitoring", "[.benchmark][sim_clock]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr double RATE_HZ = 250.0;
+    constexpr double SIMULATED_SECONDS = 3600.0;
+    constexpr size_t FRAME_SAMPLES = 50; // 5 Hz frames of 250 Hz samples
+    const size_t frames = static_cast<size_t>(SIMULATED_SECONDS * RATE_HZ) / FRAME_SAMPLES;
+
+    auto clock = SimClock::fixedStep(FRAME_SAMPLES / RATE_HZ);
+    SignalGenerator gen;
+    gen.setClock(clock);
+    auto& store = SensorDataStore::instance();
+    std::vector<SignalGenerator::SensorData> block(FRAME_SAMPLES);
+
+    const auto start = Clock::now();
+    for (size_t f = 0; f < frames; ++f) {
+        gen.generateBlock(clock->now(), 1.0 / RATE_HZ, FRAME_SAMPLES, block.data());
+        for (const auto& sample : block) {
+            store.recordHistory(sample);
+        }
+        clock->tick();
+    }
+    const double wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << "\n[BENCHMARK] " << SIMULATED_SECONDS << " s simulated at " << RATE_HZ << " Hz in "
+              << wallSeconds << " s wall time (" << clock->now() / wallSeconds << "x real time)"
+              << std::endl;
+
+    REQUIRE(clock->now() == Catch::Approx(SIMULATED_SECONDS));
+    REQUIRE(wallSeconds < SIMULATED_SECONDS);
+}
@@ -0,0 +1,224 @@
+/**
+ * @file test_stream_subscription.cpp
+ * @brief Unit tests for stream channel subscriptions and decimation
+ */
+
+#include "catch_amalgamated.hpp"
+#include "server/stream_subscription.h"
+#include "server/frame_codec.h"
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace {
+
+using Field = SensorDataStore::Field;
+
+uint16_t bit(Field field)
+{
+    return static_cast<uint16_t>(1u << static_cast<unsigned>(field));
+}
+
+StreamSubscription parsed(const std::map<std::string, std::string>& params)
+{
+    StreamSubscription sub;
+    REQUIRE(StreamSubscription::parse(params, sub));
+    return sub;
+}
+
+} // namespace
+
+TEST_CASE("StreamSubscription - Default sends everything every tick", "[stream_subscription]") {
+    const StreamSubscription sub = parsed({{"format", "binary"}});
+
+    REQUIRE(sub.isDefault());
+    REQUIRE(sub.sensors());
+    REQUIRE(sub.channels() == StreamSubscription::ALL_CHANNELS);
+    for (uint64_t tick = 0; tick < 10; ++tick)
+    {
+        REQUIRE(sub.dueChannels(tick, 20) == StreamSubscription::ALL_CHANNELS);
+    }
+}
+
+TEST_CASE("StreamSubscription - Channel selection", "[stream_subscription]") {
+    SECTION("Listed channels only, no sensor status unless asked") {
+        const auto sub = parsed({{"channels", "ecg,pleth"}});
+        REQUIRE(sub.channels() == (bit(Field::Ecg) | bit(Field::Pleth)));
+        REQUIRE_FALSE(sub.sensors());
+        REQUIRE_FALSE(sub.isDefault());
+    }
+
+    SECTION("Sensor status can be requested") {
+        const auto sub = parsed({{"channels", "spo2,sensors"}});
+        REQUIRE(sub.channels() == bit(Field::Spo2));
+        REQUIRE(sub.sensors());
+    }
+
+    SECTION("Unknown channels and empty lists are rejected") {
+        StreamSubscription sub;
+        std::string error;
+        REQUIRE_FALSE(StreamSubscription::parse({{"channels", "ecg,heart"}}, sub, &error));
+        REQUIRE(error.find("heart") != std::string::npos);
+        REQUIRE_FALSE(StreamSubscription::parse({{"channels", "timestamp"}}, sub));
+        REQUIRE_FALSE(StreamSubscription::parse({{"channels", ","}}, sub));
+    }
+}
+
+TEST_CASE("StreamSubscription - Rates and decimation", "[stream_subscription]") {
+    SECTION("Group rates, overridden per channel") {
+        const auto sub = parsed({{"vitals_hz", "1"}, {"waveform_hz", "10"}, {"resp_hz", "5"}});
+        REQUIRE(sub.rateHz(Field::Spo2) == 1.0);
+        REQUIRE(sub.rateHz(Field::TempSkin) == 1.0);
+        REQUIRE(sub.rateHz(Field::Ecg) == 10.0);
+        REQUIRE(sub.rateHz(Field::Resp) == 5.0);
+
+        REQUIRE(sub.decimation(Field::Spo2, 20) == 20);
+        REQUIRE(sub.decimation(Field::Ecg, 20) == 2);
+        REQUIRE(sub.decimation(Field::Resp, 20) == 4);
+    }
+
+    SECTION("Rates at or above the tick rate send every tick") {
+        const auto sub = parsed({{"channels", "ecg"}, {"ecg_hz", "250"}});
+        REQUIRE(sub.decimation(Field::Ecg, 20) == 1);
+        REQUIRE(sub.decimation(Field::Ecg, 0) == 1);
+    }
+
+    SECTION("Due channels follow the decimation") {
+        const auto sub = parsed({{"channels", "ecg,spo2"}, {"spo2_hz", "1"}});
+        int ecg = 0;
+        int spo2 = 0;
+        for (uint64_t tick = 1; tick <= 100; ++tick)
+        {
+            const uint16_t due = sub.dueChannels(tick, 20);
+            ecg += (due & bit(Field::Ecg)) ? 1 : 0;
+            spo2 += (due & bit(Field::Spo2)) ? 1 : 0;
+        }
+        REQUIRE(ecg == 100);
+        REQUIRE(spo2 == 5);
+    }
+
+    SECTION("Invalid rates are rejected") {
+        StreamSubscription sub;
+        for (const char* rate : {"0", "-1", "abc", "5x", "", "nan", "inf"})
+        {
+            INFO(rate);
+            REQUIRE_FALSE(StreamSubscription::parse({{"ecg_hz", rate}}, sub));
+        }
+    }
+}
+
+TEST_CASE("StreamSubscription - Canonical key", "[stream_subscription]") {
+    const auto a = parsed({{"channels", "pleth,ecg"}, {"ecg_hz", "250"}});
+    const auto b = parsed({{"channels", "ecg,pleth,ecg"}, {"ecg_hz", "250.0"}});
+    const auto c = parsed({{"channels", "ecg,pleth"}});
+
+    REQUIRE(a.key() == "ecg@250,pleth");
+    REQUIRE(a.key() == b.key());
+    REQUIRE(a.key() != c.key());
+    REQUIRE(parsed({}).key() == "ecg,spo2,resp,pleth,bp_systolic,bp_diastolic,temp_cavity,temp_skin,sensors");
+}
+
+TEST_CASE("StreamSubscription - Bed selection", "[stream_subscription]") {
+    const auto own = parsed({{"channels", "ecg"}});
+    const auto bed = parsed({{"channels", "ecg"}, {"bed", "12"}});
+
+    REQUIRE(own.bed().empty());
+    REQUIRE(bed.bed() == "12");
+    REQUIRE(bed.key() == "bed/12:ecg");
+    REQUIRE(bed.key() != own.key());
+    REQUIRE_FALSE(parsed({{"bed", "icu-3"}}).isDefault());
+
+    StreamSubscription sub;
+    for (const char* id : {"", "a/b", "bed 1", "#", "+"})
+    {
+        INFO(id);
+        REQUIRE_FALSE(StreamSubscription::parse({{"bed", id}}, sub));
+    }
+}
+
+TEST_CASE("StreamSubscription - Overview tile bandwidth", "[.benchmark][stream_subscription]") {
+    using json = nlohmann::json;
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int TICK_HZ = 20;
+    constexpr int SECONDS = 500;
+    const json sensors = {{"ecg", true}, {"spo2", true}, {"temp_core", true},
+                          {"temp_skin", true}, {"nibp", true}, {"resp", true}};
+
+    SignalGenerator::SensorData data{};
+    data.ecg = 0.53;
+    data.spo2 = 97.8;
+    data.resp = -0.41;
+    data.pleth = 0.79;
+    data.bp_systolic = 121.2;
+    data.bp_diastolic = 80.6;
+    data.temp_cavity = 37.2;
+    data.temp_skin = 36.9;
+
+    struct Result
+    {
+        size_t jsonBytes = 0;
+        size_t binaryBytes = 0;
+        double seconds = 0.0;
+    };
+
+    // Mirrors WebServer::publishFrame(): one JSON and one binary payload per due tick
+    auto run = [&](const StreamSubscription& sub) {
+        Result r;
+        const double values[] = {data.ecg, data.spo2, data.resp, data.pleth,
+                                 data.bp_systolic, data.bp_diastolic, data.temp_cavity, data.temp_skin};
+        const auto start = Clock::now();
+        for (uint32_t tick = 1; tick <= SECONDS * TICK_HZ; ++tick)
+        {
+            const uint16_t due = sub.dueChannels(tick, TICK_HZ);
+            if (due == 0)
+            {
+                continue;
+            }
+            data.timestamp = tick / static_cast<double>(TICK_HZ);
+
+            json j;
+            for (size_t i = 0; i < StreamSubscription::CHANNEL_COUNT; ++i)
+            {
+                if (due & (1u << i))
+                {
+                    j[SensorDataStore::fieldName(static_cast<Field>(i))] = values[i];
+                }
+            }
+            j["timestamp"] = data.timestamp;
+            if (sub.sensors())
+            {
+                j["sensors"] = sensors;
+            }
+            r.jsonBytes += j.dump().size();
+
+            uint8_t raw[FrameCodec::BINARY_CHANNELS_FRAME_MAX_SIZE];
+            r.binaryBytes += (due == StreamSubscription::ALL_CHANNELS)
+                                 ? (FrameCodec::encodeBinary(data, 0x3F, tick, raw), FrameCodec::BINARY_FRAME_SIZE)
+                                 : FrameCodec::encodeBinaryChannels(data, 0x3F, tick, due, raw);
+        }
+        r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return r;
+    };
+
+    const Result full = run(StreamSubscription());
+    const Result tile = run(parsed({{"channels", "spo2,bp_systolic,bp_diastolic"}, {"vitals_hz", "1"}}));
+    const Result waves = run(parsed({{"channels", "ecg,pleth"}, {"ecg_hz", "250"}, {"vitals_hz", "1"}}));
+
+    auto report = [](const char* name, const Result& r) {
+        std::cout << "  " << name << ": JSON " << r.jsonBytes / SECONDS << " B/s, binary "
+                  << r.binaryBytes / SECONDS << " B/s, encode " << r.seconds * 1e6 / SECONDS << " us/s"
+                  << std::endl;
+    };
+    std::cout << "\n[BENCHMARK] Stream bytes and encode time per client-second at " << TICK_HZ << " Hz"
+              << std::endl;
+    report("everything        ", full);
+    report("vitals tile (1 Hz)", tile);
+    report("ecg + pleth       ", waves);
+
+    REQUIRE(tile.jsonBytes * 10 < full.jsonBytes);
+    REQUIRE(waves.jsonBytes * 2 < full.jsonBytes);
+}
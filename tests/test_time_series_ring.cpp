@@ -0,0 +1,171 @@
+/**
+ * @file test_time_series_ring.cpp
+ * @brief Unit tests for per-channel history ring buffers
+ */
+
+#include "catch_amalgamated.hpp"
+#include "core/time_series_ring.h"
+#include "core/SensorDataStore.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+TEST_CASE("TimeSeriesRing - Range reads", "[time_series_ring]") {
+    TimeSeriesRing ring(100);
+
+    SECTION("Empty ring") {
+        std::vector<TimeSample> out;
+        TimeSample last{};
+        REQUIRE(ring.readRange(0.0, 10.0, out) == 0);
+        REQUIRE_FALSE(ring.latest(last));
+        REQUIRE(ring.size() == 0);
+    }
+
+    SECTION("Inclusive range by timestamp") {
+        for (int i = 0; i < 50; ++i) ring.push(i * 0.1, i);
+
+        std::vector<TimeSample> out;
+        REQUIRE(ring.readRange(1.0, 2.0, out) == 11);
+        REQUIRE(out.front().v == 10);
+        REQUIRE(out.back().v == 20);
+
+        TimeSample last{};
+        REQUIRE(ring.latest(last));
+        REQUIRE(last.v == 49);
+    }
+
+    SECTION("Oldest samples are overwritten after wrap-around") {
+        for (int i = 0; i < 250; ++i) ring.push(i, i);
+
+        std::vector<TimeSample> out;
+        REQUIRE(ring.readRange(0.0, 1e9, out) == 100);
+        REQUIRE(out.front().v == 150);
+        REQUIRE(out.back().v == 249);
+        REQUIRE(ring.size() == 100);
+        REQUIRE(ring.totalPushed() == 250);
+    }
+
+    SECTION("maxSamples keeps the newest samples") {
+        for (int i = 0; i < 50; ++i) ring.push(i, i);
+
+        std::vector<TimeSample> out;
+        REQUIRE(ring.readRange(0.0, 1e9, out, 5) == 5);
+        REQUIRE(out.front().v == 45);
+        REQUIRE(out.back().v == 49);
+
+        // The newest of the range, not of the ring; to is inclusive
+        out.clear();
+        REQUIRE(ring.readRange(10.0, 20.0, out, 3) == 3);
+        REQUIRE(out.front().v == 18);
+        REQUIRE(out.back().v == 20);
+
+        // A limit larger than the range returns all of it, appended
+        REQUIRE(ring.readRange(10.0, 11.0, out, 5) == 2);
+        REQUIRE(out.size() == 5);
+        REQUIRE(out.back().v == 11);
+    }
+}
+
+TEST_CASE("TimeSeriesRing - Concurrent reader sees ordered, untorn samples", "[time_series_ring]") {
+    TimeSeriesRing ring(256);
+    std::atomic<bool> stop{false};
+
+    std::thread writer([&] {
+        for (uint64_t i = 0; !stop; ++i)
+        {
+            ring.push(static_cast<double>(i), static_cast<double>(i));
+        }
+    });
+
+    bool ok = true;
+    std::vector<TimeSample> out;
+    for (int n = 0; n < 20000 && ok; ++n)
+    {
+        out.clear();
+        ring.readRange(0.0, 1e18, out);
+        for (size_t i = 0; i < out.size() && ok; ++i)
+        {
+            ok = out[i].t == out[i].v && (i == 0 || out[i].t == out[i - 1].t + 1.0);
+        }
+    }
+
+    stop = true;
+    writer.join();
+    REQUIRE(ok);
+}
+
+TEST_CASE("TimeSeriesRing - Overwrites during a read do not cut the range short", "[time_series_ring]") {
+    TimeSeriesRing ring(256);
+    std::atomic<bool> stop{false};
+
+    std::thread writer([&] {
+        for (uint64_t i = 0; !stop; ++i)
+        {
+            ring.push(static_cast<double>(i), static_cast<double>(i));
+        }
+    });
+
+    // The window starts at the oldest slot, which the writer overwrites first
+    bool ok = true;
+    std::vector<TimeSample> out;
+    TimeSample last{};
+    for (int n = 0; n < 20000 && ok; ++n)
+    {
+        if (!ring.latest(last) || last.t < 512.0)
+        {
+            continue;
+        }
+        const double from = last.t - 255.0;
+        const double to = from + 128.0;
+        out.clear();
+        ring.readRange(from, to, out);
+        for (size_t i = 0; i < out.size() && ok; ++i)
+        {
+            ok = out[i].t >= from && out[i].t <= to && (i == 0 || out[i].t == out[i - 1].t + 1.0);
+        }
+
+        // A sample still retained after the read was there throughout it
+        ring.latest(last);
+        if (ok && last.t - 255.0 <= to)
+        {
+            ok = !out.empty() && out.back().t == to;
+        }
+    }
+
+    stop = true;
+    writer.join();
+    REQUIRE(ok);
+}
+
+TEST_CASE("SensorDataStore - History channels", "[time_series_ring]") {
+    auto& store = SensorDataStore::instance();
+    using Field = SensorDataStore::Field;
+
+    SECTION("Channel names round-trip") {
+        Field f;
+        REQUIRE(SensorDataStore::fieldFromName("bp_systolic", f));
+        REQUIRE(f == Field::BpSystolic);
+        REQUIRE(std::string(SensorDataStore::fieldName(Field::Pleth)) == "pleth");
+        REQUIRE_FALSE(SensorDataStore::fieldFromName("bogus", f));
+    }
+
+    SECTION("Frames are recorded; vitals at a reduced rate") {
+        // Use a time range no other test touches
+        const double t0 = 1.0e6;
+        for (int i = 0; i < 20; ++i)
+        {
+            SignalGenerator::SensorData frame{};
+            frame.timestamp = t0 + i * 0.05; // 20 Hz
+            frame.ecg = i;
+            frame.spo2 = 97.0;
+            store.recordHistory(frame);
+        }
+
+        std::vector<TimeSample> ecg, spo2;
+        REQUIRE(store.readHistory(Field::Ecg, t0, t0 + 10.0, ecg) == 20);
+        REQUIRE(store.readHistory(Field::Spo2, t0, t0 + 10.0, spo2) == 10);
+        REQUIRE(store.readHistory(Field::Timestamp, t0, t0 + 10.0, ecg) == 0);
+    }
+}
@@ -0,0 +1,141 @@
+/**
+ * @file test_waveform_template.cpp
+ * @brief Unit tests and playback benchmark for the beat template tables
+ */
+
+#include "catch_amalgamated.hpp"
+#include "core/waveform_template.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+struct NamedShape
+{
+    const char* name;
+    WaveformTemplate::Shape shape;
+    const WaveformTemplate& table;
+};
+
+std::vector<NamedShape> shapes()
+{
+    return {{"ecg", BeatTemplates::ecgShape, BeatTemplates::ecg()},
+            {"mock ecg", BeatTemplates::mockEcgShape, BeatTemplates::mockEcg()},
+            {"pleth", BeatTemplates::plethShape, BeatTemplates::pleth()}};
+}
+
+} // namespace
+
+TEST_CASE("WaveformTemplate - Playback matches the shape", "[waveform_template]") {
+    for (const auto& s : shapes()) {
+        INFO(s.name);
+        REQUIRE(s.table.cells() == WaveformTemplate::DEFAULT_CELLS);
+
+        // Odd step so phases fall at every position within a cell
+        double maxError = 0.0;
+        for (double phase = 0.0; phase < 1.0; phase += 1.0 / 99991.0) {
+            maxError = std::max(maxError, std::abs(s.table.at(phase) - s.shape(phase)));
+        }
+        REQUIRE(maxError < 1e-3);
+
+        // Cell edges are exact (up to float storage)
+        for (size_t i = 0; i < s.table.cells(); i += 37) {
+            const double edge = static_cast<double>(i) / s.table.cells();
+            REQUIRE(s.table.at(edge) == Catch::Approx(s.shape(edge)).margin(1e-6));
+        }
+    }
+}
+
+TEST_CASE("WaveformTemplate - Steps on segment boundaries stay sharp", "[waveform_template]") {
+    // Pleth drops from the end of the notch (1.0) to the start of the decay (0.85) at 0.5
+    const auto& pleth = BeatTemplates::pleth();
+    REQUIRE(pleth.at(0.5 - 1e-9) == Catch::Approx(1.0).margin(1e-5));
+    REQUIRE(pleth.at(0.5) == Catch::Approx(0.85).margin(1e-5));
+
+    // ECG P wave ends at 0.15 with a small step to the isoelectric PR segment
+    const auto& ecg = BeatTemplates::ecg();
+    REQUIRE(ecg.at(0.15 - 1e-9) == Catch::Approx(BeatTemplates::ecgShape(0.15 - 1e-9)).margin(1e-5));
+    REQUIRE(ecg.at(0.15) == 0.0);
+}
+
+TEST_CASE("WaveformTemplate - Phase handling", "[waveform_template]") {
+    const auto& ecg = BeatTemplates::ecg();
+
+    SECTION("Out-of-range phases are clamped") {
+        REQUIRE(ecg.at(-0.5) == ecg.at(0.0));
+        REQUIRE(ecg.at(1.0) == Catch::Approx(BeatTemplates::ecgShape(std::nextafter(1.0, 0.0))).margin(1e-6));
+        REQUIRE(std::isfinite(ecg.at(7.0)));
+    }
+
+    SECTION("Any heart rate is a different phase mapping of the same table") {
+        // The R peak sits at phase 0.24 whatever the beat interval
+        for (double bpm : {40.0, 75.0, 180.0}) {
+            const double interval = 60.0 / bpm;
+            const double peakTime = 3.0 * interval + 0.24 * interval;
+            const double phase = std::fmod(peakTime, interval) / interval;
+            REQUIRE(ecg.at(phase) == Catch::Approx(1.1).margin(1e-3));
+        }
+    }
+
+    SECTION("render() equals at()") {
+        std::vector<double> phase(1000);
+        std::vector<double> out(phase.size());
+        for (size_t i = 0; i < phase.size(); ++i) {
+            phase[i] = static_cast<double>(i) / phase.size();
+        }
+        ecg.render(phase.data(), phase.size(), out.data());
+        for (size_t i = 0; i < phase.size(); ++i) {
+            REQUIRE(out[i] == ecg.at(phase[i]));
+        }
+    }
+
+    SECTION("Coarse tables are still usable") {
+        const WaveformTemplate coarse(BeatTemplates::plethShape, 100);
+        REQUIRE(coarse.cells() == 100);
+        REQUIRE(coarse.at(0.25) == Catch::Approx(BeatTemplates::plethShape(0.25)).margin(0.01));
+    }
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("WaveformTemplate - Playback vs direct evaluation", "[.benchmark][waveform_template]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t N = 2000000;
+    constexpr double BEAT_INTERVAL = 0.8;
+
+    // Same phases for both paths: 500 Hz sampling, offset off the segment boundaries
+    std::vector<double> phase(N);
+    for (size_t i = 0; i < N; ++i) {
+        const double t = 0.0013 + static_cast<double>(i) / 500.0;
+        phase[i] = std::fmod(t, BEAT_INTERVAL) / BEAT_INTERVAL;
+    }
+    std::vector<double> direct(N);
+    std::vector<double> table(N);
+
+    std::cout << "\n[BENCHMARK] Beat shape cost per sample, " << N << " samples" << std::endl;
+    for (const auto& s : shapes()) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < N; ++i) {
+            direct[i] = s.shape(phase[i]);
+        }
+        const double directNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / N;
+
+        start = Clock::now();
+        s.table.render(phase.data(), N, table.data());
+        const double tableNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / N;
+
+        double maxError = 0.0;
+        for (size_t i = 0; i < N; ++i) {
+            maxError = std::max(maxError, std::abs(direct[i] - table[i]));
+        }
+
+        std::cout << "  " << s.name << ": direct " << directNs << " ns, table " << tableNs << " ns ("
+                  << directNs / tableNs << "x), max error " << maxError << std::endl;
+
+        REQUIRE(maxError < 1e-3);
+        REQUIRE(tableNs < directNs);
+    }
+}
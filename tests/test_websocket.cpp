@@ -0,0 +1,900 @@
+/**
+ * @file test_websocket.cpp
+ * @brief WebSocket protocol tests and in-process client tests for the StreamServer reactor
+ */
+
+#include "catch_amalgamated.hpp"
+#include "server/websocket.h"
+#include "server/stream_server.h"
+#include "server/frame_codec.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string hex(const uint8_t* data, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (size_t i = 0; i < len; ++i)
+    {
+        out += digits[data[i] >> 4];
+        out += digits[data[i] & 0x0F];
+    }
+    return out;
+}
+
+bool waitFor(const std::function<bool()>& pred, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000))
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return pred();
+}
+
+/**
+ * Minimal blocking WebSocket client over a loopback socket
+ */
+class TestClient
+{
+public:
+    ~TestClient()
+    {
+        if (fd_ >= 0) close(fd_);
+    }
+
+    /// Shrink the kernel receive buffer (call before connecting) to simulate a stalled reader
+    void setReceiveBuffer(int bytes) { receiveBuffer_ = bytes; }
+
+    bool connectTo(int port)
+    {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (receiveBuffer_ > 0)
+        {
+            setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &receiveBuffer_, sizeof(receiveBuffer_));
+        }
+        timeval tv{2, 0};
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        return connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+
+    bool handshake(int port, const std::string& query = "")
+    {
+        if (!connectTo(port))
+        {
+            return false;
+        }
+
+        const std::string request = "GET /ws" + query + " HTTP/1.1\r\n"
+                                    "Host: localhost\r\n"
+                                    "Upgrade: websocket\r\n"
+                                    "Connection: Upgrade\r\n"
+                                    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                                    "Sec-WebSocket-Version: 13\r\n\r\n";
+        sendRaw(request);
+
+        const std::string response = readHead();
+        return response.rfind("HTTP/1.1 101", 0) == 0 &&
+               response.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") != std::string::npos;
+    }
+
+    bool subscribeSse(int port, const std::string& query = "")
+    {
+        if (!connectTo(port))
+        {
+            return false;
+        }
+        sendRaw("GET /ws" + query + " HTTP/1.1\r\nHost: localhost\r\nAccept: text/event-stream\r\n\r\n");
+
+        const std::string response = readHead();
+        return response.rfind("HTTP/1.1 200", 0) == 0 &&
+               response.find("Content-Type: text/event-stream") != std::string::npos;
+    }
+
+    int fd() const { return fd_; }
+
+    void sendRaw(const std::string& bytes)
+    {
+        ::send(fd_, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+    }
+
+    void sendFrame(WebSocket::Opcode opcode, const std::string& payload, bool fin = true)
+    {
+        const uint8_t mask[4] = {0x37, 0xfa, 0x21, 0x3d};
+        uint8_t header[WebSocket::MAX_HEADER_SIZE];
+        const size_t headerLen = WebSocket::writeHeader(header, opcode, payload.size(), fin, mask);
+
+        std::string frame(reinterpret_cast<const char*>(header), headerLen);
+        for (size_t i = 0; i < payload.size(); ++i)
+        {
+            frame += static_cast<char>(payload[i] ^ mask[i & 3]);
+        }
+        sendRaw(frame);
+    }
+
+    /// Read one frame; false on timeout or disconnect
+    bool readFrame(WebSocket::Frame& frame)
+    {
+        while (true)
+        {
+            size_t consumed = 0;
+            const auto result = WebSocket::parseFrame(reinterpret_cast<const uint8_t*>(buffer_.data()),
+                                                      buffer_.size(), frame, consumed, 1 << 20);
+            if (result == WebSocket::ParseResult::Ok)
+            {
+                buffer_.erase(0, consumed);
+                return true;
+            }
+            if (result == WebSocket::ParseResult::Error || !fill())
+            {
+                return false;
+            }
+        }
+    }
+
+    std::string readHead()
+    {
+        while (buffer_.find("\r\n\r\n") == std::string::npos)
+        {
+            if (!fill()) return buffer_;
+        }
+        const size_t end = buffer_.find("\r\n\r\n") + 4;
+        std::string head = buffer_.substr(0, end);
+        buffer_.erase(0, end);
+        return head;
+    }
+
+    std::string readBytes(size_t n)
+    {
+        while (buffer_.size() < n && fill())
+        {
+        }
+        std::string out = buffer_.substr(0, n);
+        buffer_.erase(0, out.size());
+        return out;
+    }
+
+    void disconnect()
+    {
+        close(fd_);
+        fd_ = -1;
+    }
+
+private:
+    bool fill()
+    {
+        char buf[4096];
+        const ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        buffer_.append(buf, static_cast<size_t>(n));
+        return true;
+    }
+
+    int fd_ = -1;
+    int receiveBuffer_ = 0;
+    std::string buffer_;
+};
+
+} // namespace
+
+TEST_CASE("WebSocket - Handshake accept key", "[websocket]") {
+    uint8_t digest[20];
+    WebSocket::sha1(reinterpret_cast<const uint8_t*>("abc"), 3, digest);
+    REQUIRE(hex(digest, 20) == "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+    WebSocket::sha1(nullptr, 0, digest);
+    REQUIRE(hex(digest, 20) == "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+
+    // RFC 6455 section 1.3 example
+    REQUIRE(WebSocket::acceptKey("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST_CASE("WebSocket - Frame encoding and masking", "[websocket]") {
+    const uint8_t mask[4] = {0x01, 0x02, 0x03, 0x04};
+
+    SECTION("Round trip across all length encodings") {
+        for (size_t len : {size_t(0), size_t(5), size_t(125), size_t(126), size_t(300), size_t(65535), size_t(70000)})
+        {
+            std::string payload(len, '\0');
+            for (size_t i = 0; i < len; ++i) payload[i] = static_cast<char>(i * 7);
+
+            for (const uint8_t* m : {static_cast<const uint8_t*>(nullptr), mask})
+            {
+                const std::string wire = WebSocket::encodeFrame(WebSocket::Opcode::Binary, payload.data(), len, m);
+
+                WebSocket::Frame frame;
+                size_t consumed = 0;
+                REQUIRE(WebSocket::parseFrame(reinterpret_cast<const uint8_t*>(wire.data()), wire.size(), frame,
+                                              consumed, 1 << 20) == WebSocket::ParseResult::Ok);
+                REQUIRE(consumed == wire.size());
+                REQUIRE(frame.opcode == WebSocket::Opcode::Binary);
+                REQUIRE(frame.fin);
+                REQUIRE(frame.masked == (m != nullptr));
+                REQUIRE(frame.payload == payload);
+            }
+        }
+    }
+
+    SECTION("Masked payload differs on the wire") {
+        const std::string wire = WebSocket::encodeFrame(WebSocket::Opcode::Text, "Hello", 5, mask);
+        REQUIRE(wire.size() == 2 + 4 + 5);
+        REQUIRE(wire.substr(6) != "Hello");
+    }
+
+    SECTION("Incomplete frames need more data") {
+        const std::string wire = WebSocket::encodeFrame(WebSocket::Opcode::Text, "Hello", 5, mask);
+        for (size_t n = 0; n < wire.size(); ++n)
+        {
+            WebSocket::Frame frame;
+            size_t consumed = 0;
+            REQUIRE(WebSocket::parseFrame(reinterpret_cast<const uint8_t*>(wire.data()), n, frame, consumed, 1024) ==
+                    WebSocket::ParseResult::NeedMore);
+        }
+    }
+
+    SECTION("Protocol violations are rejected") {
+        WebSocket::Frame frame;
+        size_t consumed = 0;
+
+        const std::string bigPing = WebSocket::encodeFrame(WebSocket::Opcode::Ping, std::string(126, 'x').data(), 126);
+        REQUIRE(WebSocket::parseFrame(reinterpret_cast<const uint8_t*>(bigPing.data()), bigPing.size(), frame,
+                                      consumed, 1024) == WebSocket::ParseResult::Error);
+
+        std::string reserved = WebSocket::encodeFrame(WebSocket::Opcode::Text, "x", 1);
+        reserved[0] = static_cast<char>(reserved[0] | 0x40);
+        REQUIRE(WebSocket::parseFrame(reinterpret_cast<const uint8_t*>(reserved.data()), reserved.size(), frame,
+                                      consumed, 1024) == WebSocket::ParseResult::Error);
+
+        const std::string tooBig = WebSocket::encodeFrame(WebSocket::Opcode::Text, std::string(2000, 'x').data(), 2000);
+        REQUIRE(WebSocket::parseFrame(reinterpret_cast<const uint8_t*>(tooBig.data()), tooBig.size(), frame,
+                                      consumed, 1024) == WebSocket::ParseResult::Error);
+    }
+
+    SECTION("Close frame carries the status code") {
+        const std::string wire = WebSocket::encodeClose(WebSocket::CloseCode::GOING_AWAY, "bye");
+        WebSocket::Frame frame;
+        size_t consumed = 0;
+        REQUIRE(WebSocket::parseFrame(reinterpret_cast<const uint8_t*>(wire.data()), wire.size(), frame, consumed,
+                                      1024) == WebSocket::ParseResult::Ok);
+        REQUIRE(frame.opcode == WebSocket::Opcode::Close);
+        REQUIRE(frame.payload.size() == 5);
+        REQUIRE(static_cast<uint8_t>(frame.payload[0]) == 0x03);
+        REQUIRE(static_cast<uint8_t>(frame.payload[1]) == 0xE9);
+        REQUIRE(frame.payload.substr(2) == "bye");
+    }
+}
+
+TEST_CASE("WebSocket - HTTP upgrade parsing", "[websocket]") {
+    const std::string head = "GET /ws?format=binary&name=a%20b HTTP/1.1\r\n"
+                             "Host: localhost\r\n"
+                             "UPGRADE: WebSocket\r\n"
+                             "Connection: keep-alive, Upgrade\r\n"
+                             "Sec-WebSocket-Key:   dGhlIHNhbXBsZSBub25jZQ==  \r\n"
+                             "Sec-WebSocket-Version: 13\r\n\r\n";
+
+    WebSocket::HttpRequest req;
+    REQUIRE(WebSocket::parseHttpRequest(head, req));
+    REQUIRE(req.method == "GET");
+    REQUIRE(req.path == "/ws");
+    REQUIRE(req.param("format") == "binary");
+    REQUIRE(req.param("name") == "a b");
+    REQUIRE(req.header("sec-websocket-key") == "dGhlIHNhbXBsZSBub25jZQ==");
+    REQUIRE(WebSocket::isUpgradeRequest(req));
+
+    const std::string response = WebSocket::handshakeResponse(req);
+    REQUIRE(response.rfind("HTTP/1.1 101 Switching Protocols\r\n", 0) == 0);
+    REQUIRE(response.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") != std::string::npos);
+
+    req.headers["sec-websocket-version"] = "8";
+    REQUIRE_FALSE(WebSocket::isUpgradeRequest(req));
+
+    WebSocket::HttpRequest plain;
+    REQUIRE(WebSocket::parseHttpRequest("GET /ws HTTP/1.1\r\nHost: x\r\n\r\n", plain));
+    REQUIRE_FALSE(WebSocket::isUpgradeRequest(plain));
+    REQUIRE_FALSE(WebSocket::parseHttpRequest("garbage\r\n\r\n", plain));
+}
+
+TEST_CASE("StreamServer - In-process client", "[websocket]") {
+    StreamServer server;
+    server.setMessageHandler([&server](uint64_t clientId, const std::string& message) {
+        server.send(clientId, "echo:" + message);
+    });
+    REQUIRE(server.start(0, "127.0.0.1"));
+    REQUIRE(server.port() > 0);
+
+    SECTION("Echo through the message handler") {
+        TestClient client;
+        REQUIRE(client.handshake(server.port()));
+        REQUIRE(waitFor([&] { return server.clientCount() == 1; }));
+
+        client.sendFrame(WebSocket::Opcode::Text, "hello");
+        WebSocket::Frame frame;
+        REQUIRE(client.readFrame(frame));
+        REQUIRE(frame.opcode == WebSocket::Opcode::Text);
+        REQUIRE_FALSE(frame.masked);
+        REQUIRE(frame.payload == "echo:hello");
+
+        // Fragmented message is reassembled, with a ping interleaved
+        client.sendFrame(WebSocket::Opcode::Text, "frag", false);
+        client.sendFrame(WebSocket::Opcode::Ping, "p1");
+        client.sendFrame(WebSocket::Opcode::Continuation, "mented", true);
+
+        REQUIRE(client.readFrame(frame));
+        REQUIRE(frame.opcode == WebSocket::Opcode::Pong);
+        REQUIRE(frame.payload == "p1");
+        REQUIRE(client.readFrame(frame));
+        REQUIRE(frame.payload == "echo:fragmented");
+    }
+
+    SECTION("Client table and close handshake") {
+        TestClient json;
+        TestClient binary;
+        REQUIRE(json.handshake(server.port()));
+        REQUIRE(binary.handshake(server.port(), "?format=binary"));
+        REQUIRE(waitFor([&] { return server.clientCount() == 2; }));
+        REQUIRE(server.clientCount(StreamServer::Format::Json) == 1);
+        REQUIRE(server.clientCount(StreamServer::Format::Binary) == 1);
+
+        const auto table = server.clients();
+        REQUIRE(table.size() == 2);
+        REQUIRE(table[0].id != table[1].id);
+        REQUIRE(table[0].remote.rfind("127.0.0.1:", 0) == 0);
+
+        // Broadcasts only reach clients of the matching format
+        SignalGenerator::SensorData data{};
+        data.spo2 = 97.0;
+        uint8_t raw[FrameCodec::BINARY_FRAME_SIZE];
+        FrameCodec::encodeBinary(data, 0x3F, 7, raw);
+        server.broadcast(StreamServer::Format::Binary, raw, sizeof(raw));
+        server.broadcast(StreamServer::Format::Json, "{\"spo2\":97}", 11);
+
+        WebSocket::Frame frame;
+        REQUIRE(binary.readFrame(frame));
+        REQUIRE(frame.opcode == WebSocket::Opcode::Binary);
+        FrameCodec::BinaryFrame decoded;
+        REQUIRE(FrameCodec::decodeBinary(reinterpret_cast<const uint8_t*>(frame.payload.data()),
+                                         frame.payload.size(), decoded));
+        REQUIRE(decoded.seq == 7);
+
+        REQUIRE(json.readFrame(frame));
+        REQUIRE(frame.opcode == WebSocket::Opcode::Text);
+        REQUIRE(frame.payload == "{\"spo2\":97}");
+
+        // Client-initiated close is answered, then the entry is removed
+        const std::string reason = std::string("\x03\xE8", 2);
+        json.sendFrame(WebSocket::Opcode::Close, reason);
+        REQUIRE(json.readFrame(frame));
+        REQUIRE(frame.opcode == WebSocket::Opcode::Close);
+        REQUIRE(waitFor([&] { return server.clientCount() == 1; }));
+
+        // Abrupt disconnect is also detected
+        binary.disconnect();
+        REQUIRE(waitFor([&] { return server.clientCount() == 0 && server.clients().empty(); }));
+    }
+
+    SECTION("Protocol errors close the connection") {
+        TestClient client;
+        REQUIRE(client.handshake(server.port()));
+
+        // Servers must reject unmasked client frames
+        client.sendRaw(WebSocket::encodeFrame(WebSocket::Opcode::Text, "x", 1));
+        WebSocket::Frame frame;
+        REQUIRE(client.readFrame(frame));
+        REQUIRE(frame.opcode == WebSocket::Opcode::Close);
+        REQUIRE(static_cast<uint8_t>(frame.payload[1]) == (WebSocket::CloseCode::PROTOCOL_ERROR & 0xFF));
+        REQUIRE(waitFor([&] { return server.clientCount() == 0; }));
+    }
+
+    SECTION("Input past the request or message limit closes the connection") {
+        TestClient echo;
+        REQUIRE(echo.handshake(server.port()));
+
+        // A request that never ends is cut off near MAX_HANDSHAKE_SIZE, not buffered
+        TestClient flood;
+        REQUIRE(flood.connectTo(server.port()));
+        flood.sendRaw("GET /ws HTTP/1.1\r\nHost: localhost\r\n");
+        const std::string header = "X-Pad: " + std::string(1000, 'a') + "\r\n";
+        constexpr size_t FLOOD_BYTES = 64 << 20;
+        size_t sent = 0;
+        while (sent < FLOOD_BYTES) {
+            const ssize_t n = ::send(flood.fd(), header.data(), header.size(), MSG_NOSIGNAL);
+            if (n <= 0) {
+                break;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        REQUIRE(sent < FLOOD_BYTES);
+        REQUIRE(flood.readHead().empty()); // Closed without a response
+
+        // A frame larger than MAX_MESSAGE_SIZE is refused from its header
+        TestClient big;
+        REQUIRE(big.handshake(server.port()));
+        big.sendFrame(WebSocket::Opcode::Text, std::string(1 << 20, 'x'));
+        WebSocket::Frame frame;
+        REQUIRE(big.readFrame(frame));
+        REQUIRE(frame.opcode == WebSocket::Opcode::Close);
+
+        // Other clients are still served
+        echo.sendFrame(WebSocket::Opcode::Text, "still here");
+        REQUIRE(echo.readFrame(frame));
+        REQUIRE(frame.payload == "echo:still here");
+        REQUIRE(waitFor([&] { return server.clientCount() == 1; }));
+    }
+
+    SECTION("Plain GET is served as Server-Sent Events") {
+        TestClient json;
+        TestClient binary;
+        REQUIRE(json.subscribeSse(server.port()));
+        REQUIRE(binary.subscribeSse(server.port(), "?format=binary"));
+        REQUIRE(waitFor([&] { return server.clientCount() == 2; }));
+
+        const auto table = server.clients();
+        REQUIRE(table.size() == 2);
+        REQUIRE(table[0].transport == StreamServer::Transport::Sse);
+
+        SignalGenerator::SensorData data{};
+        uint8_t raw[FrameCodec::BINARY_FRAME_SIZE];
+        FrameCodec::encodeBinary(data, 0x3F, 9, raw);
+        server.broadcast(StreamServer::Format::Binary, raw, sizeof(raw));
+        server.broadcast(StreamServer::Format::Json, "{\"ecg\":0.5}", 11);
+
+        REQUIRE(json.readBytes(19) == "data: {\"ecg\":0.5}\n\n");
+
+        char expected[FrameCodec::BINARY_SSE_FRAME_SIZE];
+        FrameCodec::encodeBinarySse(data, 0x3F, 9, expected);
+        REQUIRE(binary.readBytes(sizeof(expected)) == std::string(expected, sizeof(expected)));
+
+        json.disconnect();
+        binary.disconnect();
+        REQUIRE(waitFor([&] { return server.clientCount() == 0; }));
+    }
+
+    SECTION("Bad requests are refused") {
+        TestClient client;
+        REQUIRE(client.connectTo(server.port()));
+        client.sendRaw("GET /ws HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+                       "Connection: Upgrade\r\nSec-WebSocket-Key: x\r\nSec-WebSocket-Version: 8\r\n\r\n");
+        REQUIRE(client.readHead().rfind("HTTP/1.1 426", 0) == 0);
+
+        TestClient other;
+        REQUIRE(other.connectTo(server.port()));
+        other.sendRaw("GET /nope HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        REQUIRE(other.readHead().rfind("HTTP/1.1 404", 0) == 0);
+
+        TestClient badChannel;
+        REQUIRE(badChannel.connectTo(server.port()));
+        badChannel.sendRaw("GET /ws?channels=ecg,bogus HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        REQUIRE(badChannel.readHead().rfind("HTTP/1.1 400", 0) == 0);
+        REQUIRE(server.clientCount() == 0);
+    }
+
+    SECTION("Subscription groups") {
+        TestClient all;
+        TestClient ecgA;
+        TestClient ecgB;
+        TestClient vitals;
+        REQUIRE(all.handshake(server.port()));
+        REQUIRE(ecgA.handshake(server.port(), "?channels=ecg&ecg_hz=250"));
+        REQUIRE(ecgB.subscribeSse(server.port(), "?channels=ecg&ecg_hz=250"));
+        REQUIRE(vitals.handshake(server.port(), "?format=binary&channels=spo2,bp_systolic&vitals_hz=1"));
+        REQUIRE(waitFor([&] { return server.clientCount() == 4; }));
+
+        // Equal subscriptions share a group regardless of transport
+        auto groups = server.subscriptionGroups();
+        REQUIRE(groups.size() == 3);
+        const auto ecgGroup = std::find_if(groups.begin(), groups.end(), [](const auto& g) {
+            return g.subscription.key() == "ecg@250";
+        });
+        REQUIRE(ecgGroup != groups.end());
+        REQUIRE(ecgGroup->clients == 2);
+        REQUIRE(ecgGroup->format == StreamServer::Format::Json);
+
+        // A group broadcast reaches only its members
+        server.broadcast(ecgGroup->id, "{\"ecg\":0.5}", 11);
+        WebSocket::Frame frame;
+        REQUIRE(ecgA.readFrame(frame));
+        REQUIRE(frame.payload == "{\"ecg\":0.5}");
+        REQUIRE(ecgB.readBytes(19) == "data: {\"ecg\":0.5}\n\n");
+
+        server.broadcast(StreamServer::Format::Json, "{}", 2);
+        REQUIRE(all.readFrame(frame));
+        REQUIRE(frame.payload == "{}"); // The group frame never reached it
+
+        const auto table = server.clients();
+        REQUIRE(std::any_of(table.begin(), table.end(), [](const auto& c) {
+            return c.subscription == "spo2@1,bp_systolic@1";
+        }));
+
+        // Changing a subscription moves the client; empty groups disappear
+        for (const auto& info : table) {
+            if (info.format == StreamServer::Format::Binary) {
+                REQUIRE(server.setSubscription(info.id, StreamSubscription()));
+            }
+        }
+        groups = server.subscriptionGroups();
+        REQUIRE(groups.size() == 3);
+        REQUIRE(std::none_of(groups.begin(), groups.end(), [](const auto& g) {
+            return g.subscription.key() == "spo2@1,bp_systolic@1";
+        }));
+
+        ecgA.disconnect();
+        ecgB.disconnect();
+        REQUIRE(waitFor([&] { return server.subscriptionGroups().size() == 2; }));
+    }
+
+    server.stop();
+    REQUIRE_FALSE(server.isRunning());
+}
+
+TEST_CASE("StreamServer - Slow client policies", "[websocket]") {
+    constexpr int FRAMES = 300;
+    constexpr size_t PAYLOAD_SIZE = 32 * 1024;
+
+    StreamServer server;
+    StreamServer::BackpressureConfig config;
+    config.maxQueuedFrames = 4;
+    config.policy = StreamServer::SlowClientPolicy::DropOldest;
+    config.maxLag = std::chrono::milliseconds(100);
+    server.setBackpressure(config);
+    REQUIRE(server.start(0, "127.0.0.1"));
+
+    // The fast client reads everything; the slow one never reads and has a tiny window
+    auto runStalled = [&](const std::string& policy, TestClient& fast, TestClient& slow) {
+        REQUIRE(fast.handshake(server.port(), "?format=binary"));
+        slow.setReceiveBuffer(4096);
+        REQUIRE(slow.handshake(server.port(), "?format=binary" + policy));
+        REQUIRE(waitFor([&] { return server.clientCount() == 2; }));
+
+        std::string payload(PAYLOAD_SIZE, 'x');
+        WebSocket::Frame frame;
+        for (uint32_t seq = 0; seq < FRAMES; ++seq)
+        {
+            std::memcpy(&payload[0], &seq, sizeof(seq));
+            server.broadcast(StreamServer::Format::Binary, payload.data(), payload.size());
+
+            REQUIRE(fast.readFrame(frame));
+            uint32_t got;
+            std::memcpy(&got, frame.payload.data(), sizeof(got));
+            REQUIRE(got == seq);
+        }
+    };
+
+    auto infoFor = [&](StreamServer::SlowClientPolicy policy) {
+        for (const auto& info : server.clients())
+        {
+            if (info.policy == policy && info.framesDropped > 0) return info;
+        }
+        return StreamServer::ClientInfo{};
+    };
+
+    SECTION("Drop oldest keeps the queue bounded") {
+        TestClient fast, slow;
+        runStalled("", fast, slow);
+
+        const auto info = infoFor(StreamServer::SlowClientPolicy::DropOldest);
+        REQUIRE(info.framesDropped > 0);
+        REQUIRE(info.queuedFrames <= config.maxQueuedFrames + 1); // + a partially written frame
+        REQUIRE(info.lagMs > 0.0);
+        REQUIRE(server.clientCount() == 2);
+
+        // The fast client was never affected
+        for (const auto& c : server.clients())
+        {
+            if (c.id != info.id) REQUIRE(c.framesDropped == 0);
+        }
+    }
+
+    SECTION("Coalesce delivers the latest snapshot") {
+        TestClient fast, slow;
+        runStalled("&policy=coalesce", fast, slow);
+
+        const auto info = infoFor(StreamServer::SlowClientPolicy::Coalesce);
+        REQUIRE(info.framesDropped > 0);
+        REQUIRE(info.queuedFrames <= 2);
+
+        // Once the client catches up, the last frame it sees is the newest one
+        uint32_t last = 0;
+        WebSocket::Frame frame;
+        while (last != FRAMES - 1 && slow.readFrame(frame))
+        {
+            std::memcpy(&last, frame.payload.data(), sizeof(last));
+        }
+        REQUIRE(last == FRAMES - 1);
+    }
+
+    SECTION("Disconnect after falling too far behind") {
+        TestClient fast, slow;
+        runStalled("&policy=disconnect", fast, slow);
+
+        // Dropped on the next broadcast (or housekeeping pass) once maxLag is exceeded
+        std::this_thread::sleep_for(config.maxLag * 2);
+        server.broadcast(StreamServer::Format::Binary, "late", 4);
+        REQUIRE(waitFor([&] { return server.clientCount() == 1; }));
+
+        const auto remaining = server.clients();
+        REQUIRE(remaining.size() == 1);
+        REQUIRE(remaining[0].policy == StreamServer::SlowClientPolicy::DropOldest);
+        REQUIRE(remaining[0].framesDropped == 0);
+    }
+
+    server.stop();
+}
+
+TEST_CASE("StreamServer - Ticks keep an absolute cadence", "[websocket]") {
+    constexpr int RATE_HZ = 100;
+
+    // A handler slower than the period must skip deadlines, not shift the grid
+    StreamServer server;
+    server.setTickHandler([] { std::this_thread::sleep_for(std::chrono::milliseconds(25)); });
+    server.setTickRate(RATE_HZ);
+
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(server.start(0, "127.0.0.1"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+
+    const auto stats = server.tickStats();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    server.stop();
+
+    REQUIRE(stats.ticks > 0);
+    REQUIRE(stats.missed > 0);
+    REQUIRE(stats.maxHandlerMs >= 25.0);
+    const double gridTicks = static_cast<double>(stats.ticks + stats.missed);
+    REQUIRE(gridTicks <= elapsed * RATE_HZ + 1);
+    REQUIRE(gridTicks >= elapsed * RATE_HZ - 5);
+}
+
+// Run with: curecraft_tests "[benchmark]"
+TEST_CASE("StreamServer - Broadcast throughput", "[.benchmark][websocket]") {
+    constexpr int FRAMES = 2000;
+    const std::vector<int> clientCounts = {1, 10, 100};
+
+    std::cout << "\nclients   frames   elapsed (ms)   frames/s delivered   MB/s delivered\n";
+
+    for (int clients : clientCounts)
+    {
+        StreamServer server;
+        StreamServer::BackpressureConfig config;
+        config.maxQueuedFrames = 512; // Measure delivery, not the drop policy
+        server.setBackpressure(config);
+        REQUIRE(server.start(0, "127.0.0.1"));
+
+        std::vector<std::unique_ptr<TestClient>> sockets;
+        for (int i = 0; i < clients; ++i)
+        {
+            sockets.push_back(std::make_unique<TestClient>());
+            REQUIRE(sockets.back()->handshake(server.port(), "?format=binary"));
+        }
+        REQUIRE(waitFor([&] { return server.clientCount() == clients; }));
+
+        uint8_t raw[FrameCodec::BINARY_FRAME_SIZE];
+        SignalGenerator::SensorData data{};
+
+        std::atomic<int> received{0};
+        std::vector<std::thread> readers;
+        for (auto& socket : sockets)
+        {
+            readers.emplace_back([&received, client = socket.get()] {
+                WebSocket::Frame frame;
+                for (int n = 0; n < FRAMES && client->readFrame(frame); ++n)
+                {
+                    received.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int n = 0; n < FRAMES; ++n)
+        {
+            FrameCodec::encodeBinary(data, 0x3F, static_cast<uint32_t>(n), raw);
+            server.broadcast(StreamServer::Format::Binary, raw, sizeof(raw));
+            // Stay under the per-client queue bound, as a real tick rate would
+            if (n % 256 == 255)
+            {
+                waitFor([&] { return received.load() >= (n + 1 - 256) * clients; });
+            }
+        }
+        for (auto& t : readers) t.join();
+        const double elapsedMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        const double delivered = static_cast<double>(received.load());
+        REQUIRE(received.load() == FRAMES * clients);
+        std::cout << std::setw(7) << clients << std::setw(9) << FRAMES << std::setw(15) << std::fixed
+                  << std::setprecision(1) << elapsedMs << std::setw(21) << std::setprecision(0)
+                  << delivered / (elapsedMs / 1000.0) << std::setw(17) << std::setprecision(2)
+                  << delivered * (FrameCodec::BINARY_FRAME_SIZE + 2) / (elapsedMs / 1000.0) / 1e6 << "\n";
+
+        server.stop();
+    }
+}
+
+TEST_CASE("StreamServer - Timer tick", "[websocket]") {
+    StreamServer server;
+    std::atomic<int> ticks{0};
+    server.setTickHandler([&ticks] { ticks.fetch_add(1); });
+    server.setTickRate(200);
+    REQUIRE(server.start(0, "127.0.0.1"));
+
+    REQUIRE(waitFor([&] { return ticks.load() >= 5; }));
+
+    // Rate 0 disarms the timer
+    server.setTickRate(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const int stopped = ticks.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(ticks.load() == stopped);
+
+    server.stop();
+}
+
+// Run with: curecraft_tests "[benchmark]"
+// Half the subscribers use WebSocket, half SSE; everything is pinned to one core.
+TEST_CASE("StreamServer - 5000 subscribers at 20 Hz", "[.benchmark][websocket]") {
+    constexpr int SUBSCRIBERS = 5000;
+    constexpr int RATE_HZ = 20;
+    constexpr auto DURATION = std::chrono::seconds(5);
+    constexpr size_t WS_FRAME_SIZE = 2 + FrameCodec::BINARY_FRAME_SIZE;
+    constexpr size_t SSE_FRAME_SIZE = FrameCodec::BINARY_SSE_FRAME_SIZE;
+
+    rlimit limit{};
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if (limit.rlim_cur < 2 * SUBSCRIBERS + 64)
+    {
+        WARN("RLIMIT_NOFILE too low for " << SUBSCRIBERS << " subscribers; skipping");
+        return;
+    }
+
+    // Threads created from here on (reactor, reader) inherit the affinity
+    cpu_set_t oneCore;
+    CPU_ZERO(&oneCore);
+    CPU_SET(0, &oneCore);
+    sched_setaffinity(0, sizeof(oneCore), &oneCore);
+
+    StreamServer server;
+    std::atomic<uint32_t> ticks{0};
+    double maxTickGapMs = 0.0;
+    auto lastTick = std::chrono::steady_clock::now();
+    server.setTickHandler([&] {
+        const auto now = std::chrono::steady_clock::now();
+        if (ticks.load() > 0)
+        {
+            maxTickGapMs = std::max(maxTickGapMs, std::chrono::duration<double, std::milli>(now - lastTick).count());
+        }
+        lastTick = now;
+
+        SignalGenerator::SensorData data{};
+        data.timestamp = ticks.load() / static_cast<double>(RATE_HZ);
+        uint8_t raw[FrameCodec::BINARY_FRAME_SIZE];
+        FrameCodec::encodeBinary(data, 0x3F, ticks.fetch_add(1) + 1, raw);
+        server.broadcast(StreamServer::Format::Binary, raw, sizeof(raw));
+    });
+    REQUIRE(server.start(0, "127.0.0.1"));
+
+    std::vector<std::unique_ptr<TestClient>> clients;
+    clients.reserve(SUBSCRIBERS);
+    for (int i = 0; i < SUBSCRIBERS; ++i)
+    {
+        clients.push_back(std::make_unique<TestClient>());
+        const bool ok = (i % 2 == 0) ? clients.back()->handshake(server.port(), "?format=binary")
+                                     : clients.back()->subscribeSse(server.port(), "?format=binary");
+        REQUIRE(ok);
+    }
+    REQUIRE(waitFor([&] { return server.clientCount() == SUBSCRIBERS; }, std::chrono::seconds(10)));
+
+    // One epoll thread drains every client socket and counts bytes
+    std::vector<uint64_t> received(SUBSCRIBERS, 0);
+    std::atomic<bool> reading{true};
+    double readerCpu = 0.0;
+    std::thread reader([&] {
+        const int ep = epoll_create1(0);
+        for (int i = 0; i < SUBSCRIBERS; ++i)
+        {
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u32 = static_cast<uint32_t>(i);
+            epoll_ctl(ep, EPOLL_CTL_ADD, clients[i]->fd(), &ev);
+        }
+
+        // Drain in passes so each recv() picks up a few frames; the harness
+        // should not cost more than the server it is measuring.
+        std::vector<epoll_event> events(SUBSCRIBERS);
+        char buf[4096];
+        while (reading)
+        {
+            const int n = epoll_wait(ep, events.data(), SUBSCRIBERS, 50);
+            for (int e = 0; e < n; ++e)
+            {
+                const uint32_t i = events[e].data.u32;
+                const ssize_t got = recv(clients[i]->fd(), buf, sizeof(buf), MSG_DONTWAIT);
+                if (got > 0) received[i] += static_cast<uint64_t>(got);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        for (int i = 0; i < SUBSCRIBERS; ++i)
+        {
+            ssize_t got;
+            while ((got = recv(clients[i]->fd(), buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+            {
+                received[i] += static_cast<uint64_t>(got);
+            }
+        }
+        close(ep);
+
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        readerCpu = ts.tv_sec + ts.tv_nsec * 1e-9;
+    });
+
+    timespec cpuStart{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuStart);
+    const auto wallStart = std::chrono::steady_clock::now();
+
+    server.setTickRate(RATE_HZ);
+    std::this_thread::sleep_for(DURATION);
+    server.setTickRate(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200)); // Let the last frames drain
+
+    reading = false;
+    reader.join();
+
+    timespec cpuEnd{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuEnd);
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    const double processCpu = (cpuEnd.tv_sec - cpuStart.tv_sec) + (cpuEnd.tv_nsec - cpuStart.tv_nsec) * 1e-9;
+    const double serverCpu = processCpu - readerCpu;
+
+    const uint32_t sent = ticks.load();
+    uint64_t minFrames = UINT64_MAX;
+    uint64_t totalFrames = 0;
+    for (int i = 0; i < SUBSCRIBERS; ++i)
+    {
+        const uint64_t frames = received[i] / ((i % 2 == 0) ? WS_FRAME_SIZE : SSE_FRAME_SIZE);
+        minFrames = std::min(minFrames, frames);
+        totalFrames += frames;
+    }
+
+    const auto tickStats = server.tickStats();
+    std::cout << "\nsubscribers   ticks   missed   frames delivered   min/client   max tick gap (ms)   "
+                 "server CPU (% of 1 core)   reader CPU (%)\n"
+              << std::setw(11) << SUBSCRIBERS << std::setw(8) << sent << std::setw(9) << tickStats.missed
+              << std::setw(19) << totalFrames
+              << std::setw(13) << minFrames << std::setw(20) << std::fixed << std::setprecision(1) << maxTickGapMs
+              << std::setw(27) << 100.0 * serverCpu / wall << std::setw(17) << 100.0 * readerCpu / wall << "\n";
+
+    REQUIRE(server.clientCount() == SUBSCRIBERS);
+    REQUIRE(sent >= RATE_HZ * 4);
+    REQUIRE(minFrames == sent);
+
+    server.stop();
+}
@@ -2,6 +2,18 @@
 // CureCraft Patient Monitor - Real-time Charting Application
 // ============================================================================
 
+// Channel order of binary frames (SensorDataStore::Field, bit i of the mask)
+const BINARY_CHANNELS = [
+  "ecg",
+  "spo2",
+  "resp",
+  "pleth",
+  "bp_systolic",
+  "bp_diastolic",
+  "temp_cavity",
+  "temp_skin",
+];
+
 class PatientMonitor {
   constructor() {
     // Authentication Guard
@@ -13,7 +25,6 @@ class PatientMonitor {
     // Configuration
     this.config = {
       windowSeconds: 6.0, // Display window (seconds)
-      maxPoints: 600, // Maximum data points to store
       updateRate: 20, // Expected update rate (Hz)
       reconnectDelay: 2000, // WebSocket reconnect delay (ms)
     };
@@ -113,7 +124,9 @@ class PatientMonitor {
 
     // State
     this.eventSource = null;
+    this.socket = null;
     this.isConnected = false;
+    this.needsBackfill = true;
     this.animationFrameId = null;
     this.sessionStartTime = Date.now();
     this.totalDataPoints = 0;
@@ -250,10 +263,70 @@ class PatientMonitor {
 
   connect() {
     this.updateStatus("Connecting...", false);
+    this.needsBackfill = true;
+
+    // ?format=binary in the page URL opts into compact binary frames;
+    // ?transport=ws uses the native WebSocket stream instead of SSE.
+    const params = new URLSearchParams(window.location.search);
+    this.binaryFrames = params.get("format") === "binary";
+    const useWebSocket = params.get("transport") === "ws";
 
+    this.resolveStreamHost().then((host) => {
+      if (useWebSocket) {
+        this.connectWebSocket(host);
+      } else {
+        this.connectEventSource(host);
+      }
+    });
+  }
+
+  // Streams are served by the event-loop server on its own port, advertised
+  // by /api/status. Resolves to null if the status request fails.
+  resolveStreamHost() {
+    return fetch("/api/status")
+      .then((response) => response.json())
+      .then((status) =>
+        status.streamPort ? `${window.location.hostname}:${status.streamPort}` : null,
+      )
+      .catch(() => null);
+  }
+
+  // Stream query: format plus any channel subscription from the page URL,
+  // e.g. ?channels=ecg,pleth&ecg_hz=250&vitals_hz=1
+  streamQuery() {
+    const page = new URLSearchParams(window.location.search);
+    const query = new URLSearchParams();
+    if (this.binaryFrames) {
+      query.set("format", "binary");
+    }
+    for (const [key, value] of page) {
+      if (key === "channels" || key.endsWith("_hz")) {
+        query.set(key, value);
+      }
+    }
+    const text = query.toString();
+    return text ? `?${text}` : "";
+  }
+
+  scheduleReconnect() {
+    this.updateStatus("Disconnected", false);
+    this.isConnected = false;
+    setTimeout(() => {
+      console.log("🔄 Attempting to reconnect...");
+      this.connect();
+    }, this.config.reconnectDelay);
+  }
+
+  connectEventSource(host) {
     try {
-      // Use Server-Sent Events for real-time data streaming
-      this.eventSource = new EventSource("/ws");
+      // Use Server-Sent Events for real-time data streaming. Without a stream
+      // port, fall back to the HTTP server's own /ws route.
+      // The fallback route ignores channel subscriptions.
+      let url = this.binaryFrames ? "/ws?format=binary" : "/ws";
+      if (host) {
+        url = `${window.location.protocol}//${host}/ws${this.streamQuery()}`;
+      }
+      this.eventSource = new EventSource(url);
 
       this.eventSource.onopen = () => {
         console.log("✅ Connected to server");
@@ -263,7 +336,9 @@ class PatientMonitor {
 
       this.eventSource.onmessage = (event) => {
         try {
-          const data = JSON.parse(event.data);
+          const data = this.binaryFrames
+            ? this.decodeBinaryFrame(event.data)
+            : JSON.parse(event.data);
           this.onDataReceived(data);
         } catch (error) {
           console.error("Failed to parse data:", error);
@@ -272,18 +347,13 @@ class PatientMonitor {
 
       this.eventSource.onerror = (error) => {
         console.error("❌ Connection error:", error);
-        this.updateStatus("Disconnected", false);
-        this.isConnected = false;
 
         if (this.eventSource) {
           this.eventSource.close();
         }
 
         // Attempt reconnection
-        setTimeout(() => {
-          console.log("🔄 Attempting to reconnect...");
-          this.connect();
-        }, this.config.reconnectDelay);
+        this.scheduleReconnect();
       };
     } catch (error) {
       console.error("Failed to connect:", error);
@@ -291,6 +361,101 @@ class PatientMonitor {
     }
   }
 
+  connectWebSocket(host) {
+    if (!host) {
+      console.error("Failed to connect: stream port unavailable");
+      this.scheduleReconnect();
+      return;
+    }
+
+    const scheme = window.location.protocol === "https:" ? "wss" : "ws";
+    this.socket = new WebSocket(`${scheme}://${host}/ws${this.streamQuery()}`);
+    this.socket.binaryType = "arraybuffer";
+
+    this.socket.onopen = () => {
+      console.log("✅ Connected to WebSocket stream");
+      this.updateStatus("Connected", true);
+      this.isConnected = true;
+    };
+
+    this.socket.onmessage = (event) => {
+      try {
+        const data =
+          typeof event.data === "string"
+            ? JSON.parse(event.data)
+            : this.parseBinaryFrame(new DataView(event.data));
+        this.onDataReceived(data);
+      } catch (error) {
+        console.error("Failed to parse data:", error);
+      }
+    };
+
+    this.socket.onclose = () => {
+      console.error("❌ WebSocket closed");
+      this.socket = null;
+      this.scheduleReconnect();
+    };
+  }
+
+  decodeBinaryFrame(base64) {
+    const raw = atob(base64);
+    const bytes = new Uint8Array(raw.length);
+    for (let i = 0; i < raw.length; i++) {
+      bytes[i] = raw.charCodeAt(i);
+    }
+    return this.parseBinaryFrame(new DataView(bytes.buffer));
+  }
+
+  // Layouts documented in include/server/frame_codec.h (little-endian):
+  // version 1 carries every channel, version 2 a channel mask and the
+  // subscribed channels only, version 3 adds sample runs for waveforms.
+  parseBinaryFrame(view) {
+    const version = view.byteLength > 0 ? view.getUint8(0) : 0;
+    const minSize = { 1: 42, 2: 12, 3: 14 }[version];
+    if (!minSize || view.byteLength < minSize) {
+      throw new Error("Unsupported binary frame");
+    }
+
+    const bits = view.getUint8(1);
+    const frame = {
+      seq: view.getUint32(2, true),
+      timestamp: view.getUint32(6, true) / 1000,
+      sensors: {
+        ecg: (bits & 0x01) !== 0,
+        spo2: (bits & 0x02) !== 0,
+        temp_core: (bits & 0x04) !== 0,
+        nibp: (bits & 0x08) !== 0,
+        temp_skin: (bits & 0x10) !== 0,
+        resp: (bits & 0x20) !== 0,
+      },
+    };
+
+    const mask = version === 1 ? 0xff : view.getUint16(10, true);
+    const runs = version === 3 ? view.getUint16(12, true) : 0;
+    let offset = minSize === 42 ? 10 : minSize;
+    BINARY_CHANNELS.forEach((name, i) => {
+      if (!(mask & (1 << i))) return;
+
+      if (runs & (1 << i)) {
+        // Sample run: i32 t0 offset (us), u32 interval (us), u16 count, f32[]
+        const t0 = frame.timestamp + view.getInt32(offset, true) / 1e6;
+        const dt = view.getUint32(offset + 4, true) / 1e6;
+        const count = view.getUint16(offset + 8, true);
+        offset += 10;
+        const v = new Array(count);
+        for (let k = 0; k < count; k++) {
+          v[k] = view.getFloat32(offset, true);
+          offset += 4;
+        }
+        frame[name] = { t0, dt, v };
+      } else {
+        frame[name] = view.getFloat32(offset, true);
+        offset += 4;
+      }
+    });
+    return frame;
+  }
+
   onDataReceived(data) {
     const {
       ecg,
@@ -305,28 +470,22 @@ class PatientMonitor {
       sensors,
     } = data;
 
+    // Fill the charts from server history once per (re)connection
+    if (this.needsBackfill && typeof timestamp !== "undefined") {
+      this.needsBackfill = false;
+      this.backfillHistory(timestamp);
+    }
+
     // Handle sensor attachment
     if (sensors) {
       this.handleSensorStatus(sensors);
     }
 
     // Add data points to charts
-    if (typeof ecg !== "undefined") {
-      this.addDataPoint("ecg", timestamp, ecg);
-      this.totalDataPoints++;
-    }
-    if (typeof spo2 !== "undefined") {
-      this.addDataPoint("spo2", timestamp, spo2);
-      this.totalDataPoints++;
-    }
-    if (typeof resp !== "undefined") {
-      this.addDataPoint("resp", timestamp, resp);
-      this.totalDataPoints++;
-    }
-    if (typeof pleth !== "undefined") {
-      this.addDataPoint("pleth", timestamp, pleth);
-      this.totalDataPoints++;
-    }
+    this.addSamples("ecg", timestamp, ecg);
+    this.addSamples("spo2", timestamp, spo2);
+    this.addSamples("resp", timestamp, resp);
+    this.addSamples("pleth", timestamp, pleth);
 
     // Update vital signs summary cards
     this.updateVitalSigns(data);
@@ -335,6 +494,42 @@ class PatientMonitor {
     this.updateFooter(timestamp);
   }
 
+  async backfillHistory(until) {
+    const from = until - this.config.windowSeconds;
+
+    await Promise.all(
+      Object.keys(this.charts).map(async (key) => {
+        try {
+          const response = await fetch(
+            `/api/history?channel=${key}&from=${from}&to=${until}`,
+          );
+          if (!response.ok) return;
+          const history = await response.json();
+
+          // Keep live points from this connection, replace everything older
+          const chart = this.charts[key];
+          const firstLive = chart.data.x.findIndex((x) => x >= until);
+          const liveX = firstLive < 0 ? [] : chart.data.x.slice(firstLive);
+          const liveY = firstLive < 0 ? [] : chart.data.y.slice(firstLive);
+
+          const histX = [];
+          const histY = [];
+          for (let i = 0; i < history.t.length; i++) {
+            if (history.t[i] < until) {
+              histX.push(history.t[i]);
+              histY.push(history.v[i]);
+            }
+          }
+
+          chart.data.x = histX.concat(liveX);
+          chart.data.y = histY.concat(liveY);
+        } catch (error) {
+          console.error(`Failed to backfill ${key}:`, error);
+        }
+      }),
+    );
+  }
+
   handleSensorStatus(sensors) {
     // Show/hide charts based on sensor attachment
     this.updateChartVisibility("ecg", sensors.ecg);
@@ -370,45 +565,46 @@ class PatientMonitor {
       this.updateVitalCard("resp", respRate, this.thresholds.resp);
     }
 
-    // Update blood pressure
+    // Update blood pressure. Filtered streams omit fields between updates,
+    // so a missing value keeps the last reading unless the sensor is detached.
     if (this.dom.bpValue) {
-      if (
-        data.sensors &&
-        data.sensors.nibp &&
-        typeof data.bp_systolic !== "undefined"
-      ) {
+      if (data.sensors && !data.sensors.nibp) {
+        this.dom.bpValue.textContent = "--/--";
+        this.updateVitalStatus("bp", null);
+      } else if (typeof data.bp_systolic !== "undefined") {
         const sys = data.bp_systolic.toFixed(0);
-        const dia = data.bp_diastolic.toFixed(0);
+        const dia = (data.bp_diastolic ?? 0).toFixed(0);
         this.dom.bpValue.textContent = `${sys}/${dia}`;
         this.updateVitalStatus(
           "bp",
           data.bp_systolic,
           this.thresholds.bp_systolic,
         );
-      } else {
-        this.dom.bpValue.textContent = "--/--";
-        this.updateVitalStatus("bp", null);
       }
     }
 
     // Update temperatures
     if (this.dom.tempCoreValue && this.dom.tempSkinValue) {
-      if (
-        data.sensors &&
-        data.sensors.temp &&
-        typeof data.temp_cavity !== "undefined"
-      ) {
-        this.updateVitalCard(
-          "tempCore",
-          data.temp_cavity,
-          this.thresholds.temp,
-        );
-        this.updateVitalCard("tempSkin", data.temp_skin, this.thresholds.temp);
-      } else {
+      if (data.sensors && !data.sensors.temp) {
         this.dom.tempCoreValue.textContent = "--.-";
         this.dom.tempSkinValue.textContent = "--.-";
         this.updateVitalStatus("tempCore", null);
         this.updateVitalStatus("tempSkin", null);
+      } else {
+        if (typeof data.temp_cavity !== "undefined") {
+          this.updateVitalCard(
+            "tempCore",
+            data.temp_cavity,
+            this.thresholds.temp,
+          );
+        }
+        if (typeof data.temp_skin !== "undefined") {
+          this.updateVitalCard(
+            "tempSkin",
+            data.temp_skin,
+            this.thresholds.temp,
+          );
+        }
       }
     }
   }
@@ -451,7 +647,7 @@ class PatientMonitor {
     const chart = this.charts.ecg;
     if (!chart || chart.data.x.length < 40) return 0;
 
-    const data = chart.data.y.slice(-40); // Last 2 seconds at 20Hz
+    const data = this.recentSamples(chart, 2);
     const threshold = 0.5;
     let peaks = 0;
 
@@ -473,7 +669,7 @@ class PatientMonitor {
     const chart = this.charts.resp;
     if (!chart || chart.data.x.length < 200) return 0;
 
-    const data = chart.data.y.slice(-200); // Last 10 seconds at 20Hz
+    const data = this.recentSamples(chart, 10);
     const threshold = 0.2;
     let peaks = 0;
 
@@ -490,6 +686,20 @@ class PatientMonitor {
     return Math.round(peaks * 6); // Convert to breaths per minute
   }
 
+  // A channel value is either one sample at the frame timestamp or, for
+  // waveforms sampled at their native rate, a run {t0, dt, v: [samples]}
+  addSamples(chartName, timestamp, value) {
+    if (typeof value === "number") {
+      this.addDataPoint(chartName, timestamp, value);
+      this.totalDataPoints++;
+    } else if (value && Array.isArray(value.v)) {
+      for (let i = 0; i < value.v.length; i++) {
+        this.addDataPoint(chartName, value.t0 + i * value.dt, value.v[i]);
+      }
+      this.totalDataPoints += value.v.length;
+    }
+  }
+
   addDataPoint(chartName, x, y) {
     const chart = this.charts[chartName];
     if (!chart) return;
@@ -497,14 +707,26 @@ class PatientMonitor {
     chart.data.x.push(x);
     chart.data.y.push(y);
 
-    // Trim old data points (circular buffer)
-    if (chart.data.x.length > this.config.maxPoints * 1.1) {
-      const toRemove = Math.floor(this.config.maxPoints * 0.2);
+    // Trim points older than the window, in batches so the arrays are not
+    // shifted on every sample
+    const keepFrom = x - this.config.windowSeconds * 1.1;
+    if (chart.data.x[0] < keepFrom - this.config.windowSeconds * 0.2) {
+      const toRemove = chart.data.x.findIndex((t) => t >= keepFrom);
       chart.data.x.splice(0, toRemove);
       chart.data.y.splice(0, toRemove);
     }
   }
 
+  // Samples of a chart from the last `seconds`, whatever the sample rate
+  recentSamples(chart, seconds) {
+    const x = chart.data.x;
+    if (x.length === 0) return [];
+    const from = x[x.length - 1] - seconds;
+    let i = x.length - 1;
+    while (i > 0 && x[i - 1] >= from) i--;
+    return chart.data.y.slice(i);
+  }
+
   startRenderLoop() {
     const render = (timestamp) => {
       Object.values(this.charts).forEach((chart) => {